@@ -59,6 +59,7 @@ std::shared_ptr<runtime::ChxVM> Compile(
         bool use_cuda,
         bool fuse_operations,
         bool use_nvrtc,
+        bool use_native_jit,
         bool use_tvm,
         bool reuse_tvm_code,
         const std::string& dump_autotvm_task_dir,
@@ -80,6 +81,7 @@ std::shared_ptr<runtime::ChxVM> Compile(
     g_use_cuda = use_cuda;
     g_fuse_operations = fuse_operations;
     g_use_nvrtc = use_nvrtc;
+    g_use_native_jit = use_native_jit;
     g_use_tvm = use_tvm;
     g_reuse_tvm_code = reuse_tvm_code;
     g_dump_autotvm_task_dir = dump_autotvm_task_dir;
@@ -191,6 +193,7 @@ void InitGraph(py::module& m) {
           "use_cuda"_a = false,
           "fuse_operations"_a = false,
           "use_nvrtc"_a = false,
+          "use_native_jit"_a = false,
           "use_tvm"_a = false,
           "reuse_tvm_code"_a = false,
           "dump_autotvm_task_dir"_a = "",
@@ -6,6 +6,10 @@
 
 #include <common/log.h>
 #include <common/strutil.h>
+#include <compiler/chxvm/inplace.h>
+#include <compiler/chxvm/memory_plan.h>
+#include <compiler/chxvm/peephole.h>
+#include <compiler/chxvm/register_allocation.h>
 #include <compiler/flags.h>
 #include <compiler/flops.h>
 #include <compiler/gen_chxvm_codegen.h>
@@ -19,6 +23,7 @@
 #include <compiler/tvm/compiler.h>
 #include <compiler/value.h>
 #include <runtime/chxvm.pb.h>
+#include <runtime/ops/native_jit.h>
 
 namespace chainer_compiler {
 namespace chxvm {
@@ -58,6 +63,7 @@ void FillOpInfo(const Node& node, const std::string& debug_info, XCProgramProto*
     inst->set_debug_info(debug_info);
     inst->set_id(node.chainer_order());
     inst->set_flops(CalculateFlops(node));
+    if (node.chainer_parallel_stage() >= 0) inst->set_parallel_stage(node.chainer_parallel_stage());
 }
 
 class ChxVMEmitter {
@@ -87,6 +93,17 @@ public:
             std::cerr << "Total size of all values: " << total_mb << "MB" << std::endl;
         }
         EmitStackQuit(program);
+        // Keep the original ids when they are dumped for debugging.
+        if (!dump_value_names && !g_skip_chxvm_peephole) {
+            OptimizeProgram(program);
+        }
+        if (g_static_memory_plan) {
+            PlanMemory(program);
+        }
+        if (!dump_value_names) {
+            AllocateRegisters(program);
+        }
+        MarkConsumedInputs(program);
     }
 
     void AssignValueIds(const std::vector<Value*>& values) {
@@ -300,31 +317,44 @@ private:
             // Support auto_pad only for MNIST
             CHECK(node.auto_pad() == "NOTSET" || node.auto_pad() == "SAME_UPPER");
             EMIT(Conv, out(0), in(0), in(1), oin(2), strides(), pads(), node.group(), node.auto_pad());
+        } else if (node.op_type() == Node::kChainerConvBiasActivation) {
+            CHECK_EQ(1UL, node.outputs().size());
+            // Dilated Conv is not fused (see MaybeMergeConvBiasActivation).
+            for (int d : node.dilations()) CHECK_EQ(d, 1);
+            CHECK(node.auto_pad() == "NOTSET" || node.auto_pad() == "SAME_UPPER");
+            EMIT(ConvBiasActivation,
+                 out(0),
+                 in(0),
+                 in(1),
+                 oin(2),
+                 oin(3),
+                 strides(),
+                 pads(),
+                 node.group(),
+                 node.auto_pad(),
+                 node.activation(),
+                 node.alpha(),
+                 node.min(),
+                 node.max());
         } else if (node.op_type() == Node::kConvTranspose) {
             CHECK_LE(2UL, node.inputs().size());
             CHECK_GE(3UL, node.inputs().size());
             CHECK_EQ(1UL, node.outputs().size());
-            // TODO(hamaji): Support grouped conv in ChxVM.
-            CHECK_EQ(1, node.group()) << "ChxVM does not support grouped conv transpose";
             // TODO(ChainerX): Support dilation.
             for (int d : node.dilations()) CHECK_EQ(d, 1) << "Dilation is not supported yet";
             // TODO(hamaji): Handle output_padding and output_shape.
             std::vector<int64_t> output_shape(node.output_shape());
-            EMIT(ConvTranspose, out(0), in(0), in(1), oin(2), strides(), pads(), output_shape);
+            EMIT(ConvTranspose, out(0), in(0), in(1), oin(2), strides(), pads(), output_shape, node.group());
         } else if (node.op_type() == Node::kChainerConvTransposeWithDynamicOutputShape) {
             CHECK_EQ(3UL, node.inputs().size());
             CHECK_EQ(1UL, node.outputs().size());
-            // TODO(hamaji): Support grouped conv in ChxVM.
-            CHECK_EQ(1, node.group()) << "ChxVM does not support grouped conv";
-            EMIT(ConvTransposeWithDynamicShape, out(0), in(0), in(1), in(2), strides(), pads());
+            EMIT(ConvTransposeWithDynamicShape, out(0), in(0), in(1), in(2), strides(), pads(), node.group());
         } else if (node.op_type() == Node::kChainerConvGradWeight) {
             CHECK_EQ(3UL, node.inputs().size());
             CHECK_EQ(1UL, node.outputs().size());
-            // TODO(hamaji): Support grouped conv in ChxVM.
-            CHECK_EQ(1, node.group()) << "ChxVM does not support grouped conv";
             // TODO(ChainerX): Support dilation.
             for (int d : node.dilations()) CHECK_EQ(d, 1) << "Dilation is not supported yet";
-            EMIT(ConvGradWeight, out(0), in(0), in(1), in(2), strides(), pads());
+            EMIT(ConvGradWeight, out(0), in(0), in(1), in(2), strides(), pads(), node.group());
         } else if (node.op_type() == Node::kRNN) {
             CHECK(node.activations().empty()) << "activations not supporte yet";
             CHECK(node.activation_alpha().empty()) << "activation_alpha not supporte yet";
@@ -399,6 +429,18 @@ private:
             CHECK_EQ(3UL, node.inputs().size());
             CHECK_EQ(1UL, node.outputs().size());
             EMIT(Gemm, out(0), in(0), in(1), in(2), node.alpha(), node.beta(), node.trans_a(), node.trans_b());
+        } else if (node.op_type() == Node::kChainerGemmBiasActivation) {
+            CHECK_EQ(1UL, node.outputs().size());
+            EMIT(GemmBiasActivation,
+                 out(0),
+                 in(0),
+                 in(1),
+                 oin(2),
+                 node.alpha(),
+                 node.beta(),
+                 node.trans_a(),
+                 node.trans_b(),
+                 node.activation());
         } else if (node.op_type() == Node::kBatchNormalization) {
             EmitBatchNormalization(node, prog);
         } else if (node.op_type() == Node::kLRN) {
@@ -408,6 +450,8 @@ private:
         } else if (node.op_type() == Node::kUpsample || node.op_type() == Node::kResize) {
             CHECK_EQ("nearest", node.mode()) << "Only nearest upsampling is supported";
             EMIT(Upsample, out(0), in(0), in(1));
+        } else if (node.op_type() == Node::kChainerUpsampleGrad) {
+            EMIT(UpsampleGrad, out(0), in(0), in(1));
         } else if (node.op_type() == Node::kPad) {
             CHECK_EQ(1UL, node.inputs().size());
             CHECK_EQ(1UL, node.outputs().size());
@@ -425,15 +469,33 @@ private:
             CHECK_EQ("NOTSET", node.auto_pad()) << "auto_pad is not supported for MaxPool";
             EMIT(MaxPoolGrad, out(0), in(0), in(1), node.kernel_shape(), node.chainer_cover_all());
         } else if (node.op_type() == Node::kChainerROIMaxPool2D) {
-            EMIT(ROIMaxPool2D, out(0), in(0), in(1), in(2), node.output_shape(), node.spatial_scale());
+            EMIT(ROIMaxPool2D, out(0), oout(1), in(0), in(1), in(2), node.output_shape(), node.spatial_scale());
         } else if (node.op_type() == Node::kChainerROIAveragePool2D) {
-            EMIT(ROIAveragePool2D, out(0), in(0), in(1), in(2), node.output_shape(), node.spatial_scale());
+            EMIT(ROIAveragePool2D, out(0), oout(1), in(0), in(1), in(2), node.output_shape(), node.spatial_scale());
         } else if (node.op_type() == Node::kChainerROIMaxAlign2D) {
-            EMIT(ROIMaxAlign2D, out(0), in(0), in(1), in(2), node.output_shape(), node.spatial_scale(), node.sampling_ratio());
+            EMIT(ROIMaxAlign2D, out(0), oout(1), in(0), in(1), in(2), node.output_shape(), node.spatial_scale(), node.sampling_ratio());
         } else if (node.op_type() == Node::kChainerROIAverageAlign2D) {
-            EMIT(ROIAverageAlign2D, out(0), in(0), in(1), in(2), node.output_shape(), node.spatial_scale(), node.sampling_ratio());
+            EMIT(ROIAverageAlign2D,
+                 out(0),
+                 oout(1),
+                 in(0),
+                 in(1),
+                 in(2),
+                 node.output_shape(),
+                 node.spatial_scale(),
+                 node.sampling_ratio());
+        } else if (node.op_type() == Node::kChainerROIMaxPool2DGrad) {
+            EMIT(ROIMaxPool2DGrad, out(0), in(0), in(1), node.output_shape(), node.spatial_scale());
+        } else if (node.op_type() == Node::kChainerROIAveragePool2DGrad) {
+            EMIT(ROIAveragePool2DGrad, out(0), in(0), in(1), node.output_shape(), node.spatial_scale());
+        } else if (node.op_type() == Node::kChainerROIMaxAlign2DGrad) {
+            EMIT(ROIMaxAlign2DGrad, out(0), in(0), in(1), node.output_shape(), node.spatial_scale(), node.sampling_ratio());
+        } else if (node.op_type() == Node::kChainerROIAverageAlign2DGrad) {
+            EMIT(ROIAverageAlign2DGrad, out(0), in(0), in(1), node.output_shape(), node.spatial_scale(), node.sampling_ratio());
         } else if (node.op_type() == Node::kChainerResizeImages) {
             EMIT(ResizeImages, out(0), in(0), node.output_shape());
+        } else if (node.op_type() == Node::kChainerResizeImagesGrad) {
+            EMIT(ResizeImagesGrad, out(0), in(0), in(1));
         } else if (node.op_type() == Node::kAveragePool) {
             CHECK_EQ("NOTSET", node.auto_pad()) << "auto_pad is not supported for AveragePool";
             CHECK_EQ(1UL, node.inputs().size());
@@ -991,6 +1053,50 @@ private:
             return;
         }
 
+        if (g_use_native_jit && node.fusion_type() == "native") {
+            const bool has_reduction =
+                    std::any_of(body.nodes().begin(), body.nodes().end(), [](const Node* n) { return IsNativeRowReduction(*n); });
+            std::string native_code;
+            std::vector<int64_t> row_outputs;
+            bool ok = has_reduction ? BuildNativeRowReductionProgram(
+                                              body.nodes(),
+                                              node.chainer_fusion_group(),
+                                              body.input_values(),
+                                              body.output_values(),
+                                              &native_code,
+                                              &row_outputs)
+                                    : BuildNativeProgram(
+                                              body.nodes(),
+                                              node.chainer_fusion_group(),
+                                              body.input_values(),
+                                              body.output_values(),
+                                              &native_code);
+            if (g_compiler_log) {
+                CLOG() << "Fusion group (native) " << GetFusionGroupSummary(node) << (ok ? "" : " is not compiled") << std::endl;
+                CLOG() << native_code;
+            }
+            // Compile the code now so the unfused subgraph is used if
+            // the system C++ compiler cannot build it.
+            ok = ok && runtime::PrepareNativeFusion(node.chainer_fusion_group(), native_code);
+
+            if (ok) {
+                std::vector<int> inputs;
+                std::vector<ChxVMValue> outputs;
+                for (Value* value : node.inputs()) {
+                    inputs.push_back(GetValueId(value));
+                }
+                for (Value* value : node.outputs()) {
+                    outputs.emplace_back(GetValueId(value), value);
+                }
+                if (has_reduction) {
+                    EMIT(RowReductionNative, outputs, inputs, outputs.size(), row_outputs, native_code, node.chainer_fusion_group());
+                } else {
+                    EMIT(ElementWiseNative, outputs, inputs, outputs.size(), native_code, node.chainer_fusion_group());
+                }
+                return;
+            }
+        }
+
         AssignValueIds(body);
 
         for (size_t i = 0; i < node.inputs().size(); ++i) {
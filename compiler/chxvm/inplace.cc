@@ -0,0 +1,80 @@
+#include "compiler/chxvm/inplace.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include <common/log.h>
+#include <compiler/chxvm/program_util.h>
+#include <compiler/log.h>
+#include <runtime/chxvm.pb.h>
+
+namespace chainer_compiler {
+namespace chxvm {
+namespace {
+
+using runtime::XCInstructionProto;
+using runtime::XCProgramProto;
+using runtime::XCValueProto;
+
+// Inputs whose buffers the runtime kernel of `op` can overwrite. Keep
+// this in sync with the ops which check `ChxVMOp::consumes_input`.
+std::vector<int> GetConsumableInputs(XCInstructionProto::Op op) {
+    switch (op) {
+        case XCInstructionProto::Relu:
+        case XCInstructionProto::Sigmoid:
+        case XCInstructionProto::Tanh:
+        case XCInstructionProto::Cast:
+            return {0};
+        case XCInstructionProto::Add:
+        case XCInstructionProto::Sub:
+        case XCInstructionProto::Mul:
+        case XCInstructionProto::ReluGrad:
+            return {0, 1};
+        default:
+            return {};
+    }
+}
+
+}  // namespace
+
+int MarkConsumedInputs(XCProgramProto* program) {
+    const int num_insts = program->instructions_size();
+    int num_marked = 0;
+    for (int pc = 0; pc < num_insts; ++pc) {
+        XCInstructionProto* inst = program->mutable_instructions(pc);
+        inst->clear_consumed_inputs();
+        const std::vector<int> consumable = GetConsumableInputs(inst->op());
+        if (consumable.empty()) continue;
+
+        // The emitter frees values right after their last users. As
+        // `Free` never jumps, these values are dead once `inst` runs.
+        std::set<int> freed;
+        for (int next = pc + 1; next < num_insts; ++next) {
+            const XCInstructionProto& free = program->instructions(next);
+            if (free.op() != XCInstructionProto::Free) break;
+            freed.insert(free.inputs(0).array());
+        }
+        if (freed.empty()) continue;
+
+        // A variable passed twice (e.g., Mul(x, x)) is still read by
+        // the other input.
+        std::map<int, int> num_uses;
+        for (int id : GetInputIds(*inst)) ++num_uses[id];
+        for (int id : inst->outputs()) ++num_uses[id];
+
+        for (int index : consumable) {
+            if (index >= inst->inputs_size()) continue;
+            const XCValueProto& value = inst->inputs(index);
+            if (value.type() != XCValueProto::ARRAY || value.array() < 0) continue;
+            if (!freed.count(value.array()) || num_uses[value.array()] != 1) continue;
+            inst->add_consumed_inputs(index);
+            ++num_marked;
+        }
+    }
+    CLOG() << "In-place candidates: " << num_marked << " inputs" << std::endl;
+    return num_marked;
+}
+
+}  // namespace chxvm
+}  // namespace chainer_compiler
@@ -0,0 +1,19 @@
+#pragma once
+
+namespace chainer_compiler {
+
+namespace runtime {
+class XCProgramProto;
+}
+
+namespace chxvm {
+
+// Marks array inputs of elementwise instructions which die at the
+// instruction, i.e., are freed by `Free` instructions right after it,
+// in `XCInstructionProto.consumed_inputs`. The runtime moves such
+// inputs out of their variables so kernels can write results into the
+// input buffers. Returns the number of marked inputs.
+int MarkConsumedInputs(runtime::XCProgramProto* program);
+
+}  // namespace chxvm
+}  // namespace chainer_compiler
@@ -0,0 +1,54 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <compiler/chxvm/chxvm_value.h>
+#include <compiler/chxvm/inplace.h>
+#include <compiler/gen_chxvm_codegen.h>
+#include <runtime/chxvm.pb.h>
+
+namespace chainer_compiler {
+namespace chxvm {
+namespace {
+
+using runtime::XCInstructionProto;
+using runtime::XCProgramProto;
+
+std::vector<int> ConsumedInputs(const XCInstructionProto& inst) {
+    return std::vector<int>(inst.consumed_inputs().begin(), inst.consumed_inputs().end());
+}
+
+TEST(InPlaceTest, LastUse) {
+    XCProgramProto program;
+    AddInOp(&program, ChxVMValue(0), "x");
+    AddInOp(&program, ChxVMValue(1), "y");
+    // $0 is used later.
+    AddReluOp(&program, ChxVMValue(2), 0);
+    // $2 dies but $0 does not.
+    AddAddOp(&program, ChxVMValue(3), 0, 2);
+    AddFreeOp(&program, 2);
+    // Both die.
+    AddMulOp(&program, ChxVMValue(4), 3, 1);
+    AddFreeOp(&program, 1);
+    AddFreeOp(&program, 3);
+    // The same variable is passed twice.
+    AddSubOp(&program, ChxVMValue(5), 4, 4);
+    AddFreeOp(&program, 4);
+    // Not an elementwise op.
+    AddIdentityOp(&program, ChxVMValue(6), 5);
+    AddFreeOp(&program, 5);
+    AddOutOp(&program, "out", 6);
+    AddFreeOp(&program, 0);
+    AddFreeOp(&program, 6);
+
+    EXPECT_EQ(3, MarkConsumedInputs(&program));
+    EXPECT_EQ(std::vector<int>({}), ConsumedInputs(program.instructions(2)));
+    EXPECT_EQ(std::vector<int>({1}), ConsumedInputs(program.instructions(3)));
+    EXPECT_EQ(std::vector<int>({0, 1}), ConsumedInputs(program.instructions(5)));
+    EXPECT_EQ(std::vector<int>({}), ConsumedInputs(program.instructions(8)));
+    EXPECT_EQ(std::vector<int>({}), ConsumedInputs(program.instructions(10)));
+}
+
+}  // namespace
+}  // namespace chxvm
+}  // namespace chainer_compiler
@@ -0,0 +1,194 @@
+#include "compiler/chxvm/memory_plan.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <chainerx/dtype.h>
+
+#include <common/log.h>
+#include <compiler/chxvm/program_util.h>
+#include <compiler/log.h>
+#include <runtime/chxvm.pb.h>
+
+namespace chainer_compiler {
+namespace chxvm {
+namespace {
+
+using runtime::XCInstructionProto;
+using runtime::XCProgramProto;
+using runtime::XCTypeProto;
+
+constexpr int64_t kAlignment = 64;
+
+// Ops which write their outputs into the buffers placed by the
+// compiler (see `ChxVMState::AllocateOutput`).
+bool CanPlaceOutput(XCInstructionProto::Op op) {
+    switch (op) {
+        case XCInstructionProto::Add:
+        case XCInstructionProto::Sub:
+        case XCInstructionProto::Mul:
+        case XCInstructionProto::Relu:
+        case XCInstructionProto::ReluGrad:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Ops which neither return views of their inputs nor keep references
+// to them. A value used only by these ops is dead after its `Free`.
+bool NeverRetainsInputs(XCInstructionProto::Op op) {
+    switch (op) {
+        case XCInstructionProto::Add:
+        case XCInstructionProto::Sub:
+        case XCInstructionProto::Mul:
+        case XCInstructionProto::Div:
+        case XCInstructionProto::Pow:
+        case XCInstructionProto::Neg:
+        case XCInstructionProto::Reciprocal:
+        case XCInstructionProto::Exp:
+        case XCInstructionProto::Log:
+        case XCInstructionProto::Sqrt:
+        case XCInstructionProto::Tanh:
+        case XCInstructionProto::Sigmoid:
+        case XCInstructionProto::Relu:
+        case XCInstructionProto::ReluGrad:
+        case XCInstructionProto::LeakyRelu:
+        case XCInstructionProto::Elu:
+        case XCInstructionProto::Selu:
+        case XCInstructionProto::Conv:
+        case XCInstructionProto::ConvTranspose:
+        case XCInstructionProto::ConvGradWeight:
+        case XCInstructionProto::MatMul:
+        case XCInstructionProto::Gemm:
+        case XCInstructionProto::Linear:
+        case XCInstructionProto::LinearGradWeight:
+        case XCInstructionProto::ReduceSum:
+        case XCInstructionProto::ReduceSumSquare:
+        case XCInstructionProto::ReduceMean:
+        case XCInstructionProto::ReduceMax:
+        case XCInstructionProto::Softmax:
+        case XCInstructionProto::LogSoftmax:
+        case XCInstructionProto::Equal:
+        case XCInstructionProto::Greater:
+        case XCInstructionProto::GreaterEqual:
+        case XCInstructionProto::Not:
+            return true;
+        default:
+            return false;
+    }
+}
+
+int64_t GetNBytes(const XCTypeProto& type) {
+    if (type.dtype() <= 0) return -1;
+    int64_t nbytes = chainerx::GetItemSize(static_cast<chainerx::Dtype>(type.dtype()));
+    for (int d : type.shape()) nbytes *= d;
+    return nbytes;
+}
+
+struct Placement {
+    int pc;
+    int output_index;
+    int begin;
+    int end;
+    int64_t nbytes;
+    int64_t offset;
+};
+
+struct ValueInfo {
+    int num_defs{0};
+    int num_frees{0};
+    int def_pc{-1};
+    int free_pc{-1};
+    int last_use_pc{-1};
+    bool retained{false};
+    int output_index{-1};
+    int64_t nbytes{-1};
+};
+
+}  // namespace
+
+int64_t PlanMemory(XCProgramProto* program) {
+    std::map<int, ValueInfo> values;
+    for (int pc = 0; pc < program->instructions_size(); ++pc) {
+        const XCInstructionProto& inst = program->instructions(pc);
+        for (int id : GetInputIds(inst)) {
+            ValueInfo& info = values[id];
+            if (inst.op() == XCInstructionProto::Free) {
+                info.num_frees++;
+                info.free_pc = pc;
+            } else {
+                info.last_use_pc = pc;
+                if (!NeverRetainsInputs(inst.op())) info.retained = true;
+            }
+        }
+
+        for (int i = 0; i < inst.outputs_size(); ++i) {
+            int id = inst.outputs(i);
+            if (id < 0) continue;
+            ValueInfo& info = values[id];
+            info.num_defs++;
+            info.def_pc = pc;
+            info.output_index = i;
+            if (CanPlaceOutput(inst.op()) && i < inst.output_types_size()) {
+                info.nbytes = GetNBytes(inst.output_types(i));
+            }
+        }
+    }
+
+    // Values defined and freed exactly once keep the buffer during
+    // [def_pc, free_pc] in program order. This holds even inside
+    // loops, since a value alive across a back edge would be defined
+    // or freed more than once.
+    std::vector<Placement> placements;
+    for (const auto& p : values) {
+        const ValueInfo& info = p.second;
+        if (info.nbytes <= 0 || info.num_defs != 1 || info.num_frees != 1 || info.retained) continue;
+        if (info.free_pc <= info.def_pc || info.last_use_pc > info.free_pc) continue;
+        int64_t nbytes = (info.nbytes + kAlignment - 1) / kAlignment * kAlignment;
+        placements.push_back(Placement{info.def_pc, info.output_index, info.def_pc, info.free_pc, nbytes, -1});
+    }
+
+    // Greedy interval packing: larger buffers first, each at the
+    // lowest offset which does not collide with live buffers.
+    std::sort(placements.begin(), placements.end(), [](const Placement& a, const Placement& b) {
+        if (a.nbytes != b.nbytes) return a.nbytes > b.nbytes;
+        return a.begin < b.begin;
+    });
+
+    int64_t arena_size = 0;
+    std::vector<const Placement*> placed;
+    for (Placement& p : placements) {
+        std::vector<const Placement*> live;
+        for (const Placement* q : placed) {
+            if (p.begin <= q->end && q->begin <= p.end) live.push_back(q);
+        }
+        std::sort(live.begin(), live.end(), [](const Placement* a, const Placement* b) { return a->offset < b->offset; });
+
+        int64_t offset = 0;
+        for (const Placement* q : live) {
+            if (offset + p.nbytes <= q->offset) break;
+            offset = std::max(offset, q->offset + q->nbytes);
+        }
+        p.offset = offset;
+        arena_size = std::max(arena_size, offset + p.nbytes);
+        placed.push_back(&p);
+    }
+
+    for (const Placement& p : placements) {
+        XCInstructionProto* inst = program->mutable_instructions(p.pc);
+        while (inst->output_offsets_size() < inst->outputs_size()) {
+            inst->add_output_offsets(-1);
+        }
+        inst->set_output_offsets(p.output_index, p.offset);
+    }
+    program->set_arena_size(arena_size);
+
+    CLOG() << "Static memory plan: " << placements.size() << " values in " << arena_size << " bytes" << std::endl;
+    return arena_size;
+}
+
+}  // namespace chxvm
+}  // namespace chainer_compiler
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace chainer_compiler {
+
+namespace runtime {
+class XCProgramProto;
+}
+
+namespace chxvm {
+
+// Assigns arena offsets to statically shaped outputs of `program` so
+// that values whose lifetimes do not overlap share memory. The plan
+// is recorded in `output_offsets` of each instruction and
+// `arena_size` of the program. Returns the size of the arena.
+int64_t PlanMemory(runtime::XCProgramProto* program);
+
+}  // namespace chxvm
+}  // namespace chainer_compiler
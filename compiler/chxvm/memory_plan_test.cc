@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <chainerx/dtype.h>
+
+#include <compiler/chxvm/chxvm_value.h>
+#include <compiler/chxvm/memory_plan.h>
+#include <compiler/gen_chxvm_codegen.h>
+#include <runtime/chxvm.pb.h>
+
+namespace chainer_compiler {
+namespace chxvm {
+namespace {
+
+using runtime::XCInstructionProto;
+using runtime::XCProgramProto;
+
+void SetFloatType(XCProgramProto* program, std::initializer_list<int> shape) {
+    runtime::XCTypeProto* type = program->mutable_instructions(program->instructions_size() - 1)->mutable_output_types(0);
+    type->set_dtype(static_cast<int>(chainerx::Dtype::kFloat32));
+    for (int d : shape) type->add_shape(d);
+}
+
+int64_t GetOffset(const XCProgramProto& program, int pc) {
+    const XCInstructionProto& inst = program.instructions(pc);
+    if (inst.output_offsets_size() == 0) return -1;
+    return inst.output_offsets(0);
+}
+
+TEST(MemoryPlanTest, ReuseDeadBuffer) {
+    XCProgramProto program;
+    AddInOp(&program, ChxVMValue(1), "x");
+    // pc=1: $2 = Relu($1)
+    AddReluOp(&program, ChxVMValue(2), 1);
+    SetFloatType(&program, {4, 4});
+    AddFreeOp(&program, 1);
+    // pc=3: $3 = Relu($2)
+    AddReluOp(&program, ChxVMValue(3), 2);
+    SetFloatType(&program, {4, 4});
+    AddFreeOp(&program, 2);
+    // pc=5: $4 = Relu($3), can reuse the buffer of $2.
+    AddReluOp(&program, ChxVMValue(4), 3);
+    SetFloatType(&program, {4, 4});
+    AddFreeOp(&program, 3);
+    // pc=7: $5 = Relu($4), escapes via Out.
+    AddReluOp(&program, ChxVMValue(5), 4);
+    SetFloatType(&program, {4, 4});
+    AddFreeOp(&program, 4);
+    AddOutOp(&program, "y", 5);
+    AddFreeOp(&program, 5);
+
+    int64_t arena_size = PlanMemory(&program);
+    EXPECT_EQ(64 * 2, arena_size);
+    EXPECT_EQ(arena_size, program.arena_size());
+
+    int64_t off2 = GetOffset(program, 1);
+    int64_t off3 = GetOffset(program, 3);
+    int64_t off4 = GetOffset(program, 5);
+    EXPECT_LE(0, off2);
+    EXPECT_LE(0, off3);
+    EXPECT_NE(off2, off3);
+    EXPECT_EQ(off2, off4);
+    // Outputs of the program are not placed.
+    EXPECT_EQ(-1, GetOffset(program, 7));
+}
+
+TEST(MemoryPlanTest, RetainedValue) {
+    XCProgramProto program;
+    AddInOp(&program, ChxVMValue(1), "x");
+    AddReluOp(&program, ChxVMValue(2), 1);
+    SetFloatType(&program, {4, 4});
+    AddFreeOp(&program, 1);
+    // Identity aliases its input, so $2 must not be placed.
+    AddIdentityOp(&program, ChxVMValue(3), 2);
+    AddFreeOp(&program, 2);
+    AddOutOp(&program, "y", 3);
+    AddFreeOp(&program, 3);
+
+    EXPECT_EQ(0, PlanMemory(&program));
+    EXPECT_EQ(-1, GetOffset(program, 1));
+}
+
+}  // namespace
+}  // namespace chxvm
+}  // namespace chainer_compiler
@@ -0,0 +1,504 @@
+#include "compiler/chxvm/peephole.h"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <common/log.h>
+#include <compiler/chxvm/program_util.h>
+#include <compiler/gen_chxvm_codegen.h>
+#include <compiler/log.h>
+#include <runtime/chxvm.pb.h>
+
+namespace chainer_compiler {
+namespace chxvm {
+namespace {
+
+using runtime::XCInstructionProto;
+using runtime::XCProgramProto;
+using runtime::XCValueProto;
+
+// A half-open range of program points. The point `pc` is right before
+// the instruction `pc`.
+typedef std::pair<int, int> Range;
+
+bool IsConstant(XCInstructionProto::Op op) {
+    switch (op) {
+        case XCInstructionProto::IntScalarConstant:
+        case XCInstructionProto::FloatScalarConstant:
+        case XCInstructionProto::IntConstant:
+        case XCInstructionProto::FloatConstant:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool IsFreeOf(const XCInstructionProto& inst, int id) {
+    return inst.op() == XCInstructionProto::Free && inst.inputs(0).array() == id;
+}
+
+// Returns the variable ids referenced by `inst`, with duplicates.
+std::vector<int> GetReferencedIds(const XCInstructionProto& inst) {
+    std::vector<int> ids = GetInputIds(inst);
+    for (int id : inst.outputs()) {
+        if (id >= 0) ids.push_back(id);
+    }
+    return ids;
+}
+
+bool Defines(const XCInstructionProto& inst, int id) {
+    const auto& outputs = inst.outputs();
+    return std::find(outputs.begin(), outputs.end(), id) != outputs.end();
+}
+
+// Ops on sequences update their sequence inputs in place.
+bool UpdatesSequence(const XCInstructionProto& inst, int id) {
+    for (const XCValueProto& value : inst.inputs()) {
+        if (value.type() == XCValueProto::SEQUENCE && value.sequence() == id) return true;
+    }
+    return false;
+}
+
+int GetNumIds(const XCProgramProto& program) {
+    int num_ids = 0;
+    for (const XCInstructionProto& inst : program.instructions()) {
+        for (int id : GetReferencedIds(inst)) num_ids = std::max(num_ids, id + 1);
+    }
+    return num_ids;
+}
+
+// Removes and inserts instructions at once. Jumps to a removed
+// instruction land on the next remaining one, and jumps to an
+// instruction land after the instructions inserted before it.
+class ProgramEditor {
+public:
+    explicit ProgramEditor(const XCProgramProto& program)
+        : removed_(program.instructions_size()), before_(program.instructions_size()), after_(program.instructions_size()) {
+    }
+
+    void Remove(int pc) {
+        removed_[pc] = true;
+    }
+
+    // Inserted instructions run only when the control reaches `pc` by
+    // falling through.
+    void InsertBefore(int pc, const XCInstructionProto& inst) {
+        before_[pc].push_back(inst);
+    }
+
+    // Inserted instructions run only when the instruction `pc` falls
+    // through.
+    void InsertAfter(int pc, const XCInstructionProto& inst) {
+        after_[pc].push_back(inst);
+    }
+
+    int num_removed() const {
+        return std::count(removed_.begin(), removed_.end(), true);
+    }
+
+    void Apply(XCProgramProto* program) {
+        const int num_insts = program->instructions_size();
+        google::protobuf::RepeatedPtrField<XCInstructionProto> insts;
+        std::vector<int> anchors(num_insts + 1);
+        for (int pc = 0; pc < num_insts; ++pc) {
+            for (const XCInstructionProto& inst : before_[pc]) *insts.Add() = inst;
+            anchors[pc] = insts.size();
+            if (!removed_[pc]) insts.Add()->Swap(program->mutable_instructions(pc));
+            for (const XCInstructionProto& inst : after_[pc]) *insts.Add() = inst;
+        }
+        anchors[num_insts] = insts.size();
+
+        for (XCInstructionProto& inst : insts) {
+            int target = GetJumpTarget(inst);
+            if (target < 0) continue;
+            CHECK_LE(target, num_insts) << inst.DebugString();
+            const int index = inst.op() == XCInstructionProto::Jmp ? 0 : 1;
+            inst.mutable_inputs(index)->set_i(anchors[target]);
+        }
+        program->mutable_instructions()->Swap(&insts);
+    }
+
+private:
+    std::vector<bool> removed_;
+    std::vector<std::vector<XCInstructionProto>> before_;
+    std::vector<std::vector<XCInstructionProto>> after_;
+};
+
+// Moves each `Free` up to right after the last reference of the
+// variable in the same basic block. This shortens lifetimes so more
+// copies can be coalesced. The number of instructions in each block is
+// kept, so jump targets stay valid.
+int MoveFreesEarly(XCProgramProto* program) {
+    int num_moved = 0;
+    for (const BasicBlock& block : BuildBasicBlocks(*program)) {
+        // Instructions other than `Free` in the original order, and
+        // `Free`s to be placed after each of them. `frees[0]` is for
+        // the beginning of the block.
+        std::vector<int> others;
+        std::vector<std::vector<int>> frees(1);
+        std::map<int, int> last_refs;
+        for (int pc = block.begin; pc < block.end; ++pc) {
+            const XCInstructionProto& inst = program->instructions(pc);
+            if (inst.op() == XCInstructionProto::Free) {
+                auto found = last_refs.find(inst.inputs(0).array());
+                const int pos = found == last_refs.end() ? 0 : found->second;
+                if (pos < static_cast<int>(others.size())) ++num_moved;
+                frees[pos].push_back(pc);
+                continue;
+            }
+            others.push_back(pc);
+            frees.emplace_back();
+            for (int id : GetReferencedIds(inst)) last_refs[id] = others.size();
+        }
+
+        std::vector<XCInstructionProto> insts;
+        for (int pc : frees[0]) insts.push_back(program->instructions(pc));
+        for (size_t i = 0; i < others.size(); ++i) {
+            insts.push_back(program->instructions(others[i]));
+            for (int pc : frees[i + 1]) insts.push_back(program->instructions(pc));
+        }
+        for (int pc = block.begin; pc < block.end; ++pc) {
+            program->mutable_instructions(pc)->Swap(&insts[pc - block.begin]);
+        }
+    }
+    return num_moved;
+}
+
+// Replaces the destination of `Identity` by its source while both of
+// them live in a basic block, i.e., `d = Identity(s)` is followed by
+// uses of `d` and `Free(d)` without any change of `s` and `d`.
+int ForwardCopies(XCProgramProto* program) {
+    const int num_insts = program->instructions_size();
+    std::vector<int> num_refs(GetNumIds(*program));
+    for (const XCInstructionProto& inst : program->instructions()) {
+        for (int id : GetReferencedIds(inst)) ++num_refs[id];
+    }
+
+    std::vector<int> block_ends(num_insts);
+    for (const BasicBlock& block : BuildBasicBlocks(*program)) {
+        for (int pc = block.begin; pc < block.end; ++pc) block_ends[pc] = block.end;
+    }
+
+    ProgramEditor editor(*program);
+    std::vector<bool> removed(num_insts);
+    int num_forwarded = 0;
+    for (int pc = 0; pc < num_insts; ++pc) {
+        const XCInstructionProto& copy = program->instructions(pc);
+        if (removed[pc] || copy.op() != XCInstructionProto::Identity) continue;
+        const int src = copy.inputs(0).array();
+        const int dst = copy.outputs(0);
+        if (src == dst) continue;
+
+        int free_pc = -1;
+        int num_dst_refs = 1;
+        for (int i = pc + 1; i < block_ends[pc]; ++i) {
+            if (removed[i]) continue;
+            const XCInstructionProto& inst = program->instructions(i);
+            if (IsFreeOf(inst, dst)) {
+                free_pc = i;
+                ++num_dst_refs;
+                break;
+            }
+            if (Defines(inst, src) || Defines(inst, dst) || IsFreeOf(inst, src)) break;
+            if (UpdatesSequence(inst, src) || UpdatesSequence(inst, dst)) break;
+            const std::vector<int> ids = GetReferencedIds(inst);
+            num_dst_refs += std::count(ids.begin(), ids.end(), dst);
+        }
+        if (free_pc < 0 || num_dst_refs != num_refs[dst]) continue;
+
+        const int num_uses = num_dst_refs - 2;
+        for (int i = pc + 1; i < free_pc; ++i) {
+            RenameVariables(program->mutable_instructions(i), [src, dst](int id) { return id == dst ? src : id; });
+        }
+        num_refs[src] += num_uses - 1;
+        num_refs[dst] = 0;
+        removed[pc] = removed[free_pc] = true;
+        editor.Remove(pc);
+        editor.Remove(free_pc);
+        ++num_forwarded;
+    }
+    editor.Apply(program);
+    return num_forwarded;
+}
+
+// Computes the ranges of program points where each variable may hold
+// a value by a forward dataflow analysis over basic blocks. Variables
+// are occupied by their definitions and released by `Free`.
+std::vector<std::vector<Range>> ComputeOccupiedRanges(const XCProgramProto& program, const std::vector<BasicBlock>& blocks, int num_ids) {
+    std::vector<std::vector<int>> preds(blocks.size());
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        for (int succ : blocks[b].succs) preds[succ].push_back(b);
+    }
+
+    auto transfer = [&program](int pc, std::vector<bool>* occupied) {
+        const XCInstructionProto& inst = program.instructions(pc);
+        if (inst.op() == XCInstructionProto::Free) {
+            (*occupied)[inst.inputs(0).array()] = false;
+        }
+        for (int id : inst.outputs()) {
+            if (id >= 0) (*occupied)[id] = true;
+        }
+    };
+
+    std::vector<std::vector<bool>> ins(blocks.size(), std::vector<bool>(num_ids));
+    std::vector<std::vector<bool>> outs(blocks.size(), std::vector<bool>(num_ids));
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            for (int pred : preds[b]) {
+                for (int id = 0; id < num_ids; ++id) {
+                    if (outs[pred][id]) ins[b][id] = true;
+                }
+            }
+            std::vector<bool> occupied = ins[b];
+            for (int pc = blocks[b].begin; pc < blocks[b].end; ++pc) transfer(pc, &occupied);
+            if (occupied != outs[b]) {
+                outs[b].swap(occupied);
+                changed = true;
+            }
+        }
+    }
+
+    std::vector<std::vector<Range>> ranges(num_ids);
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        const BasicBlock& block = blocks[b];
+        std::vector<int> begins(num_ids, -1);
+        for (int id = 0; id < num_ids; ++id) {
+            if (ins[b][id]) begins[id] = block.begin;
+        }
+        for (int pc = block.begin; pc < block.end; ++pc) {
+            const XCInstructionProto& inst = program.instructions(pc);
+            if (inst.op() == XCInstructionProto::Free) {
+                const int id = inst.inputs(0).array();
+                if (begins[id] >= 0) ranges[id].emplace_back(begins[id], pc + 1);
+                begins[id] = -1;
+            }
+            for (int id : inst.outputs()) {
+                if (id >= 0 && begins[id] < 0) begins[id] = pc + 1;
+            }
+        }
+        for (int id = 0; id < num_ids; ++id) {
+            if (begins[id] >= 0 && begins[id] < block.end) ranges[id].emplace_back(begins[id], block.end);
+        }
+    }
+    for (std::vector<Range>& r : ranges) std::sort(r.begin(), r.end());
+    return ranges;
+}
+
+// Returns true if `a` and `b` overlap at a point other than `allowed`.
+bool Interferes(const std::vector<Range>& a, const std::vector<Range>& b, int allowed) {
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        const int begin = std::max(a[i].first, b[j].first);
+        const int end = std::min(a[i].second, b[j].second);
+        if (begin < end && !(begin == allowed && end == allowed + 1)) return true;
+        if (a[i].second < b[j].second) {
+            ++i;
+        } else {
+            ++j;
+        }
+    }
+    return false;
+}
+
+// Removes `d = Identity(s); Free(s)` by letting `d` and `s` share a
+// variable when they never hold values at the same time.
+int CoalesceMoves(XCProgramProto* program) {
+    const int num_insts = program->instructions_size();
+    const int num_ids = GetNumIds(*program);
+    const std::vector<BasicBlock> blocks = BuildBasicBlocks(*program);
+    std::vector<bool> is_leader(num_insts + 1);
+    for (const BasicBlock& block : blocks) is_leader[block.begin] = true;
+    std::vector<std::vector<Range>> ranges = ComputeOccupiedRanges(*program, blocks, num_ids);
+
+    std::vector<int> parents(num_ids);
+    for (int id = 0; id < num_ids; ++id) parents[id] = id;
+    std::function<int(int)> find = [&parents, &find](int id) {
+        if (parents[id] != id) parents[id] = find(parents[id]);
+        return parents[id];
+    };
+
+    ProgramEditor editor(*program);
+    int num_coalesced = 0;
+    for (int pc = 0; pc + 1 < num_insts; ++pc) {
+        const XCInstructionProto& copy = program->instructions(pc);
+        if (copy.op() != XCInstructionProto::Identity) continue;
+        const int src = copy.inputs(0).array();
+        const int dst = copy.outputs(0);
+        if (src == dst || is_leader[pc + 1] || !IsFreeOf(program->instructions(pc + 1), src)) continue;
+
+        const int src_root = find(src);
+        const int dst_root = find(dst);
+        if (src_root != dst_root) {
+            if (Interferes(ranges[src_root], ranges[dst_root], pc + 1)) continue;
+            std::vector<Range> merged;
+            std::merge(
+                    ranges[src_root].begin(),
+                    ranges[src_root].end(),
+                    ranges[dst_root].begin(),
+                    ranges[dst_root].end(),
+                    std::back_inserter(merged));
+            ranges[dst_root].swap(merged);
+            ranges[src_root].clear();
+            parents[src_root] = dst_root;
+        }
+        editor.Remove(pc);
+        editor.Remove(pc + 1);
+        ++pc;
+        ++num_coalesced;
+    }
+    if (num_coalesced == 0) return 0;
+
+    for (int pc = 0; pc < num_insts; ++pc) {
+        RenameVariables(program->mutable_instructions(pc), find);
+    }
+    editor.Apply(program);
+    return num_coalesced;
+}
+
+// Removes `Identity` whose destination is never used but freed.
+int RemoveDeadCopies(XCProgramProto* program) {
+    const int num_insts = program->instructions_size();
+    const int num_ids = GetNumIds(*program);
+    std::vector<int> num_refs(num_ids);
+    std::vector<int> free_pcs(num_ids, -1);
+    for (int pc = 0; pc < num_insts; ++pc) {
+        const XCInstructionProto& inst = program->instructions(pc);
+        for (int id : GetReferencedIds(inst)) ++num_refs[id];
+        if (inst.op() == XCInstructionProto::Free) free_pcs[inst.inputs(0).array()] = pc;
+    }
+
+    ProgramEditor editor(*program);
+    int num_removed = 0;
+    for (int pc = 0; pc < num_insts; ++pc) {
+        const XCInstructionProto& inst = program->instructions(pc);
+        if (inst.op() != XCInstructionProto::Identity) continue;
+        const int dst = inst.outputs(0);
+        if (dst == inst.inputs(0).array() || num_refs[dst] != 2 || free_pcs[dst] < 0) continue;
+        editor.Remove(pc);
+        editor.Remove(free_pcs[dst]);
+        ++num_removed;
+    }
+    editor.Apply(program);
+    return num_removed;
+}
+
+// Moves constants defined and freed only inside a loop before the
+// loop, and their `Free` after the loop. A loop is a range of
+// instructions [header, back-edge] which has no other entry than the
+// header and no exit other than falling through the back-edge.
+int HoistLoopConstants(XCProgramProto* program) {
+    const int num_insts = program->instructions_size();
+    std::vector<std::pair<int, int>> jumps;
+    for (int pc = 0; pc < num_insts; ++pc) {
+        int target = GetJumpTarget(program->instructions(pc));
+        if (target >= 0) jumps.emplace_back(pc, target);
+    }
+
+    std::vector<Range> loops;
+    for (const std::pair<int, int>& back_edge : jumps) {
+        const int header = back_edge.second;
+        const int end = back_edge.first + 1;
+        if (header >= end) continue;
+        bool ok = true;
+        for (const std::pair<int, int>& jump : jumps) {
+            const bool from_inside = header <= jump.first && jump.first < end;
+            const bool to_inside = header <= jump.second && jump.second < end;
+            if (from_inside != to_inside) ok = false;
+        }
+        if (ok) loops.emplace_back(header, end);
+    }
+    if (loops.empty()) return 0;
+
+    const int num_ids = GetNumIds(*program);
+    std::vector<int> num_defs(num_ids);
+    std::vector<int> free_pcs(num_ids, -1);
+    std::vector<int> first_refs(num_ids, num_insts);
+    std::vector<int> last_refs(num_ids, -1);
+    for (int pc = 0; pc < num_insts; ++pc) {
+        const XCInstructionProto& inst = program->instructions(pc);
+        for (int id : inst.outputs()) {
+            if (id >= 0) ++num_defs[id];
+        }
+        if (inst.op() == XCInstructionProto::Free) {
+            const int id = inst.inputs(0).array();
+            free_pcs[id] = free_pcs[id] < 0 ? pc : num_insts;
+        }
+        for (int id : GetReferencedIds(inst)) {
+            first_refs[id] = std::min(first_refs[id], pc);
+            last_refs[id] = std::max(last_refs[id], pc);
+        }
+    }
+
+    ProgramEditor editor(*program);
+    int num_hoisted = 0;
+    for (int pc = 0; pc < num_insts; ++pc) {
+        const XCInstructionProto& inst = program->instructions(pc);
+        if (!IsConstant(inst.op())) continue;
+        const int id = inst.outputs(0);
+        if (num_defs[id] != 1 || free_pcs[id] < 0 || free_pcs[id] == num_insts) continue;
+
+        // The outermost loop which contains all references.
+        const Range* best = nullptr;
+        for (const Range& loop : loops) {
+            if (loop.first <= first_refs[id] && last_refs[id] < loop.second) {
+                if (!best || loop.second - loop.first > best->second - best->first) best = &loop;
+            }
+        }
+        if (!best) continue;
+
+        XCProgramProto free;
+        AddFreeOp(&free, id);
+        free.mutable_instructions(0)->set_debug_info(program->instructions(free_pcs[id]).debug_info());
+        editor.InsertBefore(best->first, inst);
+        editor.InsertAfter(best->second - 1, free.instructions(0));
+        editor.Remove(pc);
+        editor.Remove(free_pcs[id]);
+        ++num_hoisted;
+    }
+    editor.Apply(program);
+    return num_hoisted;
+}
+
+int RemoveJumpsToNext(XCProgramProto* program) {
+    ProgramEditor editor(*program);
+    for (int pc = 0; pc < program->instructions_size(); ++pc) {
+        const XCInstructionProto& inst = program->instructions(pc);
+        if (IsUnconditionalJump(inst) && GetJumpTarget(inst) == pc + 1) editor.Remove(pc);
+    }
+    const int num_removed = editor.num_removed();
+    editor.Apply(program);
+    return num_removed;
+}
+
+}  // namespace
+
+PeepholeStats OptimizeProgram(XCProgramProto* program) {
+    PeepholeStats stats;
+    stats.num_instructions_before = program->instructions_size();
+    program->clear_arena_size();
+    for (XCInstructionProto& inst : *program->mutable_instructions()) {
+        inst.clear_output_offsets();
+        inst.clear_consumed_inputs();
+    }
+
+    if (program->instructions_size()) {
+        stats.num_early_frees = MoveFreesEarly(program);
+        stats.num_forwarded_copies = ForwardCopies(program);
+        stats.num_coalesced_moves = CoalesceMoves(program);
+        stats.num_dead_copies = RemoveDeadCopies(program);
+        stats.num_hoisted_constants = HoistLoopConstants(program);
+        stats.num_removed_jumps = RemoveJumpsToNext(program);
+    }
+
+    stats.num_instructions_after = program->instructions_size();
+    CLOG() << "Peephole: " << stats.num_instructions_before << " => " << stats.num_instructions_after << " instructions" << std::endl;
+    return stats;
+}
+
+}  // namespace chxvm
+}  // namespace chainer_compiler
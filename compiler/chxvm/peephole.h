@@ -0,0 +1,36 @@
+#pragma once
+
+namespace chainer_compiler {
+
+namespace runtime {
+class XCProgramProto;
+}
+
+namespace chxvm {
+
+struct PeepholeStats {
+    int num_instructions_before{0};
+    int num_instructions_after{0};
+    // `Free` instructions moved right after the last reference.
+    int num_early_frees{0};
+    // `Identity` whose destination is replaced by its source.
+    int num_forwarded_copies{0};
+    // `Identity` + `Free` pairs removed by sharing a variable.
+    int num_coalesced_moves{0};
+    // `Identity` whose destination is only freed.
+    int num_dead_copies{0};
+    // Constants moved out of loops.
+    int num_hoisted_constants{0};
+    // `Jmp` to the next instruction.
+    int num_removed_jumps{0};
+};
+
+// Removes redundant instructions emitted for MOVEs, loop epilogues,
+// and subgraph boundaries. Jump targets are updated accordingly. As
+// lifetimes of values change, the memory plan and consumed inputs in
+// `program` are cleared, i.e., run `PlanMemory` and
+// `MarkConsumedInputs` after this.
+PeepholeStats OptimizeProgram(runtime::XCProgramProto* program);
+
+}  // namespace chxvm
+}  // namespace chainer_compiler
@@ -0,0 +1,189 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <compiler/chxvm/chxvm_value.h>
+#include <compiler/chxvm/peephole.h>
+#include <compiler/chxvm/program_util.h>
+#include <compiler/gen_chxvm_codegen.h>
+#include <runtime/chxvm.pb.h>
+
+namespace chainer_compiler {
+namespace chxvm {
+namespace {
+
+using runtime::XCInstructionProto;
+using runtime::XCProgramProto;
+
+// Runs `program` abstractly and checks every variable is set before it
+// is used and empty before it is defined. Conditional jumps are taken
+// `num_iterations` times.
+void CheckSlotUsage(const XCProgramProto& program, int num_variables, int num_iterations) {
+    std::vector<bool> is_set(num_variables);
+    int num_jumps = 0;
+    for (int pc = 0; pc < program.instructions_size(); ++pc) {
+        const XCInstructionProto& inst = program.instructions(pc);
+        for (int id : GetInputIds(inst)) {
+            ASSERT_GT(num_variables, id);
+            EXPECT_TRUE(is_set[id]) << "pc=" << pc << " $" << id;
+        }
+        if (inst.op() == XCInstructionProto::Free) {
+            is_set[inst.inputs(0).array()] = false;
+        }
+        for (int id : inst.outputs()) {
+            ASSERT_GT(num_variables, id);
+            EXPECT_FALSE(is_set[id]) << "pc=" << pc << " $" << id;
+            is_set[id] = true;
+        }
+        int target = GetJumpTarget(inst);
+        if (target >= 0 && (IsUnconditionalJump(inst) || num_jumps++ < num_iterations)) {
+            pc = target - 1;
+        }
+    }
+    for (int id = 0; id < num_variables; ++id) {
+        EXPECT_FALSE(is_set[id]) << "$" << id << " leaked";
+    }
+}
+
+std::vector<XCInstructionProto::Op> GetOps(const XCProgramProto& program) {
+    std::vector<XCInstructionProto::Op> ops;
+    for (const XCInstructionProto& inst : program.instructions()) ops.push_back(inst.op());
+    return ops;
+}
+
+TEST(PeepholeTest, Copies) {
+    XCProgramProto program;
+    AddInOp(&program, ChxVMValue(1), "x");
+    // A copy for a subgraph input.
+    AddIdentityOp(&program, ChxVMValue(2), 1);
+    AddReluOp(&program, ChxVMValue(3), 2);
+    AddFreeOp(&program, 2);
+    // A MOVE for a subgraph output.
+    AddIdentityOp(&program, ChxVMValue(4), 3);
+    AddFreeOp(&program, 3);
+    // A copy which is never used.
+    AddIdentityOp(&program, ChxVMValue(5), 1);
+    AddOutOp(&program, "y", 4);
+    AddFreeOp(&program, 1);
+    AddFreeOp(&program, 4);
+    AddFreeOp(&program, 5);
+
+    PeepholeStats stats = OptimizeProgram(&program);
+    EXPECT_EQ(11, stats.num_instructions_before);
+    EXPECT_EQ(5, stats.num_instructions_after);
+    EXPECT_EQ(1, stats.num_forwarded_copies);
+    EXPECT_EQ(2, stats.num_coalesced_moves);
+    EXPECT_EQ(std::vector<XCInstructionProto::Op>(
+                      {XCInstructionProto::In,
+                       XCInstructionProto::Relu,
+                       XCInstructionProto::Free,
+                       XCInstructionProto::Out,
+                       XCInstructionProto::Free}),
+              GetOps(program));
+    EXPECT_EQ(program.instructions(0).outputs(0), program.instructions(1).inputs(0).array());
+    EXPECT_EQ(program.instructions(1).outputs(0), program.instructions(3).inputs(1).array());
+    CheckSlotUsage(program, 6, 0);
+}
+
+// The epilogue of a loop emitted for ONNX's Loop.
+TEST(PeepholeTest, Loop) {
+    XCProgramProto program;
+    AddInOp(&program, ChxVMValue(1), "x");
+    AddIntScalarConstantOp(&program, ChxVMValue(2), 0, 0, true);
+    AddInOp(&program, ChxVMValue(3), "c");
+    AddIdentityOp(&program, ChxVMValue(4), 1);
+    AddFreeOp(&program, 1);
+    const int loop_begin = program.instructions_size();
+    AddReluOp(&program, ChxVMValue(5), 4);
+    AddReluOp(&program, ChxVMValue(10), 5);
+    AddFreeOp(&program, 5);
+    AddInOp(&program, ChxVMValue(6), "c");
+    AddIntScalarConstantOp(&program, ChxVMValue(7), 1, 0, true);
+    AddAddOp(&program, ChxVMValue(8), 2, 7);
+    AddFreeOp(&program, 7);
+    AddFreeOp(&program, 2);
+    AddFreeOp(&program, 3);
+    AddFreeOp(&program, 4);
+    AddIdentityOp(&program, ChxVMValue(2), 8);
+    AddFreeOp(&program, 8);
+    AddIdentityOp(&program, ChxVMValue(3), 6);
+    AddFreeOp(&program, 6);
+    AddIdentityOp(&program, ChxVMValue(4), 10);
+    AddFreeOp(&program, 10);
+    AddJmpTrueOp(&program, 3, loop_begin);
+    AddFreeOp(&program, 2);
+    AddFreeOp(&program, 3);
+    AddIdentityOp(&program, ChxVMValue(9), 4);
+    AddFreeOp(&program, 4);
+    AddOutOp(&program, "y", 9);
+    AddFreeOp(&program, 9);
+    XCProgramProto orig = program;
+    CheckSlotUsage(orig, 11, 3);
+
+    PeepholeStats stats = OptimizeProgram(&program);
+    // Frees of the condition and the state.
+    EXPECT_EQ(2, stats.num_early_frees);
+    EXPECT_EQ(1, stats.num_hoisted_constants);
+    // The input, the condition, the state, and the output. The
+    // iteration counter is still used when its next value is computed.
+    EXPECT_EQ(4, stats.num_coalesced_moves);
+    EXPECT_EQ(orig.instructions_size() - 8, program.instructions_size());
+    CheckSlotUsage(program, 11, 3);
+
+    const XCInstructionProto& jmp = program.instructions(program.instructions_size() - 6);
+    ASSERT_EQ(XCInstructionProto::JmpTrue, jmp.op());
+    const int target = jmp.inputs(1).i();
+    EXPECT_EQ(XCInstructionProto::Free, program.instructions(target).op());
+    EXPECT_EQ(XCInstructionProto::IntScalarConstant, program.instructions(target - 1).op());
+    EXPECT_EQ(XCInstructionProto::Free, program.instructions(program.instructions_size() - 5).op());
+}
+
+// Unused outputs are never freed, so their variables stay occupied
+// and are not shared with others.
+TEST(PeepholeTest, NeverFreed) {
+    XCProgramProto program;
+    AddInOp(&program, ChxVMValue(1), "x");
+    AddIdentityOp(&program, ChxVMValue(2), 1);
+    AddReluOp(&program, ChxVMValue(3), 1);
+    AddFreeOp(&program, 1);
+    AddIdentityOp(&program, ChxVMValue(4), 3);
+    AddFreeOp(&program, 3);
+    AddOutOp(&program, "y", 4);
+    AddFreeOp(&program, 4);
+
+    PeepholeStats stats = OptimizeProgram(&program);
+    EXPECT_EQ(1, stats.num_coalesced_moves);
+    ASSERT_EQ(6, program.instructions_size());
+    const int unused = program.instructions(1).outputs(0);
+    EXPECT_EQ(2, unused);
+    for (int pc = 2; pc < program.instructions_size(); ++pc) {
+        const XCInstructionProto& inst = program.instructions(pc);
+        EXPECT_FALSE(inst.op() == XCInstructionProto::Free && inst.inputs(0).array() == unused) << pc;
+        for (int id : inst.outputs()) EXPECT_NE(unused, id) << pc;
+    }
+}
+
+TEST(PeepholeTest, JumpToNext) {
+    XCProgramProto program;
+    AddInOp(&program, ChxVMValue(1), "c");
+    AddJmpFalseOp(&program, 1, 4);
+    AddReluOp(&program, ChxVMValue(2), 1);
+    AddJmpOp(&program, 6);
+    // The else branch.
+    AddIdentityOp(&program, ChxVMValue(2), 1);
+    AddJmpOp(&program, 6);
+    AddFreeOp(&program, 1);
+    AddOutOp(&program, "y", 2);
+    AddFreeOp(&program, 2);
+
+    PeepholeStats stats = OptimizeProgram(&program);
+    EXPECT_EQ(1, stats.num_removed_jumps);
+    ASSERT_EQ(8, program.instructions_size());
+    EXPECT_EQ(4, program.instructions(1).inputs(1).i());
+    EXPECT_EQ(5, program.instructions(3).inputs(0).i());
+    CheckSlotUsage(program, 3, 0);
+}
+
+}  // namespace
+}  // namespace chxvm
+}  // namespace chainer_compiler
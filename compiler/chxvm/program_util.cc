@@ -0,0 +1,132 @@
+#include "compiler/chxvm/program_util.h"
+
+#include <common/log.h>
+#include <runtime/chxvm.pb.h>
+
+namespace chainer_compiler {
+namespace chxvm {
+
+using runtime::XCInstructionProto;
+using runtime::XCProgramProto;
+using runtime::XCValueProto;
+
+std::vector<int> GetInputIds(const XCInstructionProto& inst) {
+    std::vector<int> ids;
+    auto add = [&ids](int id) {
+        if (id >= 0) ids.push_back(id);
+    };
+    for (const XCValueProto& value : inst.inputs()) {
+        switch (value.type()) {
+            case XCValueProto::ARRAY:
+                add(value.array());
+                break;
+            case XCValueProto::ARRAY_LIST:
+                for (int id : value.array_list()) add(id);
+                break;
+            case XCValueProto::SEQUENCE:
+                add(value.sequence());
+                break;
+            case XCValueProto::OPAQUE:
+                add(value.opaque());
+                break;
+            case XCValueProto::SHAPE:
+                add(value.shape());
+                break;
+            case XCValueProto::SCALAR:
+                add(value.scalar());
+                break;
+            default:
+                break;
+        }
+    }
+    return ids;
+}
+
+void RenameVariables(XCInstructionProto* inst, const std::function<int(int)>& fn) {
+    auto rename = [&fn](int id) { return id >= 0 ? fn(id) : id; };
+    for (XCValueProto& value : *inst->mutable_inputs()) {
+        switch (value.type()) {
+            case XCValueProto::ARRAY:
+                value.set_array(rename(value.array()));
+                break;
+            case XCValueProto::ARRAY_LIST:
+                for (int i = 0; i < value.array_list_size(); ++i) {
+                    value.set_array_list(i, rename(value.array_list(i)));
+                }
+                break;
+            case XCValueProto::SEQUENCE:
+                value.set_sequence(rename(value.sequence()));
+                break;
+            case XCValueProto::OPAQUE:
+                value.set_opaque(rename(value.opaque()));
+                break;
+            case XCValueProto::SHAPE:
+                value.set_shape(rename(value.shape()));
+                break;
+            case XCValueProto::SCALAR:
+                value.set_scalar(rename(value.scalar()));
+                break;
+            default:
+                break;
+        }
+    }
+    for (int i = 0; i < inst->outputs_size(); ++i) {
+        inst->set_outputs(i, rename(inst->outputs(i)));
+    }
+}
+
+int GetJumpTarget(const XCInstructionProto& inst) {
+    switch (inst.op()) {
+        case XCInstructionProto::Jmp:
+            CHECK_EQ(1, inst.inputs_size());
+            return inst.inputs(0).i();
+        case XCInstructionProto::JmpTrue:
+        case XCInstructionProto::JmpFalse:
+            CHECK_EQ(2, inst.inputs_size());
+            return inst.inputs(1).i();
+        default:
+            return -1;
+    }
+}
+
+bool IsUnconditionalJump(const XCInstructionProto& inst) {
+    return inst.op() == XCInstructionProto::Jmp;
+}
+
+std::vector<BasicBlock> BuildBasicBlocks(const XCProgramProto& program) {
+    const int num_insts = program.instructions_size();
+    std::vector<bool> is_leader(num_insts + 1);
+    is_leader[0] = true;
+    for (int pc = 0; pc < num_insts; ++pc) {
+        int target = GetJumpTarget(program.instructions(pc));
+        if (target < 0) continue;
+        CHECK_LE(target, num_insts) << program.instructions(pc).DebugString();
+        is_leader[target] = true;
+        is_leader[pc + 1] = true;
+    }
+
+    std::vector<BasicBlock> blocks;
+    std::vector<int> block_of_pc(num_insts + 1, -1);
+    for (int pc = 0; pc < num_insts; ++pc) {
+        if (is_leader[pc]) {
+            if (!blocks.empty()) blocks.back().end = pc;
+            blocks.push_back(BasicBlock{pc, num_insts});
+        }
+        block_of_pc[pc] = blocks.size() - 1;
+    }
+
+    for (BasicBlock& block : blocks) {
+        const XCInstructionProto& last = program.instructions(block.end - 1);
+        int target = GetJumpTarget(last);
+        if (target >= 0 && target < num_insts) {
+            block.succs.push_back(block_of_pc[target]);
+        }
+        if (!IsUnconditionalJump(last) && block.end < num_insts) {
+            block.succs.push_back(block_of_pc[block.end]);
+        }
+    }
+    return blocks;
+}
+
+}  // namespace chxvm
+}  // namespace chainer_compiler
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+namespace chainer_compiler {
+
+namespace runtime {
+class XCInstructionProto;
+class XCProgramProto;
+}
+
+namespace chxvm {
+
+// Returns variable ids referenced by inputs of `inst`. Absent
+// optional inputs (negative ids) are skipped.
+std::vector<int> GetInputIds(const runtime::XCInstructionProto& inst);
+
+// Replaces every variable id in inputs and outputs of `inst` by
+// `fn(id)`. Absent values (negative ids) are kept as they are.
+void RenameVariables(runtime::XCInstructionProto* inst, const std::function<int(int)>& fn);
+
+// Returns the destination pc of a jump instruction, or -1 if `inst`
+// is not a jump.
+int GetJumpTarget(const runtime::XCInstructionProto& inst);
+
+// Returns true if `inst` never falls through to the next pc.
+bool IsUnconditionalJump(const runtime::XCInstructionProto& inst);
+
+struct BasicBlock {
+    // Instructions in [begin, end).
+    int begin;
+    int end;
+    // Indices of successor blocks.
+    std::vector<int> succs;
+};
+
+// Splits `program` into basic blocks at jumps and jump targets.
+std::vector<BasicBlock> BuildBasicBlocks(const runtime::XCProgramProto& program);
+
+}  // namespace chxvm
+}  // namespace chainer_compiler
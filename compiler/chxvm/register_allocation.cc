@@ -0,0 +1,130 @@
+#include "compiler/chxvm/register_allocation.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <common/log.h>
+#include <compiler/chxvm/program_util.h>
+#include <compiler/log.h>
+#include <runtime/chxvm.pb.h>
+
+namespace chainer_compiler {
+namespace chxvm {
+
+using runtime::XCInstructionProto;
+using runtime::XCProgramProto;
+
+int AllocateRegisters(XCProgramProto* program) {
+    const int num_insts = program->instructions_size();
+    if (num_insts == 0) return 0;
+
+    std::vector<std::vector<int>> uses(num_insts);
+    int num_ids = 0;
+    for (int pc = 0; pc < num_insts; ++pc) {
+        const XCInstructionProto& inst = program->instructions(pc);
+        uses[pc] = GetInputIds(inst);
+        for (int id : uses[pc]) num_ids = std::max(num_ids, id + 1);
+        for (int id : inst.outputs()) num_ids = std::max(num_ids, id + 1);
+    }
+
+    // Backward liveness analysis over basic blocks.
+    const std::vector<BasicBlock> blocks = BuildBasicBlocks(*program);
+    std::vector<std::vector<bool>> live_in(blocks.size(), std::vector<bool>(num_ids));
+    std::vector<std::vector<bool>> live_out(blocks.size(), std::vector<bool>(num_ids));
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (int b = blocks.size() - 1; b >= 0; --b) {
+            const BasicBlock& block = blocks[b];
+            for (int succ : block.succs) {
+                for (int id = 0; id < num_ids; ++id) {
+                    if (live_in[succ][id]) live_out[b][id] = true;
+                }
+            }
+            std::vector<bool> live = live_out[b];
+            for (int pc = block.end - 1; pc >= block.begin; --pc) {
+                for (int id : program->instructions(pc).outputs()) {
+                    if (id >= 0) live[id] = false;
+                }
+                for (int id : uses[pc]) live[id] = true;
+            }
+            if (live != live_in[b]) {
+                live_in[b].swap(live);
+                changed = true;
+            }
+        }
+    }
+
+    // A value occupies its slot during [begin, end] in program order.
+    // The interval covers every pc where the value is live, so two
+    // values with disjoint intervals never need the slot at once.
+    std::vector<int> begins(num_ids, std::numeric_limits<int>::max());
+    std::vector<int> ends(num_ids, -1);
+    auto extend = [&begins, &ends](int id, int pc) {
+        begins[id] = std::min(begins[id], pc);
+        ends[id] = std::max(ends[id], pc);
+    };
+    for (int pc = 0; pc < num_insts; ++pc) {
+        for (int id : uses[pc]) extend(id, pc);
+        for (int id : program->instructions(pc).outputs()) {
+            if (id >= 0) extend(id, pc);
+        }
+    }
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        for (int id = 0; id < num_ids; ++id) {
+            if (live_in[b][id]) extend(id, blocks[b].begin);
+            if (live_out[b][id]) extend(id, blocks[b].end - 1);
+        }
+    }
+    // Values which are never freed (e.g., unused outputs) keep their
+    // slots until the end, as a slot must be empty when it is defined.
+    std::vector<bool> is_freed(num_ids);
+    for (const XCInstructionProto& inst : program->instructions()) {
+        if (inst.op() == XCInstructionProto::Free) is_freed[inst.inputs(0).array()] = true;
+    }
+    for (int id = 0; id < num_ids; ++id) {
+        if (!is_freed[id] && ends[id] >= 0) extend(id, num_insts - 1);
+    }
+
+    // Linear scan allocation. Slot 0 is left unused as the emitter
+    // does.
+    std::vector<int> order;
+    for (int id = 0; id < num_ids; ++id) {
+        if (ends[id] >= 0) order.push_back(id);
+    }
+    std::sort(order.begin(), order.end(), [&begins](int a, int b) { return begins[a] < begins[b]; });
+
+    std::vector<int> new_ids(num_ids, -1);
+    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> active;
+    std::set<int> free_slots;
+    int num_slots = 1;
+    for (int id : order) {
+        while (!active.empty() && active.top().first < begins[id]) {
+            free_slots.insert(active.top().second);
+            active.pop();
+        }
+        int slot;
+        if (free_slots.empty()) {
+            slot = num_slots++;
+        } else {
+            slot = *free_slots.begin();
+            free_slots.erase(free_slots.begin());
+        }
+        new_ids[id] = slot;
+        active.emplace(ends[id], slot);
+    }
+
+    for (int pc = 0; pc < num_insts; ++pc) {
+        RenameVariables(program->mutable_instructions(pc), [&new_ids](int id) { return new_ids[id]; });
+    }
+
+    CLOG() << "Register allocation: " << num_ids << " => " << num_slots << " variables" << std::endl;
+    return num_slots;
+}
+
+}  // namespace chxvm
+}  // namespace chainer_compiler
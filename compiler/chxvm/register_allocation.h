@@ -0,0 +1,18 @@
+#pragma once
+
+namespace chainer_compiler {
+
+namespace runtime {
+class XCProgramProto;
+}
+
+namespace chxvm {
+
+// Renumbers variables of `program` so that values whose live ranges
+// do not overlap share a variable slot. Liveness is computed over the
+// control flow graph formed by jump instructions. Returns the number
+// of variables the program needs, i.e., the largest new id plus one.
+int AllocateRegisters(runtime::XCProgramProto* program);
+
+}  // namespace chxvm
+}  // namespace chainer_compiler
@@ -0,0 +1,109 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <compiler/chxvm/chxvm_value.h>
+#include <compiler/chxvm/program_util.h>
+#include <compiler/chxvm/register_allocation.h>
+#include <compiler/gen_chxvm_codegen.h>
+#include <runtime/chxvm.pb.h>
+
+namespace chainer_compiler {
+namespace chxvm {
+namespace {
+
+using runtime::XCInstructionProto;
+using runtime::XCProgramProto;
+
+// Runs `program` abstractly and checks every variable is set before it
+// is used and empty before it is defined. Conditional jumps are taken
+// `num_iterations` times.
+void CheckSlotUsage(const XCProgramProto& program, int num_variables, int num_iterations) {
+    std::vector<bool> is_set(num_variables);
+    int num_jumps = 0;
+    for (int pc = 0; pc < program.instructions_size(); ++pc) {
+        const XCInstructionProto& inst = program.instructions(pc);
+        for (int id : GetInputIds(inst)) {
+            ASSERT_GT(num_variables, id);
+            EXPECT_TRUE(is_set[id]) << "pc=" << pc << " $" << id;
+        }
+        if (inst.op() == XCInstructionProto::Free) {
+            is_set[inst.inputs(0).array()] = false;
+        }
+        for (int id : inst.outputs()) {
+            ASSERT_GT(num_variables, id);
+            EXPECT_FALSE(is_set[id]) << "pc=" << pc << " $" << id;
+            is_set[id] = true;
+        }
+        int target = GetJumpTarget(inst);
+        if (target >= 0 && (IsUnconditionalJump(inst) || num_jumps++ < num_iterations)) {
+            pc = target - 1;
+        }
+    }
+    for (int id = 0; id < num_variables; ++id) {
+        EXPECT_FALSE(is_set[id]) << "$" << id << " leaked";
+    }
+}
+
+TEST(RegisterAllocationTest, StraightLine) {
+    XCProgramProto program;
+    AddInOp(&program, ChxVMValue(1), "x");
+    for (int i = 1; i < 10; ++i) {
+        AddReluOp(&program, ChxVMValue(i + 1), i);
+        AddFreeOp(&program, i);
+    }
+    AddOutOp(&program, "y", 10);
+    AddFreeOp(&program, 10);
+
+    // Only two values are alive at once.
+    EXPECT_EQ(3, AllocateRegisters(&program));
+    CheckSlotUsage(program, 3, 0);
+}
+
+TEST(RegisterAllocationTest, Loop) {
+    XCProgramProto program;
+    AddInOp(&program, ChxVMValue(1), "x");
+    AddIdentityOp(&program, ChxVMValue(2), 1);
+    AddFreeOp(&program, 1);
+    AddInOp(&program, ChxVMValue(3), "c");
+    // The loop body. $2 and $3 are carried across the back edge.
+    const int loop_begin = program.instructions_size();
+    AddReluOp(&program, ChxVMValue(4), 2);
+    AddFreeOp(&program, 2);
+    AddReluOp(&program, ChxVMValue(5), 4);
+    AddFreeOp(&program, 4);
+    AddReluOp(&program, ChxVMValue(2), 5);
+    AddFreeOp(&program, 5);
+    AddFreeOp(&program, 3);
+    AddInOp(&program, ChxVMValue(3), "c");
+    AddJmpTrueOp(&program, 3, loop_begin);
+    AddFreeOp(&program, 3);
+    AddOutOp(&program, "y", 2);
+    AddFreeOp(&program, 2);
+
+    CheckSlotUsage(program, 6, 3);
+    int num_variables = AllocateRegisters(&program);
+    EXPECT_GT(6, num_variables);
+    CheckSlotUsage(program, num_variables, 3);
+
+    // The loop still jumps to the same place.
+    EXPECT_EQ(loop_begin, GetJumpTarget(program.instructions(program.instructions_size() - 4)));
+}
+
+TEST(RegisterAllocationTest, NeverFreed) {
+    XCProgramProto program;
+    AddInOp(&program, ChxVMValue(1), "x");
+    // $2 is neither used nor freed.
+    AddIdentityOp(&program, ChxVMValue(2), 1);
+    AddReluOp(&program, ChxVMValue(3), 1);
+    AddFreeOp(&program, 1);
+    AddOutOp(&program, "y", 3);
+    AddFreeOp(&program, 3);
+
+    AllocateRegisters(&program);
+    EXPECT_NE(program.instructions(1).outputs(0), program.instructions(2).outputs(0));
+}
+
+}  // namespace
+}  // namespace chxvm
+}  // namespace chainer_compiler
@@ -0,0 +1,328 @@
+// Benchmarks for compiler passes.
+//
+// Usage: chainer_compiler_compiler_bench [iterations]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <chainerx/context.h>
+
+#include <compiler/onnx.h>
+
+#include <common/log.h>
+#include <common/strutil.h>
+#include <compiler/computation_order/policy_chen.h>
+#include <compiler/computation_order/policy_remat.h>
+#include <compiler/constant_propagation.h>
+#include <compiler/fusion.h>
+#include <compiler/gradient.h>
+#include <compiler/graph.h>
+#include <compiler/graph_builder.h>
+#include <compiler/graph_view.h>
+#include <compiler/memory_simulator.h>
+#include <compiler/node.h>
+#include <compiler/scheduler.h>
+#include <compiler/tensor.h>
+#include <compiler/value.h>
+
+namespace chainer_compiler {
+namespace {
+
+const int64_t kBatchSize = 2;
+const int64_t kSeqLen = 16;
+const int64_t kHidden = 64;
+const int64_t kNumHeads = 4;
+
+// Builds a dimension as exported models do, i.e., an int32 scalar
+// which is casted and unsqueezed to an int64 tensor with one element.
+Value* Dim(GraphBuilder* gb, int64_t d) {
+    Value* v = gb->Const(Type(Dtype::kInt32, {}), {d});
+    v = gb->Op(Node::kCast, {v});
+    v->producer()->set_to(Dtype::kInt64);
+    v = gb->Op(Node::kUnsqueeze, {v});
+    v->producer()->set_axes({0});
+    return v;
+}
+
+Value* Concat(GraphBuilder* gb, const std::vector<Value*>& inputs) {
+    Value* v = gb->Op(Node::kConcat, inputs);
+    v->producer()->set_axis(0);
+    return v;
+}
+
+Value* Transpose(GraphBuilder* gb, Value* x, const std::vector<int64_t>& perm) {
+    Value* v = gb->Op(Node::kTranspose, {x});
+    v->producer()->set_perm(perm);
+    return v;
+}
+
+// A self-attention layer of BERT whose shapes and the attention mask
+// are computed from constants.
+Value* AddLayer(Graph* graph, int layer, Value* x) {
+    GraphBuilder gb(graph, StrCat("BertLayer", layer), x);
+    auto weight = [graph, layer](const std::string& name) {
+        return graph->AddInputValue(StrCat(name, layer), Type(Dtype::kFloat32, {kHidden, kHidden}));
+    };
+
+    Value* heads_shape = Concat(
+            &gb,
+            {Dim(&gb, kBatchSize),
+             Dim(&gb, kSeqLen),
+             Dim(&gb, kNumHeads),
+             gb.Op(Node::kDiv, {Dim(&gb, kHidden), Dim(&gb, kNumHeads)})});
+    Value* merged_shape = Concat(
+            &gb,
+            {Dim(&gb, kBatchSize), Dim(&gb, kSeqLen), gb.Op(Node::kMul, {Dim(&gb, kNumHeads), Dim(&gb, kHidden / kNumHeads)})});
+
+    auto project = [&](const std::string& name) {
+        Value* h = gb.Op(Node::kMatMul, {x, weight(name)});
+        h = gb.Op(Node::kReshape, {h, heads_shape});
+        return Transpose(&gb, h, {0, 2, 1, 3});
+    };
+    Value* q = project("wq");
+    Value* k = project("wk");
+    Value* v = project("wv");
+
+    Value* mask = gb.Const(Type(Dtype::kInt64, {kSeqLen}), std::vector<int64_t>(kSeqLen, 1));
+    Value* cond = gb.Op(Node::kNot, {gb.Op(Node::kEqual, {mask, gb.Const(Type(Dtype::kInt64, {}), {0})})});
+    Value* mask_bias =
+            gb.Op(Node::kWhere, {cond, gb.Const(Type(Dtype::kFloat32, {}), {0.0}), gb.Const(Type(Dtype::kFloat32, {}), {-10000.0})});
+    mask_bias = gb.Op(Node::kUnsqueeze, {mask_bias});
+    mask_bias->producer()->set_axes({0, 1, 2});
+
+    Value* scores = gb.Op(Node::kMatMul, {q, Transpose(&gb, k, {0, 1, 3, 2})});
+    scores = gb.Op(Node::kAdd, {scores, mask_bias});
+    Value* probs = gb.Op(Node::kSoftmax, {scores});
+    probs->producer()->set_axis(3);
+    Value* context = gb.Op(Node::kMatMul, {probs, v});
+    context = gb.Op(Node::kReshape, {Transpose(&gb, context, {0, 2, 1, 3}), merged_shape});
+    return gb.Op(Node::kAdd, {x, gb.Op(Node::kMatMul, {context, weight("wo")})});
+}
+
+std::unique_ptr<Graph> MakeBertLike(int num_layers) {
+    std::unique_ptr<Graph> graph(new Graph("bert"));
+    Value* x = graph->AddInputValue("x", Type(Dtype::kFloat32, {kBatchSize, kSeqLen, kHidden}));
+    for (int i = 0; i < num_layers; ++i) {
+        x = AddLayer(graph.get(), i, x);
+    }
+    Value* y = graph->AddOutputValue("y", Type(Dtype::kFloat32, {kBatchSize, kSeqLen, kHidden}));
+    GraphBuilder gb(graph.get(), "Output", y);
+    gb.Op(Node::kIdentity, {x}, y);
+    return graph;
+}
+
+void BenchConstantPropagation(int iterations) {
+    for (int num_layers : {12, 24, 48}) {
+        double best_ms = std::numeric_limits<double>::max();
+        ConstantPropagationStats stats;
+        size_t num_nodes_before = 0, num_nodes_after = 0;
+        for (int i = 0; i < iterations; ++i) {
+            std::unique_ptr<Graph> graph(MakeBertLike(num_layers));
+            num_nodes_before = graph->GetLiveNodes().size();
+            auto start = std::chrono::steady_clock::now();
+            stats = PropagateConstants(graph.get());
+            auto end = std::chrono::steady_clock::now();
+            num_nodes_after = graph->GetLiveNodes().size();
+            best_ms = std::min(best_ms, std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        std::cout << "PropagateConstants BERT-like L=" << num_layers << ": " << best_ms << " msec (" << best_ms / num_layers
+                  << " msec/layer) nodes=" << num_nodes_before << "=>" << num_nodes_after << " folded=" << stats.num_folded_nodes
+                  << " evals=" << stats.num_evals << std::endl;
+    }
+}
+
+double ElapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// A long chain of diamonds, which has as many nodes as unrolled loops
+// and gradient graphs.
+std::unique_ptr<Graph> MakeLongChain(int num_blocks) {
+    std::unique_ptr<Graph> graph(new Graph("chain"));
+    const Type type(Dtype::kFloat32, {kBatchSize, kHidden});
+    Value* x = graph->AddInputValue("x", type);
+    Value* y = graph->AddOutputValue("y", type);
+    GraphBuilder gb(graph.get(), "Chain", y);
+    for (int i = 0; i < num_blocks; ++i) {
+        Value* a = gb.Op(Node::kTanh, {x}, gb.Temp(type));
+        Value* b = gb.Op(Node::kSigmoid, {x}, gb.Temp(type));
+        x = gb.Op(Node::kAdd, {a, b}, gb.Temp(type));
+    }
+    gb.Op(Node::kIdentity, {x}, y);
+    return graph;
+}
+
+void BenchLargeGraph(int iterations) {
+    for (int num_blocks : {2500, 5000, 10000}) {
+        const double kInf = std::numeric_limits<double>::max();
+        double schedule_ms = kInf, simulate_ms = kInf, sort_ms = kInf, necessary_map_ms = kInf, necessary_view_ms = kInf;
+        size_t num_nodes = 0;
+        for (int i = 0; i < iterations; ++i) {
+            std::unique_ptr<Graph> graph(MakeLongChain(num_blocks));
+            num_nodes = graph->nodes().size();
+
+            auto start = std::chrono::steady_clock::now();
+            ScheduleComputation(*graph, 0);
+            schedule_ms = std::min(schedule_ms, ElapsedMs(start));
+
+            start = std::chrono::steady_clock::now();
+            SimulateMemoryUsage(*graph);
+            simulate_ms = std::min(simulate_ms, ElapsedMs(start));
+
+            start = std::chrono::steady_clock::now();
+            CHECK_EQ(num_nodes, graph->GetTopologicallySortedNodes().size());
+            sort_ms = std::min(sort_ms, ElapsedMs(start));
+
+            start = std::chrono::steady_clock::now();
+            graph->GetNecessaryNodesAndInputCounts(graph->output_values());
+            necessary_map_ms = std::min(necessary_map_ms, ElapsedMs(start));
+
+            start = std::chrono::steady_clock::now();
+            GraphView(*graph).GetNecessaryNodesAndInputCounts(graph->output_values());
+            necessary_view_ms = std::min(necessary_view_ms, ElapsedMs(start));
+        }
+        std::cout << "Chain nodes=" << num_nodes << ": schedule=" << schedule_ms << " simulate=" << simulate_ms << " sort=" << sort_ms
+                  << " necessary_nodes(map)=" << necessary_map_ms << " necessary_nodes(view)=" << necessary_view_ms << " msec"
+                  << std::endl;
+    }
+}
+
+// Elementwise ops split by `Relu`, which is not fused. Each block
+// makes a fusion group.
+std::unique_ptr<Graph> MakeFusionChain(int num_blocks) {
+    std::unique_ptr<Graph> graph(new Graph("fusion_chain"));
+    const Type type(Dtype::kFloat32, {kBatchSize, kHidden});
+    Value* x = graph->AddInputValue("x", type);
+    Value* y = graph->AddOutputValue("y", type);
+    GraphBuilder gb(graph.get(), "FusionChain", y);
+    for (int i = 0; i < num_blocks; ++i) {
+        Value* h = gb.Op(Node::kTanh, {x}, gb.Temp(type));
+        h = gb.Op(Node::kAdd, {h, x}, gb.Temp(type));
+        x = gb.Op(Node::kRelu, {h}, gb.Temp(type));
+    }
+    gb.Op(Node::kIdentity, {x}, y);
+    return graph;
+}
+
+void BenchFusion(int iterations) {
+    for (int num_blocks : {1000, 3000, 7000}) {
+        double best_ms = std::numeric_limits<double>::max();
+        size_t num_nodes_before = 0, num_nodes_after = 0;
+        for (int i = 0; i < iterations; ++i) {
+            std::unique_ptr<Graph> graph(MakeFusionChain(num_blocks));
+            num_nodes_before = graph->nodes().size();
+            auto start = std::chrono::steady_clock::now();
+            FuseElementwiseOperations(graph.get());
+            best_ms = std::min(best_ms, ElapsedMs(start));
+            num_nodes_after = graph->GetLiveNodes().size();
+        }
+        std::cout << "FuseElementwiseOperations nodes=" << num_nodes_before << "=>" << num_nodes_after << ": " << best_ms << " msec"
+                  << std::endl;
+    }
+}
+
+Value* AddParam(Graph* graph, const std::string& name, const std::vector<int64_t>& dims) {
+    onnx::TensorProto xtensor;
+    xtensor.set_name(name);
+    xtensor.set_data_type(onnx::TensorProto::FLOAT);
+    int64_t size = 1;
+    for (int64_t d : dims) {
+        xtensor.add_dims(d);
+        size *= d;
+    }
+    for (int64_t i = 0; i < size; ++i) xtensor.add_float_data(0.01);
+    Value* value = graph->AddInputValue(name, Type(Dtype::kFloat32, dims));
+    value->ResetInitializer(std::make_unique<Tensor>(xtensor));
+    return value;
+}
+
+// Basic blocks of ResNet, i.e., two convolutions with a shortcut.
+std::unique_ptr<Graph> MakeResNetLike(int num_blocks) {
+    const int64_t kChannels = 8;
+    const int64_t kSize = 8;
+    const Type type(Dtype::kFloat32, {kBatchSize, kChannels, kSize, kSize});
+    std::unique_ptr<Graph> graph(new Graph("resnet"));
+    Value* x = graph->AddInputValue("x", type);
+    Value* y = graph->AddOutputValue("y", Type(Dtype::kFloat32, {}));
+    GraphBuilder gb(graph.get(), "ResNet", y);
+    auto conv = [&](Value* h, const std::string& name) {
+        h = gb.Op(Node::kConv, {h, AddParam(graph.get(), name, {kChannels, kChannels, 3, 3})}, gb.Temp(type));
+        h->producer()->set_pads({1, 1, 1, 1});
+        return h;
+    };
+    for (int i = 0; i < num_blocks; ++i) {
+        Value* h = conv(x, StrCat("conv_a", i));
+        h = gb.Op(Node::kRelu, {h}, gb.Temp(type));
+        h = conv(h, StrCat("conv_b", i));
+        h = gb.Op(Node::kAdd, {h, x}, gb.Temp(type));
+        x = gb.Op(Node::kRelu, {h}, gb.Temp(type));
+    }
+    gb.Op(Node::kReduceSum, {x}, y)->producer()->set_keepdims(false);
+    return graph;
+}
+
+void BenchChenPolicy(int iterations) {
+    for (int num_blocks : {50, 500, 2000}) {
+        double articulation_ms = std::numeric_limits<double>::max();
+        double policy_ms = std::numeric_limits<double>::max();
+        size_t num_nodes = 0, num_articulation_points = 0, num_orders = 0;
+        for (int i = 0; i < iterations; ++i) {
+            std::unique_ptr<Graph> graph(MakeResNetLike(num_blocks));
+            AddGradientNodesForTraining(graph.get());
+            num_nodes = graph->GetLiveNodes().size();
+
+            auto start = std::chrono::steady_clock::now();
+            num_articulation_points = FindArticulationPoints(*graph).size();
+            articulation_ms = std::min(articulation_ms, ElapsedMs(start));
+
+            start = std::chrono::steady_clock::now();
+            num_orders = ChenPolicy(*graph).size();
+            policy_ms = std::min(policy_ms, ElapsedMs(start));
+        }
+        std::cout << "ChenPolicy ResNet-like blocks=" << num_blocks << " nodes=" << num_nodes
+                  << ": articulation_points=" << articulation_ms << " policy=" << policy_ms
+                  << " msec candidates=" << num_articulation_points << " orders=" << num_orders << std::endl;
+    }
+}
+
+void BenchRematPolicy(int iterations) {
+    for (int num_blocks : {50, 500, 2000}) {
+        double best_ms = std::numeric_limits<double>::max();
+        size_t num_nodes = 0, num_orders = 0;
+        for (int i = 0; i < iterations; ++i) {
+            std::unique_ptr<Graph> graph(MakeResNetLike(num_blocks));
+            num_nodes = graph->nodes().size();
+            // Parameters, their gradients, and a third of activations.
+            int64_t budget = 0;
+            for (const std::unique_ptr<Value>& value : graph->all_values()) {
+                budget += value->initializer() ? value->GetNBytes() * 2 : value->GetNBytes() / 3;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            num_orders = RematPolicy(*graph, budget).size();
+            best_ms = std::min(best_ms, ElapsedMs(start));
+        }
+        std::cout << "RematPolicy ResNet-like blocks=" << num_blocks << " nodes=" << num_nodes << ": " << best_ms
+                  << " msec orders=" << num_orders << std::endl;
+    }
+}
+
+}  // namespace
+}  // namespace chainer_compiler
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 3;
+    chainerx::Context ctx;
+    chainerx::ContextScope ctx_scope(ctx);
+    chainer_compiler::BenchConstantPropagation(iterations);
+    chainer_compiler::BenchLargeGraph(iterations);
+    chainer_compiler::BenchFusion(iterations);
+    chainer_compiler::BenchChenPolicy(iterations);
+    chainer_compiler::BenchRematPolicy(iterations);
+}
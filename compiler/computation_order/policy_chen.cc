@@ -3,61 +3,83 @@
 
 #include <algorithm>
 #include <cmath>
-#include <iostream>
-#include <map>
-#include <numeric>
-#include <queue>
 #include <set>
+#include <utility>
 #include <vector>
 
+#include <common/log.h>
 #include <compiler/flags.h>
 #include <compiler/graph.h>
+#include <compiler/graph_view.h>
+#include <compiler/log.h>
 #include <compiler/node.h>
 
 namespace chainer_compiler {
 
-std::set<Node*> FindArticulationPoints(const Graph& graph) {
+std::vector<bool> FindArticulationPoints(const GraphView& view) {
+    const int n = view.num_nodes();
     // Convert to consise representation (undirected graph)
-    std::vector<Node*> nodes = graph.nodes();
-    const size_t n = nodes.size();
-    std::map<Node*, size_t> node_ids;
-    for (size_t i = 0; i < n; ++i) {
-        node_ids.emplace(nodes[i], i);
-    }
-    std::vector<std::vector<size_t>> adj(n);
-
-    for (Node* node : graph.nodes()) {
-        for (Value* output : node->outputs()) {
-            for (Node* user : output->users()) {
+    std::vector<std::vector<int>> adj(n);
+    for (int node_id = 0; node_id < n; ++node_id) {
+        for (int value_id : view.outputs(node_id)) {
+            for (int user : view.users(value_id)) {
                 // There is an edge (node, user)
-                size_t i = node_ids[node], j = node_ids[user];
-                adj[i].push_back(j);
-                adj[j].push_back(i);
+                adj[node_id].push_back(user);
+                adj[user].push_back(node_id);
             }
         }
     }
 
-    std::set<Node*> articulation_points;
-    // In this implementation, we try naive approach to enumerate articulation points
-    for (size_t i = 0; i < n; ++i) {
-        // Check connectivity after the removal of node i
-        std::vector<size_t> visited(n);
-        std::queue<size_t> q;
-        q.push((i + 1) % n);
-        while (!q.empty()) {
-            size_t j = q.front();
-            q.pop();
-            if (visited[j]) continue;
-            visited[j] = 1;
-
-            for (size_t k : adj[j]) {
-                if (k == i || visited[k]) continue;
-                q.push(k);
+    // The order of visits and the lowest order reachable without
+    // the edge to the parent in the DFS tree.
+    std::vector<int> order(n, -1);
+    std::vector<int> low(n);
+    std::vector<bool> articulation_points(n);
+    int num_visited = 0;
+    // Pairs of a node and the index of its next edge, as recursive
+    // DFS would overflow the stack for deep graphs.
+    std::vector<std::pair<int, size_t>> stack;
+    for (int root = 0; root < n; ++root) {
+        if (order[root] >= 0 || view.node(root)->detached()) continue;
+        int num_root_children = 0;
+        order[root] = low[root] = num_visited++;
+        stack.emplace_back(root, 0);
+        while (!stack.empty()) {
+            const int node_id = stack.back().first;
+            size_t& edge = stack.back().second;
+            if (edge < adj[node_id].size()) {
+                const int next = adj[node_id][edge++];
+                if (order[next] >= 0) {
+                    low[node_id] = std::min(low[node_id], order[next]);
+                } else {
+                    order[next] = low[next] = num_visited++;
+                    stack.emplace_back(next, 0);
+                }
+                continue;
+            }
+
+            stack.pop_back();
+            if (stack.empty()) break;
+            const int parent = stack.back().first;
+            low[parent] = std::min(low[parent], low[node_id]);
+            if (parent == root) {
+                ++num_root_children;
+            } else if (low[node_id] >= order[parent]) {
+                // `node_id` cannot reach nodes before `parent`.
+                articulation_points[parent] = true;
             }
         }
-        if (std::accumulate(visited.begin(), visited.end(), 0) < n - 1) {
-            articulation_points.insert(nodes[i]);
-        }
+        if (num_root_children > 1) articulation_points[root] = true;
+    }
+    return articulation_points;
+}
+
+std::set<Node*> FindArticulationPoints(const Graph& graph) {
+    const GraphView view(graph);
+    const std::vector<bool> is_articulation_point = FindArticulationPoints(view);
+    std::set<Node*> articulation_points;
+    for (int node_id = 0; node_id < view.num_nodes(); ++node_id) {
+        if (is_articulation_point[node_id]) articulation_points.insert(view.node(node_id));
     }
     return articulation_points;
 }
@@ -72,16 +94,15 @@ std::vector<Order> ChenPolicy(const Graph& graph) {
             }
         }
         budget = budget / static_cast<int64_t>(std::sqrt(graph.nodes().size()));
-        std::cout << "Budget = " << budget / 1000000LL << " MB is used." << std::endl;
+        CLOG() << "Budget = " << budget / 1000000LL << " MB is used." << std::endl;
     }
 
-    std::vector<Order> orders;
-
-    std::vector<Node*> sorted = graph.GetTopologicallySortedNodes();
+    const GraphView view(graph);
+    std::vector<Node*> sorted = view.GetTopologicallySortedNodes();
 
     // find blocks to split
-    std::set<Node*> split_candidates = FindArticulationPoints(graph);
-    std::vector<Node*> splits;
+    const std::vector<bool> split_candidates = FindArticulationPoints(view);
+    std::vector<bool> is_split(sorted.size());
     std::vector<size_t> split_indices;
 
     int64_t sum = 0;
@@ -92,74 +113,84 @@ std::vector<Order> ChenPolicy(const Graph& graph) {
         for (const Value* output : node->outputs()) {
             consumption += output->GetNBytes();
         }
-        if (split_candidates.count(node) && sum + consumption > budget) {
-            splits.push_back(node);
+        if (split_candidates[view.NodeId(node)] && sum + consumption > budget) {
+            is_split[i] = true;
             split_indices.push_back(i);
             sum = 0;
         } else {
             sum += consumption;
         }
     }
-    for (auto s : splits) std::cout << "Split at " << s->ToString() << std::endl;
+    for (size_t i : split_indices) CLOG() << "Split at " << sorted[i]->ToString() << std::endl;
+
+    return GetSegmentedOrders(view, sorted, is_split, std::vector<bool>(view.num_values()));
+}
+
+std::vector<Order> GetSegmentedOrders(
+        const GraphView& view, const std::vector<Node*>& sorted, const std::vector<bool>& is_split, const std::vector<bool>& retained) {
+    std::vector<Order> orders;
+    std::vector<size_t> split_indices;
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        if (is_split[i]) split_indices.push_back(i);
+    }
 
     // Determine nodes that should be retained after forward propagation
-    std::map<Value*, size_t> generation;
+    std::vector<int> generation(view.num_values(), -1);
     {
-        size_t g = 0;
-        for (Node* node : sorted) {
-            for (Value* value : node->outputs()) {
-                CHECK(generation.count(value) == 0) << "Value has multiple parents?";
-                generation.emplace(value, g);
+        int g = 0;
+        for (size_t i = 0; i < sorted.size(); ++i) {
+            for (int value_id : view.outputs(view.NodeId(sorted[i]))) {
+                CHECK_EQ(-1, generation[value_id]) << "Value has multiple parents?";
+                generation[value_id] = g;
             }
-            if (g < splits.size() && splits[g] == node) {
+            if (is_split[i]) {
                 g++;
             }
         }
     }
-    std::set<Value*> must_remember;
+    std::vector<bool> must_remember(retained);
     {
-        size_t g = 0;
-        for (Node* node : sorted) {
-            for (Value* value : node->inputs()) {
-                auto it = generation.find(value);
-                if (it == generation.end()) {
-                    // input value
-                    must_remember.insert(value);
-                } else if (it->second != g) {
-                    // boundary value
-                    must_remember.insert(value);
-                }
+        int g = 0;
+        for (size_t i = 0; i < sorted.size(); ++i) {
+            for (int value_id : view.inputs(view.NodeId(sorted[i]))) {
+                // input value or boundary value
+                if (generation[value_id] != g) must_remember[value_id] = true;
             }
-            if (g < splits.size() && splits[g] == node) {
+            if (is_split[i]) {
                 g++;
             }
         }
     }
+    // Recomputation reproduces all outputs of a node, so they are
+    // remembered or forgotten together.
+    for (Node* node : sorted) {
+        const auto& outputs = view.outputs(view.NodeId(node));
+        if (std::any_of(outputs.begin(), outputs.end(), [&must_remember](int value_id) { return must_remember[value_id]; })) {
+            for (int value_id : outputs) must_remember[value_id] = true;
+        }
+    }
+    auto forget_outputs = [&view, &sorted, &must_remember, &orders](size_t begin, size_t end) {
+        for (size_t j = begin; j < end; ++j) {
+            for (int value_id : view.outputs(view.NodeId(sorted[j]))) {
+                if (!must_remember[value_id]) {
+                    orders.emplace_back(Order::kForgetForward, nullptr, view.value(value_id));
+                }
+            }
+        }
+    };
 
     // Perform forward propagation with forgetting
     size_t last_split = 0;
     for (size_t i = 0; i < sorted.size(); ++i) {
         Node* node = sorted[i];
         orders.emplace_back(Order::kComputeForward, node, nullptr);
-        if (std::count(splits.begin(), splits.end(), node) > 0) {
+        if (is_split[i]) {
             // split point -> perform forgetting
-            for (size_t j = last_split; j < i; ++j) {
-                for (Value* value : sorted[j]->outputs()) {
-                    if (!must_remember.count(value)) {
-                        orders.emplace_back(Order::kForgetForward, nullptr, value);
-                    }
-                }
-            }
+            forget_outputs(last_split, i);
             last_split = i + 1;
         }
     }
-    for (size_t j = last_split; j < sorted.size(); ++j) {
-        for (Value* value : sorted[j]->outputs()) {
-            if (!must_remember.count(value)) {
-                orders.emplace_back(Order::kForgetForward, nullptr, value);
-            }
-        }
-    }
+    forget_outputs(last_split, sorted.size());
 
     // now turn to backward computation
     size_t end_index = sorted.size();
@@ -169,8 +200,8 @@ std::vector<Order> ChenPolicy(const Graph& graph) {
         for (int64_t j = begin_index; j < end_index; ++j) {
             // recomputation for [begin_index, end_index)
             bool need_recompute = false;
-            for (Value* output : sorted[j]->outputs()) {
-                if (!must_remember.count(output)) {
+            for (int value_id : view.outputs(view.NodeId(sorted[j]))) {
+                if (!must_remember[value_id]) {
                     need_recompute = true;
                     break;
                 }
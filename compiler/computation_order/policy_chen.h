@@ -2,10 +2,28 @@
 
 #include "compiler/computation_order/core.h"
 
+#include <set>
 #include <vector>
 
 namespace chainer_compiler {
 
+class GraphView;
+
+// Returns live nodes whose removal splits the graph into more
+// connected components, regarding edges between nodes as undirected.
+std::set<Node*> FindArticulationPoints(const Graph& graph);
+// Same as above, but the result is indexed by node IDs of `view`.
+std::vector<bool> FindArticulationPoints(const GraphView& view);
+
 std::vector<Order> ChenPolicy(const Graph& graph);
 
+// Computes `sorted` forward, and then backward segment by segment in
+// the reverse order. A segment ends at each node marked by `is_split`.
+// Values used across segments or marked by `retained` (indexed by
+// value IDs of `view`) are kept after the forward computation. Other
+// values are forgotten and recomputed for the backward computation
+// of their segment.
+std::vector<Order> GetSegmentedOrders(
+        const GraphView& view, const std::vector<Node*>& sorted, const std::vector<bool>& is_split, const std::vector<bool>& retained);
+
 }  // namespace chainer_compiler
@@ -0,0 +1,166 @@
+#include <map>
+#include <memory>
+#include <numeric>
+#include <queue>
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <chainerx/testing/context_session.h>
+
+#include <compiler/onnx.h>
+
+#include <compiler/computation_order/policy_chen.h>
+#include <compiler/gradient.h>
+#include <compiler/graph.h>
+#include <compiler/graph_builder.h>
+#include <compiler/node.h>
+#include <compiler/tensor.h>
+#include <compiler/type.h>
+
+namespace chainer_compiler {
+namespace {
+
+// Removes each node in turn and checks if the rest is connected.
+std::set<Node*> FindArticulationPointsNaively(const Graph& graph) {
+    std::vector<Node*> nodes = graph.GetLiveNodes();
+    const size_t n = nodes.size();
+    std::map<Node*, size_t> node_ids;
+    for (size_t i = 0; i < n; ++i) {
+        node_ids.emplace(nodes[i], i);
+    }
+    std::vector<std::vector<size_t>> adj(n);
+    for (Node* node : nodes) {
+        for (Value* output : node->outputs()) {
+            for (Node* user : output->users()) {
+                size_t i = node_ids.at(node), j = node_ids.at(user);
+                adj[i].push_back(j);
+                adj[j].push_back(i);
+            }
+        }
+    }
+
+    std::set<Node*> articulation_points;
+    for (size_t i = 0; i < n; ++i) {
+        std::vector<size_t> visited(n);
+        std::queue<size_t> q;
+        q.push((i + 1) % n);
+        while (!q.empty()) {
+            size_t j = q.front();
+            q.pop();
+            if (visited[j]) continue;
+            visited[j] = 1;
+            for (size_t k : adj[j]) {
+                if (k == i || visited[k]) continue;
+                q.push(k);
+            }
+        }
+        if (std::accumulate(visited.begin(), visited.end(), 0UL) < n - 1) {
+            articulation_points.insert(nodes[i]);
+        }
+    }
+    return articulation_points;
+}
+
+Value* AddParam(Graph* graph, const std::string& name, const Type& type) {
+    onnx::TensorProto xtensor;
+    xtensor.set_name(name);
+    xtensor.set_data_type(onnx::TensorProto::FLOAT);
+    xtensor.add_dims(1);
+    xtensor.add_float_data(1.0);
+    Value* value = graph->AddInputValue(name, type);
+    value->ResetInitializer(std::make_unique<Tensor>(xtensor));
+    return value;
+}
+
+// out = (in0 + in1) * in2, as in GradientTest.Basic.
+std::unique_ptr<Graph> MakeSimpleGraph() {
+    const Type type(Dtype::kFloat32, {1});
+    std::unique_ptr<Graph> graph(new Graph("simple"));
+    Value* out = graph->AddOutputValue("out", type);
+    Value* in0 = AddParam(graph.get(), "in0", type);
+    Value* in1 = AddParam(graph.get(), "in1", type);
+    Value* in2 = AddParam(graph.get(), "in2", type);
+    Value* t0 = graph->AddValue("t0");
+    graph->AddNode(Node::kAdd, {in0, in1}, {t0});
+    graph->AddNode(Node::kMul, {t0, in2}, {out});
+    return graph;
+}
+
+// Residual blocks whose outputs are articulation points.
+std::unique_ptr<Graph> MakeResidualGraph(int num_blocks) {
+    const Type type(Dtype::kFloat32, {1});
+    std::unique_ptr<Graph> graph(new Graph("residual"));
+    Value* out = graph->AddOutputValue("out", type);
+    Value* x = AddParam(graph.get(), "x", type);
+    GraphBuilder gb(graph.get(), "Residual", out);
+    for (int i = 0; i < num_blocks; ++i) {
+        Value* h = gb.Op(Node::kMul, {x, AddParam(graph.get(), "w" + std::to_string(i), type)});
+        h = gb.Op(Node::kTanh, {h});
+        h = gb.Op(Node::kExp, {h});
+        x = gb.Op(Node::kAdd, {h, x});
+    }
+    gb.Op(Node::kNeg, {x}, out);
+    return graph;
+}
+
+TEST(ChenPolicyTest, FindArticulationPoints) {
+    chainerx::testing::ContextSession sess;
+
+    std::vector<std::unique_ptr<Graph>> graphs;
+    graphs.push_back(MakeSimpleGraph());
+    graphs.push_back(MakeSimpleGraph());
+    AddGradientNodesForTraining(graphs.back().get());
+    graphs.push_back(MakeResidualGraph(10));
+    graphs.push_back(MakeResidualGraph(10));
+    AddGradientNodesForTraining(graphs.back().get());
+
+    for (const std::unique_ptr<Graph>& graph : graphs) {
+        EXPECT_EQ(FindArticulationPointsNaively(*graph), FindArticulationPoints(*graph)) << graph->DebugString();
+    }
+
+    // The `Add` of each block, and `Tanh` and `Exp` in the first
+    // block which has no shortcut from the previous block.
+    EXPECT_EQ(10UL + 2UL, FindArticulationPoints(*graphs[2]).size());
+}
+
+TEST(ChenPolicyTest, Orders) {
+    chainerx::testing::ContextSession sess;
+
+    std::unique_ptr<Graph> graph(MakeResidualGraph(100));
+    std::vector<Order> orders = ChenPolicy(*graph);
+
+    std::map<Node*, int> num_forwards;
+    std::map<Node*, int> num_backwards;
+    int num_forgets = 0;
+    for (const Order& order : orders) {
+        switch (order.kind) {
+            case Order::kComputeForward:
+                ++num_forwards[order.node];
+                break;
+            case Order::kComputeBackward:
+                ++num_backwards[order.node];
+                break;
+            case Order::kForgetForward:
+                ++num_forgets;
+                break;
+            default:
+                FAIL() << order;
+        }
+    }
+
+    const std::vector<Node*> nodes = graph->GetLiveNodes();
+    ASSERT_EQ(nodes.size(), num_backwards.size());
+    for (Node* node : nodes) {
+        EXPECT_EQ(1, num_backwards[node]);
+        EXPECT_LE(1, num_forwards[node]);
+        EXPECT_GE(2, num_forwards[node]);
+    }
+    // Some values are forgotten and recomputed.
+    EXPECT_LT(0, num_forgets);
+    EXPECT_LT(nodes.size(), orders.size() - num_forgets - nodes.size());
+}
+
+}  // namespace
+}  // namespace chainer_compiler
@@ -0,0 +1,295 @@
+// Rematerialization under a memory budget. As Chen's policy, the
+// forward computation is split into segments at articulation points
+// and forgotten values are recomputed segment by segment in the
+// backward computation. Consecutive segments are grouped by dynamic
+// programming instead of a fixed size. All outputs of a group are
+// kept, or only ones used by later groups are kept and the others
+// are recomputed. The peak memory usage is estimated as
+//
+//   inputs + gradients of parameters + kept values + max(working sets)
+//
+// where the working set of a group is the values produced by it and
+// their gradients. For each cap of working sets, the constraint on
+// kept values is relaxed by a Lagrange multiplier (FLOPs per byte),
+// which is searched by bisection to minimize FLOPs of recomputation.
+#include "compiler/computation_order/policy_remat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <common/log.h>
+#include <compiler/computation_order/policy_chen.h>
+#include <compiler/flops.h>
+#include <compiler/graph.h>
+#include <compiler/graph_view.h>
+#include <compiler/log.h>
+#include <compiler/node.h>
+#include <compiler/value.h>
+
+namespace chainer_compiler {
+
+namespace {
+
+// A forward node. Its outputs are kept or recomputed together.
+struct NodeCost {
+    // The last segment which uses outputs of the node.
+    int last_use;
+    int64_t bytes;
+    int64_t flops;
+};
+
+// Segments in [begin, end).
+struct Group {
+    int begin;
+    int end;
+    bool keep_all;
+};
+
+struct Plan {
+    std::vector<Group> groups;
+    int64_t kept_bytes{0};
+    int64_t max_working_bytes{0};
+    int64_t recompute_flops{0};
+
+    int64_t bytes() const {
+        return kept_bytes + max_working_bytes;
+    }
+};
+
+class Planner {
+public:
+    explicit Planner(std::vector<std::vector<NodeCost>> segments) : segments_(std::move(segments)) {
+        for (const std::vector<NodeCost>& nodes : segments_) {
+            int64_t bytes = 0;
+            for (const NodeCost& node : nodes) {
+                bytes += node.bytes;
+                total_flops_ += node.flops;
+            }
+            produced_bytes_.push_back(bytes);
+            total_bytes_ += bytes;
+        }
+    }
+
+    int num_segments() const {
+        return segments_.size();
+    }
+
+    int64_t total_bytes() const {
+        return total_bytes_;
+    }
+
+    int64_t total_flops() const {
+        return total_flops_;
+    }
+
+    // A group which contains a segment needs at least its outputs.
+    int64_t GetMinWorkingBytes() const {
+        return produced_bytes_.empty() ? 0 : *std::max_element(produced_bytes_.begin(), produced_bytes_.end());
+    }
+
+    Plan KeepAll() const {
+        Plan plan;
+        for (int i = 0; i < num_segments(); ++i) {
+            plan.groups.push_back(Group{i, i + 1, true});
+        }
+        Evaluate(&plan);
+        return plan;
+    }
+
+    // Returns a plan which minimizes `recompute_flops + lambda *
+    // kept_bytes` among plans whose working sets are at most `cap`.
+    Plan Solve(int64_t cap, double lambda) const {
+        const int n = num_segments();
+        std::vector<double> costs(n + 1, std::numeric_limits<double>::infinity());
+        std::vector<Group> last_groups(n + 1);
+        costs[0] = 0;
+        for (int end = 1; end <= n; ++end) {
+            auto update = [&costs, &last_groups, end](int begin, bool keep_all, double cost) {
+                if (cost < costs[end]) {
+                    costs[end] = cost;
+                    last_groups[end] = Group{begin, end, keep_all};
+                }
+            };
+
+            if (produced_bytes_[end - 1] <= cap) {
+                update(end - 1, true, costs[end - 1] + lambda * produced_bytes_[end - 1]);
+            }
+
+            // Working sets only grow as the group is extended.
+            int64_t produced = 0;
+            int64_t forgotten = 0;
+            int64_t flops = 0;
+            for (int begin = end - 1; begin >= 0; --begin) {
+                for (const NodeCost& node : segments_[begin]) {
+                    produced += node.bytes;
+                    if (node.last_use < end) {
+                        forgotten += node.bytes;
+                        flops += node.flops;
+                    }
+                }
+                if (produced + forgotten > cap) break;
+                update(begin, false, costs[begin] + flops + lambda * (produced - forgotten));
+            }
+        }
+        CHECK_LT(costs[n], std::numeric_limits<double>::infinity()) << "Too small cap: " << cap;
+
+        Plan plan;
+        for (int end = n; end > 0; end = last_groups[end].begin) {
+            plan.groups.push_back(last_groups[end]);
+        }
+        std::reverse(plan.groups.begin(), plan.groups.end());
+        Evaluate(&plan);
+        return plan;
+    }
+
+private:
+    void Evaluate(Plan* plan) const {
+        for (const Group& group : plan->groups) {
+            int64_t produced = 0;
+            int64_t forgotten = 0;
+            for (int i = group.begin; i < group.end; ++i) {
+                for (const NodeCost& node : segments_[i]) {
+                    produced += node.bytes;
+                    if (!group.keep_all && node.last_use < group.end) {
+                        forgotten += node.bytes;
+                        plan->recompute_flops += node.flops;
+                    }
+                }
+            }
+            plan->kept_bytes += produced - forgotten;
+            plan->max_working_bytes = std::max(plan->max_working_bytes, produced + forgotten);
+        }
+    }
+
+    std::vector<std::vector<NodeCost>> segments_;
+    std::vector<int64_t> produced_bytes_;
+    int64_t total_bytes_{0};
+    int64_t total_flops_{0};
+};
+
+// Finds a plan which fits in `budget` with the minimum FLOPs of
+// recomputation, or the smallest plan if there is no such plan.
+Plan FindPlan(const Planner& planner, int64_t budget) {
+    Plan best = planner.KeepAll();
+    if (best.bytes() <= budget) return best;
+
+    // Any byte is more expensive than all recomputation.
+    const double max_lambda = planner.total_flops() + 1.0;
+    const double min_lambda = 1.0 / (planner.total_bytes() + 1.0);
+    const int kNumBisections = 24;
+    bool found = false;
+    // No plan with a larger cap fits in the budget, but larger caps
+    // may give smaller plans when the budget is too small.
+    const int64_t max_cap = planner.total_bytes() * 2;
+    for (int64_t cap = planner.GetMinWorkingBytes(); cap < budget || (!found && cap <= max_cap);
+         cap += std::max<int64_t>(cap / 2, 1)) {
+        Plan smallest = planner.Solve(cap, max_lambda);
+        if (smallest.bytes() > budget) {
+            if (!found && smallest.bytes() < best.bytes()) best = smallest;
+            continue;
+        }
+        if (!found || smallest.recompute_flops < best.recompute_flops) best = smallest;
+        found = true;
+
+        double lo = min_lambda;
+        double hi = max_lambda;
+        for (int i = 0; i < kNumBisections; ++i) {
+            const double lambda = std::sqrt(lo * hi);
+            Plan plan = planner.Solve(cap, lambda);
+            if (plan.bytes() <= budget) {
+                if (plan.recompute_flops < best.recompute_flops) best = plan;
+                hi = lambda;
+            } else {
+                lo = lambda;
+            }
+        }
+    }
+    return best;
+}
+
+int64_t GetNBytes(const Node& node) {
+    int64_t bytes = 0;
+    for (const Value* output : node.outputs()) {
+        bytes += std::max<int64_t>(0, output->GetNBytes());
+    }
+    return bytes;
+}
+
+}  // namespace
+
+std::vector<Order> RematPolicy(const Graph& graph, int64_t budget) {
+    const GraphView view(graph);
+    const std::vector<Node*> sorted = view.GetTopologicallySortedNodes();
+    if (sorted.empty()) return {};
+
+    // A segment ends at each articulation point.
+    const std::vector<bool> split_candidates = FindArticulationPoints(view);
+    std::vector<int> segment_ids(view.num_nodes(), -1);
+    std::vector<size_t> segment_ends;
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        const int node_id = view.NodeId(sorted[i]);
+        segment_ids[node_id] = segment_ends.size();
+        if (split_candidates[node_id] || i + 1 == sorted.size()) segment_ends.push_back(i);
+    }
+    const int num_segments = segment_ends.size();
+
+    std::vector<bool> is_output(view.num_values());
+    for (const Value* value : graph.output_values()) {
+        const int value_id = view.ValueId(value);
+        if (value_id >= 0) is_output[value_id] = true;
+    }
+
+    std::vector<std::vector<NodeCost>> segments(num_segments);
+    for (Node* node : sorted) {
+        const int node_id = view.NodeId(node);
+        int last_use = segment_ids[node_id];
+        for (int value_id : view.outputs(node_id)) {
+            if (is_output[value_id]) last_use = num_segments;
+            for (int user : view.users(value_id)) {
+                last_use = std::max(last_use, segment_ids[user]);
+            }
+        }
+        const int64_t bytes = GetNBytes(*node);
+        int64_t flops = CalculateFlops(*node);
+        // Assume an operation per byte for unknown ops.
+        if (flops < 0) flops = bytes;
+        segments[segment_ids[node_id]].push_back(NodeCost{last_use, bytes, flops});
+    }
+
+    int64_t fixed_bytes = 0;
+    for (const Value* value : graph.input_values()) {
+        const int64_t bytes = std::max<int64_t>(0, value->GetNBytes());
+        fixed_bytes += value->initializer() ? bytes * 2 : bytes;
+    }
+
+    const Planner planner(std::move(segments));
+    const Plan plan = FindPlan(planner, budget - fixed_bytes);
+    CLOG() << "Remat: budget=" << budget / 1000000 << "MB estimated=" << (fixed_bytes + plan.bytes()) / 1000000
+           << "MB kept=" << plan.kept_bytes / 1000000 << "MB working=" << plan.max_working_bytes / 1000000
+           << "MB groups=" << plan.groups.size() << " recompute_flops=" << plan.recompute_flops << "/" << planner.total_flops()
+           << std::endl;
+    if (fixed_bytes + plan.bytes() > budget) {
+        WARN_ONCE(
+                "Memory budget of the remat policy is too small: " << budget / 1000000 << "MB < "
+                                                                   << (fixed_bytes + plan.bytes()) / 1000000 << "MB");
+    }
+
+    std::vector<bool> is_split(sorted.size());
+    std::vector<bool> retained(is_output);
+    for (const Group& group : plan.groups) {
+        if (group.end < num_segments) is_split[segment_ends[group.end - 1]] = true;
+        if (!group.keep_all) continue;
+        const size_t begin = group.begin ? segment_ends[group.begin - 1] + 1 : 0;
+        for (size_t i = begin; i <= segment_ends[group.end - 1]; ++i) {
+            for (int value_id : view.outputs(view.NodeId(sorted[i]))) {
+                retained[value_id] = true;
+            }
+        }
+    }
+    return GetSegmentedOrders(view, sorted, is_split, retained);
+}
+
+}  // namespace chainer_compiler
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "compiler/computation_order/core.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+namespace chainer_compiler {
+
+// Chooses forward values to be forgotten and recomputed so that the
+// estimated peak memory usage of training fits in `budget` bytes with
+// the minimum FLOPs of recomputation.
+std::vector<Order> RematPolicy(const Graph& graph, int64_t budget);
+
+}  // namespace chainer_compiler
@@ -0,0 +1,94 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <chainerx/testing/context_session.h>
+
+#include <compiler/onnx.h>
+
+#include <common/strutil.h>
+#include <compiler/computation_order/policy_remat.h>
+#include <compiler/gradient_with_order.h>
+#include <compiler/graph.h>
+#include <compiler/graph_builder.h>
+#include <compiler/memory_simulator.h>
+#include <compiler/node.h>
+#include <compiler/tensor.h>
+#include <compiler/type.h>
+
+namespace chainer_compiler {
+namespace {
+
+const int64_t kBatchSize = 4;
+const int64_t kHidden = 256;
+
+// Residual blocks of elementwise ops with a loss.
+std::unique_ptr<Graph> MakeResidualGraph(int num_blocks) {
+    const Type type(Dtype::kFloat32, {kBatchSize, kHidden});
+    std::unique_ptr<Graph> graph(new Graph("residual"));
+    Value* x = graph->AddInputValue("x", type);
+    Value* loss = graph->AddOutputValue("loss", Type(Dtype::kFloat32, {}));
+    GraphBuilder gb(graph.get(), "Residual", loss);
+    for (int i = 0; i < num_blocks; ++i) {
+        onnx::TensorProto xtensor;
+        xtensor.set_data_type(onnx::TensorProto::FLOAT);
+        xtensor.add_dims(kHidden);
+        for (int j = 0; j < kHidden; ++j) xtensor.add_float_data(0.1);
+        Value* w = graph->AddInputValue(StrCat("w", i), Type(Dtype::kFloat32, {kHidden}));
+        w->ResetInitializer(std::make_unique<Tensor>(xtensor));
+
+        Value* h = gb.Op(Node::kMul, {x, w}, gb.Temp(type));
+        h = gb.Op(Node::kTanh, {h}, gb.Temp(type));
+        h = gb.Op(Node::kSigmoid, {h}, gb.Temp(type));
+        x = gb.Op(Node::kAdd, {h, x}, gb.Temp(type));
+    }
+    gb.Op(Node::kReduceSum, {x}, loss)->producer()->set_keepdims(false);
+    return graph;
+}
+
+struct RematResult {
+    int64_t peak;
+    int num_forgets;
+    int num_forwards;
+};
+
+RematResult RunRemat(int64_t budget) {
+    std::unique_ptr<Graph> graph(MakeResidualGraph(30));
+    const std::vector<Order> orders = RematPolicy(*graph, budget);
+    RematResult result{};
+    for (const Order& order : orders) {
+        if (order.kind == Order::kForgetForward) ++result.num_forgets;
+        if (order.kind == Order::kComputeForward) ++result.num_forwards;
+    }
+    EXPECT_TRUE(AddGradientNodesForTrainingWithOrders(graph.get(), orders));
+    result.peak = SimulateMemoryUsage(*graph).peak;
+    return result;
+}
+
+TEST(RematPolicyTest, Budget) {
+    chainerx::testing::ContextSession sess;
+
+    const int num_nodes = 30 * 4 + 1;
+    const RematResult keep_all = RunRemat(1LL << 40);
+    EXPECT_EQ(0, keep_all.num_forgets);
+    EXPECT_EQ(num_nodes, keep_all.num_forwards);
+
+    for (int percent : {80, 60, 50}) {
+        SCOPED_TRACE(percent);
+        const int64_t budget = keep_all.peak * percent / 100;
+        const RematResult result = RunRemat(budget);
+        EXPECT_LE(result.peak, budget);
+        EXPECT_LT(0, result.num_forgets);
+        EXPECT_LT(num_nodes, result.num_forwards);
+        EXPECT_GT(num_nodes * 2, result.num_forwards);
+    }
+
+    // The smallest plan is used for a too small budget.
+    const RematResult smallest = RunRemat(keep_all.peak / 10);
+    EXPECT_GT(keep_all.peak, smallest.peak);
+}
+
+}  // namespace
+}  // namespace chainer_compiler
@@ -1,7 +1,11 @@
 #include "compiler/constant_propagation.h"
 
+#include <map>
+#include <queue>
+#include <set>
 #include <vector>
 
+#include <common/log.h>
 #include <compiler/evaluator.h>
 #include <compiler/graph.h>
 #include <compiler/graph_builder.h>
@@ -14,100 +18,205 @@ namespace chainer_compiler {
 
 namespace {
 
-bool HasConstantInputsOnly(const Node& node) {
-    if (node.inputs().empty()) return false;
-    for (Value* input : node.inputs()) {
-        if (input->producer() &&
-            (input->producer()->op_type() == Node::kConstant || input->producer()->op_type() == Node::kChainerSequenceConstants)) {
-        } else {
-            return false;
-        }
-    }
-    return true;
-}
-
-void DoConstantPropagation(Graph* graph, Node* node) {
-    CLOG() << "Propagate " << node->ToString() << std::endl;
-    std::vector<Node*> inputs;
-    std::set<Value*> seen_inputs;
-    for (Value* input : node->inputs()) {
-        if (seen_inputs.insert(input).second) {
-            inputs.push_back(input->producer());
-        }
-    }
-
-    std::vector<std::unique_ptr<EvaluatedValue>> next_values;
-    std::vector<Node*> nodes = inputs;
-    nodes.push_back(node);
-    Eval(nodes, node->outputs(), &next_values);
-
-    for (size_t i = 0; i < next_values.size(); ++i) {
-        auto& next_value = next_values[i];
-        GraphBuilder gb(graph, "Const", node->output(i));
-        if (next_value->is_tensor()) {
-            gb.Op(Node::kConstant, {}, node->output(i))->producer()->set_tensor_value(next_value->ReleaseTensor());
-        } else {
-            gb.Op(Node::kChainerSequenceConstants, {}, node->output(i))->producer()->set_tensor_values(next_value->ReleaseSequence());
-        }
-    }
-
-    graph->DetachNode(node);
-    for (Node* input : inputs) {
-        Value* output = input->output(0);
-        // Detach node if the value is not uesd by other ops nor a
-        // graph output.
-        if (output->users().empty() && !output->IsOutput()) {
-            graph->DetachNode(input);
-        }
-    }
+bool IsConstant(const Node& node) {
+    return node.op_type() == Node::kConstant || node.op_type() == Node::kChainerSequenceConstants;
 }
 
-bool MaybePropagateConstant(Graph* graph, Node* node) {
-    switch (node->op_type()) {
-        // TODO(hamaji): Handle more ops.
+bool IsFoldable(const Node& node) {
+    switch (node.op_type()) {
+        case Node::kAbs:
         case Node::kAdd:
+        case Node::kAnd:
         case Node::kCast:
+        case Node::kCeil:
         case Node::kChainerGenericIs:
         case Node::kChainerGenericLen:
         case Node::kChainerSequenceAppend:
         case Node::kChainerSequenceConcat:
         case Node::kChainerSequenceCreate:
+        case Node::kChainerSequenceLookup:
         case Node::kChainerSequenceRange:
+        case Node::kChainerSequenceSize:
         case Node::kChainerSequenceStack:
         case Node::kConcat:
         case Node::kDiv:
+        case Node::kEqual:
         case Node::kExpand:
+        case Node::kFloor:
         case Node::kGather:
+        case Node::kGreater:
         case Node::kIdentity:
+        case Node::kMax:
+        case Node::kMin:
         case Node::kMul:
+        case Node::kNeg:
+        case Node::kNot:
+        case Node::kOr:
+        case Node::kReduceMax:
+        case Node::kReduceMean:
+        case Node::kReduceSum:
+        case Node::kReduceSumSquare:
+        case Node::kReshape:
         case Node::kShape:
+        case Node::kSize:
         case Node::kSlice:
+        case Node::kSqueeze:
         case Node::kSub:
         case Node::kTranspose:
-        case Node::kUnsqueeze: {
-            DoConstantPropagation(graph, node);
+        case Node::kUnsqueeze:
+        case Node::kWhere:
             return true;
-        }
 
         default:
-            CLOG() << "Not propagate " << node->ToString() << std::endl;
+            return false;
     }
-    return false;
 }
 
-}  // namespace
+// Finds foldable nodes whose inputs are all constants or outputs of
+// other foldable nodes. The result is topologically sorted.
+std::vector<Node*> FindFoldableNodes(Graph* graph) {
+    std::set<Value*> constants;
+    std::set<Node*> queued;
+    std::queue<Value*> q;
+    for (Node* node : graph->nodes()) {
+        if (node->detached() || !IsConstant(*node)) continue;
+        for (Value* output : node->outputs()) {
+            if (constants.insert(output).second) q.push(output);
+        }
+    }
 
-void PropagateConstants(Graph* graph) {
-    bool replaced = true;
-    while (replaced) {
-        replaced = false;
-        for (Node* node : graph->GetLiveNodes()) {
-            if (!HasConstantInputsOnly(*node)) continue;
-            if (MaybePropagateConstant(graph, node)) {
-                replaced = true;
+    std::vector<Node*> foldable;
+    while (!q.empty()) {
+        Value* value = q.front();
+        q.pop();
+        for (Node* user : value->users()) {
+            if (user->detached() || !IsFoldable(*user) || queued.count(user)) continue;
+            bool ready = true;
+            for (Value* input : user->inputs()) {
+                if (!constants.count(input)) {
+                    ready = false;
+                    break;
+                }
             }
+            if (!ready) continue;
+
+            queued.insert(user);
+            foldable.push_back(user);
+            for (Value* output : user->outputs()) {
+                if (!output->IsNull() && constants.insert(output).second) q.push(output);
+            }
+        }
+    }
+    return foldable;
+}
+
+Node* FindRoot(std::map<Node*, Node*>* parents, Node* node) {
+    Node* root = node;
+    while ((*parents)[root] != root) root = (*parents)[root];
+    while (node != root) {
+        Node* next = (*parents)[node];
+        (*parents)[node] = root;
+        node = next;
+    }
+    return root;
+}
+
+// Splits `foldable` into connected components. Each component keeps
+// the topological order of `foldable`.
+std::vector<std::vector<Node*>> GroupConnectedNodes(const std::vector<Node*>& foldable) {
+    std::map<Node*, Node*> parents;
+    for (Node* node : foldable) parents.emplace(node, node);
+    for (Node* node : foldable) {
+        for (Value* input : node->inputs()) {
+            Node* producer = input->producer();
+            if (!parents.count(producer)) continue;
+            Node* a = FindRoot(&parents, node);
+            Node* b = FindRoot(&parents, producer);
+            if (a != b) parents[a] = b;
         }
     }
+
+    std::map<Node*, size_t> component_ids;
+    std::vector<std::vector<Node*>> components;
+    for (Node* node : foldable) {
+        Node* root = FindRoot(&parents, node);
+        auto inserted = component_ids.emplace(root, components.size());
+        if (inserted.second) components.emplace_back();
+        components[inserted.first->second].push_back(node);
+    }
+    return components;
+}
+
+void FoldComponent(Graph* graph, const std::vector<Node*>& component, ConstantPropagationStats* stats) {
+    const std::set<Node*> members(component.begin(), component.end());
+
+    std::vector<Node*> inputs;
+    std::set<Node*> seen_inputs;
+    std::vector<Value*> fetches;
+    for (Node* node : component) {
+        CLOG() << "Propagate " << node->ToString() << std::endl;
+        for (Value* input : node->inputs()) {
+            Node* producer = input->producer();
+            if (!members.count(producer) && seen_inputs.insert(producer).second) {
+                inputs.push_back(producer);
+            }
+        }
+        for (Value* output : node->outputs()) {
+            if (output->IsNull()) continue;
+            bool used_outside = output->IsOutput();
+            for (Node* user : output->users()) {
+                if (!members.count(user)) used_outside = true;
+            }
+            if (used_outside) fetches.push_back(output);
+        }
+    }
+
+    if (!fetches.empty()) {
+        std::vector<Node*> nodes = inputs;
+        nodes.insert(nodes.end(), component.begin(), component.end());
+        std::vector<std::unique_ptr<EvaluatedValue>> next_values;
+        Eval(nodes, fetches, &next_values);
+        ++stats->num_evals;
+        CHECK_EQ(fetches.size(), next_values.size());
+
+        for (size_t i = 0; i < next_values.size(); ++i) {
+            auto& next_value = next_values[i];
+            GraphBuilder gb(graph, "Const", fetches[i]);
+            if (next_value->is_tensor()) {
+                gb.Op(Node::kConstant, {}, fetches[i])->producer()->set_tensor_value(next_value->ReleaseTensor());
+            } else {
+                gb.Op(Node::kChainerSequenceConstants, {}, fetches[i])->producer()->set_tensor_values(next_value->ReleaseSequence());
+            }
+        }
+    }
+
+    for (Node* node : component) {
+        graph->DetachNode(node);
+    }
+    stats->num_folded_nodes += component.size();
+
+    for (Node* input : inputs) {
+        Value* output = input->output(0);
+        // Detach node if the value is not uesd by other ops nor a
+        // graph output.
+        if (output->users().empty() && !output->IsOutput()) {
+            graph->DetachNode(input);
+        }
+    }
+}
+
+}  // namespace
+
+ConstantPropagationStats PropagateConstants(Graph* graph) {
+    ConstantPropagationStats stats;
+    for (const std::vector<Node*>& component : GroupConnectedNodes(FindFoldableNodes(graph))) {
+        FoldComponent(graph, component, &stats);
+    }
+    if (stats.num_folded_nodes) {
+        CLOG() << "Constant propagation: folded " << stats.num_folded_nodes << " nodes with " << stats.num_evals << " evaluations"
+               << std::endl;
+    }
+    return stats;
 }
 
 }  // namespace chainer_compiler
@@ -4,6 +4,13 @@ namespace chainer_compiler {
 
 class Graph;
 
-void PropagateConstants(Graph* graph);
+struct ConstantPropagationStats {
+    int num_folded_nodes{0};
+    int num_evals{0};
+};
+
+// Replaces maximal subgraphs whose inputs are all constants by their
+// values. Each subgraph is evaluated by a single `Eval` call.
+ConstantPropagationStats PropagateConstants(Graph* graph);
 
 }  // namespace chainer_compiler
@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <chainerx/testing/context_session.h>
+
+#include <compiler/constant_propagation.h>
+#include <compiler/graph.h>
+#include <compiler/graph_builder.h>
+#include <compiler/tensor.h>
+#include <compiler/value.h>
+
+namespace chainer_compiler {
+namespace {
+
+TEST(ConstantPropagationTest, FoldSubgraphs) {
+    chainerx::testing::ContextSession sess;
+
+    Graph graph("test");
+    Value* x = graph.AddInputValue("x", Type(Dtype::kFloat32, {2, 6}));
+    Value* y = graph.AddOutputValue("y", Type(Dtype::kFloat32, {3, 4}));
+    Value* shape;
+    Value* scale;
+    {
+        GraphBuilder gb(&graph, "test", y);
+        // Add => Cast => Reshape, which is evaluated at once.
+        Value* a = gb.Const(Type(Dtype::kInt32, {2}), {2, 3});
+        Value* b = gb.Const(Type(Dtype::kInt32, {2}), {1, 1});
+        Value* sum = gb.Op(Node::kAdd, {a, b});
+        shape = gb.Op(Node::kCast, {sum});
+        shape->producer()->set_to(Dtype::kInt64);
+        Value* reshaped = gb.Op(Node::kReshape, {x, shape});
+        // Another subgraph which is independent from the above.
+        Value* c = gb.Const(Type(Dtype::kFloat32, {}), {2.0});
+        scale = gb.Op(Node::kNeg, {c});
+        gb.Op(Node::kMul, {reshaped, scale}, y);
+    }
+
+    ConstantPropagationStats stats = PropagateConstants(&graph);
+    EXPECT_EQ(3, stats.num_folded_nodes);
+    EXPECT_EQ(2, stats.num_evals);
+
+    std::vector<Node::OpType> ops;
+    for (Node* node : graph.GetTopologicallySortedNodes()) {
+        ops.push_back(node->op_type());
+    }
+    EXPECT_EQ(4UL, ops.size());
+    EXPECT_EQ(2, std::count(ops.begin(), ops.end(), Node::kConstant));
+
+    ASSERT_EQ(Node::kConstant, shape->producer()->op_type());
+    const Tensor& shape_value = *shape->producer()->tensor_value();
+    EXPECT_EQ(Dtype::kInt64, shape_value.dtype());
+    ASSERT_EQ(2, shape_value.NumElements());
+    EXPECT_EQ(3, shape_value.Get<int64_t>(0));
+    EXPECT_EQ(4, shape_value.Get<int64_t>(1));
+
+    ASSERT_EQ(Node::kConstant, scale->producer()->op_type());
+    EXPECT_EQ(-2.0, scale->producer()->tensor_value()->Get<float>(0));
+}
+
+}  // namespace
+}  // namespace chainer_compiler
@@ -100,6 +100,7 @@ void InferDtype(Node* node) {
         case Node::kConcat:
         case Node::kMatMul:
         case Node::kGemm:
+        case Node::kChainerGemmBiasActivation:
         case Node::kChainerLinear:
         case Node::kChainerLinearGradWeight: {
             set(0, coerce());
@@ -7,6 +7,7 @@ bool g_compiler_log;
 bool g_permissive;
 
 bool g_skip_inference;
+bool g_onnx_shape_inference;
 
 bool g_use_cuda;
 
@@ -14,6 +15,8 @@ bool g_fuse_operations;
 
 bool g_use_nvrtc;
 
+bool g_use_native_jit;
+
 bool g_use_tvm;
 
 bool g_reuse_tvm_code;
@@ -47,7 +50,17 @@ bool g_dump_after_fusion;
 bool g_dump_after_scheduling;
 bool g_dump_subgraphs;
 
+bool g_static_memory_plan;
+
+bool g_skip_chxvm_peephole;
+
+std::string g_scheduler;
+int g_scheduler_beam_width;
+int g_scheduler_time_budget;
+int g_scheduler_num_workers;
+
 std::string g_computation_order;
 int g_chen_budget;
+int g_remat_budget;
 
 }  // namespace chainer_compiler
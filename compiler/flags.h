@@ -14,6 +14,10 @@ extern bool g_permissive;
 // Skip dtype/shape inference.
 extern bool g_skip_inference;
 
+// Infer shapes by ONNX's shape inference on the whole graph instead
+// of the native one.
+extern bool g_onnx_shape_inference;
+
 // Use CUDA specific ops.
 extern bool g_use_cuda;
 
@@ -23,6 +27,9 @@ extern bool g_fuse_operations;
 // Use NVRTC to execute fused operations.
 extern bool g_use_nvrtc;
 
+// Use the system C++ compiler to execute fused operations on CPU.
+extern bool g_use_native_jit;
+
 // Use TVM to execute operations.
 extern bool g_use_tvm;
 
@@ -70,8 +77,27 @@ extern bool g_dump_after_fusion;
 extern bool g_dump_after_scheduling;
 extern bool g_dump_subgraphs;
 
+// Place statically shaped outputs in a preallocated arena.
+extern bool g_static_memory_plan;
+
+// Do not run peephole optimizations on emitted ChxVM programs.
+extern bool g_skip_chxvm_peephole;
+
+// The scheduler of nodes ("greedy", "min_peak", or "critical_path").
+// The greedy scheduler is used when empty.
+extern std::string g_scheduler;
+// The beam width and the time budget (in msec) of the min_peak
+// scheduler. Default values are used for zeros.
+extern int g_scheduler_beam_width;
+extern int g_scheduler_time_budget;
+// The number of nodes which run in parallel in each stage by the
+// critical_path scheduler. Stages are not limited for zero.
+extern int g_scheduler_num_workers;
+
 // The policy of computation order.
 extern std::string g_computation_order;
 extern int g_chen_budget;
+// The peak memory budget (in MB) of the remat policy.
+extern int g_remat_budget;
 
 }  // namespace chainer_compiler
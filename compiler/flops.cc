@@ -11,7 +11,7 @@ namespace {
 
 bool HasKnownInOuts(const Node& node) {
     for (Value* value : node.inputs()) {
-        if (!value->type().HasKnownShape()) {
+        if (!value->IsNull() && !value->type().HasKnownShape()) {
             return false;
         }
     }
@@ -124,6 +124,9 @@ int64_t CalculateFlopsImpl(const Node& node) {
         case Node::kGemm:
             return CalculateFlopsOfGemm(node);
 
+        case Node::kChainerGemmBiasActivation:
+            return CalculateFlopsOfGemm(node) + OutputSize(node);
+
         case Node::kChainerFusionGroup:
             CHECK(false);
 
@@ -139,6 +142,15 @@ int64_t CalculateFlopsImpl(const Node& node) {
         case Node::kConv:
             return CalculateFlopsOfConv(node);
 
+        case Node::kChainerConvBiasActivation: {
+            // The activation and additions of the bias and the residual.
+            int64_t num_epilogue_ops = 1;
+            for (size_t i = 2; i < node.inputs().size(); ++i) {
+                if (!node.input(i)->IsNull()) ++num_epilogue_ops;
+            }
+            return CalculateFlopsOfConv(node) + num_epilogue_ops * OutputSize(node);
+        }
+
         case Node::kConvTranspose:
             return CalculateFlopsOfConvTranspose(node);
 
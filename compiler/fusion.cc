@@ -13,6 +13,7 @@
 #include <compiler/flags.h>
 #include <compiler/graph.h>
 #include <compiler/graph_builder.h>
+#include <compiler/graph_view.h>
 #include <compiler/node.h>
 #include <compiler/topology.h>
 #include <compiler/value.h>
@@ -21,38 +22,27 @@ namespace chainer_compiler {
 
 namespace {
 
-void RejectCyclicNodes(std::set<Node*>* cands) {
-    std::stack<Node*> q;
+// Rejects candidates which are reachable from nodes outside
+// candidates which use outputs of candidates, since fusing them
+// makes a cycle.
+void RejectCyclicNodes(const GraphView& view, ReachabilityIndex* reachability, std::set<Node*>* cands) {
+    std::vector<int> cand_ids;
     for (Node* node : *cands) {
-        for (Value* output : node->outputs()) {
-            for (Node* n : output->users()) {
-                if (!cands->count(n)) q.push(n);
-            }
-        }
+        cand_ids.push_back(view.NodeId(node));
     }
 
-    std::set<Node*> rejected;
-    std::set<Node*> seen;
-
-    while (!q.empty()) {
-        Node* node = q.top();
-        q.pop();
-        if (!seen.emplace(node).second) continue;
-        if (cands->count(node)) {
-            rejected.insert(node);
-        }
-
-        // TODO(hamaji): Optimize this algorithm by pre-calculating
-        // the max distance from the input for all nodes.
-
-        for (Value* output : node->outputs()) {
-            for (Node* n : output->users()) {
-                q.push(n);
+    std::vector<int> sources;
+    for (int node_id : cand_ids) {
+        for (int value_id : view.outputs(node_id)) {
+            for (int user : view.users(value_id)) {
+                if (!cands->count(view.node(user))) sources.push_back(user);
             }
         }
     }
 
-    for (Node* node : rejected) cands->erase(node);
+    for (int node_id : reachability->FindReachableTargets(sources, cand_ids)) {
+        cands->erase(view.node(node_id));
+    }
 }
 
 void RejectUnusedConstants(std::set<Node*>* cands) {
@@ -76,16 +66,21 @@ void RejectUnusedConstants(std::set<Node*>* cands) {
     for (Node* node : rejected) cands->erase(node);
 }
 
-}  // namespace
-
-void CreateFusionGroup(
-        Graph* graph, const std::set<Node*>& nodes, const std::string& fusion_type, int fusion_group_id, bool can_fuse_initializers) {
+// Same as `CreateFusionGroup` but nodes are not moved to the
+// subgraph yet. Returns false if no fusion group is created.
+bool CreateFusionGroupWithoutMigration(
+        Graph* graph,
+        const std::set<Node*>& nodes,
+        const std::string& fusion_type,
+        int fusion_group_id,
+        bool can_fuse_initializers,
+        Graph::Migration* migration) {
     std::vector<Value*> inputs;
     std::vector<Value*> outputs;
     std::vector<Value*> temps;
     ClassifyValues(std::vector<Node*>(nodes.begin(), nodes.end()), &inputs, &outputs, &temps);
     if (inputs.empty() || outputs.empty()) {
-        return;
+        return false;
     }
 
     GraphBuilder gb(graph, StrCat("Fusion", fusion_group_id), outputs.front());
@@ -133,7 +128,7 @@ void CreateFusionGroup(
     }
 
     Node* fused = gb.MOp(Node::kChainerFusionGroup, subgraph_inputs, outputs);
-    graph->MigrateNodes({nodes.begin(), nodes.end()}, temps, subgraph);
+    *migration = {{nodes.begin(), nodes.end()}, temps, subgraph};
     fused->set_subgraph(subgraph);
     fused->set_fusion_type(fusion_type);
     fused->set_chainer_fusion_group(fusion_group_id);
@@ -151,42 +146,67 @@ void CreateFusionGroup(
         }
     }
 #endif
+    return true;
+}
+
+}  // namespace
+
+void CreateFusionGroup(
+        Graph* graph, const std::set<Node*>& nodes, const std::string& fusion_type, int fusion_group_id, bool can_fuse_initializers) {
+    Graph::Migration migration;
+    if (CreateFusionGroupWithoutMigration(graph, nodes, fusion_type, fusion_group_id, can_fuse_initializers, &migration)) {
+        graph->MigrateNodes({migration});
+    }
 }
 
 void FuseAllConnectedNodes(
         const char* name, Graph* graph, int min_fuse_ops, bool can_fuse_initializers, const std::function<bool(const Node&)>& is_fusable) {
     int num_fusion_groups = 0;
-    const std::vector<Node*> all_nodes(graph->nodes());
-    for (Node* base_node : all_nodes) {
+    // Nodes are moved to subgraphs at once in the end.
+    std::vector<Graph::Migration> migrations;
+    // Fused nodes are marked by `chainer_fusion_group` and never
+    // visited again, so the view of the original graph can be used
+    // after fusion groups are created. The reachability index treats
+    // each fusion group as a single node.
+    const GraphView view(*graph);
+    ReachabilityIndex reachability(view);
+    // The last base node which visited each node.
+    std::vector<int> visited(view.num_nodes(), -1);
+    for (int base_id = 0; base_id < view.num_nodes(); ++base_id) {
+        Node* base_node = view.node(base_id);
         if (base_node->chainer_fusion_group()) continue;
         if (!is_fusable(*base_node)) continue;
 
+        auto can_fuse = [&view, &is_fusable, base_node](int node_id) {
+            const Node& node = *view.node(node_id);
+            return !node.chainer_fusion_group() && is_fusable(node) && base_node->IsGradNode() == node.IsGradNode();
+        };
+
         std::set<Node*> cands;
-        std::stack<Node*> q;
-        q.push(base_node);
+        std::stack<int> q;
+        q.push(base_id);
         while (!q.empty()) {
-            Node* node = q.top();
-            CHECK_EQ(0, node->chainer_fusion_group());
+            const int node_id = q.top();
             q.pop();
-            if (!cands.emplace(node).second) continue;
-
-            for (Value* value : node->inputs()) {
-                Node* next_node = value->producer();
-                if (!next_node) continue;
-                if (!is_fusable(*next_node)) continue;
-                if (base_node->IsGradNode() != next_node->IsGradNode()) continue;
-                q.push(next_node);
+            if (visited[node_id] == base_id) continue;
+            visited[node_id] = base_id;
+            cands.insert(view.node(node_id));
+
+            for (int value_id : view.inputs(node_id)) {
+                const int next_id = view.producer(value_id);
+                if (next_id < 0) continue;
+                if (!can_fuse(next_id)) continue;
+                q.push(next_id);
             }
-            for (Value* value : node->outputs()) {
-                for (Node* next_node : value->users()) {
-                    if (!is_fusable(*next_node)) continue;
-                    if (base_node->IsGradNode() != next_node->IsGradNode()) continue;
-                    q.push(next_node);
+            for (int value_id : view.outputs(node_id)) {
+                for (int next_id : view.users(value_id)) {
+                    if (!can_fuse(next_id)) continue;
+                    q.push(next_id);
                 }
             }
         }
 
-        RejectCyclicNodes(&cands);
+        RejectCyclicNodes(view, &reachability, &cands);
         RejectUnusedConstants(&cands);
 
         int num_calculation = 0;
@@ -196,12 +216,19 @@ void FuseAllConnectedNodes(
         if (num_calculation < min_fuse_ops) continue;
 
         ++num_fusion_groups;
+        std::vector<int> fused_ids;
         for (Node* node : cands) {
             node->set_chainer_fusion_group(num_fusion_groups);
+            fused_ids.push_back(view.NodeId(node));
         }
+        reachability.Merge(fused_ids);
 
-        CreateFusionGroup(graph, cands, name, num_fusion_groups, can_fuse_initializers);
+        Graph::Migration migration;
+        if (CreateFusionGroupWithoutMigration(graph, cands, name, num_fusion_groups, can_fuse_initializers, &migration)) {
+            migrations.push_back(migration);
+        }
     }
+    graph->MigrateNodes(migrations);
 }
 
 void FuseOperations(Graph* graph) {
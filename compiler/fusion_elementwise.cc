@@ -1,15 +1,57 @@
 #include <set>
+#include <vector>
 
+#include <compiler/flags.h>
 #include <compiler/fusion.h>
 #include <compiler/graph.h>
+#include <compiler/graph_builder.h>
 #include <compiler/node.h>
+#include <compiler/nvrtc_builder.h>
+#include <compiler/type.h>
 #include <compiler/value.h>
 
 namespace chainer_compiler {
 
+namespace {
+
+// Replaces Softmax and LogSoftmax along the last axis by reductions
+// and element-wise operations so the native JIT can fuse them.
+void DecomposeSoftmax(Graph* graph) {
+    for (Node* node : graph->GetLiveNodes()) {
+        if (node->op_type() != Node::kSoftmax && node->op_type() != Node::kLogSoftmax) continue;
+        const Type& type = node->input(0)->type();
+        if (!type.HasKnownShape() || type.ndim() == 0) continue;
+        if (type.dtype() != Dtype::kFloat32 && type.dtype() != Dtype::kFloat64) continue;
+        const int64_t last_axis = type.ndim() - 1;
+        if (node->axis() != -1 && node->axis() != last_axis) continue;
+
+        std::vector<int64_t> row_dims = type.dims();
+        row_dims.back() = 1;
+        const Type row_type(type.dtype(), row_dims);
+
+        GraphBuilder gb(graph, "DecomposeSoftmax", node->output(0));
+        Value* x = node->input(0);
+        Value* max = gb.Op(Node::kReduceMax, {x}, gb.Temp(row_type));
+        max->producer()->set_axes({last_axis})->set_keepdims(true);
+        Value* shifted = gb.Op(Node::kSub, {x, max}, gb.Temp(type));
+        Value* exp = gb.Op(Node::kExp, {shifted}, gb.Temp(type));
+        Value* sum = gb.Op(Node::kReduceSum, {exp}, gb.Temp(row_type));
+        sum->producer()->set_axes({last_axis})->set_keepdims(true);
+        if (node->op_type() == Node::kSoftmax) {
+            gb.Op(Node::kDiv, {exp, sum}, node->output(0));
+        } else {
+            Value* log_sum = gb.Op(Node::kLog, {sum}, gb.Temp(row_type));
+            gb.Op(Node::kSub, {shifted, log_sum}, node->output(0));
+        }
+        graph->DetachNode(node);
+    }
+}
+
+}  // namespace
+
 void FuseElementwiseOperations(Graph* graph) {
     // TODO(hamaji): Do not try fusing integer ops.
-    const std::set<Node::OpType> fusable_ops = {
+    std::set<Node::OpType> fusable_ops = {
             Node::kIdentity,
             Node::kAdd,
             Node::kSub,
@@ -19,24 +61,33 @@ void FuseElementwiseOperations(Graph* graph) {
             Node::kSigmoid,
             Node::kExp,
     };
+    if (g_use_native_jit) {
+        fusable_ops.insert({Node::kDiv, Node::kNeg, Node::kReciprocal, Node::kSqrt, Node::kLog});
+        DecomposeSoftmax(graph);
+    }
+
+    // The native JIT does not support float16.
+    auto is_supported_dtype = [](Dtype dtype) { return dtype.IsFloat() && (!g_use_native_jit || dtype != Dtype::kFloat16); };
 
-    auto is_fusable = [&fusable_ops](const Node& node) {
+    auto is_fusable = [&fusable_ops, is_supported_dtype](const Node& node) {
         if (node.op_type() == Node::kConstant) {
             Tensor* t = node.tensor_value().get();
-            return t->dtype().IsFloat() && t->NumElements() == 1;
+            return is_supported_dtype(t->dtype()) && t->NumElements() == 1;
         }
 
-        if (!fusable_ops.count(node.op_type())) return false;
+        // The native JIT fuses reductions along the last axis with
+        // their producers and consumers.
+        if (!fusable_ops.count(node.op_type()) && !(g_use_native_jit && IsNativeRowReduction(node))) return false;
         for (Value* value : node.inputs()) {
             Dtype dtype = value->type().dtype();
             // TODO(hamaji): Fix the dtype inference and do not fuse
             // unknown dtypes.
-            if (!dtype.IsFloat() && dtype != Dtype::kUnknown) return false;
+            if (!is_supported_dtype(dtype) && dtype != Dtype::kUnknown) return false;
         }
         return true;
     };
 
-    FuseAllConnectedNodes("nvrtc", graph, 2, false, is_fusable);
+    FuseAllConnectedNodes(g_use_native_jit ? "native" : "nvrtc", graph, 2, false, is_fusable);
 }
 
 }  // namespace chainer_compiler
@@ -1,9 +1,11 @@
 #include <gtest/gtest.h>
 
+#include <common/strutil.h>
 #include <compiler/flags.h>
 #include <compiler/fusion.h>
 #include <compiler/graph.h>
 #include <compiler/graph_builder.h>
+#include <compiler/nvrtc_builder.h>
 
 namespace chainer_compiler {
 namespace {
@@ -29,5 +31,156 @@ TEST(FusionTest, Basic) {
     g_fuse_operations = false;
 }
 
+TEST(FusionTest, RejectCycle) {
+    g_fuse_operations = true;
+    Type type(Dtype::kFloat32, {});
+    Graph graph("test");
+    Value* input = graph.AddInputValue("input", type);
+    Value* output = graph.AddOutputValue("output", type);
+    GraphBuilder gb(&graph, "test", output);
+    Value* t0 = gb.Op(Node::kTanh, {input});
+    Value* t1 = gb.Op(Node::kSigmoid, {t0});
+    // Fusing `Add` with `t1` makes a cycle through `Relu`.
+    Value* r = gb.Op(Node::kRelu, {t1});
+    Value* t2 = gb.Op(Node::kAdd, {t1, r});
+    Value* t3 = gb.Op(Node::kTanh, {t2});
+    gb.Op(Node::kSigmoid, {t3}, {output});
+
+    FuseOperations(&graph);
+    std::vector<Node*> nodes = graph.GetTopologicallySortedNodes();
+    ASSERT_EQ(3, nodes.size());
+    EXPECT_EQ(Node::kChainerFusionGroup, nodes[0]->op_type());
+    EXPECT_EQ(2, nodes[0]->subgraph()->nodes().size());
+    EXPECT_EQ(Node::kRelu, nodes[1]->op_type());
+    EXPECT_EQ(Node::kChainerFusionGroup, nodes[2]->op_type());
+    EXPECT_EQ(3, nodes[2]->subgraph()->nodes().size());
+    graph.CheckSanity("fused");
+    g_fuse_operations = false;
+}
+
+TEST(FusionTest, Native) {
+    g_fuse_operations = true;
+    g_use_native_jit = true;
+    Type type(Dtype::kFloat32, {4, 3});
+    Graph graph("test");
+    Value* x = graph.AddInputValue("x", type);
+    Value* y = graph.AddInputValue("y", type);
+    Value* z = graph.AddInputValue("z", Type(Dtype::kFloat32, {3}));
+    Value* output = graph.AddOutputValue("output", type);
+    GraphBuilder gb(&graph, "test", output);
+    Value* t0 = gb.Op(Node::kSigmoid, {x});
+    Value* t1 = gb.Op(Node::kTanh, {y});
+    Value* t2 = gb.Op(Node::kMul, {t0, t1});
+    gb.Op(Node::kAdd, {t2, z}, {output});
+
+    FuseOperations(&graph);
+    ASSERT_EQ(1, graph.nodes().size());
+    const Node& node = *graph.nodes()[0];
+    ASSERT_EQ(Node::kChainerFusionGroup, node.op_type());
+    EXPECT_EQ("native", node.fusion_type());
+    const Graph& body = *node.subgraph();
+    EXPECT_EQ(4, body.nodes().size());
+
+    std::string code;
+    ASSERT_TRUE(BuildNativeProgram(body.nodes(), node.chainer_fusion_group(), body.input_values(), body.output_values(), &code));
+    EXPECT_NE(std::string::npos, code.find("typedef float T;"));
+    EXPECT_NE(std::string::npos, code.find(StrCat("extern \"C\" void fusion", node.chainer_fusion_group(), "(")));
+    EXPECT_NE(std::string::npos, code.find("#define CHX_INNER_STRIDE_2 1"));
+    graph.CheckSanity("fused");
+    g_use_native_jit = false;
+    g_fuse_operations = false;
+}
+
+TEST(FusionTest, NativeLayerNorm) {
+    g_fuse_operations = true;
+    g_use_native_jit = true;
+    Type type(Dtype::kFloat32, {4, 3});
+    Type row_type(Dtype::kFloat32, {4, 1});
+    Graph graph("test");
+    Value* x = graph.AddInputValue("x", type);
+    Value* gamma = graph.AddInputValue("gamma", Type(Dtype::kFloat32, {3}));
+    Value* output = graph.AddOutputValue("output", type);
+    Value* mean_output = graph.AddOutputValue("mean_output", row_type);
+    GraphBuilder gb(&graph, "test", output);
+    Value* mean = gb.Op(Node::kReduceMean, {x}, mean_output);
+    mean->producer()->set_axes({-1});
+    Value* d = gb.Op(Node::kSub, {x, mean}, gb.Temp(type));
+    Value* d2 = gb.Op(Node::kMul, {d, d}, gb.Temp(type));
+    Value* var = gb.Op(Node::kReduceMean, {d2}, gb.Temp(row_type));
+    var->producer()->set_axes({1});
+    Value* eps = gb.Const(Type(Dtype::kFloat32, {}), {1e-5});
+    Value* std = gb.Op(Node::kSqrt, {gb.Op(Node::kAdd, {var, eps}, gb.Temp(row_type))}, gb.Temp(row_type));
+    Value* normalized = gb.Op(Node::kDiv, {d, std}, gb.Temp(type));
+    gb.Op(Node::kMul, {normalized, gamma}, output);
+
+    FuseOperations(&graph);
+    std::vector<Node*> nodes = graph.GetLiveNodes();
+    ASSERT_EQ(1, nodes.size());
+    const Node& node = *nodes[0];
+    ASSERT_EQ(Node::kChainerFusionGroup, node.op_type());
+    EXPECT_EQ("native", node.fusion_type());
+    const Graph& body = *node.subgraph();
+
+    std::string code;
+    std::vector<int64_t> row_outputs;
+    ASSERT_TRUE(BuildNativeRowReductionProgram(
+            body.nodes(), node.chainer_fusion_group(), body.input_values(), body.output_values(), &code, &row_outputs));
+    ASSERT_EQ(1, row_outputs.size());
+    EXPECT_EQ(body.output_values()[row_outputs[0]]->type().dims(), row_type.dims());
+    // Two reductions and element-wise outputs.
+    EXPECT_EQ(3, SplitString(code, "#pragma omp simd").size() - 1);
+    graph.CheckSanity("fused");
+    g_use_native_jit = false;
+    g_fuse_operations = false;
+}
+
+TEST(FusionTest, NativeSoftmax) {
+    g_fuse_operations = true;
+    g_use_native_jit = true;
+    Type type(Dtype::kFloat32, {4, 3});
+    Graph graph("test");
+    Value* x = graph.AddInputValue("x", type);
+    Value* output = graph.AddOutputValue("output", type);
+    {
+        GraphBuilder gb(&graph, "test", output);
+        gb.Op(Node::kSoftmax, {x}, output)->producer()->set_axis(1);
+    }
+
+    FuseOperations(&graph);
+    std::vector<Node*> nodes = graph.GetLiveNodes();
+    ASSERT_EQ(1, nodes.size());
+    const Node& node = *nodes[0];
+    ASSERT_EQ(Node::kChainerFusionGroup, node.op_type());
+    const Graph& body = *node.subgraph();
+    EXPECT_EQ(5, body.nodes().size());
+
+    std::string code;
+    std::vector<int64_t> row_outputs;
+    ASSERT_TRUE(BuildNativeRowReductionProgram(
+            body.nodes(), node.chainer_fusion_group(), body.input_values(), body.output_values(), &code, &row_outputs));
+    EXPECT_TRUE(row_outputs.empty());
+    EXPECT_NE(std::string::npos, code.find("reduction(max:"));
+    EXPECT_NE(std::string::npos, code.find("reduction(+:"));
+    g_use_native_jit = false;
+    g_fuse_operations = false;
+}
+
+TEST(FusionTest, NativeSkipsFloat16) {
+    g_fuse_operations = true;
+    g_use_native_jit = true;
+    Type type(Dtype::kFloat16, {});
+    Graph graph("test");
+    Value* input = graph.AddInputValue("input", type);
+    Value* output = graph.AddOutputValue("output", type);
+    GraphBuilder gb(&graph, "test", output);
+    Value* tmp = gb.Op(Node::kTanh, {input});
+    gb.Op(Node::kSigmoid, {tmp}, {output});
+
+    FuseOperations(&graph);
+    EXPECT_EQ(2, graph.nodes().size());
+    g_use_native_jit = false;
+    g_fuse_operations = false;
+}
+
 }  // namespace
 }  // namespace chainer_compiler
@@ -36,7 +36,7 @@ class Dtype(object):
     pass
 
 
-CHAINER_COMPILERX_GLOBAL_ATTRS = attr_sets(chainer_order=-1, chainer_fusion_group=0)
+CHAINER_COMPILERX_GLOBAL_ATTRS = attr_sets(chainer_order=-1, chainer_parallel_stage=-1, chainer_fusion_group=0)
 
 NODES = []
 
@@ -222,13 +222,21 @@ NodeDef('ChainerLinearGradWeight', 2, 1)
 NodeDef('ChainerReluGrad', 2, 1)
 NodeDef('ChainerReduceSumTo', 2, 1)
 
-NodeDef('ChainerROIMaxPool2D', 3, 1,
+NodeDef('ChainerROIMaxPool2D', 3, (1, 2),
         output_shape=[int], spatial_scale=Required(float))
-NodeDef('ChainerROIAveragePool2D', 3, 1,
+NodeDef('ChainerROIAveragePool2D', 3, (1, 2),
         output_shape=[int], spatial_scale=Required(float))
-NodeDef('ChainerROIMaxAlign2D', 3, 1,
+NodeDef('ChainerROIMaxAlign2D', 3, (1, 2),
         output_shape=[int], spatial_scale=Required(float), sampling_ratio=[int])
-NodeDef('ChainerROIAverageAlign2D', 3, 1,
+NodeDef('ChainerROIAverageAlign2D', 3, (1, 2),
+        output_shape=[int], spatial_scale=Required(float), sampling_ratio=[int])
+NodeDef('ChainerROIMaxPool2DGrad', 2, 1,
+        output_shape=[int], spatial_scale=Required(float))
+NodeDef('ChainerROIAveragePool2DGrad', 2, 1,
+        output_shape=[int], spatial_scale=Required(float))
+NodeDef('ChainerROIMaxAlign2DGrad', 2, 1,
+        output_shape=[int], spatial_scale=Required(float), sampling_ratio=[int])
+NodeDef('ChainerROIAverageAlign2DGrad', 2, 1,
         output_shape=[int], spatial_scale=Required(float), sampling_ratio=[int])
 NodeDef('ChainerResizeImages', 1, 1, output_shape=[int])
 
@@ -244,10 +252,23 @@ NodeDef('ChainerConvTransposeWithDynamicOutputShape', 3, 1, **conv_attrs)
 NodeDef('ChainerSoftmaxCrossEntropy', 2, 1)
 NodeDef('ChainerSelectItem', 2, 1)
 NodeDef('ChainerSelectItemGrad', 3, 1)
+NodeDef('ChainerUpsampleGrad', 2, 1)
+NodeDef('ChainerResizeImagesGrad', 2, 1)
 NodeDef('ChainerLRNGrad', 4, 1,
         alpha=1e-4, beta=0.75, bias=1.0, size=Required(int))
 NodeDef('ChainerLSTMGrad', 2, 4)
 NodeDef('ChainerConvGradWeight', 3, 1, **conv_attrs)
+# Conv followed by an optional residual Add and an activation, which
+# is one of Relu, LeakyRelu, and Clip. The inputs are X, W, optional
+# B, and optional Z, which is added to the output of Conv.
+NodeDef('ChainerConvBiasActivation', (2, 3, 4), 1,
+        activation=Required(str), alpha=0.01,
+        max=float('inf'), min=float('-inf'), **conv_attrs)
+# Gemm with an optional C followed by an activation, which is one of
+# Relu, Sigmoid, and Tanh.
+NodeDef('ChainerGemmBiasActivation', (2, 3), 1,
+        activation=Required(str),
+        alpha=1.0, beta=1.0, transA=False, transB=False)
 NodeDef('ChainerGatherGrad', 3, 1, axis=0)
 NodeDef('ChainerDynamicSliceGrad', (4, 5, 6), 1)
 NodeDef('ChainerFusionGroup', None, None, subgraph=Graph, fusion_type=str)
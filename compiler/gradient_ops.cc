@@ -421,16 +421,22 @@ void ConvGradFn(GradientOpContext* gc) {
                     ->producer()
                     ->set_strides(node->strides())
                     ->set_pads(node->pads())
+                    ->set_group(node->group())
                     ->set_output_shape({x->type().dims().begin() + 2, x->type().dims().end()});
         } else {
             Value* x_shape = gb.Op(Node::kShape, {gc->x(0)});
             gc->GradOp(Node::kChainerConvTransposeWithDynamicOutputShape, 0, {gy, w, x_shape})
                     ->producer()
                     ->set_strides(node->strides())
-                    ->set_pads(node->pads());
+                    ->set_pads(node->pads())
+                    ->set_group(node->group());
         }
     }
-    gc->GradOp(Node::kChainerConvGradWeight, 1, {w, gc->x(0), gy})->producer()->set_strides(node->strides())->set_pads(node->pads());
+    gc->GradOp(Node::kChainerConvGradWeight, 1, {w, gc->x(0), gy})
+            ->producer()
+            ->set_strides(node->strides())
+            ->set_pads(node->pads())
+            ->set_group(node->group());
     if (node->inputs().size() == 3) {
         std::vector<int64_t> axes{{0}};
         CHECK(!node->kernel_shape().empty()) << "ConvGrad with no kernel_shape is not supported yet.";
@@ -470,6 +476,54 @@ void AveragePoolGradFn(GradientOpContext* gc) {
             ->set_count_include_pad(node->count_include_pad());
 }
 
+void ROIPool2DGradFn(GradientOpContext* gc, Node::OpType grad_op_type) {
+    Node* node = gc->node();
+    CHECK_EQ(1, node->outputs().size());
+    Value* context = gc->AddOutput(Type(Type::Kind::kOpaque));
+    gc->GradOp(grad_op_type, 0, {gc->gy(0), context})
+            ->producer()
+            ->set_output_shape(node->output_shape())
+            ->set_spatial_scale(node->spatial_scale());
+}
+
+void ROIMaxPool2DGradFn(GradientOpContext* gc) {
+    ROIPool2DGradFn(gc, Node::kChainerROIMaxPool2DGrad);
+}
+
+void ROIAveragePool2DGradFn(GradientOpContext* gc) {
+    ROIPool2DGradFn(gc, Node::kChainerROIAveragePool2DGrad);
+}
+
+void ROIAlign2DGradFn(GradientOpContext* gc, Node::OpType grad_op_type) {
+    Node* node = gc->node();
+    CHECK_EQ(1, node->outputs().size());
+    Value* context = gc->AddOutput(Type(Type::Kind::kOpaque));
+    gc->GradOp(grad_op_type, 0, {gc->gy(0), context})
+            ->producer()
+            ->set_output_shape(node->output_shape())
+            ->set_spatial_scale(node->spatial_scale())
+            ->set_sampling_ratio(node->sampling_ratio());
+}
+
+void ROIMaxAlign2DGradFn(GradientOpContext* gc) {
+    ROIAlign2DGradFn(gc, Node::kChainerROIMaxAlign2DGrad);
+}
+
+void ROIAverageAlign2DGradFn(GradientOpContext* gc) {
+    ROIAlign2DGradFn(gc, Node::kChainerROIAverageAlign2DGrad);
+}
+
+void UpsampleGradFn(GradientOpContext* gc) {
+    CHECK_EQ("nearest", gc->node()->mode()) << "Only nearest upsampling is supported";
+    gc->GradOp(Node::kChainerUpsampleGrad, 0, {gc->gy(0), gc->x(1)});
+}
+
+void ResizeImagesGradFn(GradientOpContext* gc) {
+    GraphBuilder gb{gc->builder(0)};
+    Value* t0 = gb.Op(Node::kShape, {gc->x(0)});
+    gc->GradOp(Node::kChainerResizeImagesGrad, 0, {gc->gy(0), t0});
+}
+
 void LogSoftmaxGradFn(GradientOpContext* gc) {
     const Node* node = gc->node();
     GraphBuilder gb{gc->builder(0)};
@@ -991,6 +1045,13 @@ bool AddGradientForNode(Graph* graph, Graph* dest_graph, Node* node, std::map<Va
         register_grad_fn(Node::kConv, &ConvGradFn);
         register_grad_fn(Node::kMaxPool, &MaxPoolGradFn);
         register_grad_fn(Node::kAveragePool, &AveragePoolGradFn);
+        register_grad_fn(Node::kUpsample, &UpsampleGradFn);
+        register_grad_fn(Node::kResize, &UpsampleGradFn);
+        register_grad_fn(Node::kChainerResizeImages, &ResizeImagesGradFn);
+        register_grad_fn(Node::kChainerROIMaxPool2D, &ROIMaxPool2DGradFn);
+        register_grad_fn(Node::kChainerROIAveragePool2D, &ROIAveragePool2DGradFn);
+        register_grad_fn(Node::kChainerROIMaxAlign2D, &ROIMaxAlign2DGradFn);
+        register_grad_fn(Node::kChainerROIAverageAlign2D, &ROIAverageAlign2DGradFn);
         register_grad_fn(Node::kLogSoftmax, &LogSoftmaxGradFn);
         register_grad_fn(Node::kSoftmax, &SoftmaxGradFn);
 
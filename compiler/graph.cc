@@ -11,10 +11,10 @@
 
 #include <common/log.h>
 #include <common/strutil.h>
+#include <compiler/graph_view.h>
 #include <compiler/node.h>
 #include <compiler/serializer_util.h>
 #include <compiler/tensor.h>
-#include <compiler/topology.h>
 #include <compiler/util.h>
 #include <compiler/value.h>
 
@@ -30,6 +30,7 @@ void Graph::Construct(const onnx::GraphProto& xgraph) {
     std::map<std::string, Value*> values_by_name;
     for (const onnx::ValueInfoProto& input : xgraph.input()) {
         Value* value = new Value(input, Value::Kind::kInput);
+        value->id_ = all_values_.size();
         all_values_.emplace_back(value);
         input_values_.push_back(value);
         CHECK(values_by_name.emplace(value->name(), value).second) << "Duplicated value name: " << value->name();
@@ -39,6 +40,7 @@ void Graph::Construct(const onnx::GraphProto& xgraph) {
         auto p = values_by_name.emplace(value->name(), value.get());
         if (p.second) {
             output_values_.push_back(value.get());
+            value->id_ = all_values_.size();
             all_values_.emplace_back(std::move(value));
         } else {
             // We allow graph output to be null.
@@ -51,6 +53,7 @@ void Graph::Construct(const onnx::GraphProto& xgraph) {
     }
     for (const onnx::ValueInfoProto& temp : xgraph.value_info()) {
         Value* value = new Value(temp, Value::Kind::kTemp);
+        value->id_ = all_values_.size();
         all_values_.emplace_back(value);
         temp_values_.push_back(value);
         CHECK(values_by_name.emplace(value->name(), value).second) << "Duplicated value name: " << value->name();
@@ -165,6 +168,7 @@ std::set<Value*> Graph::GetNecessaryValues() const {
 
 Value* Graph::AddValue(const std::string& name, const Type& type, Value::Kind kind) {
     Value* value = new Value(MakeUnique(name), type, kind);
+    value->id_ = all_values_.size();
     all_values_.emplace_back(value);
     if (value->IsInput()) input_values_.push_back(value);
     if (value->IsOutput()) output_values_.push_back(value);
@@ -205,7 +209,7 @@ void Graph::DetachNode(Node* node) {
 }
 
 std::vector<Node*> Graph::GetTopologicallySortedNodes() const {
-    return SortTopologically(GetLiveNodes(), input_values(), true);
+    return GraphView(*this).GetTopologicallySortedNodes();
 }
 
 void Graph::SortNodesTopologically() {
@@ -284,24 +288,40 @@ std::string Graph::MakeUnique(const std::string& name) {
 void Graph::AddNodeImpl(std::unique_ptr<Node> node, const std::vector<Value*>& inputs, const std::vector<Value*>& outputs) {
     for (Value* input : inputs) input->AddUser(node.get());
     for (Value* output : outputs) output->SetProducer(node.get());
+    node->id_ = nodes_buf_.size();
     nodes_.push_back(node.get());
     nodes_buf_.emplace_back(std::move(node));
 }
 
 void Graph::MigrateNodes(const std::vector<Node*>& nodes, const std::vector<Value*>& temps, Graph* to) {
-    for (Node* node : nodes) {
-        auto found = std::find(nodes_.begin(), nodes_.end(), node);
-        CHECK(found != nodes_.end()) << node->DebugString();
-        nodes_.erase(found);
-        to->nodes_.push_back(node);
+    MigrateNodes({{nodes, temps, to}});
+}
+
+void Graph::MigrateNodes(const std::vector<Migration>& migrations) {
+    std::set<Node*> moved_nodes;
+    std::set<Value*> moved_temps;
+    for (const Migration& migration : migrations) {
+        for (Node* node : migration.nodes) {
+            CHECK(moved_nodes.insert(node).second) << node->DebugString();
+            migration.to->nodes_.push_back(node);
+        }
+        for (Value* value : migration.temps) {
+            CHECK(moved_temps.insert(value).second) << value->DebugString();
+            migration.to->temp_values_.push_back(value);
+        }
     }
-    for (Value* value : temps) {
-        auto found = std::find(temp_values_.begin(), temp_values_.end(), value);
-        CHECK(found != temp_values_.end()) << value->DebugString();
-        temp_values_.erase(found);
-        to->temp_values_.push_back(value);
+
+    auto remove_moved = [](auto* values, const auto& moved) {
+        const size_t num_values = values->size();
+        values->erase(std::remove_if(values->begin(), values->end(), [&moved](auto* v) { return moved.count(v); }), values->end());
+        return num_values - values->size() == moved.size();
+    };
+    CHECK(remove_moved(&nodes_, moved_nodes)) << "Migrated nodes are not in " << name();
+    CHECK(remove_moved(&temp_values_, moved_temps)) << "Migrated values are not in " << name();
+
+    for (const Migration& migration : migrations) {
+        migration.to->SortNodesTopologically();
     }
-    to->SortNodesTopologically();
 }
 
 void Graph::InferShapes() {
@@ -85,8 +85,21 @@ public:
         return &output_values_;
     }
 
+    // Nodes and temporary values to be moved to `to`.
+    struct Migration {
+        std::vector<Node*> nodes;
+        std::vector<Value*> temps;
+        Graph* to{nullptr};
+    };
+
     void MigrateNodes(const std::vector<Node*>& nodes, const std::vector<Value*>& temps, Graph* to);
+    // Same as `MigrateNodes` for each of `migrations`, but nodes and
+    // values in this graph are scanned only once.
+    void MigrateNodes(const std::vector<Migration>& migrations);
 
+    // Infers shapes by ONNX's shape inference. As the whole graph is
+    // converted to ONNX and back, all nodes and values are recreated.
+    // Use `InferAllShapes` in shape_inference.h instead.
     void InferShapes();
 
     void ResetGradients();
@@ -101,6 +114,22 @@ public:
 
     void AddNodeImpl(std::unique_ptr<Node> node, const std::vector<Value*>& inputs, const std::vector<Value*>& outputs);
 
+    // Returns true if `node` or `value` was created by this graph, so
+    // its ID is unique in this graph.
+    bool Owns(const Node* node) const {
+        return node->id() >= 0 && static_cast<size_t>(node->id()) < nodes_buf_.size() && nodes_buf_[node->id()].get() == node;
+    }
+    bool Owns(const Value* value) const {
+        return value->id() >= 0 && static_cast<size_t>(value->id()) < all_values_.size() && all_values_[value->id()].get() == value;
+    }
+    // Upper bounds of IDs of nodes and values created by this graph.
+    int num_node_ids() const {
+        return nodes_buf_.size();
+    }
+    int num_value_ids() const {
+        return all_values_.size();
+    }
+
 private:
     std::string GenSym(const std::string& base = "");
     std::string MakeUnique(const std::string& name);
@@ -1,13 +1,11 @@
 #include "compiler/graph_builder.h"
 
-#include <compiler/onnx.h>
-#include <onnx/shape_inference/implementation.h>
-
 #include <common/strutil.h>
 #include <compiler/dtype_inference.h>
 #include <compiler/flags.h>
 #include <compiler/graph.h>
 #include <compiler/node.h>
+#include <compiler/shape_inference.h>
 #include <compiler/topology.h>
 #include <compiler/value.h>
 
@@ -32,35 +30,12 @@ GraphBuilder::~GraphBuilder() {
             }
         }
         CHECK_EQ(added_nodes_.size(), nodes.size());
-
-        onnx::GraphProto xgraph;
-        for (Node* node : nodes) {
-            node->ToONNX(xgraph.add_node());
-        }
-        for (Value* value : inputs) {
-            value->ToONNX(xgraph.add_input());
-        }
-        for (Value* value : outputs) {
-            value->ToONNX(xgraph.add_output());
-        }
-        for (Value* value : temps) {
-            value->ToONNX(xgraph.add_value_info());
-        }
-        std::unordered_map<std::string, int> opset_imports;
-        opset_imports[""] = 9;
-        onnx::shape_inference::InferShapes(&xgraph, opset_imports);
-
-        for (size_t i = 0; i < outputs.size(); ++i) {
-            if (xgraph.output(i).type().has_tensor_type()) outputs[i]->set_type(new Type(xgraph.output(i).type()));
-        }
-        for (size_t i = 0; i < temps.size(); ++i) {
-            if (xgraph.value_info(i).type().has_tensor_type()) temps[i]->set_type(new Type(xgraph.value_info(i).type()));
+        InferShapes(nodes);
+    } else {
+        for (Node* node : added_nodes_) {
+            InferDtype(node);
         }
     }
-
-    for (Node* node : added_nodes_) {
-        InferDtype(node);
-    }
 }
 
 Value* GraphBuilder::Op(Node::OpType op_type, const std::vector<Value*>& inputs, Value* output) {
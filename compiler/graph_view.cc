@@ -0,0 +1,196 @@
+#include "compiler/graph_view.h"
+
+#include <common/log.h>
+#include <compiler/graph.h>
+#include <compiler/node.h>
+#include <compiler/value.h>
+
+namespace chainer_compiler {
+
+GraphView::GraphView(const Graph& graph)
+    : graph_(graph), nodes_(graph.nodes()), node_ids_(graph.num_node_ids(), -1) {
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        const Node* node = nodes_[i];
+        if (graph.Owns(node)) {
+            node_ids_[node->id()] = i;
+        } else {
+            CHECK(foreign_node_ids_.emplace(node, i).second);
+        }
+    }
+    // Values created by the graph use their own IDs.
+    for (const std::unique_ptr<Value>& value : graph.all_values()) {
+        values_.push_back(value.get());
+    }
+
+    node_input_offsets_.push_back(0);
+    node_output_offsets_.push_back(0);
+    for (const Node* node : nodes_) {
+        for (Value* input : node->inputs()) {
+            node_inputs_.push_back(AddValue(input));
+        }
+        node_input_offsets_.push_back(node_inputs_.size());
+        for (Value* output : node->outputs()) {
+            node_outputs_.push_back(AddValue(output));
+        }
+        node_output_offsets_.push_back(node_outputs_.size());
+    }
+
+    value_producers_.assign(values_.size(), -1);
+    value_user_offsets_.assign(values_.size() + 1, 0);
+    for (int node_id = 0; node_id < num_nodes(); ++node_id) {
+        for (int value_id : outputs(node_id)) {
+            value_producers_[value_id] = node_id;
+        }
+        for (int value_id : inputs(node_id)) {
+            ++value_user_offsets_[value_id + 1];
+        }
+    }
+    for (size_t i = 0; i < values_.size(); ++i) {
+        value_user_offsets_[i + 1] += value_user_offsets_[i];
+    }
+    value_users_.resize(value_user_offsets_.back());
+    std::vector<int> num_filled(values_.size());
+    for (int node_id = 0; node_id < num_nodes(); ++node_id) {
+        for (int value_id : inputs(node_id)) {
+            value_users_[value_user_offsets_[value_id] + num_filled[value_id]++] = node_id;
+        }
+    }
+
+    value_is_null_.resize(values_.size());
+    value_is_external_.resize(values_.size());
+    for (size_t i = 0; i < values_.size(); ++i) {
+        const Value* value = values_[i];
+        value_is_null_[i] = value->IsNull();
+        if (value_producers_[i] < 0 && value->producer()) value_is_external_[i] = NodeId(value->producer()) < 0;
+    }
+}
+
+int GraphView::AddValue(Value* value) {
+    int id = ValueId(value);
+    if (id >= 0) return id;
+    id = values_.size();
+    values_.push_back(value);
+    CHECK(foreign_value_ids_.emplace(value, id).second);
+    return id;
+}
+
+int GraphView::GetNumActualInputs(int node_id) const {
+    int count = 0;
+    for (int value_id : inputs(node_id)) {
+        if (!is_null(value_id)) ++count;
+    }
+    return count;
+}
+
+int GraphView::NodeId(const Node* node) const {
+    if (graph_.Owns(node)) return node_ids_[node->id()];
+    auto found = foreign_node_ids_.find(node);
+    return found == foreign_node_ids_.end() ? -1 : found->second;
+}
+
+int GraphView::ValueId(const Value* value) const {
+    if (graph_.Owns(value)) return value->id();
+    auto found = foreign_value_ids_.find(value);
+    return found == foreign_value_ids_.end() ? -1 : found->second;
+}
+
+std::vector<int> GraphView::GetNecessaryNodesAndInputCounts(const std::vector<Value*>& output_values) const {
+    std::vector<int> input_counts(num_nodes(), -1);
+    std::vector<int> q;
+    auto fail_external_reference = [this](const Value* value) {
+        std::cerr << "External reference from " << graph_.name() << ". External node:\n" << value->producer()->DebugString();
+        graph_.DumpONNXOnFailure();
+        CHECK(false);
+    };
+    auto push_producer = [this, &q, fail_external_reference](int value_id) {
+        if (value_is_external_[value_id]) fail_external_reference(values_[value_id]);
+        if (producer(value_id) >= 0) q.push_back(producer(value_id));
+    };
+    // Nodes without any outputs are always necessary (e.g., ChainerPrint).
+    auto push_sinks = [this, &q](int value_id) {
+        for (int user : users(value_id)) {
+            if (outputs(user).empty()) q.push_back(user);
+        }
+    };
+
+    for (const Value* value : output_values) {
+        const int value_id = ValueId(value);
+        if (value_id >= 0) {
+            push_producer(value_id);
+        } else if (value->producer()) {
+            fail_external_reference(value);
+        }
+    }
+
+    while (!q.empty()) {
+        const int node_id = q.back();
+        q.pop_back();
+        if (input_counts[node_id] >= 0) continue;
+        input_counts[node_id] = GetNumActualInputs(node_id);
+
+        for (int value_id : inputs(node_id)) {
+            push_producer(value_id);
+            push_sinks(value_id);
+        }
+        for (int value_id : outputs(node_id)) {
+            push_sinks(value_id);
+        }
+    }
+    return input_counts;
+}
+
+std::vector<bool> GraphView::GetNecessaryValues(const std::vector<Value*>& output_values) const {
+    std::vector<bool> necessary(num_values());
+    std::vector<int> q;
+    for (const Value* value : output_values) {
+        const int value_id = ValueId(value);
+        if (value_id >= 0) q.push_back(value_id);
+    }
+
+    while (!q.empty()) {
+        const int node_id = producer(q.back());
+        q.pop_back();
+        if (node_id < 0) continue;
+        for (int value_id : inputs(node_id)) {
+            if (necessary[value_id]) continue;
+            necessary[value_id] = true;
+            q.push_back(value_id);
+        }
+    }
+    return necessary;
+}
+
+std::vector<Node*> GraphView::GetTopologicallySortedNodes() const {
+    std::vector<int> input_counts(num_nodes(), -1);
+    for (int node_id = 0; node_id < num_nodes(); ++node_id) {
+        if (!nodes_[node_id]->detached()) input_counts[node_id] = GetNumActualInputs(node_id);
+    }
+
+    std::vector<int> q;
+    for (const Value* value : graph_.input_values()) {
+        q.push_back(ValueId(value));
+    }
+
+    std::vector<Node*> sorted_nodes;
+    auto add_sorted_node = [this, &sorted_nodes, &q](int node_id) {
+        sorted_nodes.push_back(nodes_[node_id]);
+        for (int value_id : outputs(node_id)) {
+            q.push_back(value_id);
+        }
+    };
+
+    for (int node_id = 0; node_id < num_nodes(); ++node_id) {
+        if (input_counts[node_id] == 0) add_sorted_node(node_id);
+    }
+
+    for (size_t i = 0; i < q.size(); ++i) {
+        const int value_id = q[i];
+        if (is_null(value_id)) continue;
+        for (int user : users(value_id)) {
+            if (input_counts[user] > 0 && --input_counts[user] == 0) add_sorted_node(user);
+        }
+    }
+    return sorted_nodes;
+}
+
+}  // namespace chainer_compiler
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace chainer_compiler {
+
+class Graph;
+class Node;
+class Value;
+
+// A snapshot of connections between nodes and values of a graph for
+// passes which visit many nodes. Nodes in `Graph::nodes()` and values
+// referred by them get dense IDs from zero, and inputs, outputs, and
+// users are stored in CSR arrays. Passes can use vectors indexed by
+// these IDs instead of maps keyed by pointers. The view must be built
+// again after the graph is modified.
+class GraphView {
+public:
+    // A range of IDs in a CSR array.
+    class IdRange {
+    public:
+        IdRange(const int* begin, const int* end) : begin_(begin), end_(end) {
+        }
+        const int* begin() const {
+            return begin_;
+        }
+        const int* end() const {
+            return end_;
+        }
+        size_t size() const {
+            return end_ - begin_;
+        }
+        bool empty() const {
+            return begin_ == end_;
+        }
+        int operator[](size_t i) const {
+            return begin_[i];
+        }
+
+    private:
+        const int* begin_;
+        const int* end_;
+    };
+
+    explicit GraphView(const Graph& graph);
+
+    GraphView(const GraphView&) = delete;
+    GraphView& operator=(const GraphView&) = delete;
+
+    const Graph& graph() const {
+        return graph_;
+    }
+
+    int num_nodes() const {
+        return nodes_.size();
+    }
+    int num_values() const {
+        return values_.size();
+    }
+
+    Node* node(int id) const {
+        return nodes_[id];
+    }
+    Value* value(int id) const {
+        return values_[id];
+    }
+
+    // Returns -1 for nodes and values which are not in this view.
+    int NodeId(const Node* node) const;
+    int ValueId(const Value* value) const;
+
+    // IDs of input and output values of a node, including null values.
+    IdRange inputs(int node_id) const {
+        return Range(node_input_offsets_, node_inputs_, node_id);
+    }
+    IdRange outputs(int node_id) const {
+        return Range(node_output_offsets_, node_outputs_, node_id);
+    }
+    // IDs of nodes which use a value, as many times as they use it.
+    IdRange users(int value_id) const {
+        return Range(value_user_offsets_, value_users_, value_id);
+    }
+    // Returns -1 if the value is not produced by nodes in this view.
+    int producer(int value_id) const {
+        return value_producers_[value_id];
+    }
+    bool is_null(int value_id) const {
+        return value_is_null_[value_id];
+    }
+
+    // Same as `Graph::GetNecessaryNodesAndInputCounts` but returns a
+    // vector indexed by node IDs. Unnecessary nodes have -1.
+    std::vector<int> GetNecessaryNodesAndInputCounts(const std::vector<Value*>& output_values) const;
+
+    // Same as `Graph::GetNecessaryValues` but returns a vector indexed
+    // by value IDs.
+    std::vector<bool> GetNecessaryValues(const std::vector<Value*>& output_values) const;
+
+    // Same as `Graph::GetTopologicallySortedNodes`. Nodes without
+    // inputs come in the order of `Graph::nodes()`.
+    std::vector<Node*> GetTopologicallySortedNodes() const;
+
+private:
+    static IdRange Range(const std::vector<int>& offsets, const std::vector<int>& ids, int index) {
+        return IdRange(ids.data() + offsets[index], ids.data() + offsets[index + 1]);
+    }
+
+    int AddValue(Value* value);
+
+    // Same as `Node::GetNumActualInputs`.
+    int GetNumActualInputs(int node_id) const;
+
+    const Graph& graph_;
+    std::vector<Node*> nodes_;
+    std::vector<Value*> values_;
+
+    // IDs in this view of nodes indexed by `Node::id()`. Values created
+    // by the graph have the same IDs as `Value::id()`. Nodes and values
+    // from other graphs, e.g., nodes moved to the graph by
+    // `Graph::MigrateNodes`, are in the maps.
+    std::vector<int> node_ids_;
+    std::unordered_map<const Node*, int> foreign_node_ids_;
+    std::unordered_map<const Value*, int> foreign_value_ids_;
+
+    std::vector<int> node_input_offsets_;
+    std::vector<int> node_inputs_;
+    std::vector<int> node_output_offsets_;
+    std::vector<int> node_outputs_;
+    std::vector<int> value_user_offsets_;
+    std::vector<int> value_users_;
+    std::vector<int> value_producers_;
+    std::vector<bool> value_is_null_;
+    // Values produced by nodes outside this view.
+    std::vector<bool> value_is_external_;
+};
+
+}  // namespace chainer_compiler
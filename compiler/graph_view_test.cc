@@ -0,0 +1,104 @@
+#include <map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <compiler/graph.h>
+#include <compiler/graph_builder.h>
+#include <compiler/graph_view.h>
+#include <compiler/node.h>
+#include <compiler/type.h>
+#include <compiler/value.h>
+
+namespace chainer_compiler {
+namespace {
+
+TEST(GraphViewTest, Basic) {
+    Type type(Dtype::kFloat32, {});
+    Graph graph("test");
+    Value* input = graph.AddInputValue("input", type);
+    Value* output = graph.AddOutputValue("output", type);
+    GraphBuilder gb(&graph, "test", output);
+
+    Value* temp0 = gb.Op(Node::kTanh, {input});
+    Value* temp1 = gb.Op(Node::kAdd, {temp0, temp0});
+    Value* unused = gb.Op(Node::kTanh, {temp0});
+    gb.Op(Node::kMul, {temp1, input}, output);
+
+    const GraphView view(graph);
+    ASSERT_EQ(4, view.num_nodes());
+    EXPECT_EQ(graph.all_values().size(), view.num_values());
+
+    for (int id = 0; id < view.num_nodes(); ++id) {
+        EXPECT_EQ(graph.nodes()[id], view.node(id));
+        EXPECT_EQ(id, view.NodeId(view.node(id)));
+    }
+    for (int id = 0; id < view.num_values(); ++id) {
+        EXPECT_EQ(id, view.ValueId(view.value(id)));
+    }
+
+    const int add = view.NodeId(temp1->producer());
+    ASSERT_EQ(2, view.inputs(add).size());
+    EXPECT_EQ(view.ValueId(temp0), view.inputs(add)[0]);
+    EXPECT_EQ(view.ValueId(temp0), view.inputs(add)[1]);
+    ASSERT_EQ(1, view.outputs(add).size());
+    EXPECT_EQ(view.ValueId(temp1), view.outputs(add)[0]);
+
+    // `Add` uses `temp0` twice.
+    EXPECT_EQ(3, view.users(view.ValueId(temp0)).size());
+    EXPECT_EQ(2, view.users(view.ValueId(input)).size());
+    EXPECT_EQ(0, view.users(view.ValueId(output)).size());
+    EXPECT_EQ(-1, view.producer(view.ValueId(input)));
+    EXPECT_EQ(view.NodeId(temp0->producer()), view.producer(view.ValueId(temp0)));
+
+    const std::map<Node*, int> expected_counts = graph.GetNecessaryNodesAndInputCounts(graph.output_values());
+    const std::vector<int> input_counts = view.GetNecessaryNodesAndInputCounts(graph.output_values());
+    ASSERT_EQ(view.num_nodes(), input_counts.size());
+    EXPECT_EQ(-1, input_counts[view.NodeId(unused->producer())]);
+    for (int id = 0; id < view.num_nodes(); ++id) {
+        auto found = expected_counts.find(view.node(id));
+        EXPECT_EQ(found == expected_counts.end() ? -1 : found->second, input_counts[id]);
+    }
+
+    const std::vector<bool> necessary = view.GetNecessaryValues(graph.output_values());
+    EXPECT_TRUE(necessary[view.ValueId(input)]);
+    EXPECT_TRUE(necessary[view.ValueId(temp0)]);
+    EXPECT_TRUE(necessary[view.ValueId(temp1)]);
+    EXPECT_FALSE(necessary[view.ValueId(unused)]);
+    EXPECT_FALSE(necessary[view.ValueId(output)]);
+
+    const std::vector<Node*> sorted = view.GetTopologicallySortedNodes();
+    ASSERT_EQ(4, sorted.size());
+    EXPECT_EQ(temp0->producer(), sorted[0]);
+    EXPECT_EQ(output->producer(), sorted[3]);
+}
+
+TEST(GraphViewTest, MigratedNodes) {
+    Type type(Dtype::kFloat32, {});
+    Graph graph("test");
+    Value* input = graph.AddInputValue("input", type);
+    Value* output = graph.AddOutputValue("output", type);
+    Value* temp;
+    {
+        GraphBuilder gb(&graph, "test", output);
+        temp = gb.Op(Node::kTanh, {input});
+        gb.Op(Node::kTanh, {temp}, output);
+    }
+
+    Graph subgraph("sub");
+    graph.MigrateNodes({temp->producer(), output->producer()}, {temp}, &subgraph);
+
+    // Nodes and values created by `graph` are in the view of `subgraph`.
+    const GraphView view(subgraph);
+    ASSERT_EQ(2, view.num_nodes());
+    EXPECT_LE(0, view.NodeId(temp->producer()));
+    EXPECT_LE(0, view.ValueId(temp));
+    EXPECT_LE(0, view.ValueId(input));
+    EXPECT_EQ(view.NodeId(temp->producer()), view.producer(view.ValueId(temp)));
+    ASSERT_EQ(1, view.users(view.ValueId(temp)).size());
+    EXPECT_EQ(view.NodeId(output->producer()), view.users(view.ValueId(temp))[0]);
+    EXPECT_EQ(-1, GraphView(graph).NodeId(temp->producer()));
+}
+
+}  // namespace
+}  // namespace chainer_compiler
@@ -1,17 +1,20 @@
 #include "compiler/memory_simulator.h"
 
-#include <map>
 #include <numeric>
+#include <vector>
 
 #include <common/log.h>
 #include <common/strutil.h>
 #include <compiler/graph.h>
+#include <compiler/graph_view.h>
 #include <compiler/log.h>
 
 namespace chainer_compiler {
 
 SimulatedMemoryUsage SimulateMemoryUsage(const Graph& graph) {
-    std::map<const Value*, int> num_users;
+    const GraphView view(graph);
+    // The number of remaining users of necessary values, or -1.
+    std::vector<int> num_users(view.num_values(), -1);
     SimulatedMemoryUsage usage{};
     int64_t mem = 0;
 
@@ -29,7 +32,10 @@ SimulatedMemoryUsage SimulateMemoryUsage(const Graph& graph) {
         usage.peak = std::max<int64_t>(usage.peak, mem);
     };
 
-    for (const Value* value : graph.GetNecessaryValues()) {
+    const std::vector<bool> necessary = view.GetNecessaryValues(graph.output_values());
+    for (int value_id = 0; value_id < view.num_values(); ++value_id) {
+        if (!necessary[value_id]) continue;
+        const Value* value = view.value(value_id);
         int nu = value->users().size();
         if (value->IsInput()) {
             int64_t bytes = value->GetNBytes();
@@ -40,19 +46,19 @@ SimulatedMemoryUsage SimulateMemoryUsage(const Graph& graph) {
             }
             alloc(value);
         }
-        CHECK(num_users.emplace(value, nu).second);
+        num_users[value_id] = nu;
     }
 
     std::vector<const Node*> nodes(graph.GetComputationSequence());
     for (const Node* node : nodes) {
-        for (const Value* value : node->outputs()) {
-            alloc(value);
+        const int node_id = view.NodeId(node);
+        for (int output : view.outputs(node_id)) {
+            alloc(view.value(output));
         }
-        for (const Value* value : node->inputs()) {
-            auto found = num_users.find(value);
-            if (found == num_users.end()) continue;
-            if (--found->second == 0) {
-                mem -= value->GetNBytes();
+        for (int input : view.inputs(node_id)) {
+            if (num_users[input] < 0) continue;
+            if (--num_users[input] == 0) {
+                mem -= view.value(input)->GetNBytes();
             }
         }
     }
@@ -194,6 +194,176 @@ bool MaybeMergeConvBN(Graph* graph, Node* conv) {
     return true;
 }
 
+// Returns the only user of `value`, or nullptr if `value` is used by
+// other nodes or is an output of the graph.
+Node* GetSingleUser(Value* value) {
+    if (value->IsOutput() || value->users().size() != 1) {
+        return nullptr;
+    }
+    return value->user(0);
+}
+
+// Merges Conv, an optional Add of a value in the same shape (e.g., a
+// shortcut of ResNet), and Relu, LeakyRelu, or Clip.
+bool MaybeMergeConvBiasActivation(Graph* graph, Node* conv) {
+    for (int64_t d : conv->dilations()) {
+        if (d != 1) {
+            return false;
+        }
+    }
+    if (conv->auto_pad() != "NOTSET" && conv->auto_pad() != "SAME_UPPER") {
+        return false;
+    }
+
+    Value* value = conv->output(0);
+    Node* user = GetSingleUser(value);
+    if (!user) {
+        return false;
+    }
+
+    Node* add = nullptr;
+    Value* residual = nullptr;
+    if (user->op_type() == Node::kAdd) {
+        add = user;
+        if (add->input(0) == add->input(1)) {
+            return false;
+        }
+        residual = add->input(add->input(0) == value ? 1 : 0);
+        // The residual must not be broadcasted.
+        const Type& type = value->type();
+        const Type& residual_type = residual->type();
+        if (!type.HasKnownShape() || !residual_type.HasKnownShape() || type.dtype() != residual_type.dtype() ||
+            type.dims() != residual_type.dims()) {
+            return false;
+        }
+        value = add->output(0);
+        user = GetSingleUser(value);
+        if (!user) {
+            return false;
+        }
+    }
+
+    Node* activation = user;
+    switch (activation->op_type()) {
+        case Node::kRelu:
+        case Node::kLeakyRelu:
+            break;
+        case Node::kClip:
+            // Clip in opset 11 takes `min` and `max` as inputs.
+            if (activation->inputs().size() != 1) {
+                return false;
+            }
+            break;
+        default:
+            return false;
+    }
+
+    GraphBuilder gb(graph, "MergeConvBiasActivation", activation->output(0));
+    std::vector<Value*> new_in = conv->inputs();
+    if (residual) {
+        if (new_in.size() == 2) {
+            new_in.push_back(gb.Null());
+        }
+        new_in.push_back(residual);
+    }
+    Node* fused = gb.MOp(Node::kChainerConvBiasActivation, new_in, activation->outputs());
+    fused->set_auto_pad(conv->auto_pad());
+    fused->set_dilations(conv->dilations());
+    fused->set_group(conv->group());
+    fused->set_kernel_shape(conv->kernel_shape());
+    fused->set_pads(conv->pads());
+    fused->set_strides(conv->strides());
+    fused->set_activation(Node::OpTypeToString(activation->op_type()));
+    if (activation->op_type() == Node::kLeakyRelu) {
+        fused->set_alpha(activation->alpha());
+    } else if (activation->op_type() == Node::kClip) {
+        fused->set_min(activation->min());
+        fused->set_max(activation->max());
+    }
+
+    graph->DetachNode(conv);
+    if (add) {
+        graph->DetachNode(add);
+    }
+    graph->DetachNode(activation);
+
+    return true;
+}
+
+// Merges Gemm, ChainerLinear, or MatMul with an optional Add of a bias,
+// and Relu, Sigmoid, or Tanh.
+bool MaybeMergeGemmBiasActivation(Graph* graph, Node* gemm) {
+    std::vector<Value*> new_in = gemm->inputs();
+    if (gemm->op_type() != Node::kGemm) {
+        const Type& a_type = gemm->input(0)->type();
+        const Type& b_type = gemm->input(1)->type();
+        if (!a_type.HasKnownRank() || !b_type.HasKnownRank() || a_type.ndim() != 2 || b_type.ndim() != 2) {
+            return false;
+        }
+        if (gemm->op_type() == Node::kChainerLinear && gemm->n_batch_axes() != 1) {
+            return false;
+        }
+    }
+
+    Value* value = gemm->output(0);
+    Node* user = GetSingleUser(value);
+    if (!user) {
+        return false;
+    }
+
+    Node* add = nullptr;
+    if (gemm->op_type() == Node::kMatMul && user->op_type() == Node::kAdd) {
+        add = user;
+        if (add->input(0) == add->input(1)) {
+            return false;
+        }
+        Value* bias = add->input(add->input(0) == value ? 1 : 0);
+        // The bias must be broadcastable to the output as C of Gemm.
+        const Type& type = value->type();
+        const Type& bias_type = bias->type();
+        if (!type.HasKnownShape() || !bias_type.HasKnownShape() || type.dtype() != bias_type.dtype() || bias_type.ndim() > 2) {
+            return false;
+        }
+        for (int i = 0; i < bias_type.ndim(); ++i) {
+            const int64_t dim = bias_type.dims()[i];
+            if (dim != 1 && dim != type.dims()[2 - bias_type.ndim() + i]) {
+                return false;
+            }
+        }
+        new_in.push_back(bias);
+        value = add->output(0);
+        user = GetSingleUser(value);
+        if (!user) {
+            return false;
+        }
+    }
+
+    Node* activation = user;
+    if (activation->op_type() != Node::kRelu && activation->op_type() != Node::kSigmoid && activation->op_type() != Node::kTanh) {
+        return false;
+    }
+
+    GraphBuilder gb(graph, "MergeGemmBiasActivation", activation->output(0));
+    Node* fused = gb.MOp(Node::kChainerGemmBiasActivation, new_in, activation->outputs());
+    if (gemm->op_type() == Node::kGemm) {
+        fused->set_alpha(gemm->alpha());
+        fused->set_beta(gemm->beta());
+        fused->set_trans_a(gemm->trans_a());
+        fused->set_trans_b(gemm->trans_b());
+    } else if (gemm->op_type() == Node::kChainerLinear) {
+        fused->set_trans_b(true);
+    }
+    fused->set_activation(Node::OpTypeToString(activation->op_type()));
+
+    graph->DetachNode(gemm);
+    if (add) {
+        graph->DetachNode(add);
+    }
+    graph->DetachNode(activation);
+
+    return true;
+}
+
 bool MaybeMergeTransposeGemm(Graph* graph, Node* trans) {
     Value* trans_gemm = trans->output(0);
     if (trans_gemm->users().size() != 1) {
@@ -230,7 +400,7 @@ bool MaybeMergeTransposeGemm(Graph* graph, Node* trans) {
 
 }  // namespace
 
-void MergeOperations(Graph* graph, bool gen_backprop) {
+void MergeOperations(Graph* graph, bool gen_backprop, bool merge_activations) {
     bool replaced = true;
     while (replaced) {
         replaced = false;
@@ -250,8 +420,20 @@ void MergeOperations(Graph* graph, bool gen_backprop) {
                     replaced |= MaybeMergePadConv(graph, node);
                     break;
                 case Node::kConv:
-                    if (!gen_backprop) {
-                        replaced |= MaybeMergeConvBN(graph, node);
+                    if (gen_backprop) {
+                        break;
+                    }
+                    if (MaybeMergeConvBN(graph, node)) {
+                        replaced = true;
+                    } else if (merge_activations) {
+                        replaced |= MaybeMergeConvBiasActivation(graph, node);
+                    }
+                    break;
+                case Node::kGemm:
+                case Node::kMatMul:
+                case Node::kChainerLinear:
+                    if (!gen_backprop && merge_activations) {
+                        replaced |= MaybeMergeGemmBiasActivation(graph, node);
                     }
                     break;
                 case Node::kTranspose:
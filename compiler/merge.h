@@ -4,6 +4,10 @@ namespace chainer_compiler {
 
 class Graph;
 
-void MergeOperations(Graph* graph, bool gen_backprop);
+// Conv and Gemm followed by activations are merged into
+// ChainerConvBiasActivation and ChainerGemmBiasActivation only when
+// `merge_activations` is true, as backends other than ChxVM do not
+// support them.
+void MergeOperations(Graph* graph, bool gen_backprop, bool merge_activations = false);
 
 }  // namespace chainer_compiler
@@ -147,5 +147,109 @@ TEST(MergeTest, ConvBN) {
     EXPECT_ARRAY_ALL_CLOSE(W * f.Reshape({3, 1, 1, 1}), new_w);
 }
 
+TEST(MergeTest, ConvBiasActivation) {
+    Type type(Dtype::kFloat32, {2, 4, 5, 5});
+    Graph graph("test");
+    Value* x = graph.AddInputValue("x", Type(Dtype::kFloat32, {2, 3, 5, 5}));
+    Value* w = graph.AddInputValue("w", Type(Dtype::kFloat32, {4, 3, 3, 3}));
+    Value* z = graph.AddInputValue("z", type);
+    Value* output = graph.AddOutputValue("output", type);
+
+    {
+        GraphBuilder gb(&graph, "test", output);
+        Value* y = gb.Op(Node::kConv, {x, w}, gb.Temp(type));
+        y->producer()->set_pads({1, 1, 1, 1});
+        Value* h = gb.Op(Node::kAdd, {z, y}, gb.Temp(type));
+        gb.Op(Node::kClip, {h}, output)->producer()->set_min(0)->set_max(6);
+    }
+
+    MergeOperations(&graph, false, true);
+    graph.DeleteDetached();
+    ASSERT_EQ(1, graph.nodes().size());
+    const Node& node = *graph.nodes()[0];
+    EXPECT_EQ(Node::kChainerConvBiasActivation, node.op_type());
+    ASSERT_EQ(4, node.inputs().size());
+    EXPECT_EQ(x, node.input(0));
+    EXPECT_EQ(w, node.input(1));
+    EXPECT_TRUE(node.input(2)->IsNull());
+    EXPECT_EQ(z, node.input(3));
+    EXPECT_EQ("Clip", node.activation());
+    EXPECT_EQ(0, node.min());
+    EXPECT_EQ(6, node.max());
+    EXPECT_EQ(std::vector<int64_t>({1, 1, 1, 1}), node.pads());
+    graph.CheckSanity("merged");
+}
+
+TEST(MergeTest, ConvBiasActivationNotMerged) {
+    Type type(Dtype::kFloat32, {2, 4, 5, 5});
+    Graph graph("test");
+    Value* x = graph.AddInputValue("x", Type(Dtype::kFloat32, {2, 3, 5, 5}));
+    Value* w = graph.AddInputValue("w", Type(Dtype::kFloat32, {4, 3, 3, 3}));
+    // Broadcasted residuals are not merged.
+    Value* z = graph.AddInputValue("z", Type(Dtype::kFloat32, {4, 1, 1}));
+    Value* output = graph.AddOutputValue("output", type);
+    // The output of Conv is used by other nodes.
+    Value* conv_output = graph.AddOutputValue("conv_output", type);
+
+    {
+        GraphBuilder gb(&graph, "test", output);
+        Value* y = gb.Op(Node::kConv, {x, w}, gb.Temp(type));
+        Value* h = gb.Op(Node::kAdd, {y, z}, gb.Temp(type));
+        gb.Op(Node::kRelu, {h}, output);
+        gb.Op(Node::kRelu, {gb.Op(Node::kConv, {x, w}, gb.Temp(type))}, conv_output);
+        gb.Op(Node::kIdentity, {conv_output->producer()->input(0)}, graph.AddOutputValue("identity", type));
+    }
+
+    MergeOperations(&graph, false, true);
+    graph.DeleteDetached();
+    EXPECT_EQ(6, graph.nodes().size());
+    for (const Node* node : graph.nodes()) {
+        EXPECT_NE(Node::kChainerConvBiasActivation, node->op_type());
+    }
+    graph.CheckSanity("merged");
+}
+
+TEST(MergeTest, GemmBiasActivation) {
+    Graph graph("test");
+    Value* x = graph.AddInputValue("x", Type(Dtype::kFloat32, {8, 16}));
+    Value* w1 = graph.AddInputValue("w1", Type(Dtype::kFloat32, {16, 32}));
+    Value* b1 = graph.AddInputValue("b1", Type(Dtype::kFloat32, {32}));
+    Value* w2 = graph.AddInputValue("w2", Type(Dtype::kFloat32, {4, 32}));
+    Value* b2 = graph.AddInputValue("b2", Type(Dtype::kFloat32, {4}));
+    Value* output = graph.AddOutputValue("output", Type(Dtype::kFloat32, {8, 4}));
+
+    {
+        GraphBuilder gb(&graph, "test", output);
+        Type type(Dtype::kFloat32, {8, 32});
+        Value* h = gb.Op(Node::kMatMul, {x, w1}, gb.Temp(type));
+        h = gb.Op(Node::kAdd, {h, b1}, gb.Temp(type));
+        h = gb.Op(Node::kRelu, {h}, gb.Temp(type));
+        h = gb.Op(Node::kGemm, {h, w2, b2}, gb.Temp(Type(Dtype::kFloat32, {8, 4})));
+        h->producer()->set_alpha(0.5)->set_trans_b(true);
+        gb.Op(Node::kTanh, {h}, output);
+    }
+
+    MergeOperations(&graph, false, true);
+    graph.DeleteDetached();
+    ASSERT_EQ(2, graph.nodes().size());
+    for (const Node* node : graph.nodes()) {
+        EXPECT_EQ(Node::kChainerGemmBiasActivation, node->op_type());
+        ASSERT_EQ(3, node->inputs().size());
+        if (node->input(0) == x) {
+            EXPECT_EQ(w1, node->input(1));
+            EXPECT_EQ(b1, node->input(2));
+            EXPECT_EQ("Relu", node->activation());
+            EXPECT_FALSE(node->trans_b());
+        } else {
+            EXPECT_EQ(w2, node->input(1));
+            EXPECT_EQ(b2, node->input(2));
+            EXPECT_EQ("Tanh", node->activation());
+            EXPECT_EQ(0.5, node->alpha());
+            EXPECT_TRUE(node->trans_b());
+        }
+    }
+    graph.CheckSanity("merged");
+}
+
 }  // namespace
 }  // namespace chainer_compiler
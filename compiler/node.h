@@ -67,7 +67,15 @@ public:
 
     std::string ToString() const;
 
+    // A dense ID in the graph which created this node, or -1. Use
+    // `GraphView` to map nodes to IDs.
+    int id() const {
+        return id_;
+    }
+
 private:
+    friend class Graph;
+
     std::vector<Value*> inputs_;
     std::vector<Value*> outputs_;
     std::string name_;
@@ -75,6 +83,7 @@ private:
     std::string doc_string_;
 
     bool detached_ = false;
+    int id_ = -1;
 };
 
 std::ostream& operator<<(std::ostream& os, Node::OpType op_type);
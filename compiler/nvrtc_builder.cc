@@ -8,6 +8,8 @@
 #include <queue>
 #include <set>
 #include <sstream>
+#include <tuple>
+#include <utility>
 
 #include <common/log.h>
 #include <compiler/code_emitter.h>
@@ -81,21 +83,29 @@ void EmitNode(const Node* node, CodeEmitter* ce) {
             binary('/');
             break;
 
+        case Node::kNeg:
+            out1("-" + ins[0]);
+            break;
+
+        case Node::kReciprocal:
+            out1("static_cast<T>(1) / " + ins[0]);
+            break;
+
+        case Node::kSqrt:
+            out1("sqrt(" + ins[0] + ")");
+            break;
+
+        case Node::kLog:
+            out1("log(" + ins[0] + ")");
+            break;
+
         default:
             CHECK(false) << "Cannot build NVRTC program for: " << node->ToString();
     }
 }
 
-}  // namespace
-
-void BuildNvrtcProgram(
-        const std::vector<Node*>& nodes, int id, const std::vector<Value*>& inputs, const std::vector<Value*>& outputs, std::string* prog) {
-    std::set<Node::OpType> seen_ops;
-    for (Node* node : nodes) {
-        seen_ops.insert(node->op_type());
-    }
-
-    // TODO(hamaji): Currently, we assume unknown dtype is float32.
+// TODO(hamaji): Currently, we assume unknown dtype is float32.
+Dtype GetDtype(const std::vector<Node*>& nodes) {
     Dtype dtype = Dtype::kUnknown;
     for (Node* node : nodes) {
         for (Value* value : node->inputs()) {
@@ -112,6 +122,126 @@ void BuildNvrtcProgram(
     if (dtype == Dtype::kUnknown) {
         dtype = Dtype::kFloat32;
     }
+    return dtype;
+}
+
+void EmitSigmoid(const std::vector<Node*>& nodes, const char* qualifier, CodeEmitter* ce) {
+    for (Node* node : nodes) {
+        if (node->op_type() != Node::kSigmoid) continue;
+        *ce << qualifier << " T sigmoid(T x) {\n";
+        *ce << "const T half = 0.5;\n";
+        *ce << "return tanh(x * half) * half + half;\n";
+        *ce << "}\n";
+        return;
+    }
+}
+
+// Returns nodes other than constants in a topological order. Values
+// of `inputs` and constants must be defined before.
+std::vector<Node*> SortNodes(const std::vector<Node*>& nodes, const std::vector<Value*>& inputs) {
+    std::map<Node*, int> input_counts;
+    for (Node* node : nodes) {
+        CHECK(input_counts.emplace(node, node->GetNumActualInputs()).second);
+    }
+
+    std::queue<Value*> q;
+    for (Value* value : inputs) {
+        q.push(value);
+    }
+    for (Node* node : nodes) {
+        if (node->op_type() == Node::kConstant) q.push(node->output(0));
+    }
+
+    std::vector<Node*> sorted;
+    while (!q.empty()) {
+        Value* value = q.front();
+        q.pop();
+
+        for (Node* node : value->users()) {
+            auto found = input_counts.find(node);
+            if (found == input_counts.end()) continue;
+            if (--found->second != 0) continue;
+            sorted.push_back(node);
+            for (Value* value : node->outputs()) q.push(value);
+        }
+    }
+    return sorted;
+}
+
+void EmitConstants(const std::vector<Node*>& nodes, CodeEmitter* ce) {
+    for (Node* node : nodes) {
+        if (node->op_type() != Node::kConstant) continue;
+        Tensor* t = node->tensor_value().get();
+        CHECK_EQ(1, t->NumElements()) << t->dtype();
+        double value;
+        switch (t->dtype()) {
+            case Dtype::kFloat16:
+                value = static_cast<double>(t->Get<chainerx::Float16>(0));
+                break;
+            case Dtype::kFloat32:
+                value = t->Get<float>(0);
+                break;
+            case Dtype::kFloat64:
+                value = t->Get<double>(0);
+                break;
+            default:
+                CHECK(false) << t->dtype();
+        }
+        *ce << "const T " << CleanseIdent(node->output(0)->name()) << " = " << value << ";  // Constant\n";
+    }
+}
+
+// Emits constants and `nodes` in a topological order. Values of
+// `inputs` must be defined before.
+void EmitComputation(const std::vector<Node*>& nodes, const std::vector<Value*>& inputs, CodeEmitter* ce) {
+    EmitConstants(nodes, ce);
+    for (Node* node : SortNodes(nodes, inputs)) {
+        EmitNode(node, ce);
+    }
+}
+
+// Emits definitions shared by programs for the native JIT.
+void EmitNativePrologue(const std::vector<Node*>& nodes, Dtype dtype, size_t num_inputs, CodeEmitter* ce) {
+    *ce << "#include <cmath>\n";
+    *ce << "#include <cstdint>\n";
+    *ce << "#include <limits>\n";
+    for (const char* func : {"exp", "log", "sqrt", "tanh"}) {
+        *ce << "using std::" << func << ";\n";
+    }
+    *ce << "typedef " << (dtype == Dtype::kFloat32 ? "float" : "double") << " T;\n";
+    // Let GCC vectorize calls of math functions by glibc's libmvec
+    // without -ffast-math.
+    const char* suffix = dtype == Dtype::kFloat32 ? "f" : "";
+    *ce << "#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__GLIBC__)\n";
+    *ce << "#if __GLIBC_PREREQ(2, 35)\n";
+    for (const char* func : {"exp", "log", "tanh"}) {
+        *ce << "extern \"C\" __attribute__((simd(\"notinbranch\"))) T " << func << suffix << "(T) throw();\n";
+    }
+    *ce << "#endif\n";
+    *ce << "#endif\n";
+    // Inputs are contiguous along the inner loop unless the runtime
+    // defines their strides as zero for broadcast.
+    for (size_t i = 0; i < num_inputs; ++i) {
+        *ce << "#ifndef CHX_INNER_STRIDE_" << i << "\n";
+        *ce << "#define CHX_INNER_STRIDE_" << i << " 1\n";
+        *ce << "#endif\n";
+    }
+
+    EmitSigmoid(nodes, "static inline", ce);
+}
+
+// Returns true if `value` has the same value for all elements in a
+// row, i.e., its last dimension is broadcast.
+bool IsRowValue(const Value* value) {
+    const Type& type = value->type();
+    return type.HasKnownRank() && (type.ndim() == 0 || type.dims().back() == 1);
+}
+
+}  // namespace
+
+void BuildNvrtcProgram(
+        const std::vector<Node*>& nodes, int id, const std::vector<Value*>& inputs, const std::vector<Value*>& outputs, std::string* prog) {
+    const Dtype dtype = GetDtype(nodes);
 
     std::ostringstream oss;
     CodeEmitter ce(oss);
@@ -129,12 +259,7 @@ void BuildNvrtcProgram(
             CHECK(false) << "Unknown dtype: " << dtype;
     }
 
-    if (seen_ops.count(Node::kSigmoid)) {
-        ce << "__device__ T sigmoid(T x) {\n";
-        ce << "const T half = 0.5;\n";
-        ce << "return tanh(x * half) * half + half;\n";
-        ce << "}\n";
-    }
+    EmitSigmoid(nodes, "__device__", &ce);
 
     ce << "extern \"C\" __global__\n";
     ce << "void fusion" << id << "(size_t n";
@@ -151,58 +276,268 @@ void BuildNvrtcProgram(
         ce << "const T " << CleanseIdent(value->name()) << " = " << CleanseIdent(value->name(), "i_") << "[tid];  // input\n";
     }
 
-    std::map<Node*, int> input_counts;
-    for (Node* node : nodes) {
-        CHECK(input_counts.emplace(node, node->GetNumActualInputs()).second);
+    EmitComputation(nodes, inputs, &ce);
+
+    for (Value* value : outputs) {
+        ce << CleanseIdent(value->name(), "o_") << "[tid] = " << CleanseIdent(value->name()) << ";  // output\n";
     }
 
-    std::queue<Value*> q;
-    for (Value* value : inputs) {
-        q.push(value);
+    ce << "}\n";
+
+    *prog = oss.str();
+}
+
+bool BuildNativeProgram(
+        const std::vector<Node*>& nodes, int id, const std::vector<Value*>& inputs, const std::vector<Value*>& outputs, std::string* prog) {
+    const Dtype dtype = GetDtype(nodes);
+    if (dtype != Dtype::kFloat32 && dtype != Dtype::kFloat64) {
+        return false;
+    }
+
+    std::ostringstream oss;
+    CodeEmitter ce(oss);
+    EmitNativePrologue(nodes, dtype, inputs.size(), &ce);
+
+    ce << "extern \"C\" void fusion" << id << "(int64_t outer_begin, int64_t outer_end, int64_t inner_begin, int64_t inner_end, "
+       << "int64_t inner, const void* const* ins, const int64_t* outer_strides, void* const* outs) {\n";
+    ce << "for (int64_t o = outer_begin; o < outer_end; ++o) {\n";
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        ce << "const T* __restrict__ " << CleanseIdent(inputs[i]->name(), "i_") << " = static_cast<const T*>(ins[" << i
+           << "]) + o * outer_strides[" << i << "];\n";
+    }
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        ce << "T* __restrict__ " << CleanseIdent(outputs[i]->name(), "o_") << " = static_cast<T*>(outs[" << i << "]) + o * inner;\n";
+    }
+    ce << "for (int64_t j = inner_begin; j < inner_end; ++j) {\n";
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        ce << "const T " << CleanseIdent(inputs[i]->name()) << " = " << CleanseIdent(inputs[i]->name(), "i_") << "[j * CHX_INNER_STRIDE_"
+           << i << "];  // input\n";
+    }
+
+    EmitComputation(nodes, inputs, &ce);
+
+    for (Value* value : outputs) {
+        ce << CleanseIdent(value->name(), "o_") << "[j] = " << CleanseIdent(value->name()) << ";  // output\n";
+    }
+    ce << "}\n";
+    ce << "}\n";
+    ce << "}\n";
+
+    *prog = oss.str();
+    return true;
+}
+
+bool IsNativeRowReduction(const Node& node) {
+    switch (node.op_type()) {
+        case Node::kReduceSum:
+        case Node::kReduceMean:
+        case Node::kReduceMax:
+            break;
+        default:
+            return false;
+    }
+    const Type& type = node.input(0)->type();
+    if (!node.keepdims() || node.axes().size() != 1 || !type.HasKnownShape() || type.ndim() == 0) {
+        return false;
+    }
+    const int64_t axis = node.axes()[0];
+    return axis == -1 || axis == static_cast<int64_t>(type.ndim()) - 1;
+}
+
+bool BuildNativeRowReductionProgram(
+        const std::vector<Node*>& nodes,
+        int id,
+        const std::vector<Value*>& inputs,
+        const std::vector<Value*>& outputs,
+        std::string* prog,
+        std::vector<int64_t>* row_outputs) {
+    const Dtype dtype = GetDtype(nodes);
+    if (dtype != Dtype::kFloat32 && dtype != Dtype::kFloat64) {
+        return false;
     }
 
+    const std::vector<Node*> sorted = SortNodes(nodes, inputs);
+
+    // All reductions must take values of the same shape.
+    const Type* full_type = nullptr;
+    for (Node* node : sorted) {
+        if (!IsNativeRowReduction(*node)) continue;
+        const Type& type = node->input(0)->type();
+        if (full_type && full_type->dims() != type.dims()) return false;
+        full_type = &type;
+    }
+    CHECK(full_type);
+    std::vector<int64_t> row_dims = full_type->dims();
+    row_dims.back() = 1;
+
+    // Values computed once per row, and the number of reductions
+    // which must be done before each value is available.
+    std::set<Value*> is_row;
+    std::map<Value*, int> stages;
+    for (Value* value : inputs) {
+        if (IsRowValue(value)) is_row.insert(value);
+    }
     for (Node* node : nodes) {
-        if (node->op_type() != Node::kConstant) continue;
-        q.push(node->output(0));
-        Tensor* t = node->tensor_value().get();
-        CHECK_EQ(1, t->NumElements()) << t->dtype();
-        double value;
-        switch (t->dtype()) {
-            case Dtype::kFloat16:
-                value = static_cast<double>(t->Get<chainerx::Float16>(0));
-                break;
-            case Dtype::kFloat32:
-                value = t->Get<float>(0);
-                break;
-            case Dtype::kFloat64:
-                value = t->Get<double>(0);
-                break;
-            default:
-                CHECK(false) << t->dtype();
+        if (node->op_type() == Node::kConstant) is_row.insert(node->output(0));
+    }
+    int num_stages = 0;
+    for (Node* node : sorted) {
+        bool row = true;
+        int stage = 0;
+        for (Value* value : node->inputs()) {
+            if (!is_row.count(value)) row = false;
+            stage = std::max(stage, stages[value]);
+        }
+        if (IsNativeRowReduction(*node)) {
+            if (row || node->input(0)->type().dims() != full_type->dims()) return false;
+            row = true;
+            ++stage;
         }
-        ce << "const T " << CleanseIdent(node->output(0)->name()) << " = " << value << ";  // Constant\n";
+        if (row) is_row.insert(node->output(0));
+        stages[node->output(0)] = stage;
+        num_stages = std::max(num_stages, stage);
     }
 
-    while (!q.empty()) {
-        Value* value = q.front();
-        q.pop();
+    row_outputs->clear();
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        Value* value = outputs[i];
+        const bool row = is_row.count(value);
+        if (!value->type().HasKnownShape() || value->type().dims() != (row ? row_dims : full_type->dims())) return false;
+        if (row) row_outputs->push_back(i);
+    }
 
-        for (Node* node : value->users()) {
-            auto found = input_counts.find(node);
-            if (found == input_counts.end()) continue;
-            if (--found->second != 0) continue;
+    // Collects nodes which compute `targets` for each element. Values
+    // computed once per row are given.
+    auto get_element_nodes = [&sorted, &is_row](const std::vector<Value*>& targets) {
+        std::set<Value*> needed(targets.begin(), targets.end());
+        std::vector<Node*> element_nodes;
+        for (auto it = sorted.rbegin(); it != sorted.rend(); ++it) {
+            Node* node = *it;
+            if (is_row.count(node->output(0)) || !needed.count(node->output(0))) continue;
+            element_nodes.push_back(node);
+            for (Value* value : node->inputs()) needed.insert(value);
+        }
+        std::reverse(element_nodes.begin(), element_nodes.end());
+        return std::make_pair(element_nodes, needed);
+    };
+
+    std::ostringstream oss;
+    CodeEmitter ce(oss);
+    EmitNativePrologue(nodes, dtype, inputs.size(), &ce);
+
+    // Each row is scanned once per stage of reductions and once more
+    // for element-wise outputs. Rows usually stay in cache.
+    ce << "extern \"C\" void fusion" << id << "(int64_t outer_begin, int64_t outer_end, int64_t inner_begin, int64_t inner_end, "
+       << "int64_t inner, const void* const* ins, const int64_t* outer_strides, void* const* outs) {\n";
+    EmitConstants(nodes, &ce);
+    ce << "for (int64_t o = outer_begin; o < outer_end; ++o) {\n";
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        ce << "const T* __restrict__ " << CleanseIdent(inputs[i]->name(), "i_") << " = static_cast<const T*>(ins[" << i
+           << "]) + o * outer_strides[" << i << "];\n";
+    }
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        ce << "T* __restrict__ " << CleanseIdent(outputs[i]->name(), "o_") << " = static_cast<T*>(outs[" << i << "]) + o"
+           << (is_row.count(outputs[i]) ? "" : " * inner") << ";\n";
+    }
+    for (Value* value : inputs) {
+        if (is_row.count(value)) {
+            ce << "const T " << CleanseIdent(value->name()) << " = " << CleanseIdent(value->name(), "i_") << "[0];  // input\n";
+        }
+    }
+
+    auto emit_element_loop = [&](const std::vector<Value*>& targets, const std::vector<Node*>& reductions) {
+        std::vector<Node*> element_nodes;
+        std::set<Value*> needed;
+        std::tie(element_nodes, needed) = get_element_nodes(targets);
+
+        std::string sum_vars, max_vars;
+        for (Node* node : reductions) {
+            const std::string& acc = CleanseIdent(node->output(0)->name(), "r_");
+            const bool is_max = node->op_type() == Node::kReduceMax;
+            ce << "T " << acc << " = " << (is_max ? "-std::numeric_limits<T>::infinity()" : "0") << ";\n";
+            std::string* vars = is_max ? &max_vars : &sum_vars;
+            *vars += (vars->empty() ? "" : ", ") + acc;
+            if (is_max) {
+                // Comparisons drop NaN, so NaNs are counted separately
+                // by a sum, which is combined safely across lanes.
+                ce << "T " << acc << "_nans = 0;\n";
+                sum_vars += (sum_vars.empty() ? "" : ", ") + acc + "_nans";
+            }
+        }
+        ce << "#pragma omp simd";
+        if (!sum_vars.empty()) ce << " reduction(+:" << sum_vars << ")";
+        if (!max_vars.empty()) ce << " reduction(max:" << max_vars << ")";
+        ce << "\n";
+        ce << "for (int64_t j = inner_begin; j < inner_end; ++j) {\n";
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            Value* value = inputs[i];
+            if (is_row.count(value) || !needed.count(value)) continue;
+            ce << "const T " << CleanseIdent(value->name()) << " = " << CleanseIdent(value->name(), "i_") << "[j * CHX_INNER_STRIDE_"
+               << i << "];  // input\n";
+        }
+        for (Node* node : element_nodes) {
             EmitNode(node, &ce);
-            for (Value* value : node->outputs()) q.push(value);
         }
+        for (Node* node : reductions) {
+            const std::string& acc = CleanseIdent(node->output(0)->name(), "r_");
+            const std::string& input = CleanseIdent(node->input(0)->name());
+            if (node->op_type() == Node::kReduceMax) {
+                ce << acc << " = " << acc << " > " << input << " ? " << acc << " : " << input << ";\n";
+                ce << acc << "_nans += " << input << " != " << input << ";\n";
+            } else {
+                ce << acc << " += " << input << ";\n";
+            }
+        }
+        for (Value* value : outputs) {
+            if (is_row.count(value) || !std::count(targets.begin(), targets.end(), value)) continue;
+            ce << CleanseIdent(value->name(), "o_") << "[j] = " << CleanseIdent(value->name()) << ";  // output\n";
+        }
+        ce << "}\n";
+        for (Node* node : reductions) {
+            const std::string& acc = CleanseIdent(node->output(0)->name(), "r_");
+            ce << "const T " << CleanseIdent(node->output(0)->name()) << " = ";
+            if (node->op_type() == Node::kReduceMax) ce << acc << "_nans ? std::numeric_limits<T>::quiet_NaN() : ";
+            ce << acc;
+            if (node->op_type() == Node::kReduceMean) ce << " / static_cast<T>(inner)";
+            ce << ";  // " << node->op_type() << "\n";
+        }
+    };
+
+    for (int stage = 0; stage <= num_stages; ++stage) {
+        // Values computed once per row which are available now.
+        for (Node* node : sorted) {
+            if (stages[node->output(0)] == stage && is_row.count(node->output(0)) && !IsNativeRowReduction(*node)) {
+                EmitNode(node, &ce);
+            }
+        }
+        if (stage == num_stages) break;
+
+        std::vector<Node*> reductions;
+        std::vector<Value*> targets;
+        for (Node* node : sorted) {
+            if (IsNativeRowReduction(*node) && stages[node->output(0)] == stage + 1) {
+                reductions.push_back(node);
+                targets.push_back(node->input(0));
+            }
+        }
+        emit_element_loop(targets, reductions);
     }
 
+    std::vector<Value*> element_outputs;
     for (Value* value : outputs) {
-        ce << CleanseIdent(value->name(), "o_") << "[tid] = " << CleanseIdent(value->name()) << ";  // output\n";
+        if (is_row.count(value)) {
+            ce << CleanseIdent(value->name(), "o_") << "[0] = " << CleanseIdent(value->name()) << ";  // output\n";
+        } else {
+            element_outputs.push_back(value);
+        }
     }
+    if (!element_outputs.empty()) emit_element_loop(element_outputs, {});
 
+    ce << "}\n";
     ce << "}\n";
 
     *prog = oss.str();
+    return true;
 }
 
 }  // namespace chainer_compiler
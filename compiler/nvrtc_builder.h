@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdint.h>
+
 #include <string>
 #include <vector>
 
@@ -11,4 +13,26 @@ class Value;
 void BuildNvrtcProgram(
         const std::vector<Node*>& nodes, int id, const std::vector<Value*>& inputs, const std::vector<Value*>& outputs, std::string* prog);
 
+// Builds C++ code of a function which computes `nodes` on CPU. The
+// function is named `fusion<id>` and runs over rows of a (outer, inner)
+// iteration space. Returns false if `nodes` cannot be compiled for CPU.
+bool BuildNativeProgram(
+        const std::vector<Node*>& nodes, int id, const std::vector<Value*>& inputs, const std::vector<Value*>& outputs, std::string* prog);
+
+// Returns true if `node` is a reduction along the last axis which can
+// be fused with element-wise operations by the native JIT.
+bool IsNativeRowReduction(const Node& node);
+
+// Same as `BuildNativeProgram` but `nodes` contain reductions checked
+// by `IsNativeRowReduction`. The function runs over whole rows, i.e.,
+// the inner dimension is the reduced axis. Indices of `outputs` which
+// have a value per row are stored to `row_outputs`.
+bool BuildNativeRowReductionProgram(
+        const std::vector<Node*>& nodes,
+        int id,
+        const std::vector<Value*>& inputs,
+        const std::vector<Value*>& outputs,
+        std::string* prog,
+        std::vector<int64_t>* row_outputs);
+
 }  // namespace chainer_compiler
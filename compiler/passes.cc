@@ -7,7 +7,6 @@
 
 #include <compiler/computation_order/core.h>
 #include <compiler/constant_propagation.h>
-#include <compiler/dtype_inference.h>
 #include <compiler/flags.h>
 #include <compiler/flops.h>
 #include <compiler/fusion.h>
@@ -19,6 +18,7 @@
 #include <compiler/model.h>
 #include <compiler/scheduler.h>
 #include <compiler/shape_evaluator.h>
+#include <compiler/shape_inference.h>
 #include <compiler/simplifier.h>
 #include <compiler/subgraph_canonicalizer.h>
 #include <configs/backend_config.h>
@@ -93,8 +93,7 @@ void RunDefaultPasses(Graph* graph, bool gen_backprop, bool skip_scheduling) {
         }
     }
     if (!g_skip_inference) {
-        graph->InferShapes();
-        InferAllDtype(graph);
+        InferAllShapes(graph);
     }
 
     auto dump_onnx = [&graph](bool cond, const char* msg) {
@@ -115,7 +114,12 @@ void RunDefaultPasses(Graph* graph, bool gen_backprop, bool skip_scheduling) {
             Simplify(bc.GetSimplifyPreproc(), graph, gen_backprop);
         });
 
-        Recursively([gen_backprop](Graph* graph) { MergeOperations(graph, gen_backprop); }, graph);
+        Recursively(*backend_config, graph, [gen_backprop](const BackendConfig& bc, Graph* graph) {
+            // Fusers for external compilers do not know the merged ops.
+            const bool merge_activations = bc.HasOp("ChainerConvBiasActivation") && bc.HasOp("ChainerGemmBiasActivation") &&
+                                           !g_use_tvm && !g_use_ngraph && !g_use_dldt;
+            MergeOperations(graph, gen_backprop, merge_activations);
+        });
 
         Recursively(PropagateConstants, graph);
 
@@ -145,7 +149,7 @@ void RunDefaultPasses(Graph* graph, bool gen_backprop, bool skip_scheduling) {
     }
 
     // TODO(hamaji): Make it possible to infer shapes here.
-    // if (!g_skip_inference) graph->InferShapes();
+    // if (!g_skip_inference) InferAllShapes(graph);
 
     if (!skip_scheduling) {
         Recursively(*backend_config, graph, [gen_backprop](const BackendConfig& bc, Graph* graph) {
@@ -179,7 +183,8 @@ void RunDefaultPasses(Graph* graph, bool gen_backprop, bool skip_scheduling) {
     }
 
     int64_t order = 0;
-    Recursively([&order](Graph* g) { order = ScheduleComputation(*g, order); }, graph);
+    const SchedulerType scheduler_type = GetSchedulerType(g_scheduler);
+    Recursively([&order, scheduler_type](Graph* g) { order = ScheduleComputation(*g, order, scheduler_type); }, graph);
 
     if (g_compiler_log) {
         ShowSimulatedMemoryUsage(*graph);
@@ -195,7 +200,7 @@ void RunDefaultPasses(Graph* graph, bool gen_backprop, bool skip_scheduling) {
 
 void RunDefaultPassesBeforeGradient(Graph* graph) {
     std::unique_ptr<BackendConfig> backend_config(BackendConfig::FromName(g_backend_name));
-    graph->InferShapes();
+    InferAllShapes(graph);
     CanonicalizeSubGraphs(graph);
     Recursively(*backend_config, graph, [](const BackendConfig& bc, Graph* graph) { Simplify(bc.GetSimplify(), graph, true); });
     Recursively(PropagateConstants, graph);
@@ -1,13 +1,22 @@
 #include "compiler/scheduler.h"
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <map>
 #include <queue>
+#include <random>
+#include <set>
+#include <tuple>
+#include <unordered_set>
 #include <vector>
 
+#include <compiler/flags.h>
+#include <compiler/flops.h>
 #include <compiler/graph.h>
+#include <compiler/graph_view.h>
 #include <compiler/log.h>
 #include <compiler/node.h>
 #include <compiler/value.h>
@@ -103,41 +112,42 @@ std::vector<Node*> DelaySimpleNodes(const std::vector<Node*>& nodes_in) {
 }
 
 // A simple topological sort.
-std::vector<Node*> ScheduleNaively(const Graph& graph, const std::vector<Value*>& input_values, const std::vector<Value*>& output_values) {
-    std::map<Node*, int> input_counts = graph.GetNecessaryNodesAndInputCounts(output_values);
+std::vector<Node*> ScheduleNaively(const GraphView& view, const std::vector<Value*>& input_values, const std::vector<Value*>& output_values) {
+    std::vector<int> input_counts = view.GetNecessaryNodesAndInputCounts(output_values);
 
-    std::queue<const Value*> q;
+    std::queue<int> q;
     // Sort them topologically.
     for (const Value* value : input_values) {
-        q.push(value);
+        const int value_id = view.ValueId(value);
+        if (value_id >= 0) q.push(value_id);
     }
 
     std::vector<Node*> nodes;
 
-    auto schedule_node = [&nodes, &q](Node* node) {
+    auto schedule_node = [&view, &nodes, &q](int node_id) {
+        Node* node = view.node(node_id);
         if (node->chainer_order() < 0) nodes.push_back(node);
-        for (const Value* output : node->outputs()) {
+        for (int output : view.outputs(node_id)) {
             q.push(output);
         }
     };
 
     // Schedule nodes which are already schedulable (e.g., Constant).
-    for (const auto& p : input_counts) {
-        if (p.second == 0) {
-            schedule_node(p.first);
+    for (int node_id = 0; node_id < view.num_nodes(); ++node_id) {
+        if (input_counts[node_id] == 0) {
+            schedule_node(node_id);
         }
     }
 
     while (!q.empty()) {
-        const Value* value = q.front();
+        const int value_id = q.front();
         q.pop();
-        if (value->IsNull()) continue;
-        for (Node* node : value->users()) {
-            auto found = input_counts.find(node);
-            if (found == input_counts.end()) continue;
-            int cnt = --found->second;
+        if (view.is_null(value_id)) continue;
+        for (int node_id : view.users(value_id)) {
+            if (input_counts[node_id] < 0) continue;
+            int cnt = --input_counts[node_id];
             if (cnt > 0) continue;
-            schedule_node(node);
+            schedule_node(node_id);
         }
     }
     return nodes;
@@ -145,52 +155,53 @@ std::vector<Node*> ScheduleNaively(const Graph& graph, const std::vector<Value*>
 
 // A greedy scheduler which tries to reduce the current working
 // memory in greedy mannar.
-std::vector<Node*> ScheduleGreedy(const Graph& graph, const std::vector<Value*>& input_values, const std::vector<Value*>& output_values) {
-    std::map<Node*, int> input_counts = graph.GetNecessaryNodesAndInputCounts(output_values);
+std::vector<Node*> ScheduleGreedy(const GraphView& view, const std::vector<Value*>& input_values, const std::vector<Value*>& output_values) {
+    std::vector<int> input_counts = view.GetNecessaryNodesAndInputCounts(output_values);
     // A map from estimated memory increase to schedulable nodes.
-    std::multimap<int64_t, Node*> q;
+    std::multimap<int64_t, int> q;
     // TODO(hamaji): Redesign scheduler to allow delaying nodes for
     // the second scheduling.
     bool has_already_scheduled_nodes = false;
 
-    auto enqueue_node = [&q](Node* node) {
+    auto enqueue_node = [&view, &q](int node_id) {
+        Node* node = view.node(node_id);
         int64_t estimated_memory_increase = EstimateMemoryIncrease(node);
         if (node->op_type() == Node::kRelu) estimated_memory_increase += 1000 * 1000 * 1000;
-        q.emplace(estimated_memory_increase, node);
+        q.emplace(estimated_memory_increase, node_id);
     };
 
-    auto make_value_ready = [&input_counts, enqueue_node](const Value* value) {
-        if (value->IsNull()) return;
-        for (Node* node : value->users()) {
-            auto found = input_counts.find(node);
-            if (found == input_counts.end()) continue;
-            int cnt = --found->second;
-            CHECK_LE(0, cnt) << node->ToString();
+    auto make_value_ready = [&view, &input_counts, enqueue_node](int value_id) {
+        if (value_id < 0 || view.is_null(value_id)) return;
+        for (int node_id : view.users(value_id)) {
+            if (input_counts[node_id] < 0) continue;
+            int cnt = --input_counts[node_id];
+            CHECK_LE(0, cnt) << view.node(node_id)->ToString();
             if (cnt != 0) continue;
-            enqueue_node(node);
+            enqueue_node(node_id);
         }
     };
 
     // Schedule nodes which are already schedulable (e.g., Constant).
-    for (const auto& p : input_counts) {
-        if (p.second == 0) {
-            enqueue_node(p.first);
+    for (int node_id = 0; node_id < view.num_nodes(); ++node_id) {
+        if (input_counts[node_id] == 0) {
+            enqueue_node(node_id);
         }
     }
 
     for (const Value* value : input_values) {
-        make_value_ready(value);
+        make_value_ready(view.ValueId(value));
     }
 
     std::vector<Node*> nodes;
     while (!q.empty()) {
-        Node* node = q.begin()->second;
+        const int node_id = q.begin()->second;
         q.erase(q.begin());
+        Node* node = view.node(node_id);
         if (node->chainer_order() < 0) {
             nodes.push_back(node);
             has_already_scheduled_nodes = true;
         }
-        for (Value* output : node->outputs()) {
+        for (int output : view.outputs(node_id)) {
             make_value_ready(output);
         }
     }
@@ -199,63 +210,449 @@ std::vector<Node*> ScheduleGreedy(const Graph& graph, const std::vector<Value*>&
     return nodes;
 }
 
+// Nodes, values, and dependencies between them for the search of the
+// order with the minimum peak memory usage. Peak memory usage is
+// estimated as `SimulateMemoryUsage` does, i.e., outputs of a node
+// are allocated before its inputs are freed, and graph outputs and
+// parameters are never freed.
+struct PeakMemoryProblem {
+    std::vector<Node*> nodes;
+    // Indices in `nodes` indexed by node IDs of the `GraphView`, or -1
+    // for unnecessary nodes.
+    std::vector<int> node_ids;
+    // Nodes which use outputs of each node, as many times as they use.
+    std::vector<std::vector<int>> consumers;
+    // Pairs of input value IDs and the number of their uses.
+    std::vector<std::vector<std::pair<int, int>>> inputs;
+    std::vector<std::vector<int>> outputs;
+    std::vector<int64_t> value_bytes;
+    std::vector<bool> value_pinned;
+    std::vector<uint64_t> node_hashes;
+};
+
+struct PeakMemoryState {
+    std::vector<int> input_counts;
+    std::vector<int> num_uses;
+    std::vector<int> ready;
+    std::vector<int> order;
+    int64_t mem{0};
+    int64_t peak{0};
+    // The XOR of `node_hashes` of nodes in `order`.
+    uint64_t hash{0};
+};
+
+void InitPeakMemoryProblem(
+        const GraphView& view,
+        const std::vector<Value*>& input_values,
+        const std::vector<Value*>& output_values,
+        const std::vector<int>& input_counts,
+        PeakMemoryProblem* problem,
+        PeakMemoryState* state) {
+    problem->node_ids.assign(view.num_nodes(), -1);
+    for (int node_id = 0; node_id < view.num_nodes(); ++node_id) {
+        if (input_counts[node_id] < 0) continue;
+        problem->node_ids[node_id] = problem->nodes.size();
+        problem->nodes.push_back(view.node(node_id));
+    }
+    const size_t num_nodes = problem->nodes.size();
+
+    std::vector<bool> outputs(view.num_values());
+    for (const Value* value : output_values) {
+        const int value_id = view.ValueId(value);
+        if (value_id >= 0) outputs[value_id] = true;
+    }
+    std::vector<int> value_ids(view.num_values(), -1);
+    auto get_value_id = [&](int view_value_id) {
+        int& id = value_ids[view_value_id];
+        if (id < 0) {
+            const Value* value = view.value(view_value_id);
+            id = problem->value_bytes.size();
+            problem->value_bytes.push_back(std::max<int64_t>(0, value->GetNBytes()));
+            problem->value_pinned.push_back(value->IsOutput() || value->initializer() || outputs[view_value_id]);
+            state->num_uses.push_back(0);
+        }
+        return id;
+    };
+
+    std::mt19937_64 rng(num_nodes);
+    problem->consumers.resize(num_nodes);
+    problem->inputs.resize(num_nodes);
+    problem->outputs.resize(num_nodes);
+    for (int node_id = 0; node_id < view.num_nodes(); ++node_id) {
+        const int i = problem->node_ids[node_id];
+        if (i < 0) continue;
+        std::map<int, int> uses;
+        for (int input : view.inputs(node_id)) {
+            if (view.is_null(input)) continue;
+            int id = get_value_id(input);
+            ++uses[id];
+            ++state->num_uses[id];
+        }
+        problem->inputs[i].assign(uses.begin(), uses.end());
+        for (int output : view.outputs(node_id)) {
+            if (view.is_null(output)) continue;
+            problem->outputs[i].push_back(get_value_id(output));
+            for (int user : view.users(output)) {
+                if (problem->node_ids[user] >= 0) problem->consumers[i].push_back(problem->node_ids[user]);
+            }
+        }
+        problem->node_hashes.push_back(rng());
+        state->input_counts.push_back(input_counts[node_id]);
+    }
+
+    std::vector<bool> seen_inputs(view.num_values());
+    for (const Value* value : input_values) {
+        const int value_id = view.ValueId(value);
+        if (value_id < 0 || value->IsNull()) continue;
+        for (int user : view.users(value_id)) {
+            if (problem->node_ids[user] >= 0) --state->input_counts[problem->node_ids[user]];
+        }
+        if (value_ids[value_id] >= 0 && !seen_inputs[value_id]) {
+            seen_inputs[value_id] = true;
+            state->mem += problem->value_bytes[value_ids[value_id]];
+        }
+    }
+    state->peak = state->mem;
+
+    for (size_t i = 0; i < num_nodes; ++i) {
+        if (state->input_counts[i] == 0) state->ready.push_back(i);
+    }
+}
+
+// Returns the peak and the current memory usage after `node_id` is
+// run in `state`.
+std::pair<int64_t, int64_t> EstimateMemoryAfter(const PeakMemoryProblem& problem, const PeakMemoryState& state, int node_id) {
+    int64_t mem = state.mem;
+    for (int id : problem.outputs[node_id]) mem += problem.value_bytes[id];
+    const int64_t peak = std::max(state.peak, mem);
+    for (const std::pair<int, int>& p : problem.inputs[node_id]) {
+        if (state.num_uses[p.first] == p.second && !problem.value_pinned[p.first]) mem -= problem.value_bytes[p.first];
+    }
+    for (int id : problem.outputs[node_id]) {
+        if (state.num_uses[id] == 0 && !problem.value_pinned[id]) mem -= problem.value_bytes[id];
+    }
+    return {peak, mem};
+}
+
+void RunNode(const PeakMemoryProblem& problem, int node_id, PeakMemoryState* state) {
+    std::tie(state->peak, state->mem) = EstimateMemoryAfter(problem, *state, node_id);
+    for (const std::pair<int, int>& p : problem.inputs[node_id]) {
+        state->num_uses[p.first] -= p.second;
+    }
+    auto found = std::find(state->ready.begin(), state->ready.end(), node_id);
+    CHECK(found != state->ready.end());
+    state->ready.erase(found);
+    for (int user : problem.consumers[node_id]) {
+        if (--state->input_counts[user] == 0) state->ready.push_back(user);
+    }
+    state->order.push_back(node_id);
+    state->hash ^= problem.node_hashes[node_id];
+}
+
+// Searches the order of nodes which minimizes the peak memory usage.
+// Each step extends `beam_width` partial orders with the lowest peak
+// and current memory usage. Partial orders of the same set of nodes
+// are merged since the rest of the computation depends only on the
+// set. The search is exhaustive if `beam_width` is unlimited.
+PeakMemoryState SearchMinPeakMemoryOrder(const PeakMemoryProblem& problem, const PeakMemoryState& initial, size_t beam_width, int time_budget_ms) {
+    struct Candidate {
+        size_t state;
+        int node_id;
+        int64_t peak;
+        int64_t mem;
+        uint64_t hash;
+    };
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(time_budget_ms);
+    std::vector<PeakMemoryState> beam = {initial};
+    for (size_t step = 0; step < problem.nodes.size(); ++step) {
+        if (beam_width > 1 && std::chrono::steady_clock::now() > deadline) {
+            CLOG() << "Scheduler: time budget exceeded at step " << step << "/" << problem.nodes.size() << std::endl;
+            beam_width = 1;
+        }
+
+        std::vector<Candidate> candidates;
+        for (size_t i = 0; i < beam.size(); ++i) {
+            for (int node_id : beam[i].ready) {
+                std::pair<int64_t, int64_t> usage = EstimateMemoryAfter(problem, beam[i], node_id);
+                candidates.push_back({i, node_id, usage.first, usage.second, beam[i].hash ^ problem.node_hashes[node_id]});
+            }
+        }
+        if (candidates.empty()) break;
+        std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+            return std::make_pair(a.peak, a.mem) < std::make_pair(b.peak, b.mem);
+        });
+
+        std::vector<PeakMemoryState> next_beam;
+        std::unordered_set<uint64_t> seen;
+        for (const Candidate& candidate : candidates) {
+            if (next_beam.size() >= beam_width) break;
+            if (!seen.insert(candidate.hash).second) continue;
+            next_beam.push_back(beam[candidate.state]);
+            RunNode(problem, candidate.node_id, &next_beam.back());
+        }
+        beam.swap(next_beam);
+    }
+    return beam[0];
+}
+
+// A scheduler which searches the order with the minimum peak memory
+// usage. The order by `ScheduleGreedy` is used when it is not worse.
+std::vector<Node*> ScheduleMinPeakMemory(
+        const GraphView& view, const std::vector<Value*>& input_values, const std::vector<Value*>& output_values) {
+    // The exhaustive search visits at most C(20, 10) states per step.
+    const size_t kMaxNodesForExhaustiveSearch = 20;
+    const size_t kDefaultBeamWidth = 16;
+    const int kDefaultTimeBudgetMs = 1000;
+
+    std::vector<Node*> greedy_nodes = ScheduleGreedy(view, input_values, output_values);
+
+    const std::vector<int> input_counts = view.GetNecessaryNodesAndInputCounts(output_values);
+    for (int node_id = 0; node_id < view.num_nodes(); ++node_id) {
+        // The search does not model values of already scheduled
+        // nodes, so such graphs use the greedy order.
+        if (input_counts[node_id] >= 0 && view.node(node_id)->chainer_order() >= 0) return greedy_nodes;
+    }
+
+    PeakMemoryProblem problem;
+    PeakMemoryState initial;
+    InitPeakMemoryProblem(view, input_values, output_values, input_counts, &problem, &initial);
+
+    PeakMemoryState greedy = initial;
+    for (Node* node : greedy_nodes) {
+        RunNode(problem, problem.node_ids[view.NodeId(node)], &greedy);
+    }
+
+    const size_t beam_width = problem.nodes.size() <= kMaxNodesForExhaustiveSearch
+                                      ? std::numeric_limits<size_t>::max()
+                                      : (g_scheduler_beam_width > 0 ? g_scheduler_beam_width : kDefaultBeamWidth);
+    const int time_budget_ms = g_scheduler_time_budget > 0 ? g_scheduler_time_budget : kDefaultTimeBudgetMs;
+    PeakMemoryState searched = SearchMinPeakMemoryOrder(problem, initial, beam_width, time_budget_ms);
+    CLOG() << "Scheduler (" << view.graph().name() << "): peak memory " << greedy.peak << " (greedy) => " << searched.peak
+           << " (min_peak)" << std::endl;
+    if (searched.order.size() != problem.nodes.size() || greedy.peak <= searched.peak) {
+        return greedy_nodes;
+    }
+
+    std::vector<Node*> nodes;
+    for (int node_id : searched.order) {
+        nodes.push_back(problem.nodes[node_id]);
+    }
+    return nodes;
+}
+
+// The estimated cost of `node`, which is its FLOPs plus the overhead
+// to run an op.
+int64_t EstimateCost(const Node& node) {
+    const int64_t kOpOverheadFlops = 10000;
+    return std::max<int64_t>(0, CalculateFlops(node)) + kOpOverheadFlops;
+}
+
+// Returns the costs of the most expensive paths from necessary nodes
+// to outputs, including nodes themselves. Unnecessary nodes have -1.
+std::vector<int64_t> CalculateBottomLevels(const GraphView& view, const std::vector<int>& input_counts) {
+    std::vector<int> num_users(view.num_nodes(), -1);
+    for (int node_id = 0; node_id < view.num_nodes(); ++node_id) {
+        if (input_counts[node_id] >= 0) num_users[node_id] = 0;
+    }
+    for (int node_id = 0; node_id < view.num_nodes(); ++node_id) {
+        if (input_counts[node_id] < 0) continue;
+        for (int input : view.inputs(node_id)) {
+            const int producer = view.producer(input);
+            if (producer >= 0 && num_users[producer] >= 0) ++num_users[producer];
+        }
+    }
+
+    // Visit nodes from outputs to inputs.
+    std::vector<int64_t> levels(view.num_nodes(), -1);
+    std::vector<int> q;
+    for (int node_id = 0; node_id < view.num_nodes(); ++node_id) {
+        if (num_users[node_id] == 0) q.push_back(node_id);
+    }
+    while (!q.empty()) {
+        const int node_id = q.back();
+        q.pop_back();
+        int64_t level = 0;
+        for (int output : view.outputs(node_id)) {
+            for (int user : view.users(output)) {
+                level = std::max(level, levels[user]);
+            }
+        }
+        levels[node_id] = level + EstimateCost(*view.node(node_id));
+        for (int input : view.inputs(node_id)) {
+            const int producer = view.producer(input);
+            if (producer >= 0 && num_users[producer] > 0 && --num_users[producer] == 0) q.push_back(producer);
+        }
+    }
+    return levels;
+}
+
+// A list scheduler which reduces the latency with inter-op
+// parallelism. Nodes are split into stages of independent nodes.
+// Each stage takes ready nodes in the descending order of costs of
+// their critical paths, up to `g_scheduler_num_workers` nodes. The
+// stage of each node is stored to `stages`.
+std::vector<Node*> ScheduleCriticalPath(
+        const GraphView& view, const std::vector<Value*>& input_values, const std::vector<Value*>& output_values, std::vector<int>* stages) {
+    std::vector<int> input_counts = view.GetNecessaryNodesAndInputCounts(output_values);
+    const std::vector<int64_t> levels = CalculateBottomLevels(view, input_counts);
+
+    // Ready nodes ordered by their critical paths, and then by their
+    // positions in the graph.
+    std::set<std::pair<int64_t, int>> q;
+    std::vector<int> already_scheduled;
+
+    auto enqueue_node = [&](int node_id) {
+        if (view.node(node_id)->chainer_order() >= 0) {
+            already_scheduled.push_back(node_id);
+        } else {
+            CHECK_LE(0, levels[node_id]) << view.node(node_id)->ToString();
+            q.emplace(-levels[node_id], node_id);
+        }
+    };
+
+    auto make_value_ready = [&view, &input_counts, enqueue_node](int value_id) {
+        if (value_id < 0 || view.is_null(value_id)) return;
+        for (int node_id : view.users(value_id)) {
+            if (input_counts[node_id] < 0) continue;
+            int cnt = --input_counts[node_id];
+            CHECK_LE(0, cnt) << view.node(node_id)->ToString();
+            if (cnt != 0) continue;
+            enqueue_node(node_id);
+        }
+    };
+
+    // Nodes which were already run make their outputs ready
+    // immediately.
+    auto run_already_scheduled_nodes = [&view, &already_scheduled, make_value_ready]() {
+        while (!already_scheduled.empty()) {
+            const int node_id = already_scheduled.back();
+            already_scheduled.pop_back();
+            for (int output : view.outputs(node_id)) {
+                make_value_ready(output);
+            }
+        }
+    };
+
+    // Schedule nodes which are already schedulable (e.g., Constant).
+    for (int node_id = 0; node_id < view.num_nodes(); ++node_id) {
+        if (input_counts[node_id] == 0) {
+            enqueue_node(node_id);
+        }
+    }
+
+    for (const Value* value : input_values) {
+        make_value_ready(view.ValueId(value));
+    }
+
+    const size_t max_stage_size = g_scheduler_num_workers > 0 ? g_scheduler_num_workers : std::numeric_limits<size_t>::max();
+    std::vector<Node*> nodes;
+    for (int stage = 0;; ++stage) {
+        run_already_scheduled_nodes();
+        if (q.empty()) break;
+
+        std::vector<int> stage_nodes;
+        while (!q.empty() && stage_nodes.size() < max_stage_size) {
+            stage_nodes.push_back(q.begin()->second);
+            q.erase(q.begin());
+        }
+        for (int node_id : stage_nodes) {
+            nodes.push_back(view.node(node_id));
+            stages->push_back(stage);
+            for (int output : view.outputs(node_id)) {
+                make_value_ready(output);
+            }
+        }
+    }
+    return nodes;
+}
+
 void CheckSanity(
-        const Graph& graph,
+        const GraphView& view,
         const std::vector<Value*>& input_values,
         const std::vector<Value*>& output_values,
         const std::vector<Node*>& nodes) {
-    std::set<const Value*> values;
+    std::vector<bool> values(view.num_values());
     for (const Value* value : input_values) {
-        values.emplace(value);
+        const int value_id = view.ValueId(value);
+        if (value_id >= 0) values[value_id] = true;
     }
     for (const Node* node : nodes) {
-        for (const Value* output : node->outputs()) values.emplace(output);
+        for (int output : view.outputs(view.NodeId(node))) values[output] = true;
     }
 
-    std::map<Node*, int> input_counts = graph.GetNecessaryNodesAndInputCounts(output_values);
-    for (Node* node : graph.nodes()) {
-        if (node->chainer_order() > 0) input_counts.erase(node);
+    std::vector<int> input_counts = view.GetNecessaryNodesAndInputCounts(output_values);
+    for (int node_id = 0; node_id < view.num_nodes(); ++node_id) {
+        if (view.node(node_id)->chainer_order() > 0) input_counts[node_id] = -1;
     }
-    for (Node* node : nodes) {
-        input_counts.erase(node);
+    for (const Node* node : nodes) {
+        input_counts[view.NodeId(node)] = -1;
     }
-    if (!input_counts.empty()) {
-        for (auto p : input_counts) {
-            Node* node = p.first;
-            std::cerr << "Failed to schedule (" << graph.name() << "): " << node->ToString() << std::endl;
-            for (Value* value : node->inputs()) {
-                if (!values.count(value) && !value->name().empty()) {
-                    std::cerr << " " << value->name() << " cannot be ready\n";
-                }
+    bool ok = true;
+    for (int node_id = 0; node_id < view.num_nodes(); ++node_id) {
+        if (input_counts[node_id] < 0) continue;
+        ok = false;
+        std::cerr << "Failed to schedule (" << view.graph().name() << "): " << view.node(node_id)->ToString() << std::endl;
+        for (int input : view.inputs(node_id)) {
+            const Value* value = view.value(input);
+            if (!values[input] && !value->name().empty()) {
+                std::cerr << " " << value->name() << " cannot be ready\n";
             }
         }
-        graph.DumpONNXOnFailure();
+    }
+    if (!ok) {
+        view.graph().DumpONNXOnFailure();
         CHECK(false);
     }
 }
 
 }  // namespace
 
+SchedulerType GetSchedulerType(const std::string& name) {
+    if (name.empty() || name == "greedy") return SchedulerType::kGreedy;
+    if (name == "min_peak") return SchedulerType::kMinPeakMemory;
+    if (name == "critical_path") return SchedulerType::kCriticalPath;
+    CHECK(false) << "Unknown scheduler: " << name;
+}
+
 int64_t ScheduleComputation(
         const Graph& graph,
         const std::vector<Value*>& input_values,
         const std::vector<Value*>& output_values,
         int64_t order,
         SchedulerType scheduler_type) {
+    const GraphView view(graph);
     std::vector<Node*> nodes;
+    // Stages of `nodes` if the scheduler splits them into stages.
+    std::vector<int> stages;
     switch (scheduler_type) {
         case SchedulerType::kNaive:
-            nodes = ScheduleNaively(graph, input_values, output_values);
+            nodes = ScheduleNaively(view, input_values, output_values);
             break;
         case SchedulerType::kGreedy:
-            nodes = ScheduleGreedy(graph, input_values, output_values);
+            nodes = ScheduleGreedy(view, input_values, output_values);
+            break;
+        case SchedulerType::kMinPeakMemory:
+            nodes = ScheduleMinPeakMemory(view, input_values, output_values);
+            break;
+        case SchedulerType::kCriticalPath:
+            nodes = ScheduleCriticalPath(view, input_values, output_values, &stages);
             break;
     }
 
-    CheckSanity(graph, input_values, output_values, nodes);
+    CheckSanity(view, input_values, output_values, nodes);
 
-    for (Node* node : nodes) {
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        Node* node = nodes[i];
         node->set_chainer_order(++order);
+        // A stage is identified by the order of its first node.
+        if (stages.empty()) {
+            node->set_chainer_parallel_stage(-1);
+        } else if (i == 0 || stages[i] != stages[i - 1]) {
+            node->set_chainer_parallel_stage(order);
+        } else {
+            node->set_chainer_parallel_stage(nodes[i - 1]->chainer_parallel_stage());
+        }
     }
     return order;
 }
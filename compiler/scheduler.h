@@ -1,4 +1,5 @@
 #include <stdint.h>
+#include <string>
 #include <vector>
 
 namespace chainer_compiler {
@@ -9,8 +10,19 @@ class Value;
 enum class SchedulerType {
     kNaive,
     kGreedy,
+    // Searches an order which minimizes the peak memory usage. The
+    // search is exhaustive for small graphs, and a beam search for
+    // others.
+    kMinPeakMemory,
+    // Runs nodes on critical paths first and groups independent nodes
+    // into stages which can run in parallel.
+    kCriticalPath,
 };
 
+// Returns the scheduler specified by `name`, which is "greedy",
+// "min_peak", or "critical_path". Returns kGreedy for an empty name.
+SchedulerType GetSchedulerType(const std::string& name);
+
 int64_t ScheduleComputation(
         const Graph& graph,
         const std::vector<Value*>& input_values,
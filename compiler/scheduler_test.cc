@@ -3,7 +3,9 @@
 #include <compiler/onnx.h>
 
 #include <common/log.h>
+#include <compiler/flags.h>
 #include <compiler/graph.h>
+#include <compiler/memory_simulator.h>
 #include <compiler/node.h>
 #include <compiler/scheduler.h>
 
@@ -94,7 +96,82 @@ TEST_P(SchedulerTest, MultipleTimes) {
     EXPECT_EQ(2, n3->chainer_order());
 }
 
-INSTANTIATE_TEST_CASE_P(ForEachScheduler, SchedulerTest, ::testing::Values(SchedulerType::kNaive, SchedulerType::kGreedy));
+INSTANTIATE_TEST_CASE_P(
+        ForEachScheduler,
+        SchedulerTest,
+        ::testing::Values(SchedulerType::kNaive, SchedulerType::kGreedy, SchedulerType::kMinPeakMemory, SchedulerType::kCriticalPath));
+
+int64_t SchedulePeakMemory(SchedulerType scheduler_type) {
+    Graph graph("test");
+    Value* x = graph.AddInputValue("x", Type(Dtype::kFloat32, {1, 100}));
+    Value* y = graph.AddInputValue("y", Type(Dtype::kFloat32, {10, 1}));
+    Value* z = graph.AddInputValue("z", Type(Dtype::kFloat32, {100, 1}));
+    Value* small = graph.AddValue("small", Type(Dtype::kFloat32, {10, 100}));
+    Value* large = graph.AddValue("large", Type(Dtype::kFloat32, {100, 100}));
+    Value* reduced = graph.AddValue("reduced", Type(Dtype::kFloat32, {}));
+    Value* out = graph.AddOutputValue("out", Type(Dtype::kFloat32, {10, 100}));
+
+    // The greedy scheduler runs the first Add first since it increases
+    // less memory, but `small` is alive while `large` is computed.
+    graph.AddNode(Node::kAdd, {x, y}, {small});
+    graph.AddNode(Node::kAdd, {x, z}, {large});
+    graph.AddNode(Node::kReduceSum, {large}, {reduced})->set_keepdims(false);
+    graph.AddNode(Node::kAdd, {small, reduced}, {out});
+
+    ScheduleComputation(graph, 0, scheduler_type);
+    EXPECT_EQ(4UL, graph.GetComputationSequence().size());
+    return SimulateMemoryUsage(graph).peak;
+}
+
+TEST(MinPeakMemorySchedulerTest, Basic) {
+    const int64_t greedy_peak = SchedulePeakMemory(SchedulerType::kGreedy);
+    const int64_t min_peak = SchedulePeakMemory(SchedulerType::kMinPeakMemory);
+    // `y` is freed before `large` is computed.
+    EXPECT_EQ((100 + 100 + 10 * 100 + 100 * 100) * 4, greedy_peak);
+    EXPECT_EQ((100 + 10 + 100 + 100 * 100) * 4, min_peak);
+}
+
+TEST(CriticalPathSchedulerTest, Basic) {
+    for (int num_workers : {0, 1}) {
+        g_scheduler_num_workers = num_workers;
+        Graph graph("test");
+        const Type type(Dtype::kFloat32, {10, 10});
+        Value* in = graph.AddInputValue("in", type);
+        Value* a1 = graph.AddValue("a1", type);
+        Value* a2 = graph.AddValue("a2", type);
+        Value* a3 = graph.AddValue("a3", type);
+        Value* b1 = graph.AddValue("b1", type);
+        Value* out = graph.AddOutputValue("out", type);
+
+        // The short branch comes first in the graph.
+        Node* nb1 = graph.AddNode(Node::kRelu, {in}, {b1});
+        Node* na1 = graph.AddNode(Node::kRelu, {in}, {a1});
+        Node* na2 = graph.AddNode(Node::kRelu, {a1}, {a2});
+        Node* na3 = graph.AddNode(Node::kRelu, {a2}, {a3});
+        Node* nout = graph.AddNode(Node::kAdd, {a3, b1}, {out});
+
+        ScheduleComputation(graph, 0, SchedulerType::kCriticalPath);
+
+        const std::vector<const Node*> nodes(graph.GetComputationSequence());
+        if (num_workers == 0) {
+            EXPECT_EQ(std::vector<const Node*>({na1, nb1, na2, na3, nout}), nodes);
+            // The two branches start in the same stage.
+            EXPECT_EQ(1, na1->chainer_parallel_stage());
+            EXPECT_EQ(1, nb1->chainer_parallel_stage());
+            EXPECT_EQ(3, na2->chainer_parallel_stage());
+            EXPECT_EQ(4, na3->chainer_parallel_stage());
+            EXPECT_EQ(5, nout->chainer_parallel_stage());
+        } else {
+            // `na3` and `nb1` have the same critical path, so the
+            // position in the graph breaks the tie.
+            EXPECT_EQ(std::vector<const Node*>({na1, na2, nb1, na3, nout}), nodes);
+            for (const Node* node : nodes) {
+                EXPECT_EQ(node->chainer_order(), node->chainer_parallel_stage());
+            }
+        }
+    }
+    g_scheduler_num_workers = 0;
+}
 
 }  // namespace
 }  // namespace chainer_compiler
@@ -0,0 +1,740 @@
+#include "compiler/shape_inference.h"
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <compiler/onnx.h>
+#include <onnx/shape_inference/implementation.h>
+
+#include <common/log.h>
+#include <compiler/dtype_inference.h>
+#include <compiler/flags.h>
+#include <compiler/graph.h>
+#include <compiler/log.h>
+#include <compiler/node.h>
+#include <compiler/tensor.h>
+#include <compiler/type.h>
+#include <compiler/value.h>
+
+namespace chainer_compiler {
+namespace {
+
+typedef std::vector<int64_t> Dims;
+
+// Integer constants up to this size are given to ONNX's shape
+// inference so it can infer shapes which depend on them (e.g.,
+// Reshape). Other constants such as weights are never serialized.
+constexpr int64_t kMaxConstantElements = 64;
+
+const Tensor* GetConstant(const Value* value) {
+    if (const Tensor* initializer = value->initializer()) return initializer;
+    const Node* producer = value->producer();
+    if (producer && producer->op_type() == Node::kConstant) return producer->tensor_value().get();
+    return nullptr;
+}
+
+bool GetConstantInts(const Value* value, Dims* ints) {
+    const Tensor* tensor = GetConstant(value);
+    if (!tensor) return false;
+    ints->clear();
+    for (int64_t i = 0; i < tensor->NumElements(); ++i) {
+        switch (tensor->dtype()) {
+            case Dtype::kInt32:
+                ints->push_back(tensor->Get<int32_t>(i));
+                break;
+            case Dtype::kInt64:
+                ints->push_back(tensor->Get<int64_t>(i));
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+int64_t NormalizeAxis(int64_t axis, size_t ndim) {
+    return axis < 0 ? axis + ndim : axis;
+}
+
+// Returns the product of `dims` in [begin, end), or -1 if any of them
+// is unknown.
+int64_t Product(const Dims& dims, size_t begin, size_t end) {
+    int64_t num = 1;
+    for (size_t i = begin; i < end; ++i) {
+        if (dims[i] < 0) return -1;
+        num *= dims[i];
+    }
+    return num;
+}
+
+// Broadcasts dimensions of `types` in the numpy way.
+bool Broadcast(const std::vector<const Type*>& types, Dims* dims) {
+    size_t ndim = 0;
+    for (const Type* type : types) {
+        if (!type->HasKnownRank()) return false;
+        ndim = std::max(ndim, type->ndim());
+    }
+    dims->assign(ndim, 1);
+    std::vector<bool> has_unknown(ndim);
+    for (const Type* type : types) {
+        const size_t offset = ndim - type->ndim();
+        for (size_t i = 0; i < type->ndim(); ++i) {
+            const int64_t d = type->dims()[i];
+            if (d < 0) {
+                has_unknown[offset + i] = true;
+            } else if (d != 1) {
+                (*dims)[offset + i] = d;
+            }
+        }
+    }
+    for (size_t i = 0; i < ndim; ++i) {
+        if (has_unknown[i] && (*dims)[i] == 1) (*dims)[i] = -1;
+    }
+    return true;
+}
+
+// Computes spatial dimensions of outputs of Conv and pooling ops.
+bool InferWindowedDims(const Node& node, const Type& x, const Dims& kernel_shape, bool cover_all, Dims* dims) {
+    if (!x.HasKnownRank() || x.ndim() != kernel_shape.size() + 2) return false;
+    // Leave legacy `auto_pad` to ONNX.
+    if (!node.auto_pad().empty() && node.auto_pad() != "NOTSET") return false;
+    const size_t num_spatial = kernel_shape.size();
+    const Dims& pads = node.pads();
+    if (!pads.empty() && pads.size() != num_spatial * 2) return false;
+    for (size_t i = 0; i < num_spatial; ++i) {
+        const int64_t in = x.dims()[i + 2];
+        if (in < 0 || kernel_shape[i] < 0) {
+            dims->push_back(-1);
+            continue;
+        }
+        const int64_t stride = i < node.strides().size() ? node.strides()[i] : 1;
+        const int64_t dilation = i < node.dilations().size() ? node.dilations()[i] : 1;
+        const int64_t padded = in + (pads.empty() ? 0 : pads[i] + pads[i + num_spatial]);
+        const int64_t kernel = (kernel_shape[i] - 1) * dilation + 1;
+        int64_t num_positions = (padded - kernel) / stride;
+        if (cover_all && (padded - kernel) % stride) ++num_positions;
+        dims->push_back(num_positions + 1);
+    }
+    return true;
+}
+
+bool InferSlice(const Node& node, const Type& x, Dims* dims) {
+    Dims starts = node.starts();
+    Dims ends = node.ends();
+    Dims axes = node.axes();
+    Dims steps;
+    if (node.inputs().size() >= 3) {
+        if (!GetConstantInts(node.input(1), &starts) || !GetConstantInts(node.input(2), &ends)) return false;
+        axes.clear();
+        if (node.inputs().size() >= 4 && !GetConstantInts(node.input(3), &axes)) return false;
+        if (node.inputs().size() >= 5 && !GetConstantInts(node.input(4), &steps)) return false;
+    }
+    if (!x.HasKnownRank() || starts.size() != ends.size()) return false;
+    if (axes.empty()) {
+        for (size_t i = 0; i < starts.size(); ++i) axes.push_back(i);
+    }
+    if (steps.empty()) steps.assign(starts.size(), 1);
+    if (axes.size() != starts.size() || steps.size() != starts.size()) return false;
+
+    *dims = x.dims();
+    for (size_t i = 0; i < axes.size(); ++i) {
+        const int64_t axis = NormalizeAxis(axes[i], x.ndim());
+        if (axis < 0 || axis >= static_cast<int64_t>(x.ndim()) || steps[i] == 0) return false;
+        const int64_t d = x.dims()[axis];
+        if (d < 0) continue;
+        int64_t start = starts[i] < 0 ? starts[i] + d : starts[i];
+        int64_t end = ends[i] < 0 ? ends[i] + d : ends[i];
+        if (steps[i] > 0) {
+            start = std::min(std::max<int64_t>(start, 0), d);
+            end = std::min(std::max<int64_t>(end, 0), d);
+            (*dims)[axis] = std::max<int64_t>(0, (end - start + steps[i] - 1) / steps[i]);
+        } else {
+            start = std::min(std::max<int64_t>(start, 0), d - 1);
+            end = std::min(std::max<int64_t>(end, -1), d - 1);
+            (*dims)[axis] = std::max<int64_t>(0, (start - end - steps[i] - 1) / -steps[i]);
+        }
+    }
+    return true;
+}
+
+bool InferReshape(const Node& node, const Type& x, Dims* dims) {
+    if (!GetConstantInts(node.input(1), dims)) {
+        // The rank is still known from the shape of the shape.
+        const Type& shape = node.input(1)->type();
+        if (!shape.HasKnownRank() || shape.ndim() != 1 || shape.dims()[0] < 0) return false;
+        dims->assign(shape.dims()[0], -1);
+        return true;
+    }
+    // The product of known dimensions.
+    int64_t known = 1;
+    // True if a dimension copied from the input is unknown.
+    bool has_unknown = false;
+    int unknown_index = -1;
+    for (size_t i = 0; i < dims->size(); ++i) {
+        int64_t& d = (*dims)[i];
+        if (d == 0) {
+            d = x.HasKnownRank() && i < x.ndim() ? x.dims()[i] : -1;
+            if (d < 0) {
+                has_unknown = true;
+            } else {
+                known *= d;
+            }
+        } else if (d == -1) {
+            if (unknown_index >= 0) return false;
+            unknown_index = i;
+        } else if (d < 0) {
+            return false;
+        } else {
+            known *= d;
+        }
+    }
+    if (unknown_index >= 0 && !has_unknown) {
+        const int64_t num_elements = x.NumElements();
+        if (num_elements >= 0 && known > 0) (*dims)[unknown_index] = num_elements / known;
+    }
+    return true;
+}
+
+// Infers types of outputs of `node` without ONNX. Returns false if
+// `node` is not supported or types of its inputs are not sufficient.
+bool InferNatively(const Node& node, std::vector<std::unique_ptr<Type>>* types) {
+    // As `InferDtype`, ops which need floats output float32 for other
+    // inputs.
+    const Dtype default_float = Dtype::kFloat32;
+
+    auto in = [&node](int i) -> const Type& { return node.input(i)->type(); };
+    auto set = [types](int i, Type* type) { (*types)[i].reset(type); };
+    auto set_dims = [types](int i, Dtype dtype, const Dims& dims) { (*types)[i].reset(new Type(dtype, dims)); };
+    // Outputs whose shape is as same as the input. `dtype` is unknown
+    // for ops whose output dtype is decided by `InferDtype`.
+    auto set_like = [types](int i, const Type& type, Dtype dtype) {
+        Type* t = new Type(type);
+        t->set_dtype(dtype);
+        (*types)[i].reset(t);
+    };
+
+    if (node.inputs().empty()) {
+        switch (node.op_type()) {
+            case Node::kConstant: {
+                const Tensor& tensor = *node.tensor_value();
+                set_dims(0, tensor.dtype(), tensor.dims());
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+
+    const Type& x = in(0);
+    if (x.kind() != Type::Kind::kTensor) {
+        if (node.op_type() != Node::kIdentity) return false;
+        set(0, new Type(x));
+        return true;
+    }
+    const Dtype in0 = x.dtype();
+
+    switch (node.op_type()) {
+        case Node::kIdentity:
+        case Node::kNeg:
+        case Node::kAbs:
+        case Node::kRelu:
+        case Node::kFloor:
+        case Node::kCeil:
+        case Node::kSign:
+        case Node::kClip:
+        case Node::kImageScaler:
+        case Node::kChainerReluGrad: {
+            set_like(0, x, in0);
+            return true;
+        }
+
+        case Node::kReciprocal:
+        case Node::kExp:
+        case Node::kLog:
+        case Node::kSqrt:
+        case Node::kSin:
+        case Node::kSinh:
+        case Node::kCos:
+        case Node::kCosh:
+        case Node::kTan:
+        case Node::kTanh:
+        case Node::kAsin:
+        case Node::kAsinh:
+        case Node::kAcos:
+        case Node::kAcosh:
+        case Node::kAtan:
+        case Node::kAtanh:
+        case Node::kErf:
+        case Node::kSigmoid:
+        case Node::kSelu:
+        case Node::kLeakyRelu:
+        case Node::kElu:
+        case Node::kSoftplus:
+        case Node::kSoftsign:
+        case Node::kSoftmax:
+        case Node::kLogSoftmax:
+        case Node::kHardmax:
+        case Node::kLpNormalization: {
+            set_like(0, x, in0.IsFloat() ? in0 : default_float);
+            return true;
+        }
+
+        case Node::kNot:
+        case Node::kIsNaN:
+        case Node::kIsInf: {
+            set_like(0, x, Dtype::kBool);
+            return true;
+        }
+
+        case Node::kCast: {
+            set_like(0, x, node.to());
+            return true;
+        }
+
+        case Node::kDropout: {
+            set_like(0, x, in0.IsFloat() ? in0 : default_float);
+            if (node.outputs().size() >= 2) set_like(1, x, Dtype::kBool);
+            return true;
+        }
+
+        case Node::kLRN: {
+            set_like(0, x, in0.IsFloat() ? in0 : default_float);
+            return true;
+        }
+
+        case Node::kBatchNormalization: {
+            set_like(0, x, in0);
+            // The second output is a context for backward if there
+            // are only two outputs.
+            if (node.outputs().size() >= 5) {
+                set(1, new Type(in(3)));
+                set(2, new Type(in(4)));
+                set(3, new Type(in(1)));
+                set(4, new Type(in(1)));
+            }
+            return true;
+        }
+
+        case Node::kAdd:
+        case Node::kSub:
+        case Node::kMul:
+        case Node::kDiv:
+        case Node::kPow:
+        case Node::kSum:
+        case Node::kMean:
+        case Node::kMax:
+        case Node::kMin:
+        case Node::kEqual:
+        case Node::kGreater:
+        case Node::kLess:
+        case Node::kAnd:
+        case Node::kOr:
+        case Node::kXor:
+        case Node::kWhere: {
+            std::vector<const Type*> ins;
+            for (Value* input : node.inputs()) ins.push_back(&input->type());
+            Dims dims;
+            if (!Broadcast(ins, &dims)) return false;
+            Dtype dtype = Dtype::kBool;
+            switch (node.op_type()) {
+                case Node::kEqual:
+                case Node::kGreater:
+                case Node::kLess:
+                case Node::kAnd:
+                case Node::kOr:
+                case Node::kXor:
+                    break;
+                case Node::kWhere:
+                    dtype = CoerceDtype(in(1).dtype(), in(2).dtype());
+                    break;
+                default:
+                    dtype = in0;
+                    for (size_t i = 1; i < ins.size(); ++i) dtype = CoerceDtype(dtype, ins[i]->dtype());
+            }
+            set_dims(0, dtype, dims);
+            return true;
+        }
+
+        case Node::kMatMul: {
+            const Type& w = in(1);
+            if (!x.HasKnownRank() || !w.HasKnownRank() || x.ndim() == 0 || w.ndim() == 0) return false;
+            // Matrix dimensions are removed from batch dimensions.
+            Type xb(in0, Dims(x.dims().begin(), x.dims().end() - std::min<size_t>(x.ndim(), 2)));
+            Type wb(w.dtype(), Dims(w.dims().begin(), w.dims().end() - std::min<size_t>(w.ndim(), 2)));
+            Dims dims;
+            CHECK(Broadcast({&xb, &wb}, &dims));
+            if (x.ndim() >= 2) dims.push_back(x.dims()[x.ndim() - 2]);
+            if (w.ndim() >= 2) dims.push_back(w.dims().back());
+            set_dims(0, CoerceDtype(in0, w.dtype()), dims);
+            return true;
+        }
+
+        case Node::kGemm:
+        case Node::kChainerGemmBiasActivation: {
+            const Type& w = in(1);
+            if (!x.HasKnownRank() || !w.HasKnownRank() || x.ndim() != 2 || w.ndim() != 2) return false;
+            const int64_t m = x.dims()[node.trans_a() ? 1 : 0];
+            const int64_t n = w.dims()[node.trans_b() ? 0 : 1];
+            set_dims(0, CoerceDtype(in0, w.dtype()), {m, n});
+            return true;
+        }
+
+        case Node::kChainerLinear: {
+            const Type& w = in(1);
+            if (!x.HasKnownRank() || !w.HasKnownRank() || w.ndim() < 1) return false;
+            if (node.n_batch_axes() > static_cast<int64_t>(x.ndim())) return false;
+            Dims dims(x.dims().begin(), x.dims().begin() + node.n_batch_axes());
+            dims.push_back(w.dims()[0]);
+            set_dims(0, CoerceDtype(in0, w.dtype()), dims);
+            return true;
+        }
+
+        case Node::kConv:
+        case Node::kChainerConvBiasActivation: {
+            const Type& w = in(1);
+            if (!x.HasKnownRank() || !w.HasKnownRank() || w.ndim() < 2 || x.ndim() != w.ndim()) return false;
+            Dims kernel_shape = node.kernel_shape();
+            if (kernel_shape.empty()) {
+                if (!w.HasKnownShape()) return false;
+                kernel_shape.assign(w.dims().begin() + 2, w.dims().end());
+            }
+            Dims dims = {x.dims()[0], w.dims()[0]};
+            if (!InferWindowedDims(node, x, kernel_shape, false, &dims)) return false;
+            set_dims(0, in0, dims);
+            return true;
+        }
+
+        case Node::kMaxPool:
+        case Node::kAveragePool: {
+            if (!x.HasKnownRank() || x.ndim() < 2) return false;
+            const bool cover_all = node.op_type() == Node::kMaxPool && node.chainer_cover_all();
+            Dims dims = {x.dims()[0], x.dims()[1]};
+            if (!InferWindowedDims(node, x, node.kernel_shape(), cover_all, &dims)) return false;
+            set_dims(0, node.op_type() == Node::kMaxPool || in0.IsFloat() ? in0 : default_float, dims);
+            return true;
+        }
+
+        case Node::kGlobalMaxPool:
+        case Node::kGlobalAveragePool: {
+            if (!x.HasKnownRank() || x.ndim() < 2) return false;
+            Dims dims(x.ndim(), 1);
+            dims[0] = x.dims()[0];
+            dims[1] = x.dims()[1];
+            set_dims(0, node.op_type() == Node::kGlobalMaxPool || in0.IsFloat() ? in0 : default_float, dims);
+            return true;
+        }
+
+        case Node::kPad: {
+            if (!x.HasKnownRank() || node.pads().size() != x.ndim() * 2) return false;
+            Dims dims = x.dims();
+            for (size_t i = 0; i < x.ndim(); ++i) {
+                if (dims[i] >= 0) dims[i] += node.pads()[i] + node.pads()[i + x.ndim()];
+            }
+            set_dims(0, in0, dims);
+            return true;
+        }
+
+        case Node::kReshape: {
+            Dims dims;
+            if (!InferReshape(node, x, &dims)) return false;
+            set_dims(0, in0, dims);
+            return true;
+        }
+
+        case Node::kExpand: {
+            Dims shape;
+            if (!GetConstantInts(node.input(1), &shape)) return false;
+            Type to(in0, shape);
+            Dims dims;
+            if (!Broadcast({&x, &to}, &dims)) return false;
+            set_dims(0, in0, dims);
+            return true;
+        }
+
+        case Node::kTranspose: {
+            if (!x.HasKnownRank()) return false;
+            Dims perm = node.perm();
+            if (perm.empty()) {
+                for (size_t i = 0; i < x.ndim(); ++i) perm.push_back(x.ndim() - i - 1);
+            }
+            if (perm.size() != x.ndim()) return false;
+            Dims dims;
+            for (int64_t axis : perm) dims.push_back(x.dims()[axis]);
+            set_dims(0, in0, dims);
+            return true;
+        }
+
+        case Node::kConcat: {
+            if (!x.HasKnownRank()) return false;
+            const int64_t axis = NormalizeAxis(node.axis(), x.ndim());
+            Dims dims = x.dims();
+            Dtype dtype = in0;
+            for (size_t i = 1; i < node.inputs().size(); ++i) {
+                const Type& t = in(i);
+                if (!t.HasKnownRank() || t.ndim() != x.ndim()) return false;
+                for (int64_t j = 0; j < static_cast<int64_t>(dims.size()); ++j) {
+                    if (j == axis) {
+                        dims[j] = dims[j] < 0 || t.dims()[j] < 0 ? -1 : dims[j] + t.dims()[j];
+                    } else if (dims[j] < 0) {
+                        dims[j] = t.dims()[j];
+                    }
+                }
+                dtype = CoerceDtype(dtype, t.dtype());
+            }
+            set_dims(0, dtype, dims);
+            return true;
+        }
+
+        case Node::kSplit: {
+            if (!x.HasKnownRank()) return false;
+            const int64_t axis = NormalizeAxis(node.axis(), x.ndim());
+            const int64_t d = x.dims()[axis];
+            const size_t num_outputs = node.outputs().size();
+            Dims split = node.split();
+            if (split.empty()) split.assign(num_outputs, d < 0 || d % num_outputs ? -1 : d / num_outputs);
+            if (split.size() != num_outputs) return false;
+            for (size_t i = 0; i < num_outputs; ++i) {
+                Dims dims = x.dims();
+                dims[axis] = split[i];
+                set_dims(i, in0, dims);
+            }
+            return true;
+        }
+
+        case Node::kSlice:
+        case Node::kDynamicSlice: {
+            Dims dims;
+            if (!InferSlice(node, x, &dims)) return false;
+            set_dims(0, in0, dims);
+            return true;
+        }
+
+        case Node::kFlatten: {
+            if (!x.HasKnownRank()) return false;
+            const int64_t axis = NormalizeAxis(node.axis(), x.ndim());
+            if (axis < 0 || axis > static_cast<int64_t>(x.ndim())) return false;
+            set_dims(0, in0, {Product(x.dims(), 0, axis), Product(x.dims(), axis, x.ndim())});
+            return true;
+        }
+
+        case Node::kSqueeze: {
+            if (!x.HasKnownRank()) return false;
+            std::set<int64_t> axes;
+            for (int64_t axis : node.axes()) axes.insert(NormalizeAxis(axis, x.ndim()));
+            Dims dims;
+            for (size_t i = 0; i < x.ndim(); ++i) {
+                const int64_t d = x.dims()[i];
+                if (axes.empty() && d < 0) return false;
+                if (axes.empty() ? d == 1 : axes.count(i)) continue;
+                dims.push_back(d);
+            }
+            set_dims(0, in0, dims);
+            return true;
+        }
+
+        case Node::kUnsqueeze: {
+            if (!x.HasKnownRank()) return false;
+            const size_t ndim = x.ndim() + node.axes().size();
+            std::set<int64_t> axes;
+            for (int64_t axis : node.axes()) axes.insert(NormalizeAxis(axis, ndim));
+            Dims dims;
+            auto iter = x.dims().begin();
+            for (size_t i = 0; i < ndim; ++i) {
+                if (axes.count(i)) {
+                    dims.push_back(1);
+                } else {
+                    if (iter == x.dims().end()) return false;
+                    dims.push_back(*iter++);
+                }
+            }
+            set_dims(0, in0, dims);
+            return true;
+        }
+
+        case Node::kReduceSum:
+        case Node::kReduceSumSquare:
+        case Node::kReduceMean:
+        case Node::kReduceMax:
+        case Node::kReduceMin:
+        case Node::kReduceL1:
+        case Node::kReduceL2:
+        case Node::kReduceLogSum:
+        case Node::kReduceLogSumExp:
+        case Node::kArgMax:
+        case Node::kArgMin: {
+            if (!x.HasKnownRank()) return false;
+            const bool is_arg = node.op_type() == Node::kArgMax || node.op_type() == Node::kArgMin;
+            std::set<int64_t> axes;
+            if (is_arg) {
+                axes.insert(NormalizeAxis(node.axis(), x.ndim()));
+            } else {
+                for (int64_t axis : node.axes()) axes.insert(NormalizeAxis(axis, x.ndim()));
+            }
+            Dims dims;
+            for (size_t i = 0; i < x.ndim(); ++i) {
+                if (axes.empty() || axes.count(i)) {
+                    if (node.keepdims()) dims.push_back(1);
+                } else {
+                    dims.push_back(x.dims()[i]);
+                }
+            }
+            Dtype dtype = in0;
+            if (is_arg) {
+                dtype = Dtype::kInt64;
+            } else if (node.op_type() == Node::kReduceMean && !in0.IsFloat()) {
+                dtype = default_float;
+            }
+            set_dims(0, dtype, dims);
+            return true;
+        }
+
+        case Node::kGather: {
+            const Type& indices = in(1);
+            if (!x.HasKnownRank() || !indices.HasKnownRank()) return false;
+            const int64_t axis = NormalizeAxis(node.axis(), x.ndim());
+            if (axis < 0 || axis >= static_cast<int64_t>(x.ndim())) return false;
+            Dims dims(x.dims().begin(), x.dims().begin() + axis);
+            dims.insert(dims.end(), indices.dims().begin(), indices.dims().end());
+            dims.insert(dims.end(), x.dims().begin() + axis + 1, x.dims().end());
+            set_dims(0, in0, dims);
+            return true;
+        }
+
+        case Node::kShape: {
+            if (!x.HasKnownRank()) return false;
+            set_dims(0, Dtype::kInt64, {static_cast<int64_t>(x.ndim())});
+            return true;
+        }
+
+        case Node::kSize: {
+            set_dims(0, Dtype::kInt64, {});
+            return true;
+        }
+
+        case Node::kConstantOfShape: {
+            Dims dims;
+            if (!GetConstantInts(node.input(0), &dims)) return false;
+            const Tensor* value = node.tensor_value().get();
+            set_dims(0, value ? value->dtype() : default_float, dims);
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+// Infers types of outputs of `node` by ONNX's shape inference on a
+// graph which only has `node` and type information of its inputs.
+void InferByONNX(const Node& node, std::vector<std::unique_ptr<Type>>* types) {
+    onnx::GraphProto xgraph;
+    node.ToONNX(xgraph.add_node());
+    std::set<Value*> seen;
+    for (Value* input : node.inputs()) {
+        if (input->IsNull() || !seen.insert(input).second) continue;
+        input->ToONNX(xgraph.add_input());
+        const Tensor* tensor = GetConstant(input);
+        if (tensor && (tensor->dtype() == Dtype::kInt32 || tensor->dtype() == Dtype::kInt64) &&
+            tensor->NumElements() <= kMaxConstantElements) {
+            onnx::TensorProto* xtensor = xgraph.add_initializer();
+            tensor->ToONNX(xtensor);
+            xtensor->set_name(input->name());
+        }
+    }
+    std::vector<int> output_indices;
+    for (size_t i = 0; i < node.outputs().size(); ++i) {
+        Value* output = node.output(i);
+        if (output->IsNull()) continue;
+        output->ToONNX(xgraph.add_output());
+        output_indices.push_back(i);
+    }
+
+    std::unordered_map<std::string, int> opset_imports;
+    opset_imports[""] = 9;
+    onnx::shape_inference::InferShapes(&xgraph, opset_imports);
+
+    for (size_t i = 0; i < output_indices.size(); ++i) {
+        const onnx::TypeProto& xtype = xgraph.output(i).type();
+        if (xtype.has_tensor_type()) (*types)[output_indices[i]].reset(new Type(xtype));
+    }
+}
+
+bool HasSubGraphs(const Graph& graph) {
+    for (const Node* node : graph.nodes()) {
+        if (!node->GetSubGraphs().empty()) return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+bool InferShape(Node* node) {
+    std::vector<std::unique_ptr<Type>> types(node->outputs().size());
+    const bool is_native = InferNatively(*node, &types);
+    if (!is_native) {
+        InferByONNX(*node, &types);
+    }
+
+    bool updated = false;
+    std::vector<Dtype> dtypes;
+    for (size_t i = 0; i < types.size(); ++i) {
+        Value* output = node->output(i);
+        std::unique_ptr<Type>& type = types[i];
+        if (type && !output->IsNull()) {
+            const Type& old_type = output->type();
+            if (is_native && old_type.kind() == Type::Kind::kTensor && type->kind() == Type::Kind::kTensor && type->HasKnownShape()) {
+                // Fully known shapes inferred natively replace stale
+                // ones, e.g., after inputs of the graph are changed.
+                // The dtype is still merged.
+                if (old_type.dtype() != Dtype::kUnknown) type->set_dtype(old_type.dtype());
+                if (!old_type.HasKnownRank() || old_type.dtype() != type->dtype() || old_type.dims() != type->dims()) {
+                    output->set_type(type.release());
+                    updated = true;
+                }
+            } else if (output->mutable_type()->Merge(*type)) {
+                updated = true;
+            }
+        }
+        dtypes.push_back(output->type().dtype());
+    }
+
+    InferDtype(node);
+    for (size_t i = 0; i < dtypes.size(); ++i) {
+        if (dtypes[i] != node->output(i)->type().dtype()) updated = true;
+    }
+    return updated;
+}
+
+void InferShapes(const std::vector<Node*>& nodes) {
+    std::deque<Node*> queue(nodes.begin(), nodes.end());
+    std::set<Node*> queued(nodes.begin(), nodes.end());
+    while (!queue.empty()) {
+        Node* node = queue.front();
+        queue.pop_front();
+        queued.erase(node);
+        if (node->detached() || !InferShape(node)) continue;
+
+        for (Value* output : node->outputs()) {
+            for (Node* user : output->users()) {
+                if (queued.insert(user).second) queue.push_back(user);
+            }
+        }
+    }
+}
+
+void InferAllShapes(Graph* graph) {
+    if (g_onnx_shape_inference || HasSubGraphs(*graph)) {
+        CLOG() << "Infer shapes of " << graph->name() << " by ONNX" << std::endl;
+        graph->InferShapes();
+        InferAllDtype(graph);
+        return;
+    }
+    InferShapes(graph->GetTopologicallySortedNodes());
+}
+
+}  // namespace chainer_compiler
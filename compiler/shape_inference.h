@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+
+namespace chainer_compiler {
+
+class Graph;
+class Node;
+
+// Infers dtypes and shapes of outputs of `node` from its inputs. Common
+// ops are handled natively and the rest by ONNX's shape inference on a
+// graph which only has `node`. Only unknown dtypes and dimensions are
+// filled. Returns true if any output types are updated.
+bool InferShape(Node* node);
+
+// Infers dtypes and shapes of outputs of `nodes`, and then re-infers
+// nodes whose inputs are updated until no type changes.
+void InferShapes(const std::vector<Node*>& nodes);
+
+// Infers dtypes and shapes of all values in `graph`. Graphs with
+// subgraphs are inferred by ONNX on the whole graph as values in
+// subgraphs depend on values in outer graphs.
+void InferAllShapes(Graph* graph);
+
+}  // namespace chainer_compiler
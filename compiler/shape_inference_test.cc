@@ -0,0 +1,120 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <chainerx/testing/context_session.h>
+
+#include <compiler/graph.h>
+#include <compiler/graph_builder.h>
+#include <compiler/node.h>
+#include <compiler/shape_inference.h>
+#include <compiler/value.h>
+
+namespace chainer_compiler {
+namespace {
+
+TEST(ShapeInferenceTest, InferAllShapes) {
+    chainerx::testing::ContextSession sess;
+
+    Graph graph("test");
+    Value* x = graph.AddInputValue("x", Type(Dtype::kFloat32, {2, 3, 8, 8}));
+    Value* w = graph.AddInputValue("w", Type(Dtype::kFloat32, {4, 3, 3, 3}));
+    Value* fc = graph.AddInputValue("fc", Type(Dtype::kFloat32, {10, 64}));
+    Value* bias = graph.AddInputValue("bias", Type(Dtype::kFloat32, {10}));
+    Value* shape;
+    {
+        Value dummy_for_test("test");
+        GraphBuilder gb(&graph, "test", &dummy_for_test);
+        shape = gb.Const(Type(Dtype::kInt64, {2}), {0, -1});
+    }
+
+    Value* conv = graph.AddValue("conv");
+    graph.AddNode(Node::kConv, {x, w}, {conv})->set_pads({1, 1, 1, 1})->set_strides({2, 2});
+    Value* relu = graph.AddValue("relu");
+    graph.AddNode(Node::kRelu, {conv}, {relu});
+    Value* reshaped = graph.AddValue("reshaped");
+    graph.AddNode(Node::kReshape, {relu, shape}, {reshaped});
+    Value* y = graph.AddOutputValue("y", Type());
+    graph.AddNode(Node::kGemm, {reshaped, fc, bias}, {y})->set_trans_b(true);
+
+    InferAllShapes(&graph);
+
+    EXPECT_EQ(std::vector<int64_t>({2, 4, 4, 4}), conv->type().dims());
+    EXPECT_EQ(std::vector<int64_t>({2, 4, 4, 4}), relu->type().dims());
+    EXPECT_EQ(std::vector<int64_t>({2, 64}), reshaped->type().dims());
+    ASSERT_TRUE(y->type().HasKnownShape());
+    EXPECT_EQ(Dtype::kFloat32, y->type().dtype());
+    EXPECT_EQ(std::vector<int64_t>({2, 10}), y->type().dims());
+}
+
+TEST(ShapeInferenceTest, Incremental) {
+    chainerx::testing::ContextSession sess;
+
+    Graph graph("test");
+    Value* x = graph.AddInputValue("x", Type(Dtype::kFloat32, {-1, 3}));
+    Value* b = graph.AddInputValue("b", Type(Dtype::kFloat32, {3}));
+    Value* relu = graph.AddValue("relu");
+    Node* relu_node = graph.AddNode(Node::kRelu, {x}, {relu});
+    Value* y = graph.AddOutputValue("y", Type());
+    graph.AddNode(Node::kAdd, {relu, b}, {y});
+
+    InferAllShapes(&graph);
+    ASSERT_TRUE(y->type().HasKnownRank());
+    EXPECT_FALSE(y->type().HasKnownShape());
+    EXPECT_EQ(std::vector<int64_t>({-1, 3}), y->type().dims());
+
+    x->set_type(new Type(Dtype::kFloat32, {5, 3}));
+    InferShapes({relu_node});
+    EXPECT_EQ(std::vector<int64_t>({5, 3}), relu->type().dims());
+    EXPECT_EQ(std::vector<int64_t>({5, 3}), y->type().dims());
+
+    // Fully known shapes replace stale ones.
+    x->set_type(new Type(Dtype::kFloat32, {7, 3}));
+    InferShapes({relu_node});
+    EXPECT_EQ(std::vector<int64_t>({7, 3}), relu->type().dims());
+    EXPECT_EQ(std::vector<int64_t>({7, 3}), y->type().dims());
+}
+
+TEST(ShapeInferenceTest, Conv) {
+    chainerx::testing::ContextSession sess;
+
+    Graph graph("test");
+    Value* x = graph.AddInputValue("x", Type(Dtype::kFloat32, {2, 3, 8, 8}));
+    Value* w = graph.AddInputValue("w", Type(Dtype::kFloat32, {4, 3, 3, 3}));
+    Value* w1d = graph.AddInputValue("w1d", Type(Dtype::kFloat32, {4, 3, 3}));
+    Value* w_unknown = graph.AddInputValue("w_unknown", Type(Dtype::kFloat32, {4, 3, -1, 3}));
+
+    // A stale shape is overwritten.
+    Value* conv = graph.AddValue("conv", Type(Dtype::kFloat32, {2, 4, 6, 6}));
+    Node* conv_node = graph.AddNode(Node::kConv, {x, w}, {conv});
+    conv_node->set_pads({1, 1, 1, 1});
+    EXPECT_TRUE(InferShape(conv_node));
+    EXPECT_EQ(std::vector<int64_t>({2, 4, 8, 8}), conv->type().dims());
+
+    // The rank of the input does not match the weight.
+    Value* mismatched = graph.AddValue("mismatched");
+    InferShape(graph.AddNode(Node::kConv, {x, w1d}, {mismatched}));
+    EXPECT_FALSE(mismatched->type().HasKnownRank());
+
+    // The kernel shape is unknown.
+    Value* unknown = graph.AddValue("unknown");
+    InferShape(graph.AddNode(Node::kConv, {x, w_unknown}, {unknown}));
+    EXPECT_FALSE(unknown->type().HasKnownShape());
+}
+
+TEST(ShapeInferenceTest, FallbackToONNX) {
+    chainerx::testing::ContextSession sess;
+
+    Graph graph("test");
+    Value* x = graph.AddInputValue("x", Type(Dtype::kFloat32, {3, 4}));
+    Value* y = graph.AddOutputValue("y", Type());
+    Node* node = graph.AddNode(Node::kEyeLike, {x}, {y});
+
+    EXPECT_TRUE(InferShape(node));
+    EXPECT_EQ(Dtype::kFloat32, y->type().dtype());
+    EXPECT_EQ(std::vector<int64_t>({3, 4}), y->type().dims());
+    EXPECT_FALSE(InferShape(node));
+}
+
+}  // namespace
+}  // namespace chainer_compiler
@@ -7,6 +7,7 @@
 #include <set>
 
 #include <common/log.h>
+#include <compiler/graph_view.h>
 #include <compiler/node.h>
 #include <compiler/value.h>
 
@@ -104,4 +105,112 @@ std::vector<Node*> SortTopologically(const std::vector<Node*>& nodes, const std:
     return sorted_nodes;
 }
 
+ReachabilityIndex::ReachabilityIndex(const GraphView& view)
+    : view_(view),
+      parents_(view.num_nodes()),
+      members_(view.num_nodes()),
+      levels_(view.num_nodes()),
+      visited_(view.num_nodes(), -1) {
+    std::vector<int> num_preds(view.num_nodes());
+    std::vector<int> q;
+    for (int node_id = 0; node_id < view.num_nodes(); ++node_id) {
+        parents_[node_id] = node_id;
+        members_[node_id].push_back(node_id);
+        for (int value_id : view.inputs(node_id)) {
+            if (view.producer(value_id) >= 0) ++num_preds[node_id];
+        }
+        if (num_preds[node_id] == 0) q.push_back(node_id);
+    }
+
+    // The level of a node is the length of the longest path to it.
+    while (!q.empty()) {
+        const int node_id = q.back();
+        q.pop_back();
+        for (int value_id : view.outputs(node_id)) {
+            for (int user : view.users(value_id)) {
+                levels_[user] = std::max(levels_[user], levels_[node_id] + 1);
+                if (--num_preds[user] == 0) q.push_back(user);
+            }
+        }
+    }
+}
+
+int ReachabilityIndex::Find(int node_id) const {
+    while (parents_[node_id] != node_id) {
+        parents_[node_id] = parents_[parents_[node_id]];
+        node_id = parents_[node_id];
+    }
+    return node_id;
+}
+
+template <class Fn>
+void ReachabilityIndex::ForEachSuccessor(int root, Fn fn) const {
+    for (int member : members_[root]) {
+        for (int value_id : view_.outputs(member)) {
+            for (int user : view_.users(value_id)) {
+                const int next = Find(user);
+                if (next != root) fn(next);
+            }
+        }
+    }
+}
+
+std::vector<int> ReachabilityIndex::FindReachableTargets(const std::vector<int>& sources, const std::vector<int>& targets) {
+    const int search = num_searches_++;
+    int max_level = -1;
+    for (int node_id : targets) {
+        max_level = std::max(max_level, level(node_id));
+    }
+
+    std::vector<int> q;
+    for (int node_id : sources) {
+        q.push_back(Find(node_id));
+    }
+    while (!q.empty()) {
+        const int root = q.back();
+        q.pop_back();
+        if (visited_[root] == search) continue;
+        visited_[root] = search;
+        // Successors are at higher levels than all targets.
+        if (levels_[root] >= max_level) continue;
+        ForEachSuccessor(root, [this, search, &q](int next) {
+            if (visited_[next] != search) q.push_back(next);
+        });
+    }
+
+    std::vector<int> reachable;
+    for (int node_id : targets) {
+        if (visited_[Find(node_id)] == search) reachable.push_back(node_id);
+    }
+    return reachable;
+}
+
+void ReachabilityIndex::Merge(const std::vector<int>& node_ids) {
+    if (node_ids.empty()) return;
+    int root = Find(node_ids[0]);
+    for (int node_id : node_ids) {
+        int other = Find(node_id);
+        if (other == root) continue;
+        if (members_[other].size() > members_[root].size()) std::swap(other, root);
+        parents_[other] = root;
+        levels_[root] = std::max(levels_[root], levels_[other]);
+        members_[root].insert(members_[root].end(), members_[other].begin(), members_[other].end());
+        std::vector<int>().swap(members_[other]);
+    }
+
+    // Predecessors of the merged node are still at lower levels, but
+    // its successors may need to be moved to higher levels.
+    std::vector<int> q = {root};
+    while (!q.empty()) {
+        const int node = q.back();
+        q.pop_back();
+        ForEachSuccessor(node, [this, node, &q](int next) {
+            if (levels_[next] > levels_[node]) return;
+            levels_[next] = levels_[node] + 1;
+            CHECK_LT(levels_[next], view_.num_nodes()) << "Merged nodes make a cycle";
+            q.push_back(next);
+        });
+    }
+}
+
 }  // namespace chainer_compiler
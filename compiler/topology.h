@@ -4,6 +4,7 @@
 
 namespace chainer_compiler {
 
+class GraphView;
 class Node;
 class Value;
 
@@ -20,4 +21,46 @@ void ClassifyValues(const std::vector<Node*>& nodes, std::vector<Value*>* inputs
 // unreachable from `inputs` will be discarded.
 std::vector<Node*> SortTopologically(const std::vector<Node*>& nodes, const std::vector<Value*>& inputs, bool is_full_graph);
 
+// Answers which nodes are reachable from other nodes, e.g., to check
+// if merging nodes makes a cycle. Each node has a topological level
+// which is larger than levels of its predecessors, so a search for
+// targets does not visit nodes at the same or higher levels than
+// the targets. Nodes merged by `Merge` are considered as a single
+// node, as fusion groups are.
+class ReachabilityIndex {
+public:
+    explicit ReachabilityIndex(const GraphView& view);
+
+    int level(int node_id) const {
+        return levels_[Find(node_id)];
+    }
+
+    // Returns nodes in `targets` which are reachable from `sources`.
+    // Nodes in `sources` are reachable from themselves.
+    std::vector<int> FindReachableTargets(const std::vector<int>& sources, const std::vector<int>& targets);
+
+    // Merges `node_ids` into a single node. Levels of nodes after
+    // them are updated.
+    void Merge(const std::vector<int>& node_ids);
+
+private:
+    int Find(int node_id) const;
+
+    // Calls `fn` for each node which uses outputs of the merged node
+    // represented by `root`.
+    template <class Fn>
+    void ForEachSuccessor(int root, Fn fn) const;
+
+    const GraphView& view_;
+    // Parents in the union-find of merged nodes.
+    mutable std::vector<int> parents_;
+    // Members of merged nodes indexed by their roots.
+    std::vector<std::vector<int>> members_;
+    // Levels indexed by roots of merged nodes.
+    std::vector<int> levels_;
+    // The last search which visited each root.
+    std::vector<int> visited_;
+    int num_searches_{0};
+};
+
 }  // namespace chainer_compiler
@@ -3,6 +3,7 @@
 #include <common/log.h>
 #include <compiler/graph.h>
 #include <compiler/graph_builder.h>
+#include <compiler/graph_view.h>
 #include <compiler/topology.h>
 #include <compiler/type.h>
 
@@ -65,5 +66,38 @@ TEST(TopologyTest, ClassifyValues) {
     }
 }
 
+TEST(TopologyTest, ReachabilityIndex) {
+    Type type(Dtype::kFloat32, {});
+    Graph graph("test");
+    Value* input = graph.AddInputValue("input", type);
+    Value* output = graph.AddOutputValue("output", type);
+    GraphBuilder gb(&graph, "test", output);
+
+    // op0 -> op1 -> op2 -> op4
+    //    \-> op3 ------/
+    Value* temp0 = gb.Op(Node::kTanh, {input});
+    Value* temp1 = gb.Op(Node::kTanh, {temp0});
+    Value* temp2 = gb.Op(Node::kTanh, {temp1});
+    Value* temp3 = gb.Op(Node::kTanh, {temp0});
+    Value* temp4 = gb.Op(Node::kAdd, {temp2, temp3}, output);
+
+    const GraphView view(graph);
+    auto id = [&view](Value* value) { return view.NodeId(value->producer()); };
+    ReachabilityIndex reachability(view);
+    EXPECT_EQ(0, reachability.level(id(temp0)));
+    EXPECT_EQ(1, reachability.level(id(temp3)));
+    EXPECT_EQ(3, reachability.level(id(temp4)));
+
+    EXPECT_EQ(std::vector<int>({id(temp2), id(temp4)}),
+              reachability.FindReachableTargets({id(temp1)}, {id(temp0), id(temp2), id(temp3), id(temp4)}));
+    EXPECT_EQ(std::vector<int>(), reachability.FindReachableTargets({id(temp3)}, {id(temp1), id(temp2)}));
+
+    // `op2` is reachable from `op3` after `op1` and `op3` are merged.
+    reachability.Merge({id(temp1), id(temp3)});
+    EXPECT_EQ(std::vector<int>({id(temp2)}), reachability.FindReachableTargets({id(temp3)}, {id(temp2)}));
+    EXPECT_EQ(reachability.level(id(temp1)), reachability.level(id(temp3)));
+    EXPECT_LT(reachability.level(id(temp3)), reachability.level(id(temp2)));
+}
+
 }  // namespace
 }  // namespace chainer_compiler
@@ -60,6 +60,15 @@ public:
 
     bool HasKnownShape() const;
 
+    // Returns true if this is a tensor with the known number of
+    // dimensions. Some dimensions may be still unknown.
+    bool HasKnownRank() const;
+
+    // Fills the unknown dtype and dimensions of this type by `type`.
+    // Known ones are kept even if they conflict with `type`. Returns
+    // true if this type is updated.
+    bool Merge(const Type& type);
+
 private:
     Kind kind_{Kind::kTensor};
     Dtype dtype_{Dtype::kUnknown};
@@ -84,6 +84,12 @@ public:
     }
     void set_grad(Value* grad);
 
+    // A dense ID in the graph which created this value, or -1. Use
+    // `GraphView` to map values to IDs.
+    int id() const {
+        return id_;
+    }
+
     // Generate a unique ID for other values associated with this object.
     int Counter() {
         return counter_++;
@@ -107,6 +113,7 @@ private:
     // This should be used only during gradient calculation.
     Value* grad_ = nullptr;
     int counter_ = 0;
+    int id_ = -1;
 };
 
 std::ostream& operator<<(std::ostream& os, const Value::Kind& kind);
@@ -200,5 +200,10 @@ void BlitArray(const chainerx::Array& src, const chainerx::Array& dst) {
     src.device().backend().CallKernel<chainerx::CopyKernel>(src, dst);
 }
 
+bool IsExclusivelyOwned(const chainerx::Array& a) {
+    // Views and copies of `a` share the body or the data.
+    return a.IsContiguous() && a.body().use_count() == 1 && a.data().use_count() == 1;
+}
+
 }  // namespace runtime
 }  // namespace chainer_compiler
@@ -43,5 +43,21 @@ bool IsFloat(chainerx::Dtype dtype);
 
 void BlitArray(const chainerx::Array& src, const chainerx::Array& dst);
 
+// Returns true if `a` is contiguous and no other array refers to its
+// buffer, so a kernel can write its output into `a`.
+bool IsExclusivelyOwned(const chainerx::Array& a);
+
+// Returns the address of the first element of `a`, which must be on
+// a native device.
+template <typename T>
+const T* GetData(const chainerx::Array& a) {
+    return reinterpret_cast<const T*>(static_cast<const char*>(a.raw_data()) + a.offset());
+}
+
+template <typename T>
+T* GetMutableData(const chainerx::Array& a) {
+    return reinterpret_cast<T*>(static_cast<char*>(a.raw_data()) + a.offset());
+}
+
 }  // namespace runtime
 }  // namespace chainer_compiler
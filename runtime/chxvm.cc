@@ -1,5 +1,6 @@
 #include "runtime/chxvm.h"
 
+#include <algorithm>
 #include <iomanip>
 #include <numeric>
 #include <sstream>
@@ -16,8 +17,11 @@
 #include <runtime/chxvm.pb.h>
 #include <runtime/chxvm_op.h>
 #include <runtime/chxvm_state.h>
+#include <runtime/dataflow_executor.h>
 #include <runtime/meminfo.h>
 #include <runtime/npy.h>
+#include <runtime/parallel_for.h>
+#include <runtime/thread_pool.h>
 
 #define RANGE(x) (x).begin(), (x).end()
 
@@ -59,6 +63,19 @@ void CheckType(ChxVMState* st, const ChxVMOp* op) {
     }
 }
 
+void CheckInput(const ChxVMInputDesc& input, const ChxVMVar& var) {
+    if (var.IsArray()) {
+        const chainerx::Array& a = var.GetArray();
+        if (static_cast<int>(input.dtype) == 0) {
+            return;
+        }
+        CHECK_EQ(input.dtype, a.dtype()) << "Input '" << input.name << "' has an unexpected dtype";
+        CHECK_EQ(input.shape, a.shape()) << "Input '" << input.name << "' has an unexpected shape";
+    } else {
+        CHECK_EQ(static_cast<int>(input.dtype), 0) << "Input '" << input.name << "' must be a tensor";
+    }
+}
+
 int64_t InMbs(int64_t bytes) {
     return bytes / 1000 / 1000;
 }
@@ -98,6 +115,7 @@ ChxVMOptions::ChxVMOptions() {
 }
 
 ChxVM::ChxVM(const XCProgramProto& program) {
+    arena_size_ = program.arena_size();
     num_variables_ = 0;
     for (const XCInstructionProto& inst : program.instructions()) {
         for (int output : inst.outputs()) {
@@ -108,6 +126,9 @@ ChxVM::ChxVM(const XCProgramProto& program) {
     for (const XCInstructionProto& inst : program.instructions()) {
         ChxVMOp* op = MakeChxVMOp(inst);
         program_.emplace_back(op);
+        if (inst.op() == XCInstructionProto::NullConstant) {
+            may_produce_null_ = true;
+        }
     }
 
     CHECK_EQ(program.input_names_size(), program.input_types_size());
@@ -117,27 +138,38 @@ ChxVM::ChxVM(const XCProgramProto& program) {
         chainerx::Dtype dtype = static_cast<chainerx::Dtype>(type.dtype());
         chainerx::Shape shape(type.shape().begin(), type.shape().end());
         input_descs_.emplace_back(new ChxVMInputDesc(name, dtype, shape));
+        input_names_.push_back(name);
+    }
+
+    for (const XCInstructionProto& inst : program.instructions()) {
+        if (inst.op() != XCInstructionProto::In) {
+            input_index_of_pc_.push_back(-1);
+            continue;
+        }
+        const std::string& name = inst.inputs(0).s();
+        int index = GetInputIndex(name);
+        if (index < 0) {
+            index = input_names_.size();
+            input_names_.push_back(name);
+        }
+        input_index_of_pc_.push_back(index);
     }
 }
 
 ChxVM::~ChxVM() {
 }
 
+int ChxVM::GetInputIndex(const std::string& name) const {
+    auto found = std::find(input_names_.begin(), input_names_.end(), name);
+    if (found == input_names_.end()) return -1;
+    return found - input_names_.begin();
+}
+
 InOuts ChxVM::Run(const InOuts& program_inputs, const ChxVMOptions& options) {
     for (const std::unique_ptr<ChxVMInputDesc>& input : input_descs_) {
         auto found = program_inputs.find(input->name);
         CHECK(found != program_inputs.end()) << "Input '" << input->name << "' not found";
-        const ChxVMVar& var = *found->second;
-        if (var.IsArray()) {
-            const chainerx::Array& a = var.GetArray();
-            if (static_cast<int>(input->dtype) == 0) {
-                continue;
-            }
-            CHECK_EQ(input->dtype, a.dtype()) << "Input '" << input->name << "' has an unexpected dtype";
-            CHECK_EQ(input->shape, a.shape()) << "Input '" << input->name << "' has an unexpected shape";
-        } else {
-            CHECK_EQ(static_cast<int>(input->dtype), 0) << "Input '" << input->name << "' must be a tensor";
-        }
+        CheckInput(*input, *found->second);
     }
 
     ChxVMState state(options, num_variables_, program_inputs);
@@ -148,6 +180,52 @@ InOuts ChxVM::Run(const InOuts& program_inputs, const ChxVMOptions& options) {
 void ChxVM::Run(ChxVMState* state) {
     state->SetProgram(&program_);
     const ChxVMOptions& options = state->options();
+    IntraOpThreadsScope intra_op_threads(options.num_intra_op_threads);
+
+    if (DataflowExecutor::IsApplicable(options)) {
+        // The static memory plan assumes the program order, so
+        // concurrently running instructions allocate dynamically.
+        state->ReleaseArena();
+        std::unique_ptr<ThreadPool> pool;
+        {
+            std::lock_guard<std::mutex> lock(dataflow_mu_);
+            if (!dataflow_) {
+                dataflow_.reset(new DataflowExecutor(program_));
+            }
+            std::vector<std::unique_ptr<ThreadPool>>& idle_pools = idle_inter_op_pools_[options.num_inter_op_threads];
+            if (!idle_pools.empty()) {
+                pool = std::move(idle_pools.back());
+                idle_pools.pop_back();
+            }
+        }
+        if (!pool) {
+            pool.reset(new ThreadPool(options.num_inter_op_threads));
+        }
+        // The executor is never destroyed while `this` is alive and the
+        // pool is used only by this run, so the lock is not held.
+        auto release_pool = [this, &pool, &options]() {
+            std::lock_guard<std::mutex> lock(dataflow_mu_);
+            idle_inter_op_pools_[options.num_inter_op_threads].push_back(std::move(pool));
+        };
+        try {
+            dataflow_->Run(state, pool.get());
+        } catch (...) {
+            release_pool();
+            throw;
+        }
+        release_pool();
+        return;
+    }
+
+    if (arena_size_ > 0) {
+        state->PrepareArena(arena_size_);
+    }
+
+    if (CanRunRelease(*state)) {
+        RunRelease(state);
+        return;
+    }
+
     int64_t peak_used_mbs = 0, peak_total_mbs = 0;
 
     while (true) {
@@ -209,5 +287,57 @@ void ChxVM::Run(ChxVMState* state) {
     }
 }
 
+bool ChxVM::CanRunRelease(const ChxVMState& state) const {
+#ifdef CHAINER_COMPILER_ENABLE_NVTX
+    // Ranges of NVTX are pushed only by the instrumented loop.
+    return false;
+#else
+    const ChxVMOptions& options = state.options();
+    if (options.trace_level || options.check_types || options.check_nans || options.check_infs) return false;
+    if (options.dump_memory_usage || options.chrome_tracing || !options.dump_outputs_dir.empty()) return false;
+    // Ops skip null inputs only in `ChxVMOp::Run`.
+    return !may_produce_null_ && !state.HasNullInput();
+#endif  // CHAINER_COMPILER_ENABLE_NVTX
+}
+
+void ChxVM::RunRelease(ChxVMState* state) {
+    const int num_insts = program_.size();
+    int pc = state->pc();
+    try {
+        while (pc < num_insts) {
+            program_[pc]->RunRelease(state);
+            pc = state->pc() + 1;
+            state->set_pc(pc);
+        }
+    } catch (...) {
+        if (state->options().catch_exception) {
+            std::cerr << "Exception in " << program_[pc]->debug_info() << std::endl;
+        }
+        throw;
+    }
+}
+
+ChxVMSession::ChxVMSession(ChxVM* chxvm, const ChxVMOptions& options)
+    : chxvm_(chxvm), state_(new ChxVMState(options, chxvm->num_variables(), chxvm->input_names().size(), &chxvm->input_index_of_pc_)) {
+}
+
+ChxVMSession::~ChxVMSession() {
+}
+
+void ChxVMSession::SetInput(int index, const std::shared_ptr<ChxVMVar>& var) {
+    CHECK_LE(0, index) << index;
+    CHECK_GT(chxvm_->input_names_.size(), index) << index;
+    if (index < chxvm_->input_descs_.size()) {
+        CheckInput(*chxvm_->input_descs_[index], *var);
+    }
+    state_->BindInput(index, var);
+}
+
+const InOuts& ChxVMSession::Run() {
+    state_->Reset();
+    chxvm_->Run(state_.get());
+    return state_->outputs();
+}
+
 }  // namespace runtime
 }  // namespace chainer_compiler
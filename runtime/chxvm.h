@@ -2,7 +2,9 @@
 
 #include <cstdint>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -22,6 +24,8 @@ class ChromeTracingEmitter;
 class ChxVMOp;
 class ChxVMState;
 class ChxVMVar;
+class DataflowExecutor;
+class ThreadPool;
 
 typedef std::map<std::string, std::shared_ptr<ChxVMVar>> InOuts;
 
@@ -40,6 +44,12 @@ public:
 
     bool is_training{false};
 
+    // The seed of random ops (e.g., Dropout). Runs with the same seed
+    // generate the same random numbers. A negative value takes a seed
+    // for each `ChxVMState` from a sequence shared by the process, which
+    // starts at a random value.
+    int64_t seed{-1};
+
     bool check_types{false};
 
     bool check_nans{false};
@@ -56,6 +66,14 @@ public:
     std::string dump_outputs_dir;
 
     std::map<std::string, CustomOpFunc> custom_op_funcs;
+
+    // The number of threads which run independent instructions
+    // concurrently. 1 means the sequential interpreter.
+    int num_inter_op_threads{1};
+
+    // The number of threads which run loops in a single instruction
+    // (e.g., over ROIs or channels). See `ParallelFor`.
+    int num_intra_op_threads{1};
 };
 
 class ChxVMInputDesc;
@@ -72,13 +90,76 @@ public:
         return num_variables_;
     }
 
+    // Names of the inputs consumed by `In` instructions. The position
+    // in this list is the index accepted by `ChxVMSession::SetInput`.
+    const std::vector<std::string>& input_names() const {
+        return input_names_;
+    }
+
+    // Returns -1 if the program has no input named `name`.
+    int GetInputIndex(const std::string& name) const;
+
 private:
     ChxVM(const ChxVM&) = delete;
     ChxVM& operator=(const ChxVM&) = delete;
 
+    // Returns true if no option observes each instruction and no null
+    // value can appear, so `RunRelease` can be used.
+    bool CanRunRelease(const ChxVMState& state) const;
+    // The interpreter loop without any per-instruction work other than
+    // the dispatch.
+    void RunRelease(ChxVMState* state);
+
     std::vector<std::unique_ptr<ChxVMOp>> program_;
     std::vector<std::unique_ptr<ChxVMInputDesc>> input_descs_;
     int num_variables_;
+    int64_t arena_size_;
+    // True if the program has instructions which create null values.
+    bool may_produce_null_{false};
+
+    std::vector<std::string> input_names_;
+    // The index in `input_names_` for each `In` instruction, -1 for
+    // other instructions.
+    std::vector<int> input_index_of_pc_;
+
+    // Built on the first run with `num_inter_op_threads` > 1. A run
+    // takes an idle pool with its number of threads, or creates one,
+    // and returns it when it finishes, so concurrent runs (e.g., of
+    // different sessions) do not wait for each other. `dataflow_mu_`
+    // guards only the executor's construction and the idle pools.
+    std::mutex dataflow_mu_;
+    std::unique_ptr<DataflowExecutor> dataflow_;
+    std::map<int, std::vector<std::unique_ptr<ThreadPool>>> idle_inter_op_pools_;
+
+    friend class ChxVMSession;
+};
+
+// A reusable execution context of a `ChxVM`. Unlike `ChxVM::Run`,
+// which builds a fresh `ChxVMState` for each call, a session keeps
+// its options and its variable table across runs and receives inputs
+// by index. A session is not thread-safe: create one per thread.
+class ChxVMSession {
+public:
+    ChxVMSession(ChxVM* chxvm, const ChxVMOptions& options);
+    ~ChxVMSession();
+
+    // `index` is a position in `ChxVM::input_names()`.
+    void SetInput(int index, const std::shared_ptr<ChxVMVar>& var);
+
+    // Runs the program with the inputs bound so far. The returned
+    // outputs are valid until the next call of `Run`.
+    const InOuts& Run();
+
+    ChxVMState* state() {
+        return state_.get();
+    }
+
+private:
+    ChxVMSession(const ChxVMSession&) = delete;
+    ChxVMSession& operator=(const ChxVMSession&) = delete;
+
+    ChxVM* chxvm_;
+    std::unique_ptr<ChxVMState> state_;
 };
 
 }  // namespace runtime
@@ -0,0 +1,660 @@
+// Microbenchmarks for the ChxVM interpreter.
+//
+// Usage: chainer_compiler_runtime_bench [iterations]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <chainerx/array.h>
+#include <chainerx/backprop_mode.h>
+#include <chainerx/context.h>
+#include <chainerx/routines/creation.h>
+
+#include <common/log.h>
+#include <common/strutil.h>
+#include <compiler/chxvm/chxvm_value.h>
+#include <compiler/gen_chxvm_codegen.h>
+#include <runtime/chainerx_util.h>
+#include <runtime/chxvm.h>
+#include <runtime/chxvm.pb.h>
+#include <runtime/chxvm_var.h>
+
+namespace chainer_compiler {
+namespace runtime {
+namespace {
+
+using chxvm::ChxVMValue;
+
+double MeasureNsPerRun(int iterations, const std::function<void()>& fn) {
+    // Warm up.
+    fn();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / static_cast<double>(iterations);
+}
+
+void Report(const std::string& name, double ns) {
+    std::cout << name << ": " << ns / 1000 << " usec/run" << std::endl;
+}
+
+// y = Linear(Relu(Linear(x, w1, b1)), w2, b2)
+XCProgramProto MakeTinyMLP() {
+    XCProgramProto program;
+    chxvm::AddInOp(&program, ChxVMValue(1), "x");
+    chxvm::AddInOp(&program, ChxVMValue(2), "w1");
+    chxvm::AddInOp(&program, ChxVMValue(3), "b1");
+    chxvm::AddLinearOp(&program, ChxVMValue(4), 1, 2, 3, 1);
+    chxvm::AddFreeOp(&program, 1);
+    chxvm::AddFreeOp(&program, 2);
+    chxvm::AddFreeOp(&program, 3);
+    chxvm::AddReluOp(&program, ChxVMValue(5), 4);
+    chxvm::AddFreeOp(&program, 4);
+    chxvm::AddInOp(&program, ChxVMValue(6), "w2");
+    chxvm::AddInOp(&program, ChxVMValue(7), "b2");
+    chxvm::AddLinearOp(&program, ChxVMValue(8), 5, 6, 7, 1);
+    chxvm::AddFreeOp(&program, 5);
+    chxvm::AddFreeOp(&program, 6);
+    chxvm::AddFreeOp(&program, 7);
+    chxvm::AddOutOp(&program, "y", 8);
+    chxvm::AddFreeOp(&program, 8);
+    return program;
+}
+
+void BenchTinyMLP(int iterations) {
+    const int64_t kBatch = 1;
+    const int64_t kUnits = 16;
+    ChxVM chxvm(MakeTinyMLP());
+
+    InOuts inputs;
+    auto add_input = [&inputs](const std::string& name, const chainerx::Shape& shape) {
+        chainerx::Array a = chainerx::Ones(shape, chainerx::Dtype::kFloat32);
+        CHECK(inputs.emplace(name, std::make_shared<ChxVMVar>(a)).second);
+    };
+    add_input("x", {kBatch, kUnits});
+    add_input("w1", {kUnits, kUnits});
+    add_input("b1", {kUnits});
+    add_input("w2", {kUnits, kUnits});
+    add_input("b2", {kUnits});
+
+    ChxVMOptions options;
+    options.catch_exception = false;
+    double run_ns = MeasureNsPerRun(iterations, [&]() { chxvm.Run(inputs, options); });
+    Report("TinyMLP ChxVM::Run", run_ns);
+
+    ChxVMSession session(&chxvm, options);
+    for (const auto& p : inputs) {
+        int index = chxvm.GetInputIndex(p.first);
+        CHECK_LE(0, index) << p.first;
+        session.SetInput(index, p.second);
+    }
+    double session_ns = MeasureNsPerRun(iterations, [&]() { session.Run(); });
+    Report("TinyMLP ChxVMSession::Run", session_ns);
+}
+
+// y = x + d + d + ... on scalars, which measures the cost of the
+// interpreter loop rather than kernels.
+XCProgramProto MakeScalarChain(int num_adds) {
+    XCProgramProto program;
+    chxvm::AddInOp(&program, ChxVMValue(1), "x");
+    chxvm::AddInOp(&program, ChxVMValue(2), "d");
+    int sum = 1;
+    for (int i = 0; i < num_adds; ++i) {
+        int next_sum = i + 3;
+        chxvm::AddAddOp(&program, ChxVMValue(next_sum), sum, 2);
+        chxvm::AddFreeOp(&program, sum);
+        sum = next_sum;
+    }
+    chxvm::AddFreeOp(&program, 2);
+    chxvm::AddOutOp(&program, "y", sum);
+    chxvm::AddFreeOp(&program, sum);
+    return program;
+}
+
+void BenchScalarOps(int iterations) {
+    const int kAdds = 100;
+    XCProgramProto program = MakeScalarChain(kAdds);
+    const int num_insts = program.instructions_size();
+    ChxVM chxvm(program);
+
+    InOuts inputs;
+    inputs.emplace("x", std::make_shared<ChxVMVar>(chainerx::Full({}, 0, chainerx::Dtype::kInt64)));
+    inputs.emplace("d", std::make_shared<ChxVMVar>(chainerx::Full({}, 1, chainerx::Dtype::kInt64)));
+
+    // The release loop, and the loop which checks each instruction.
+    for (bool check : {false, true}) {
+        ChxVMOptions options;
+        options.catch_exception = false;
+        options.check_nans = check;
+        ChxVMSession session(&chxvm, options);
+        for (const auto& p : inputs) {
+            session.SetInput(chxvm.GetInputIndex(p.first), p.second);
+        }
+        double ns = MeasureNsPerRun(iterations, [&]() { session.Run(); });
+        std::cout << "ScalarOps" << (check ? " check_nans" : "") << ": " << ns / num_insts << " nsec/instruction" << std::endl;
+    }
+}
+
+// y = sum_i Relu(MatMul(x, w)), with independent branches.
+XCProgramProto MakeBranches(int num_branches) {
+    XCProgramProto program;
+    chxvm::AddInOp(&program, ChxVMValue(1), "x");
+    chxvm::AddInOp(&program, ChxVMValue(2), "w");
+    int next_id = 3;
+    std::vector<int> branch_ids;
+    for (int i = 0; i < num_branches; ++i) {
+        int mm = next_id++;
+        int relu = next_id++;
+        chxvm::AddMatMulOp(&program, ChxVMValue(mm), 1, 2);
+        chxvm::AddReluOp(&program, ChxVMValue(relu), mm);
+        chxvm::AddFreeOp(&program, mm);
+        branch_ids.push_back(relu);
+    }
+    chxvm::AddFreeOp(&program, 1);
+    chxvm::AddFreeOp(&program, 2);
+    int sum = branch_ids[0];
+    for (int i = 1; i < num_branches; ++i) {
+        int next_sum = next_id++;
+        chxvm::AddAddOp(&program, ChxVMValue(next_sum), sum, branch_ids[i]);
+        chxvm::AddFreeOp(&program, sum);
+        chxvm::AddFreeOp(&program, branch_ids[i]);
+        sum = next_sum;
+    }
+    chxvm::AddOutOp(&program, "y", sum);
+    chxvm::AddFreeOp(&program, sum);
+    return program;
+}
+
+void BenchInterOp(int iterations) {
+    const int kBranches = 8;
+    const int64_t kUnits = 256;
+    ChxVM chxvm(MakeBranches(kBranches));
+
+    InOuts inputs;
+    inputs.emplace("x", std::make_shared<ChxVMVar>(chainerx::Ones({kUnits, kUnits}, chainerx::Dtype::kFloat32)));
+    inputs.emplace("w", std::make_shared<ChxVMVar>(chainerx::Ones({kUnits, kUnits}, chainerx::Dtype::kFloat32)));
+
+    const int max_threads = std::max<int>(2, std::thread::hardware_concurrency());
+    for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        ChxVMOptions options;
+        options.catch_exception = false;
+        options.num_inter_op_threads = num_threads;
+        double ns = MeasureNsPerRun(iterations, [&]() { chxvm.Run(inputs, options); });
+        Report(StrCat("Branches x", kBranches, " inter_op_threads=", num_threads), ns);
+    }
+}
+
+// Bottleneck blocks of ResNet50 (from conv2_1 to conv5_3) for batch
+// size 1, with or without ConvBiasActivation. BatchNormalization is
+// assumed to be merged into Conv as in inference.
+class ResNet50Builder {
+public:
+    explicit ResNet50Builder(bool fused) : fused_(fused) {
+    }
+
+    XCProgramProto Build() {
+        chxvm::AddInOp(&program_, ChxVMValue(next_id_), "x");
+        int h = next_id_++;
+        int64_t channels = 64;
+        const int kNumBlocks[] = {3, 4, 6, 3};
+        for (int stage = 0; stage < 4; ++stage) {
+            const int64_t mid = 64 << stage;
+            for (int block = 0; block < kNumBlocks[stage]; ++block) {
+                const int stride = stage > 0 && block == 0 ? 2 : 1;
+                int shortcut = h;
+                if (block == 0) {
+                    shortcut = Conv(h, channels, mid * 4, 1, stride, false, -1);
+                }
+                int t = Conv(h, channels, mid, 1, 1, true, -1);
+                t = Conv(t, mid, mid, 3, stride, true, -1);
+                t = Conv(t, mid, mid * 4, 1, 1, true, shortcut);
+                if (shortcut != h) Free(shortcut);
+                Free(h);
+                h = t;
+                channels = mid * 4;
+            }
+        }
+        chxvm::AddOutOp(&program_, "y", h);
+        Free(h);
+        return program_;
+    }
+
+    const std::vector<std::pair<std::string, chainerx::Shape>>& params() const {
+        return params_;
+    }
+
+private:
+    int Param(const chainerx::Shape& shape) {
+        const std::string name = StrCat("p", params_.size());
+        params_.emplace_back(name, shape);
+        chxvm::AddInOp(&program_, ChxVMValue(next_id_), name);
+        return next_id_++;
+    }
+
+    void Free(int id) {
+        chxvm::AddFreeOp(&program_, id);
+    }
+
+    int Conv(int x, int64_t in_channels, int64_t out_channels, int64_t kernel, int64_t stride, bool relu, int residual) {
+        const int w = Param({out_channels, in_channels, kernel, kernel});
+        const int b = Param({out_channels});
+        const std::vector<int64_t> strides = {stride, stride};
+        const std::vector<int64_t> pads = {kernel / 2, kernel / 2};
+        const int y = next_id_++;
+        if (!relu) {
+            chxvm::AddConvOp(&program_, ChxVMValue(y), x, w, b, strides, pads, 1, "NOTSET");
+        } else if (fused_) {
+            chxvm::AddConvBiasActivationOp(
+                    &program_,
+                    ChxVMValue(y),
+                    x,
+                    w,
+                    b,
+                    residual,
+                    strides,
+                    pads,
+                    1,
+                    "NOTSET",
+                    "Relu",
+                    0,
+                    -std::numeric_limits<float>::infinity(),
+                    std::numeric_limits<float>::infinity());
+        } else {
+            int h = next_id_++;
+            chxvm::AddConvOp(&program_, ChxVMValue(h), x, w, b, strides, pads, 1, "NOTSET");
+            if (residual >= 0) {
+                const int sum = next_id_++;
+                chxvm::AddAddOp(&program_, ChxVMValue(sum), h, residual);
+                Free(h);
+                h = sum;
+            }
+            chxvm::AddReluOp(&program_, ChxVMValue(y), h);
+            Free(h);
+        }
+        Free(w);
+        Free(b);
+        return y;
+    }
+
+    const bool fused_;
+    XCProgramProto program_;
+    std::vector<std::pair<std::string, chainerx::Shape>> params_;
+    int next_id_{1};
+};
+
+void BenchResNet50(int iterations) {
+    for (bool fused : {false, true}) {
+        ResNet50Builder builder(fused);
+        ChxVM chxvm(builder.Build());
+
+        InOuts inputs;
+        inputs.emplace("x", std::make_shared<ChxVMVar>(chainerx::Ones({1, 64, 56, 56}, chainerx::Dtype::kFloat32)));
+        // Weights which keep activations around one.
+        for (const auto& p : builder.params()) {
+            const chainerx::Shape& shape = p.second;
+            const double value = shape.ndim() == 1 ? 0.01 : 1.0 / (shape.GetTotalSize() / shape[0]);
+            inputs.emplace(p.first, std::make_shared<ChxVMVar>(chainerx::Full(shape, value, chainerx::Dtype::kFloat32)));
+        }
+
+        ChxVMOptions options;
+        options.catch_exception = false;
+        double ns = MeasureNsPerRun(iterations, [&]() { chxvm.Run(inputs, options); });
+        Report(StrCat("ResNet50 blocks", fused ? " ConvBiasActivation" : " Conv+Add+Relu"), ns);
+    }
+}
+
+// Depthwise 3x3 convs of MobileNetV2 for batch size 1, as (channels,
+// input size, stride).
+const int64_t kMobileNetV2DepthwiseConvs[][3] = {
+        {32, 112, 1},
+        {96, 112, 2},
+        {144, 56, 1},
+        {144, 56, 2},
+        {192, 28, 1},
+        {192, 28, 1},
+        {192, 28, 2},
+        {384, 14, 1},
+        {384, 14, 1},
+        {384, 14, 1},
+        {384, 14, 1},
+        {576, 14, 1},
+        {576, 14, 1},
+        {576, 14, 2},
+        {960, 7, 1},
+        {960, 7, 1},
+        {960, 7, 1},
+};
+
+// Runs the depthwise convs of MobileNetV2 and their gradients if
+// `backward`. If `split`, each conv is split into convs of channels
+// and concatenated as ChxVM used to do for grouped convs.
+XCProgramProto MakeMobileNetV2DepthwiseConvs(bool split, bool backward) {
+    XCProgramProto program;
+    int next_id = 1;
+    auto split_channels = [&program, &next_id](int x, int axis, int64_t channels) {
+        std::vector<ChxVMValue> outputs;
+        std::vector<int> ids;
+        for (int64_t i = 0; i < channels; ++i) {
+            ids.push_back(next_id);
+            outputs.emplace_back(next_id++);
+        }
+        chxvm::AddSplitOp(&program, outputs, x, axis, std::vector<int64_t>(channels, 1));
+        return ids;
+    };
+    auto concat = [&program, &next_id](const std::vector<int>& ids, int axis) {
+        const int y = next_id++;
+        chxvm::AddConcatOp(&program, ChxVMValue(y), ids, axis);
+        for (int id : ids) chxvm::AddFreeOp(&program, id);
+        chxvm::AddFreeOp(&program, y);
+    };
+
+    int i = 0;
+    for (const int64_t* conv : kMobileNetV2DepthwiseConvs) {
+        const int64_t channels = conv[0];
+        const int64_t size = conv[1];
+        const std::vector<int64_t> strides = {conv[2], conv[2]};
+        const std::vector<int64_t> pads = {1, 1};
+        const int x = next_id++;
+        const int w = next_id++;
+        const int gy = next_id++;
+        chxvm::AddInOp(&program, ChxVMValue(x), StrCat("x", i));
+        chxvm::AddInOp(&program, ChxVMValue(w), StrCat("w", i));
+        chxvm::AddInOp(&program, ChxVMValue(gy), StrCat("gy", i));
+        ++i;
+
+        if (!split) {
+            const int y = next_id++;
+            chxvm::AddConvOp(&program, ChxVMValue(y), x, w, -1, strides, pads, channels, "NOTSET");
+            chxvm::AddFreeOp(&program, y);
+            if (backward) {
+                const int gx = next_id++;
+                const int gw = next_id++;
+                chxvm::AddConvTransposeOp(&program, ChxVMValue(gx), gy, w, -1, strides, pads, {size, size}, channels);
+                chxvm::AddConvGradWeightOp(&program, ChxVMValue(gw), w, x, gy, strides, pads, channels);
+                chxvm::AddFreeOp(&program, gx);
+                chxvm::AddFreeOp(&program, gw);
+            }
+        } else {
+            const std::vector<int> xs = split_channels(x, 1, channels);
+            const std::vector<int> ws = split_channels(w, 0, channels);
+            std::vector<int> ys;
+            for (int64_t c = 0; c < channels; ++c) {
+                ys.push_back(next_id);
+                chxvm::AddConvOp(&program, ChxVMValue(next_id++), xs[c], ws[c], -1, strides, pads, 1, "NOTSET");
+            }
+            concat(ys, 1);
+            if (backward) {
+                const std::vector<int> gys = split_channels(gy, 1, channels);
+                std::vector<int> gxs, gws;
+                for (int64_t c = 0; c < channels; ++c) {
+                    gxs.push_back(next_id);
+                    chxvm::AddConvTransposeOp(&program, ChxVMValue(next_id++), gys[c], ws[c], -1, strides, pads, {size, size}, 1);
+                    gws.push_back(next_id);
+                    chxvm::AddConvGradWeightOp(&program, ChxVMValue(next_id++), ws[c], xs[c], gys[c], strides, pads, 1);
+                }
+                concat(gxs, 1);
+                concat(gws, 0);
+                for (int id : gys) chxvm::AddFreeOp(&program, id);
+            }
+            for (int id : xs) chxvm::AddFreeOp(&program, id);
+            for (int id : ws) chxvm::AddFreeOp(&program, id);
+        }
+        chxvm::AddFreeOp(&program, x);
+        chxvm::AddFreeOp(&program, w);
+        chxvm::AddFreeOp(&program, gy);
+    }
+    return program;
+}
+
+void BenchMobileNetV2(int iterations) {
+    InOuts inputs;
+    int i = 0;
+    for (const int64_t* conv : kMobileNetV2DepthwiseConvs) {
+        const int64_t channels = conv[0];
+        const int64_t size = conv[1];
+        const int64_t out_size = (size - 1) / conv[2] + 1;
+        auto add_input = [&inputs, i](const std::string& name, const chainerx::Shape& shape) {
+            chainerx::Array a = chainerx::Full(shape, 0.1, chainerx::Dtype::kFloat32);
+            CHECK(inputs.emplace(StrCat(name, i), std::make_shared<ChxVMVar>(a)).second);
+        };
+        add_input("x", {1, channels, size, size});
+        add_input("w", {channels, 1, 3, 3});
+        add_input("gy", {1, channels, out_size, out_size});
+        ++i;
+    }
+
+    for (bool backward : {false, true}) {
+        for (bool split : {true, false}) {
+            ChxVM chxvm(MakeMobileNetV2DepthwiseConvs(split, backward));
+            ChxVMOptions options;
+            options.catch_exception = false;
+            double ns = MeasureNsPerRun(iterations, [&]() { chxvm.Run(inputs, options); });
+            Report(StrCat("MobileNetV2 depthwise convs", backward ? " with gradients" : "", split ? " Split+Conv+Concat" : " grouped Conv"),
+                   ns);
+        }
+    }
+}
+
+// An MLP with `num_layers` hidden layers, Relu(x * w + b) each.
+XCProgramProto MakeMLP(int num_layers, bool fused) {
+    XCProgramProto program;
+    chxvm::AddInOp(&program, ChxVMValue(1), "x");
+    int x = 1;
+    int next_id = 2;
+    for (int i = 0; i < num_layers; ++i) {
+        const int w = next_id++;
+        const int b = next_id++;
+        chxvm::AddInOp(&program, ChxVMValue(w), StrCat("w", i));
+        chxvm::AddInOp(&program, ChxVMValue(b), StrCat("b", i));
+        const int y = next_id++;
+        if (fused) {
+            chxvm::AddGemmBiasActivationOp(&program, ChxVMValue(y), x, w, b, 1.0, 1.0, 0, 0, "Relu");
+        } else {
+            const int h = next_id++;
+            chxvm::AddGemmOp(&program, ChxVMValue(h), x, w, b, 1.0, 1.0, 0, 0);
+            chxvm::AddReluOp(&program, ChxVMValue(y), h);
+            chxvm::AddFreeOp(&program, h);
+        }
+        chxvm::AddFreeOp(&program, x);
+        chxvm::AddFreeOp(&program, w);
+        chxvm::AddFreeOp(&program, b);
+        x = y;
+    }
+    chxvm::AddOutOp(&program, "y", x);
+    chxvm::AddFreeOp(&program, x);
+    return program;
+}
+
+void BenchMLP(int iterations) {
+    const int kNumLayers = 4;
+    const int64_t kBatch = 256;
+    const int64_t kUnits = 1024;
+    for (bool fused : {false, true}) {
+        ChxVM chxvm(MakeMLP(kNumLayers, fused));
+
+        InOuts inputs;
+        inputs.emplace("x", std::make_shared<ChxVMVar>(chainerx::Ones({kBatch, kUnits}, chainerx::Dtype::kFloat32)));
+        for (int i = 0; i < kNumLayers; ++i) {
+            chainerx::Array w = chainerx::Full({kUnits, kUnits}, 1.0 / kUnits, chainerx::Dtype::kFloat32);
+            chainerx::Array b = chainerx::Full({kUnits}, 0.01, chainerx::Dtype::kFloat32);
+            inputs.emplace(StrCat("w", i), std::make_shared<ChxVMVar>(w));
+            inputs.emplace(StrCat("b", i), std::make_shared<ChxVMVar>(b));
+        }
+
+        ChxVMOptions options;
+        options.catch_exception = false;
+        double ns = MeasureNsPerRun(iterations, [&]() { chxvm.Run(inputs, options); });
+        Report(StrCat("MLP ", fused ? "GemmBiasActivation" : "Gemm+Relu"), ns);
+    }
+}
+
+// A bidirectional LSTM and its gradients. Zero peepholes make LSTM
+// run by the generic implementation.
+XCProgramProto MakeLSTM(int64_t hidden_size, bool generic) {
+    XCProgramProto program;
+    int id = 1;
+    for (const char* name : {"x", "w", "r", "b", "gy", "p"}) {
+        chxvm::AddInOp(&program, ChxVMValue(id++), name);
+    }
+    chxvm::AddLSTMOp(
+            &program, ChxVMValue(7), ChxVMValue(8), ChxVMValue(9), ChxVMValue(10), 1, 2, 3, 4, -1, -1, -1, generic ? 6 : -1, hidden_size, 2);
+    chxvm::AddLSTMGradOp(&program, ChxVMValue(11), ChxVMValue(12), ChxVMValue(13), ChxVMValue(14), 5, 10);
+    chxvm::AddOutOp(&program, "y", 7);
+    chxvm::AddOutOp(&program, "gw", 12);
+    for (int i = 1; i <= 14; ++i) {
+        chxvm::AddFreeOp(&program, i);
+    }
+    return program;
+}
+
+void BenchLSTM(int iterations) {
+    // Sizes of a speech model.
+    const int64_t kSeqLength = 100;
+    const int64_t kBatch = 16;
+    const int64_t kInput = 240;
+    const int64_t kHidden = 320;
+    for (bool generic : {true, false}) {
+        ChxVM chxvm(MakeLSTM(kHidden, generic));
+
+        InOuts inputs;
+        auto random = [](const chainerx::Shape& shape) { return std::make_shared<ChxVMVar>(SlowRandom(shape) - 0.5); };
+        inputs.emplace("x", random({kSeqLength, kBatch, kInput}));
+        inputs.emplace("w", random({2, 4 * kHidden, kInput}));
+        inputs.emplace("r", random({2, 4 * kHidden, kHidden}));
+        inputs.emplace("b", random({2, 8 * kHidden}));
+        inputs.emplace("gy", random({kSeqLength, 2, kBatch, kHidden}));
+        inputs.emplace("p", std::make_shared<ChxVMVar>(chainerx::Zeros({2, 3 * kHidden}, chainerx::Dtype::kFloat32)));
+
+        ChxVMOptions options;
+        options.catch_exception = false;
+        double ns = MeasureNsPerRun(iterations, [&]() { chxvm.Run(inputs, options); });
+        Report(StrCat("LSTM+LSTMGrad ", generic ? "generic" : "native"), ns);
+    }
+}
+
+// Nearest upsampling by `scale` or bilinear resizing to the same size,
+// and its gradient.
+XCProgramProto MakeResize(int64_t scale, bool bilinear, const chainerx::Shape& shape) {
+    XCProgramProto program;
+    chxvm::AddInOp(&program, ChxVMValue(1), "x");
+    chxvm::AddInOp(&program, ChxVMValue(2), "gy");
+    if (bilinear) {
+        chxvm::AddResizeImagesOp(&program, ChxVMValue(3), 1, {shape[2] * scale, shape[3] * scale});
+        chxvm::AddShapeOp(&program, ChxVMValue(4), 1);
+        chxvm::AddResizeImagesGradOp(&program, ChxVMValue(5), 2, 4);
+    } else {
+        chxvm::AddInOp(&program, ChxVMValue(4), "scales");
+        chxvm::AddUpsampleOp(&program, ChxVMValue(3), 1, 4);
+        chxvm::AddUpsampleGradOp(&program, ChxVMValue(5), 2, 4);
+    }
+    chxvm::AddOutOp(&program, "y", 3);
+    chxvm::AddOutOp(&program, "gx", 5);
+    for (int i = 1; i <= 5; ++i) {
+        chxvm::AddFreeOp(&program, i);
+    }
+    return program;
+}
+
+void BenchResize(int iterations) {
+    // A decoder of a segmentation model.
+    const chainerx::Shape shape{8, 64, 64, 64};
+    for (bool bilinear : {false, true}) {
+        for (int64_t scale : {2, 3, 4}) {
+            ChxVM chxvm(MakeResize(scale, bilinear, shape));
+
+            InOuts inputs;
+            inputs.emplace("x", std::make_shared<ChxVMVar>(SlowRandom(shape)));
+            inputs.emplace("gy", std::make_shared<ChxVMVar>(SlowRandom({shape[0], shape[1], shape[2] * scale, shape[3] * scale})));
+            const float scales[] = {1, 1, static_cast<float>(scale), static_cast<float>(scale)};
+            inputs.emplace("scales", std::make_shared<ChxVMVar>(MakeArray(chainerx::Dtype::kFloat32, {4}, scales)));
+
+            ChxVMOptions options;
+            options.catch_exception = false;
+            double ns = MeasureNsPerRun(iterations, [&]() { chxvm.Run(inputs, options); });
+            Report(StrCat(bilinear ? "ResizeImages" : "Upsample", "+Grad x", scale), ns);
+        }
+    }
+}
+
+// ROIs of a two-stage detector, and their gradients.
+XCProgramProto MakeROI(bool align) {
+    XCProgramProto program;
+    int id = 1;
+    for (const char* name : {"x", "rois", "roi_indices", "gy"}) {
+        chxvm::AddInOp(&program, ChxVMValue(id++), name);
+    }
+    if (align) {
+        chxvm::AddROIAverageAlign2DOp(&program, ChxVMValue(5), ChxVMValue(6), 1, 2, 3, {7, 7}, 1.0 / 16, {2, 2});
+        chxvm::AddROIAverageAlign2DGradOp(&program, ChxVMValue(7), 4, 6, {7, 7}, 1.0 / 16, {2, 2});
+    } else {
+        chxvm::AddROIMaxPool2DOp(&program, ChxVMValue(5), ChxVMValue(6), 1, 2, 3, {7, 7}, 1.0 / 16);
+        chxvm::AddROIMaxPool2DGradOp(&program, ChxVMValue(7), 4, 6, {7, 7}, 1.0 / 16);
+    }
+    chxvm::AddOutOp(&program, "y", 5);
+    chxvm::AddOutOp(&program, "gx", 7);
+    for (int i = 1; i <= 7; ++i) {
+        chxvm::AddFreeOp(&program, i);
+    }
+    return program;
+}
+
+void BenchROI(int iterations) {
+    // A feature map of stride 16 for an 800x1088 image.
+    const int64_t kChannels = 256;
+    const int64_t kHeight = 50;
+    const int64_t kWidth = 68;
+    const int64_t kNumROIs = 1000;
+    std::vector<float> rois;
+    for (int64_t i = 0; i < kNumROIs; ++i) {
+        const float y = i * 37 % (kHeight * 16 - 64);
+        const float x = i * 53 % (kWidth * 16 - 64);
+        const float size = 32 + i * 7 % 256;
+        rois.insert(rois.end(), {y, x, y + size, x + size});
+    }
+    const std::vector<int32_t> roi_indices(kNumROIs, 0);
+    for (bool align : {false, true}) {
+        ChxVM chxvm(MakeROI(align));
+
+        InOuts inputs;
+        inputs.emplace("x", std::make_shared<ChxVMVar>(SlowRandom({1, kChannels, kHeight, kWidth})));
+        inputs.emplace("rois", std::make_shared<ChxVMVar>(MakeArray(chainerx::Dtype::kFloat32, {kNumROIs, 4}, rois.data())));
+        inputs.emplace(
+                "roi_indices", std::make_shared<ChxVMVar>(MakeArray(chainerx::Dtype::kInt32, {kNumROIs}, roi_indices.data())));
+        inputs.emplace("gy", std::make_shared<ChxVMVar>(SlowRandom({kNumROIs, kChannels, 7, 7})));
+
+        ChxVMOptions options;
+        options.catch_exception = false;
+        double ns = MeasureNsPerRun(iterations, [&]() { chxvm.Run(inputs, options); });
+        Report(align ? "ROIAverageAlign2D+Grad" : "ROIMaxPool2D+Grad", ns);
+    }
+}
+
+}  // namespace
+}  // namespace runtime
+}  // namespace chainer_compiler
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 10000;
+    chainerx::Context ctx;
+    chainerx::ContextScope ctx_scope(ctx);
+    chainerx::NoBackpropModeScope no_backprop;
+    chainer_compiler::runtime::BenchTinyMLP(iterations);
+    chainer_compiler::runtime::BenchScalarOps(std::max(1, iterations / 10));
+    chainer_compiler::runtime::BenchInterOp(std::max(1, iterations / 100));
+    chainer_compiler::runtime::BenchResNet50(std::max(1, iterations / 1000));
+    chainer_compiler::runtime::BenchMLP(std::max(1, iterations / 1000));
+    chainer_compiler::runtime::BenchMobileNetV2(std::max(1, iterations / 1000));
+    chainer_compiler::runtime::BenchLSTM(std::max(1, iterations / 1000));
+    chainer_compiler::runtime::BenchResize(std::max(1, iterations / 1000));
+    chainer_compiler::runtime::BenchROI(std::max(1, iterations / 1000));
+}
@@ -218,14 +218,21 @@ XC_OPS = [
     ('Conv',
      [Array('x'), Array('w'), OptionalArray('b'),
       Ints('strides'), Ints('pads'), Int('group'), String('auto_pad')], ['y']),
+    ('ConvBiasActivation',
+     [Array('x'), Array('w'), OptionalArray('b'), OptionalArray('z'),
+      Ints('strides'), Ints('pads'), Int('group'), String('auto_pad'),
+      String('activation'), Float('alpha'), Float('min'), Float('max')],
+     ['y']),
     ('ConvTranspose',
      [Array('x'), Array('w'), OptionalArray('b'),
-      Ints('strides'), Ints('pads'), Ints('output_shape')], ['y']),
+      Ints('strides'), Ints('pads'), Ints('output_shape'), Int('group')],
+     ['y']),
     ('ConvTransposeWithDynamicShape',
      [Array('x'), Array('w'), Shape('shape'),
-      Ints('strides'), Ints('pads')], ['y']),
+      Ints('strides'), Ints('pads'), Int('group')], ['y']),
     ('ConvGradWeight',
-     [Array('w'), Array('x'), Array('gy'), Ints('strides'), Ints('pads')],
+     [Array('w'), Array('x'), Array('gy'), Ints('strides'), Ints('pads'),
+      Int('group')],
      ['y']),
 
     ('Relu', [Array('x')], ['y']),
@@ -276,6 +283,7 @@ XC_OPS = [
     ('Dropout', [Array('data'), Float('ratio')], ['output', 'mask']),
 
     ('Upsample', [Array('x'), Array('scales')], ['y']),
+    ('UpsampleGrad', [Array('gy'), Array('scales')], ['gx']),
     ('Pad', [Array('data'), Ints('pads'), Float('value')], ['output']),
     ('MaxPool',
      [Array('x'), Ints('kernel_shape'), Ints('strides'), Ints('pads'),
@@ -295,22 +303,37 @@ XC_OPS = [
     ('ROIMaxPool2D',
      [Array('x'), Array('rois'), Array('roi_indices'),
       Ints('output_shape'), Float('spatial_scale')],
-     ['y']),
+     ['y', Opaque('ctx')]),
     ('ROIAveragePool2D',
      [Array('x'), Array('rois'), Array('roi_indices'),
       Ints('output_shape'), Float('spatial_scale')],
-     ['y']),
+     ['y', Opaque('ctx')]),
     ('ROIMaxAlign2D',
      [Array('x'), Array('rois'), Array('roi_indices'),
       Ints('output_shape'), Float('spatial_scale'), Ints('sampling_ratio')],
-     ['y']),
+     ['y', Opaque('ctx')]),
     ('ROIAverageAlign2D',
      [Array('x'), Array('rois'), Array('roi_indices'),
       Ints('output_shape'), Float('spatial_scale'), Ints('sampling_ratio')],
-     ['y']),
+     ['y', Opaque('ctx')]),
+    ('ROIMaxPool2DGrad',
+     [Array('gy'), Opaque('ctx'), Ints('output_shape'), Float('spatial_scale')],
+     ['gx']),
+    ('ROIAveragePool2DGrad',
+     [Array('gy'), Opaque('ctx'), Ints('output_shape'), Float('spatial_scale')],
+     ['gx']),
+    ('ROIMaxAlign2DGrad',
+     [Array('gy'), Opaque('ctx'), Ints('output_shape'), Float('spatial_scale'),
+      Ints('sampling_ratio')],
+     ['gx']),
+    ('ROIAverageAlign2DGrad',
+     [Array('gy'), Opaque('ctx'), Ints('output_shape'), Float('spatial_scale'),
+      Ints('sampling_ratio')],
+     ['gx']),
     ('ResizeImages',
      [Array('x'), Ints('output_shape')],
      ['y']),
+    ('ResizeImagesGrad', [Array('gy'), Shape('shape')], ['gx']),
     ('PadBatchSize',
      [Array('x'), Int('batch_size')],
      ['y']),
@@ -320,6 +343,11 @@ XC_OPS = [
      [Array('a'), Array('b'), Array('c'),
       Float('alpha'), Float('beta'), Int('trans_a'), Int('trans_b')],
      ['y']),
+    ('GemmBiasActivation',
+     [Array('a'), Array('b'), OptionalArray('c'),
+      Float('alpha'), Float('beta'), Int('trans_a'), Int('trans_b'),
+      String('activation')],
+     ['y']),
 
     ('RNN',
      [Array('x'), Array('w'), Array('r'),
@@ -422,6 +450,14 @@ XC_CUSTOM_FIELD_OPS = [
     ('Dldt',
      [ArrayList('inputs'), String('model_path'), String('device')],
      [ArrayList('outputs')]),
+    ('ElementWiseNative',
+     [ArrayList('inputs'), Int('num_outputs'),
+      String('code'), Int('fusion_id')],
+     [ArrayList('outputs')]),
+    ('RowReductionNative',
+     [ArrayList('inputs'), Int('num_outputs'), IntValues('row_outputs'),
+      String('code'), Int('fusion_id')],
+     [ArrayList('outputs')]),
 ]
 
 XC_SEQ_OPS = [
@@ -1,5 +1,8 @@
 #include "runtime/chxvm_op.h"
 
+#include <chainerx/dtype.h>
+
+#include <common/log.h>
 #include <common/strutil.h>
 
 namespace chainer_compiler {
@@ -7,6 +10,25 @@ namespace runtime {
 
 ChxVMOp::ChxVMOp(const XCInstructionProto& inst)
     : inst_(inst), id_(inst.id()), op_(inst.op()), name_(StrCat(XCInstructionProto_Op_Name(inst.op()), inst.id())) {
+    if (inst.output_offsets_size()) {
+        CHECK_EQ(inst.outputs_size(), inst.output_offsets_size()) << inst.DebugString();
+        CHECK_EQ(inst.outputs_size(), inst.output_types_size()) << inst.DebugString();
+        for (int i = 0; i < inst.output_offsets_size(); ++i) {
+            const XCTypeProto& type = inst.output_types(i);
+            int64_t nbytes = -1;
+            if (inst.output_offsets(i) >= 0 && type.dtype() > 0) {
+                nbytes = chainerx::GetItemSize(static_cast<chainerx::Dtype>(type.dtype()));
+                for (int d : type.shape()) nbytes *= d;
+            }
+            output_offsets_.push_back(nbytes >= 0 ? inst.output_offsets(i) : -1);
+            output_nbytes_.push_back(nbytes);
+        }
+    }
+    for (int index : inst.consumed_inputs()) {
+        CHECK_LT(index, inst.inputs_size()) << inst.DebugString();
+        if (consumed_inputs_.size() <= index) consumed_inputs_.resize(index + 1);
+        consumed_inputs_[index] = true;
+    }
 }
 
 }  // namespace runtime
@@ -2,6 +2,7 @@
 
 #include <stdint.h>
 #include <string>
+#include <vector>
 
 #include <runtime/chxvm.pb.h>
 
@@ -17,6 +18,11 @@ public:
 
     virtual void Run(ChxVMState* state) = 0;
 
+    // Runs the op without traces, checks of NaNs and infs, or skipping
+    // null inputs. Used only when none of them is necessary (see
+    // `ChxVM::CanRunRelease`).
+    virtual void RunRelease(ChxVMState* state) = 0;
+
     const XCInstructionProto& instruction() const {
         return inst_;
     }
@@ -37,11 +43,31 @@ public:
         return inst_.debug_info();
     }
 
+    // The byte offset of the `index`-th output in the arena, or -1 if
+    // the output was not placed by the compiler.
+    int64_t output_offset(int index) const {
+        return index < output_offsets_.size() ? output_offsets_[index] : -1;
+    }
+
+    // The size of the `index`-th output planned by the compiler.
+    int64_t output_nbytes(int index) const {
+        return index < output_nbytes_.size() ? output_nbytes_[index] : -1;
+    }
+
+    // True if the `index`-th input dies at this instruction, so the
+    // op may take it from its variable and overwrite its buffer.
+    bool consumes_input(int index) const {
+        return index < consumed_inputs_.size() && consumed_inputs_[index];
+    }
+
 protected:
     XCInstructionProto inst_;
     const int64_t id_;
     const XCInstructionProto::Op op_;
     const std::string name_;
+    std::vector<int64_t> output_offsets_;
+    std::vector<int64_t> output_nbytes_;
+    std::vector<bool> consumed_inputs_;
 };
 
 ChxVMOp* MakeChxVMOp(const XCInstructionProto& inst);
@@ -1,13 +1,19 @@
 #include "runtime/chxvm_state.h"
 
+#include <algorithm>
+#include <atomic>
 #include <map>
+#include <random>
 
+#include <chainerx/device.h>
+#include <chainerx/routines/creation.h>
 #include <chainerx/routines/manipulation.h>
 #include <chainerx/routines/math.h>
 #include <chainerx/routines/reduction.h>
 
 #include <common/log.h>
 #include <common/strutil.h>
+#include <runtime/chainerx_util.h>
 #include <runtime/chxvm.h>
 #include <runtime/chxvm_op.h>
 #include <runtime/chxvm_var.h>
@@ -15,13 +21,143 @@
 namespace chainer_compiler {
 namespace runtime {
 
+namespace {
+
+uint64_t GetRandomSeed(const ChxVMOptions& options) {
+    if (options.seed >= 0) return options.seed;
+    // The sequence starts at a random value so that processes do not
+    // generate the same masks.
+    static std::atomic<uint64_t> next_seed{[]() {
+        std::random_device rd;
+        return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+    }()};
+    return next_seed++;
+}
+
+}  // namespace
+
 ChxVMState::ChxVMState(const ChxVMOptions& options, int num_variables, const InOuts& inputs)
-    : pc_(0), variables_(num_variables), inputs_(inputs), options_(options) {
+    : pc_(0),
+      variables_(num_variables),
+      is_assigned_(num_variables),
+      assigned_slots_(num_variables),
+      inputs_(inputs),
+      options_(options),
+      random_seed_(GetRandomSeed(options)) {
+}
+
+ChxVMState::ChxVMState(const ChxVMOptions& options, int num_variables, int num_inputs, const std::vector<int>* input_index_of_pc)
+    : pc_(0),
+      variables_(num_variables),
+      is_assigned_(num_variables),
+      assigned_slots_(num_variables),
+      input_index_of_pc_(input_index_of_pc),
+      options_(options),
+      random_seed_(GetRandomSeed(options)) {
+    bound_inputs_.resize(num_inputs);
 }
 
 ChxVMState::~ChxVMState() {
 }
 
+void ChxVMState::Reset() {
+    pc_ = 0;
+    outputs_.clear();
+    const int num_assigned = num_assigned_;
+    for (int i = 0; i < num_assigned; ++i) {
+        const int index = assigned_slots_[i];
+        is_assigned_[index] = false;
+        if (variables_[index].get()) {
+            variables_[index].reset();
+            --num_live_variables_;
+        }
+    }
+    num_assigned_ = 0;
+    CHECK_EQ(0, num_live_variables_);
+}
+
+uint64_t ChxVMState::NextRandomStream(const ChxVMOp& op) {
+    std::lock_guard<std::mutex> lock(random_mu_);
+    const uint64_t count = random_counts_[op.id()]++;
+    return (static_cast<uint64_t>(op.id()) << 32) + count;
+}
+
+void ChxVMState::BindInput(int input_index, const std::shared_ptr<ChxVMVar>& var) {
+    CHECK(input_index_of_pc_) << "Inputs of this state are bound by name";
+    CHECK_LE(0, input_index) << input_index;
+    CHECK_GT(bound_inputs_.size(), input_index) << input_index;
+    bound_inputs_[input_index] = var;
+}
+
+bool ChxVMState::HasNullInput() const {
+    auto is_null = [](const ChxVMVar* var) {
+        if (var->IsNull()) return true;
+        if (var->kind() != ChxVMVar::Kind::kSequence) return false;
+        const ChxVMSequence& seq = *var->GetSequence();
+        return std::any_of(seq.begin(), seq.end(), [](const ChxVMVar& v) { return v.IsNull(); });
+    };
+    for (const auto& p : inputs_) {
+        if (is_null(p.second.get())) return true;
+    }
+    for (const std::shared_ptr<ChxVMVar>& var : bound_inputs_) {
+        if (var && is_null(var.get())) return true;
+    }
+    return false;
+}
+
+void ChxVMState::PrepareArena(int64_t size) {
+    chainerx::Device& device = chainerx::GetDefaultDevice();
+    if (arena_ && arena_size_ >= size && arena_device_ == &device) return;
+    arena_ = device.Allocate(size);
+    arena_size_ = size;
+    arena_device_ = &device;
+}
+
+void ChxVMState::ReleaseArena() {
+    arena_.reset();
+    arena_size_ = 0;
+    arena_device_ = nullptr;
+}
+
+chainerx::Array ChxVMState::AllocateOutput(
+        const ChxVMOp& op, int index, const chainerx::Shape& shape, chainerx::Dtype dtype, chainerx::Device& device) {
+    const int64_t offset = op.output_offset(index);
+    if (offset >= 0 && arena_ && arena_device_ == &device) {
+        const int64_t nbytes = shape.GetTotalSize() * chainerx::GetItemSize(dtype);
+        if (nbytes == op.output_nbytes(index)) {
+            CHECK_LE(offset + nbytes, arena_size_) << op.debug_info();
+            return chainerx::FromData(shape, dtype, arena_, nonstd::nullopt, offset, device);
+        }
+    }
+    return chainerx::Empty(shape, dtype, device);
+}
+
+nonstd::optional<chainerx::Array> ChxVMState::GetReusableOutput(
+        const ChxVMOp& op, int index, int input_index, const chainerx::Array& input) {
+    if (op.output_offset(index) >= 0) {
+        return AllocateOutput(op, index, input.shape(), input.dtype(), input.device());
+    }
+    if (op.consumes_input(input_index) && IsExclusivelyOwned(input)) {
+        return input;
+    }
+    return nonstd::nullopt;
+}
+
+void ChxVMState::AssignVar(int index, ChxVMVar* var) {
+    CHECK_LE(0, index) << index;
+    CHECK_GT(variables_.size(), index) << index;
+    CHECK(!variables_[index].get()) << index;
+    variables_[index].reset(var);
+    ++num_live_variables_;
+    MarkAssigned(index);
+}
+
+void ChxVMState::MarkAssigned(int index) {
+    if (is_assigned_[index]) return;
+    is_assigned_[index] = true;
+    assigned_slots_[num_assigned_++] = index;
+}
+
 chainerx::Array ChxVMState::GetArray(int index) {
     CHECK_LE(0, index) << index;
     CHECK_GT(variables_.size(), index) << index;
@@ -29,6 +165,13 @@ chainerx::Array ChxVMState::GetArray(int index) {
     return variables_[index]->GetArray();
 }
 
+chainerx::Array ChxVMState::TakeArray(int index) {
+    if (check_nans() || check_infs()) return GetArray(index);
+    chainerx::Array array = GetArray(index);
+    *variables_[index] = ChxVMVar();
+    return array;
+}
+
 nonstd::optional<chainerx::Array> ChxVMState::GetOptionalArray(int index) {
     if (index < 0) return nonstd::nullopt;
     return GetArray(index);
@@ -48,7 +191,9 @@ void ChxVMState::SetArrayList(const std::vector<int>& index, const std::vector<c
 ChxVMSequence* ChxVMState::CreateSequence(int index) {
     CHECK_LE(0, index) << index;
     CHECK_GT(variables_.size(), index) << index;
+    if (!variables_[index].get()) ++num_live_variables_;
     variables_[index].reset(new ChxVMVar(std::make_shared<ChxVMSequence>()));
+    MarkAssigned(index);
     return GetSequence(index);
 }
 
@@ -67,10 +212,7 @@ const ChxVMOpaque& ChxVMState::GetOpaque(int index) {
 }
 
 void ChxVMState::SetOpaque(int index, ChxVMOpaque* opaque) {
-    CHECK_LE(0, index) << index;
-    CHECK_GT(variables_.size(), index) << index;
-    CHECK(!variables_[index].get());
-    variables_[index].reset(new ChxVMVar(opaque));
+    AssignVar(index, new ChxVMVar(opaque));
 }
 
 ChxVMVar* ChxVMState::GetVar(int index) {
@@ -86,10 +228,7 @@ nonstd::optional<ChxVMVar*> ChxVMState::GetOptionalVar(int index) {
 }
 
 void ChxVMState::SetVar(int index, const ChxVMVar& var) {
-    CHECK_LE(0, index) << index;
-    CHECK_GT(variables_.size(), index) << index;
-    CHECK(!variables_[index].get());
-    variables_[index].reset(new ChxVMVar(var));
+    AssignVar(index, new ChxVMVar(var));
 }
 
 const chainerx::Shape& ChxVMState::GetShape(int index) {
@@ -100,10 +239,7 @@ const chainerx::Shape& ChxVMState::GetShape(int index) {
 }
 
 void ChxVMState::SetShape(int index, chainerx::Shape s) {
-    CHECK_LE(0, index) << index;
-    CHECK_GT(variables_.size(), index) << index;
-    CHECK(!variables_[index].get());
-    variables_[index].reset(new ChxVMVar(s));
+    AssignVar(index, new ChxVMVar(s));
 }
 
 const StrictScalar& ChxVMState::GetScalar(int index) {
@@ -128,10 +264,7 @@ int64_t ChxVMState::GetOptionalInt(int index, int64_t default_value) {
 }
 
 void ChxVMState::SetScalar(int index, StrictScalar s) {
-    CHECK_LE(0, index) << index;
-    CHECK_GT(variables_.size(), index) << index;
-    CHECK(!variables_[index].get());
-    variables_[index].reset(new ChxVMVar(s));
+    AssignVar(index, new ChxVMVar(s));
 }
 
 std::string ChxVMState::GetVarString(int index) {
@@ -169,10 +302,7 @@ std::string ChxVMState::GetVarListString(const std::vector<int>& indices) {
 }
 
 void ChxVMState::SetArray(int index, const chainerx::Array& value) {
-    CHECK_LE(0, index) << index;
-    CHECK_GT(variables_.size(), index) << index;
-    CHECK(!variables_[index].get());
-    variables_[index].reset(new ChxVMVar(value));
+    AssignVar(index, new ChxVMVar(value));
 }
 
 void ChxVMState::FreeVar(int index) {
@@ -180,15 +310,20 @@ void ChxVMState::FreeVar(int index) {
     CHECK_GT(variables_.size(), index) << index;
     CHECK(variables_[index].get()) << index;
     variables_[index].reset();
+    --num_live_variables_;
 }
 
 void ChxVMState::Input(const std::string& name, int index) {
-    CHECK_LE(0, index) << index;
-    CHECK_GT(variables_.size(), index) << index;
-    CHECK(!variables_[index].get()) << index;
+    if (input_index_of_pc_) {
+        CHECK_GT(input_index_of_pc_->size(), pc_);
+        const std::shared_ptr<ChxVMVar>& var = bound_inputs_[(*input_index_of_pc_)[pc_]];
+        CHECK(var.get()) << "Input value not bound: " << name;
+        AssignVar(index, new ChxVMVar(*var));
+        return;
+    }
     auto found = inputs_.find(name);
     CHECK(found != inputs_.end()) << "Input value not exist: " << name;
-    variables_[index].reset(new ChxVMVar(*found->second.get()));
+    AssignVar(index, new ChxVMVar(*found->second.get()));
 }
 
 void ChxVMState::Output(const std::string& name, int index) {
@@ -274,7 +409,9 @@ int64_t ChxVMState::GetTotalVariableSize() const {
             continue;
         }
         for (const chainerx::Array& a : v->GetArrays()) {
-            array_sizes[a.raw_data()] = std::max(array_sizes[a.raw_data()], a.GetNBytes());
+            // Arrays in the arena share `raw_data` but not offsets.
+            void* data = static_cast<char*>(a.raw_data()) + a.offset();
+            array_sizes[data] = std::max(array_sizes[data], a.GetNBytes());
         }
     }
 
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <map>
+#include <mutex>
 #include <stack>
 #include <string>
 #include <vector>
@@ -21,8 +24,39 @@ class ChxVMVar;
 class ChxVMState {
 public:
     ChxVMState(const ChxVMOptions& options, int num_variables, const InOuts& inputs);
+    // Creates a state whose inputs are bound by index. `input_index_of_pc`
+    // maps each `In` instruction to the index of its input.
+    ChxVMState(const ChxVMOptions& options, int num_variables, int num_inputs, const std::vector<int>* input_index_of_pc);
     ~ChxVMState();
 
+    // Prepares the state for the next run by releasing variables left
+    // alive by the previous run. Only slots assigned since the last
+    // reset are visited.
+    void Reset();
+
+    void BindInput(int input_index, const std::shared_ptr<ChxVMVar>& var);
+
+    // True if an input is null or a sequence which has null elements.
+    bool HasNullInput() const;
+
+    // Makes sure the arena for statically placed outputs has at least
+    // `size` bytes on the default device. The arena is kept across runs.
+    void PrepareArena(int64_t size);
+    void ReleaseArena();
+
+    // Returns an uninitialized array for the `index`-th output of `op`.
+    // The array is carved out of the arena if the compiler placed the
+    // output and the requested type matches the plan. Otherwise, a new
+    // array is allocated.
+    chainerx::Array AllocateOutput(const ChxVMOp& op, int index, const chainerx::Shape& shape, chainerx::Dtype dtype, chainerx::Device& device);
+
+    // Returns a buffer for the `index`-th output of `op`, which has the
+    // type of `input`, without a new allocation if possible: the one
+    // placed by the compiler, or `input` itself if it is the
+    // `input_index`-th input consumed by `op` and no other array refers
+    // to it. Returns null otherwise.
+    nonstd::optional<chainerx::Array> GetReusableOutput(const ChxVMOp& op, int index, int input_index, const chainerx::Array& input);
+
     int pc() const {
         return pc_;
     }
@@ -31,6 +65,10 @@ public:
     }
 
     chainerx::Array GetArray(int index);
+    // Moves the array out of the variable of a dead value. The variable
+    // is left null and released by the following `Free`. The array
+    // stays when checks which report inputs are enabled.
+    chainerx::Array TakeArray(int index);
     nonstd::optional<chainerx::Array> GetOptionalArray(int index);
     void SetArray(int index, const chainerx::Array& value);
     void FreeVar(int index);
@@ -65,6 +103,9 @@ public:
     const InOuts& GetOutputs() {
         return std::move(outputs_);
     }
+    const InOuts& outputs() const {
+        return outputs_;
+    }
 
     void CheckNans(const std::vector<int>& inputs, const std::vector<int>& outputs);
     void CheckInfs(const std::vector<int>& inputs, const std::vector<int>& outputs);
@@ -86,6 +127,15 @@ public:
         return options_.check_infs;
     }
 
+    uint64_t random_seed() const {
+        return random_seed_;
+    }
+
+    // Returns a stream of random numbers for a call of `op`. Streams of
+    // instructions in loops and of runs of a session are different for
+    // each call.
+    uint64_t NextRandomStream(const ChxVMOp& op);
+
     void ShowVariableStatus() const;
 
     void SetProgram(const std::vector<std::unique_ptr<ChxVMOp>>* program) {
@@ -96,13 +146,32 @@ public:
 
 private:
     void ReportInvalidInOuts(const std::vector<int>& inputs, const std::vector<int>& outputs);
+    void AssignVar(int index, ChxVMVar* var);
+    void MarkAssigned(int index);
 
     int pc_;
     std::vector<std::unique_ptr<ChxVMVar>> variables_;
+    // Updated by instructions running in parallel.
+    std::atomic<int> num_live_variables_{0};
+    // Slots assigned since the last `Reset`. `is_assigned_` is indexed by
+    // slots and the first `num_assigned_` elements of `assigned_slots_`
+    // list them. A slot is assigned by one instruction at a time.
+    std::vector<char> is_assigned_;
+    std::vector<int> assigned_slots_;
+    std::atomic<int> num_assigned_{0};
     InOuts inputs_;
+    std::vector<std::shared_ptr<ChxVMVar>> bound_inputs_;
+    const std::vector<int>* input_index_of_pc_{nullptr};
+    std::shared_ptr<void> arena_;
+    int64_t arena_size_{0};
+    chainerx::Device* arena_device_{nullptr};
     InOuts outputs_;
     ChxVMOptions options_;
     const std::vector<std::unique_ptr<ChxVMOp>>* program_;
+    uint64_t random_seed_;
+    // The number of calls of `NextRandomStream` for each op ID.
+    std::map<int64_t, uint64_t> random_counts_;
+    std::mutex random_mu_;
 };
 
 }  // namespace runtime
@@ -1,19 +1,46 @@
+#include <math.h>
+
+#include <algorithm>
 #include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
 
 #include <chainerx/array.h>
+#include <chainerx/context.h>
+#include <chainerx/kernels/connection.h>
 #include <chainerx/numeric.h>
+#include <chainerx/routines/connection.h>
 #include <chainerx/routines/creation.h>
+#include <chainerx/routines/hyperbolic.h>
+#include <chainerx/routines/linalg.h>
+#include <chainerx/routines/manipulation.h>
+#include <chainerx/routines/math.h>
+#include <chainerx/routines/reduction.h>
 #include <chainerx/testing/array.h>
 #include <chainerx/testing/array_check.h>
 #include <chainerx/testing/context_session.h>
 
 #include <compiler/chxvm/chxvm_value.h>
+#include <compiler/flags.h>
+#include <compiler/fusion.h>
 #include <compiler/gen_chxvm_codegen.h>
+#include <compiler/graph.h>
+#include <compiler/graph_builder.h>
+#include <compiler/node.h>
+#include <compiler/nvrtc_builder.h>
+#include <compiler/type.h>
+#include <compiler/value.h>
+#include <runtime/chainerx_util.h>
 #include <runtime/chxvm.h>
 #include <runtime/chxvm.pb.h>
 #include <runtime/chxvm_var.h>
+#include <runtime/ops/native_jit.h>
 
 namespace chainer_compiler {
 namespace runtime {
@@ -40,6 +67,978 @@ TEST(ChxVMTest, Run) {
     EXPECT_ARRAY_EQ(e, outputs["out"]->GetArray());
 }
 
+TEST(ChxVMTest, Session) {
+    chainerx::testing::ContextSession sess;
+
+    XCProgramProto program;
+    chxvm::AddInOp(&program, chxvm::ChxVMValue(0), "in1");
+    chxvm::AddInOp(&program, chxvm::ChxVMValue(1), "in2");
+    chxvm::AddAddOp(&program, chxvm::ChxVMValue(2), 0, 1);
+    chxvm::AddFreeOp(&program, 0);
+    chxvm::AddFreeOp(&program, 1);
+    chxvm::AddOutOp(&program, "out", 2);
+    chxvm::AddFreeOp(&program, 2);
+
+    ChxVM chxvm(program);
+    ASSERT_EQ(2, chxvm.input_names().size());
+    int in1_index = chxvm.GetInputIndex("in1");
+    int in2_index = chxvm.GetInputIndex("in2");
+    ASSERT_LE(0, in1_index);
+    ASSERT_LE(0, in2_index);
+    EXPECT_EQ(-1, chxvm.GetInputIndex("in3"));
+
+    ChxVMSession session(&chxvm, ChxVMOptions());
+    chainerx::Array in1 = chainerx::Eye(2, nonstd::nullopt, nonstd::nullopt, chainerx::Dtype::kFloat32);
+    session.SetInput(in1_index, std::make_shared<ChxVMVar>(in1));
+    session.SetInput(in2_index, std::make_shared<ChxVMVar>(chainerx::OnesLike(in1)));
+    for (int i = 0; i < 3; ++i) {
+        const InOuts& outputs = session.Run();
+        ASSERT_EQ(1, outputs.count("out"));
+        chainerx::Array e = chainerx::testing::BuildArray({2, 2}).WithData<float>({2, 1, 1, 2});
+        EXPECT_ARRAY_EQ(e, outputs.at("out")->GetArray());
+    }
+
+    // Rebinding one input does not affect the other one.
+    session.SetInput(in2_index, std::make_shared<ChxVMVar>(in1));
+    const InOuts& outputs = session.Run();
+    chainerx::Array e = chainerx::testing::BuildArray({2, 2}).WithData<float>({2, 0, 0, 2});
+    EXPECT_ARRAY_EQ(e, outputs.at("out")->GetArray());
+}
+
+TEST(ChxVMTest, SessionWithoutFree) {
+    chainerx::testing::ContextSession sess;
+
+    // Variables are left alive and released by the next run.
+    XCProgramProto program;
+    chxvm::AddInOp(&program, chxvm::ChxVMValue(7), "in");
+    chxvm::AddReluOp(&program, chxvm::ChxVMValue(3), 7);
+    chxvm::AddOutOp(&program, "out", 3);
+
+    ChxVM chxvm(program);
+    ChxVMSession session(&chxvm, ChxVMOptions());
+    chainerx::Array in = chainerx::testing::BuildArray({2}).WithData<float>({-1, 2});
+    session.SetInput(chxvm.GetInputIndex("in"), std::make_shared<ChxVMVar>(in));
+    for (int i = 0; i < 3; ++i) {
+        const InOuts& outputs = session.Run();
+        chainerx::Array e = chainerx::testing::BuildArray({2}).WithData<float>({0, 2});
+        EXPECT_ARRAY_EQ(e, outputs.at("out")->GetArray());
+    }
+}
+
+TEST(ChxVMTest, ConsumedInputs) {
+    chainerx::testing::ContextSession sess;
+
+    XCProgramProto program;
+    chxvm::AddInOp(&program, chxvm::ChxVMValue(0), "in1");
+    chxvm::AddInOp(&program, chxvm::ChxVMValue(1), "in2");
+    chxvm::AddSubOp(&program, chxvm::ChxVMValue(2), 0, 1);
+    chxvm::AddOutOp(&program, "diff", 2);
+    // $2 is still referred by the output "diff".
+    chxvm::AddReluOp(&program, chxvm::ChxVMValue(3), 2);
+    program.mutable_instructions(program.instructions_size() - 1)->add_consumed_inputs(0);
+    chxvm::AddFreeOp(&program, 2);
+    // $3 can be overwritten.
+    chxvm::AddMulOp(&program, chxvm::ChxVMValue(4), 3, 0);
+    program.mutable_instructions(program.instructions_size() - 1)->add_consumed_inputs(0);
+    chxvm::AddFreeOp(&program, 3);
+    chxvm::AddFreeOp(&program, 0);
+    chxvm::AddFreeOp(&program, 1);
+    chxvm::AddOutOp(&program, "out", 4);
+    chxvm::AddFreeOp(&program, 4);
+
+    ChxVM chxvm(program);
+    InOuts inputs;
+    inputs.emplace("in1", std::make_shared<ChxVMVar>(chainerx::testing::BuildArray({4}).WithData<float>({1, 2, 3, 4})));
+    inputs.emplace("in2", std::make_shared<ChxVMVar>(chainerx::testing::BuildArray({4}).WithData<float>({2, 2, 2, 2})));
+    InOuts outputs = chxvm.Run(inputs, ChxVMOptions());
+    EXPECT_ARRAY_EQ(chainerx::testing::BuildArray({4}).WithData<float>({-1, 0, 1, 2}), outputs["diff"]->GetArray());
+    EXPECT_ARRAY_EQ(chainerx::testing::BuildArray({4}).WithData<float>({0, 0, 3, 8}), outputs["out"]->GetArray());
+}
+
+TEST(ChxVMTest, SigmoidInPlace) {
+    chainerx::testing::ContextSession sess;
+
+    XCProgramProto program;
+    chxvm::AddInOp(&program, chxvm::ChxVMValue(0), "in");
+    chxvm::AddNegOp(&program, chxvm::ChxVMValue(1), 0);
+    chxvm::AddNegOp(&program, chxvm::ChxVMValue(2), 1);
+    chxvm::AddFreeOp(&program, 1);
+    // $0 is referred by the caller and $2 can be overwritten.
+    chxvm::AddSigmoidOp(&program, chxvm::ChxVMValue(3), 0);
+    program.mutable_instructions(program.instructions_size() - 1)->add_consumed_inputs(0);
+    chxvm::AddSigmoidOp(&program, chxvm::ChxVMValue(4), 2);
+    program.mutable_instructions(program.instructions_size() - 1)->add_consumed_inputs(0);
+    chxvm::AddFreeOp(&program, 0);
+    chxvm::AddFreeOp(&program, 2);
+    chxvm::AddOutOp(&program, "new", 3);
+    chxvm::AddOutOp(&program, "in_place", 4);
+    chxvm::AddFreeOp(&program, 3);
+    chxvm::AddFreeOp(&program, 4);
+
+    ChxVM chxvm(program);
+    InOuts inputs;
+    chainerx::Array in = SlowRandom({37}) * 20 - 10;
+    inputs.emplace("in", std::make_shared<ChxVMVar>(in));
+    InOuts outputs = chxvm.Run(inputs, ChxVMOptions());
+    // The results do not depend on whether the input is reused.
+    EXPECT_ARRAY_EQ(outputs["new"]->GetArray(), outputs["in_place"]->GetArray());
+    EXPECT_ARRAY_ALL_CLOSE(Sigmoid(in), outputs["new"]->GetArray());
+}
+
+TEST(ChxVMTest, InterOpParallel) {
+    chainerx::testing::ContextSession sess;
+
+    XCProgramProto program;
+    chxvm::AddInOp(&program, chxvm::ChxVMValue(0), "in1");
+    chxvm::AddInOp(&program, chxvm::ChxVMValue(1), "in2");
+    // Add and Mul can run concurrently.
+    chxvm::AddAddOp(&program, chxvm::ChxVMValue(2), 0, 1);
+    chxvm::AddMulOp(&program, chxvm::ChxVMValue(3), 0, 1);
+    chxvm::AddFreeOp(&program, 0);
+    chxvm::AddFreeOp(&program, 1);
+    chxvm::AddSubOp(&program, chxvm::ChxVMValue(4), 2, 3);
+    chxvm::AddFreeOp(&program, 2);
+    chxvm::AddFreeOp(&program, 3);
+    // Reuses the slot of $2, which must wait for the Sub.
+    chxvm::AddAddOp(&program, chxvm::ChxVMValue(2), 4, 4);
+    chxvm::AddFreeOp(&program, 4);
+    chxvm::AddOutOp(&program, "out", 2);
+    chxvm::AddFreeOp(&program, 2);
+
+    ChxVM chxvm(program);
+    InOuts inputs;
+    chainerx::Array in1 = chainerx::Eye(2, nonstd::nullopt, nonstd::nullopt, chainerx::Dtype::kFloat32);
+    inputs.emplace("in1", std::shared_ptr<ChxVMVar>(new ChxVMVar(in1)));
+    inputs.emplace("in2", std::shared_ptr<ChxVMVar>(new ChxVMVar(chainerx::OnesLike(in1))));
+    ChxVMOptions options;
+    options.num_inter_op_threads = 4;
+    chainerx::Array e = chainerx::testing::BuildArray({2, 2}).WithData<float>({2, 2, 2, 2});
+    for (int i = 0; i < 20; ++i) {
+        InOuts outputs = chxvm.Run(inputs, options);
+        ASSERT_EQ(1, outputs.count("out"));
+        EXPECT_ARRAY_EQ(e, outputs["out"]->GetArray());
+    }
+
+    // Concurrent runs take their own pools.
+    chainerx::Context& context = chainerx::GetDefaultContext();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; ++t) {
+        threads.emplace_back([&chxvm, &inputs, &options, &context, &e]() {
+            chainerx::ContextScope context_scope(context);
+            for (int i = 0; i < 20; ++i) {
+                InOuts outputs = chxvm.Run(inputs, options);
+                EXPECT_ARRAY_EQ(e, outputs["out"]->GetArray());
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+TEST(ChxVMTest, ConvBiasActivation) {
+    chainerx::testing::ContextSession sess;
+
+    InOuts inputs;
+    inputs.emplace("x", std::make_shared<ChxVMVar>(SlowRandom({2, 3, 5, 6}) - 0.5));
+    inputs.emplace("w", std::make_shared<ChxVMVar>(SlowRandom({4, 3, 3, 3}) - 0.5));
+    inputs.emplace("b", std::make_shared<ChxVMVar>(SlowRandom({4}) - 0.5));
+    inputs.emplace("z", std::make_shared<ChxVMVar>(SlowRandom({2, 4, 5, 6}) - 0.5));
+
+    for (const char* activation : {"Relu", "LeakyRelu", "Clip"}) {
+        for (bool has_residual : {false, true}) {
+            SCOPED_TRACE(activation);
+            SCOPED_TRACE(has_residual);
+            const float alpha = 0.1;
+            const float min = -0.5;
+            const float max = 0.5;
+
+            XCProgramProto program;
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(0), "x");
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(1), "w");
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(2), "b");
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(3), "z");
+            chxvm::AddConvOp(&program, chxvm::ChxVMValue(4), 0, 1, 2, {1, 1}, {1, 1}, 1, "NOTSET");
+            int conv = 4;
+            if (has_residual) {
+                chxvm::AddAddOp(&program, chxvm::ChxVMValue(5), 4, 3);
+                conv = 5;
+            }
+            if (std::string(activation) == "Relu") {
+                chxvm::AddReluOp(&program, chxvm::ChxVMValue(6), conv);
+            } else if (std::string(activation) == "LeakyRelu") {
+                chxvm::AddLeakyReluOp(&program, chxvm::ChxVMValue(6), conv, alpha);
+            } else {
+                chxvm::AddClipOp(&program, chxvm::ChxVMValue(6), conv, max, min);
+            }
+            chxvm::AddOutOp(&program, "unfused", 6);
+            chxvm::AddConvBiasActivationOp(
+                    &program, chxvm::ChxVMValue(7), 0, 1, 2, has_residual ? 3 : -1, {1, 1}, {1, 1}, 1, "NOTSET", activation, alpha, min, max);
+            chxvm::AddOutOp(&program, "fused", 7);
+
+            ChxVM chxvm(program);
+            InOuts outputs = chxvm.Run(inputs, ChxVMOptions());
+            EXPECT_ARRAY_ALL_CLOSE(outputs["unfused"]->GetArray(), outputs["fused"]->GetArray());
+        }
+    }
+}
+
+TEST(ChxVMTest, GemmBiasActivation) {
+    chainerx::testing::ContextSession sess;
+
+    // The fused op computes the 150 rows in three panels.
+    InOuts inputs;
+    inputs.emplace("a", std::make_shared<ChxVMVar>(SlowRandom({150, 7}) - 0.5));
+    inputs.emplace("b", std::make_shared<ChxVMVar>(SlowRandom({7, 6}) - 0.5));
+    inputs.emplace("bt", std::make_shared<ChxVMVar>(SlowRandom({6, 7}) - 0.5));
+    inputs.emplace("c_row", std::make_shared<ChxVMVar>(SlowRandom({6}) - 0.5));
+    inputs.emplace("c_full", std::make_shared<ChxVMVar>(SlowRandom({150, 6}) - 0.5));
+    inputs.emplace("zero", std::make_shared<ChxVMVar>(chainerx::Zeros({1}, chainerx::Dtype::kFloat32)));
+
+    for (const char* activation : {"Relu", "Sigmoid", "Tanh"}) {
+        for (const char* c : {"c_row", "c_full", ""}) {
+            for (bool trans_b : {false, true}) {
+                SCOPED_TRACE(activation);
+                SCOPED_TRACE(c);
+                SCOPED_TRACE(trans_b);
+                const bool has_c = *c;
+                const float alpha = 0.7;
+                const float beta = has_c ? 1.3 : 0.0;
+
+                XCProgramProto program;
+                chxvm::AddInOp(&program, chxvm::ChxVMValue(0), "a");
+                chxvm::AddInOp(&program, chxvm::ChxVMValue(1), trans_b ? "bt" : "b");
+                chxvm::AddInOp(&program, chxvm::ChxVMValue(2), has_c ? c : "zero");
+                chxvm::AddGemmOp(&program, chxvm::ChxVMValue(3), 0, 1, 2, alpha, beta, 0, trans_b);
+                if (std::string(activation) == "Relu") {
+                    chxvm::AddReluOp(&program, chxvm::ChxVMValue(4), 3);
+                } else if (std::string(activation) == "Sigmoid") {
+                    chxvm::AddSigmoidOp(&program, chxvm::ChxVMValue(4), 3);
+                } else {
+                    chxvm::AddTanhOp(&program, chxvm::ChxVMValue(4), 3);
+                }
+                chxvm::AddOutOp(&program, "unfused", 4);
+                chxvm::AddGemmBiasActivationOp(
+                        &program, chxvm::ChxVMValue(5), 0, 1, has_c ? 2 : -1, alpha, beta, 0, trans_b, activation);
+                chxvm::AddOutOp(&program, "fused", 5);
+
+                ChxVM chxvm(program);
+                InOuts outputs = chxvm.Run(inputs, ChxVMOptions());
+                EXPECT_ARRAY_ALL_CLOSE(outputs["unfused"]->GetArray(), outputs["fused"]->GetArray());
+            }
+        }
+    }
+}
+
+TEST(ChxVMTest, GroupedConv) {
+    chainerx::testing::ContextSession sess;
+
+    struct Config {
+        int64_t group;
+        int64_t in_channels;
+        int64_t out_channels;
+        int64_t stride;
+    };
+    // Depthwise, depthwise with a multiplier, and grouped convs.
+    for (const Config& config : {Config{4, 4, 4, 1}, Config{4, 4, 4, 2}, Config{3, 3, 6, 1}, Config{2, 4, 6, 2}}) {
+        SCOPED_TRACE(config.group);
+        SCOPED_TRACE(config.out_channels);
+        SCOPED_TRACE(config.stride);
+        const int64_t group = config.group;
+        const Int64StackVector strides = {config.stride, config.stride};
+        const Int64StackVector pads = {1, 1};
+        chainerx::Array x = SlowRandom({2, config.in_channels, 7, 6}) - 0.5;
+        chainerx::Array w = SlowRandom({config.out_channels, config.in_channels / group, 3, 3}) - 0.5;
+        chainerx::Array b = SlowRandom({config.out_channels}) - 0.5;
+
+        // References by a conv for each group.
+        std::vector<chainerx::Array> xs = SplitByLengths(x, 1, std::vector<int64_t>(group, x.shape()[1] / group));
+        std::vector<chainerx::Array> ws = SplitByLengths(w, 0, std::vector<int64_t>(group, w.shape()[0] / group));
+        std::vector<chainerx::Array> bs = SplitByLengths(b, 0, std::vector<int64_t>(group, b.shape()[0] / group));
+        std::vector<chainerx::Array> ys, gxs, gws;
+        for (int64_t i = 0; i < group; ++i) {
+            ys.push_back(chainerx::Conv(xs[i], ws[i], bs[i], strides, pads));
+        }
+        chainerx::Array y = chainerx::Concatenate(ys, 1);
+        chainerx::Array gy = SlowRandom(y.shape()) - 0.5;
+        std::vector<chainerx::Array> gys = SplitByLengths(gy, 1, std::vector<int64_t>(group, gy.shape()[1] / group));
+        for (int64_t i = 0; i < group; ++i) {
+            const chainerx::StackVector<int64_t, chainerx::kMaxNdim> out_size = {x.shape()[2], x.shape()[3]};
+            gxs.push_back(chainerx::ConvTranspose(gys[i], ws[i], nonstd::nullopt, strides, pads, out_size));
+            gws.push_back(x.device().backend().CallKernel<chainerx::ConvGradWeightKernel>(
+                    w.dtype(), ws[i].shape(), xs[i], gys[i], strides, pads, false, nonstd::nullopt));
+        }
+
+        InOuts inputs;
+        inputs.emplace("x", std::make_shared<ChxVMVar>(x));
+        inputs.emplace("w", std::make_shared<ChxVMVar>(w));
+        inputs.emplace("b", std::make_shared<ChxVMVar>(b));
+        inputs.emplace("gy", std::make_shared<ChxVMVar>(gy));
+
+        XCProgramProto program;
+        chxvm::AddInOp(&program, chxvm::ChxVMValue(0), "x");
+        chxvm::AddInOp(&program, chxvm::ChxVMValue(1), "w");
+        chxvm::AddInOp(&program, chxvm::ChxVMValue(2), "b");
+        chxvm::AddInOp(&program, chxvm::ChxVMValue(3), "gy");
+        chxvm::AddConvOp(&program, chxvm::ChxVMValue(4), 0, 1, 2, {config.stride, config.stride}, {1, 1}, group, "NOTSET");
+        chxvm::AddOutOp(&program, "y", 4);
+        chxvm::AddConvTransposeOp(
+                &program, chxvm::ChxVMValue(5), 3, 1, -1, {config.stride, config.stride}, {1, 1}, {x.shape()[2], x.shape()[3]}, group);
+        chxvm::AddOutOp(&program, "gx", 5);
+        chxvm::AddConvGradWeightOp(&program, chxvm::ChxVMValue(6), 1, 0, 3, {config.stride, config.stride}, {1, 1}, group);
+        chxvm::AddOutOp(&program, "gw", 6);
+
+        ChxVM chxvm(program);
+        InOuts outputs = chxvm.Run(inputs, ChxVMOptions());
+        EXPECT_ARRAY_ALL_CLOSE(y, outputs["y"]->GetArray());
+        EXPECT_ARRAY_ALL_CLOSE(chainerx::Concatenate(gxs, 1), outputs["gx"]->GetArray());
+        EXPECT_ARRAY_ALL_CLOSE(chainerx::Concatenate(gws, 0), outputs["gw"]->GetArray());
+    }
+}
+
+TEST(ChxVMTest, LSTM) {
+    chainerx::testing::ContextSession sess;
+
+    // In float64 to compare implementations with different orders of
+    // summations.
+    auto random = [](const chainerx::Shape& shape) { return SlowRandom(shape).AsType(chainerx::Dtype::kFloat64) - 0.5; };
+
+    const int64_t seq_length = 5;
+    const int64_t batch_size = 3;
+    const int64_t input_size = 4;
+    const int64_t hidden_size = 6;
+    for (int direction : {0, 1, 2}) {
+        for (bool has_sequence_lens : {false, true}) {
+            SCOPED_TRACE(direction);
+            SCOPED_TRACE(has_sequence_lens);
+            const int64_t num_directions = direction == 2 ? 2 : 1;
+            InOuts inputs;
+            inputs.emplace("x", std::make_shared<ChxVMVar>(random({seq_length, batch_size, input_size})));
+            inputs.emplace("w", std::make_shared<ChxVMVar>(random({num_directions, 4 * hidden_size, input_size})));
+            inputs.emplace("r", std::make_shared<ChxVMVar>(random({num_directions, 4 * hidden_size, hidden_size})));
+            inputs.emplace("b", std::make_shared<ChxVMVar>(random({num_directions, 8 * hidden_size})));
+            inputs.emplace("sequence_lens", std::make_shared<ChxVMVar>(chainerx::testing::BuildArray({3}).WithData<int32_t>({5, 2, 4})));
+            inputs.emplace("initial_h", std::make_shared<ChxVMVar>(random({num_directions, batch_size, hidden_size})));
+            inputs.emplace("initial_c", std::make_shared<ChxVMVar>(random({num_directions, batch_size, hidden_size})));
+            inputs.emplace("gy", std::make_shared<ChxVMVar>(random({seq_length, num_directions, batch_size, hidden_size})));
+            // Zero peepholes are equivalent to no peepholes, but they
+            // make LSTM run by the generic implementation.
+            inputs.emplace("p", std::make_shared<ChxVMVar>(chainerx::Zeros({num_directions, 3 * hidden_size}, chainerx::Dtype::kFloat64)));
+
+            XCProgramProto program;
+            int id = 0;
+            for (const char* name : {"x", "w", "r", "b", "sequence_lens", "initial_h", "initial_c", "gy", "p"}) {
+                chxvm::AddInOp(&program, chxvm::ChxVMValue(id++), name);
+            }
+            const int sequence_lens = has_sequence_lens ? 4 : -1;
+            for (const std::string& prefix : {"native_", "generic_"}) {
+                const int p = prefix == "native_" ? -1 : 8;
+                const int y = id;
+                chxvm::AddLSTMOp(
+                        &program,
+                        chxvm::ChxVMValue(y),
+                        chxvm::ChxVMValue(y + 1),
+                        chxvm::ChxVMValue(y + 2),
+                        chxvm::ChxVMValue(y + 3),
+                        0,
+                        1,
+                        2,
+                        3,
+                        sequence_lens,
+                        5,
+                        6,
+                        p,
+                        hidden_size,
+                        direction);
+                chxvm::AddLSTMGradOp(
+                        &program,
+                        chxvm::ChxVMValue(y + 4),
+                        chxvm::ChxVMValue(y + 5),
+                        chxvm::ChxVMValue(y + 6),
+                        chxvm::ChxVMValue(y + 7),
+                        7,
+                        y + 3);
+                int i = 0;
+                for (const char* name : {"y", "y_h", "y_c", "", "gx", "gw", "gr", "gb"}) {
+                    if (*name) chxvm::AddOutOp(&program, prefix + name, y + i);
+                    ++i;
+                }
+                id += i;
+            }
+
+            ChxVM chxvm(program);
+            InOuts outputs = chxvm.Run(inputs, ChxVMOptions());
+            for (const char* name : {"y", "y_h", "y_c", "gx", "gw", "gr", "gb"}) {
+                SCOPED_TRACE(name);
+                EXPECT_ARRAY_ALL_CLOSE(outputs[std::string("generic_") + name]->GetArray(), outputs[std::string("native_") + name]->GetArray());
+            }
+        }
+    }
+}
+
+TEST(ChxVMTest, GRU) {
+    chainerx::testing::ContextSession sess;
+
+    // In float64 to compare implementations with different orders of
+    // summations.
+    auto random = [](const chainerx::Shape& shape) { return SlowRandom(shape).AsType(chainerx::Dtype::kFloat64) - 0.5; };
+
+    const int64_t seq_length = 5;
+    const int64_t batch_size = 3;
+    const int64_t input_size = 4;
+    const int64_t hidden_size = 6;
+    for (int direction : {0, 1, 2}) {
+        for (int linear_before_reset : {0, 1}) {
+            SCOPED_TRACE(direction);
+            SCOPED_TRACE(linear_before_reset);
+            const int64_t num_directions = direction == 2 ? 2 : 1;
+            chainerx::Array x = random({seq_length, batch_size, input_size});
+            chainerx::Array w = random({num_directions, 3 * hidden_size, input_size});
+            chainerx::Array r = random({num_directions, 3 * hidden_size, hidden_size});
+            chainerx::Array b = random({num_directions, 6 * hidden_size});
+            chainerx::Array initial_h = random({num_directions, batch_size, hidden_size});
+
+            // A reference by the formula in the ONNX spec.
+            auto slice = [](const chainerx::Array& a, int64_t begin, int64_t end) {
+                return a.At({chainerx::Slice(), chainerx::Slice(begin, end)});
+            };
+            std::vector<chainerx::Array> ys, hs;
+            for (int64_t d = 0; d < num_directions; ++d) {
+                chainerx::Array wt = chainerx::Transpose(w.At({d}));
+                chainerx::Array rt = chainerx::Transpose(r.At({d}));
+                chainerx::Array wb = b.At({d, chainerx::Slice(0, 3 * hidden_size)});
+                chainerx::Array rb = b.At({d, chainerx::Slice(3 * hidden_size, 6 * hidden_size)});
+                chainerx::Array h = initial_h.At({d});
+                std::vector<chainerx::Array> outs(seq_length);
+                for (int64_t t = 0; t < seq_length; ++t) {
+                    const int64_t time = direction == 1 || d == 1 ? seq_length - t - 1 : t;
+                    chainerx::Array xw = chainerx::Dot(x.At({time}), wt) + wb;
+                    chainerx::Array hr = chainerx::Dot(h, rt) + rb;
+                    chainerx::Array z = Sigmoid(slice(xw, 0, hidden_size) + slice(hr, 0, hidden_size));
+                    chainerx::Array rg = Sigmoid(slice(xw, hidden_size, 2 * hidden_size) + slice(hr, hidden_size, 2 * hidden_size));
+                    chainerx::Array nh;
+                    if (linear_before_reset) {
+                        nh = rg * slice(hr, 2 * hidden_size, 3 * hidden_size);
+                    } else {
+                        nh = chainerx::Dot(rg * h, slice(rt, 2 * hidden_size, 3 * hidden_size)) +
+                             rb.At({chainerx::Slice(2 * hidden_size, 3 * hidden_size)});
+                    }
+                    nh = chainerx::Tanh(slice(xw, 2 * hidden_size, 3 * hidden_size) + nh);
+                    h = (1 - z) * nh + z * h;
+                    outs[time] = h;
+                }
+                ys.push_back(chainerx::Stack(outs, 0));
+                hs.push_back(h);
+            }
+
+            InOuts inputs;
+            inputs.emplace("x", std::make_shared<ChxVMVar>(x));
+            inputs.emplace("w", std::make_shared<ChxVMVar>(w));
+            inputs.emplace("r", std::make_shared<ChxVMVar>(r));
+            inputs.emplace("b", std::make_shared<ChxVMVar>(b));
+            inputs.emplace("initial_h", std::make_shared<ChxVMVar>(initial_h));
+
+            XCProgramProto program;
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(0), "x");
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(1), "w");
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(2), "r");
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(3), "b");
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(4), "initial_h");
+            chxvm::AddGRUOp(
+                    &program, chxvm::ChxVMValue(5), chxvm::ChxVMValue(6), 0, 1, 2, 3, -1, 4, hidden_size, linear_before_reset, direction);
+            chxvm::AddOutOp(&program, "y", 5);
+            chxvm::AddOutOp(&program, "y_h", 6);
+
+            ChxVM chxvm(program);
+            InOuts outputs = chxvm.Run(inputs, ChxVMOptions());
+            EXPECT_ARRAY_ALL_CLOSE(chainerx::Stack(ys, 1), outputs["y"]->GetArray());
+            EXPECT_ARRAY_ALL_CLOSE(chainerx::Stack(hs, 0), outputs["y_h"]->GetArray());
+        }
+    }
+}
+
+TEST(ChxVMTest, Dropout) {
+    chainerx::testing::ContextSession sess;
+
+    const int64_t size = 10000;
+    const float ratio = 0.3;
+    InOuts inputs;
+    chainerx::Array x = chainerx::Full({size}, 2.0, chainerx::Dtype::kFloat32);
+    inputs.emplace("x", std::make_shared<ChxVMVar>(x));
+
+    XCProgramProto program;
+    chxvm::AddInOp(&program, chxvm::ChxVMValue(0), "x");
+    chxvm::AddDropoutOp(&program, chxvm::ChxVMValue(1), chxvm::ChxVMValue(2), 0, ratio);
+    chxvm::AddOutOp(&program, "y", 1);
+    chxvm::AddOutOp(&program, "mask", 2);
+    ChxVM chxvm(program);
+
+    auto run = [&chxvm, &inputs](int64_t seed) {
+        ChxVMOptions options;
+        options.is_training = true;
+        options.seed = seed;
+        return chxvm.Run(inputs, options);
+    };
+    InOuts outputs = run(42);
+    chainerx::Array y = outputs["y"]->GetArray();
+    chainerx::Array mask = outputs["mask"]->GetArray();
+    EXPECT_ARRAY_ALL_CLOSE(x * mask, y);
+    const double kept = static_cast<double>(chainerx::AsScalar(chainerx::Sum(mask)));
+    EXPECT_NEAR(size * (1 - ratio), kept, size * 0.03);
+
+    // The same seed generates the same mask.
+    EXPECT_ARRAY_ALL_CLOSE(mask, run(42)["mask"]->GetArray());
+    EXPECT_FALSE(chainerx::AllClose(mask, run(43)["mask"]->GetArray()));
+
+    // Other dtypes take the fallback path, which makes the same mask.
+    inputs["x"] = std::make_shared<ChxVMVar>(x.AsType(chainerx::Dtype::kFloat16));
+    EXPECT_ARRAY_ALL_CLOSE(mask, run(42)["mask"]->GetArray().AsType(chainerx::Dtype::kFloat32));
+}
+
+TEST(ChxVMTest, Upsample) {
+    chainerx::testing::ContextSession sess;
+
+    const chainerx::Shape shape{2, 3, 4, 5};
+    for (const std::vector<int64_t>& hw_scales : std::vector<std::vector<int64_t>>{{2, 2}, {3, 2}, {1, 4}}) {
+        const int64_t sy = hw_scales[0];
+        const int64_t sx = hw_scales[1];
+        SCOPED_TRACE(sy);
+        SCOPED_TRACE(sx);
+        const chainerx::Shape split_shape{2, 3, 4, sy, 5, sx};
+        const chainerx::Shape y_shape{2, 3, 4 * sy, 5 * sx};
+        chainerx::Array x = SlowRandom(shape).AsType(chainerx::Dtype::kFloat64);
+        chainerx::Array gy = SlowRandom(y_shape).AsType(chainerx::Dtype::kFloat64);
+        chainerx::Array scales =
+                chainerx::testing::BuildArray({4}).WithData<float>({1, 1, static_cast<float>(sy), static_cast<float>(sx)});
+
+        InOuts inputs;
+        inputs.emplace("x", std::make_shared<ChxVMVar>(x));
+        inputs.emplace("gy", std::make_shared<ChxVMVar>(gy));
+        inputs.emplace("scales", std::make_shared<ChxVMVar>(scales));
+
+        XCProgramProto program;
+        chxvm::AddInOp(&program, chxvm::ChxVMValue(0), "x");
+        chxvm::AddInOp(&program, chxvm::ChxVMValue(1), "gy");
+        chxvm::AddInOp(&program, chxvm::ChxVMValue(2), "scales");
+        chxvm::AddUpsampleOp(&program, chxvm::ChxVMValue(3), 0, 2);
+        chxvm::AddUpsampleGradOp(&program, chxvm::ChxVMValue(4), 1, 2);
+        chxvm::AddOutOp(&program, "y", 3);
+        chxvm::AddOutOp(&program, "gx", 4);
+        ChxVM chxvm(program);
+
+        // Each element is repeated in a block of `sy` x `sx`.
+        auto upsample = [&split_shape, &y_shape](const chainerx::Array& a) {
+            return chainerx::Reshape(chainerx::BroadcastTo(chainerx::Reshape(a, {2, 3, 4, 1, 5, 1}), split_shape), y_shape);
+        };
+        chainerx::Array expected_y = upsample(x);
+        chainerx::Array expected_gx = chainerx::Sum(chainerx::Reshape(gy, split_shape), chainerx::Axes{3, 5});
+        InOuts outputs = chxvm.Run(inputs, ChxVMOptions());
+        EXPECT_ARRAY_ALL_CLOSE(expected_y, outputs["y"]->GetArray());
+        EXPECT_ARRAY_ALL_CLOSE(expected_gx, outputs["gx"]->GetArray());
+
+        // Other dtypes are copied as they are.
+        chainerx::Array xi = (x * 100).AsType(chainerx::Dtype::kInt32);
+        inputs["x"] = std::make_shared<ChxVMVar>(xi);
+        outputs = chxvm.Run(inputs, ChxVMOptions());
+        EXPECT_ARRAY_EQ(upsample(xi), outputs["y"]->GetArray());
+    }
+}
+
+TEST(ChxVMTest, ResizeImages) {
+    chainerx::testing::ContextSession sess;
+
+    // Matrices of the linear interpolation with aligned corners.
+    auto interpolation = [](int64_t src_size, int64_t dst_size) {
+        std::vector<double> m(dst_size * src_size);
+        for (int64_t i = 0; i < dst_size; ++i) {
+            const double v = dst_size > 1 ? static_cast<double>(i) * (src_size - 1) / (dst_size - 1) : 0;
+            const int64_t i0 = std::min<int64_t>(v, src_size - 1);
+            const int64_t i1 = std::min<int64_t>(i0 + 1, src_size - 1);
+            m[i * src_size + i0] += 1 - (v - i0);
+            m[i * src_size + i1] += v - i0;
+        }
+        return chainerx::testing::BuildArray({dst_size, src_size}).WithData<double>(m);
+    };
+
+    const int64_t sh = 4;
+    const int64_t sw = 5;
+    for (const std::vector<int64_t>& output_shape : std::vector<std::vector<int64_t>>{{7, 9}, {2, 3}, {4, 1}}) {
+        const int64_t dh = output_shape[0];
+        const int64_t dw = output_shape[1];
+        SCOPED_TRACE(dh);
+        SCOPED_TRACE(dw);
+        chainerx::Array x = SlowRandom({2, 3, sh, sw}).AsType(chainerx::Dtype::kFloat64);
+        chainerx::Array gy = SlowRandom({2, 3, dh, dw}).AsType(chainerx::Dtype::kFloat64);
+
+        chainerx::Array my = interpolation(sh, dh);
+        chainerx::Array mx = interpolation(sw, dw);
+        std::vector<chainerx::Array> ys, gxs;
+        for (int64_t n = 0; n < 2; ++n) {
+            for (int64_t c = 0; c < 3; ++c) {
+                ys.push_back(chainerx::Dot(chainerx::Dot(my, x.At({n, c})), chainerx::Transpose(mx)));
+                gxs.push_back(chainerx::Dot(chainerx::Dot(chainerx::Transpose(my), gy.At({n, c})), mx));
+            }
+        }
+        chainerx::Array expected_y = chainerx::Reshape(chainerx::Stack(ys, 0), gy.shape());
+        chainerx::Array expected_gx = chainerx::Reshape(chainerx::Stack(gxs, 0), x.shape());
+
+        InOuts inputs;
+        inputs.emplace("x", std::make_shared<ChxVMVar>(x));
+        inputs.emplace("gy", std::make_shared<ChxVMVar>(gy));
+
+        XCProgramProto program;
+        chxvm::AddInOp(&program, chxvm::ChxVMValue(0), "x");
+        chxvm::AddInOp(&program, chxvm::ChxVMValue(1), "gy");
+        chxvm::AddResizeImagesOp(&program, chxvm::ChxVMValue(2), 0, output_shape);
+        chxvm::AddShapeOp(&program, chxvm::ChxVMValue(3), 0);
+        chxvm::AddResizeImagesGradOp(&program, chxvm::ChxVMValue(4), 1, 3);
+        chxvm::AddOutOp(&program, "y", 2);
+        chxvm::AddOutOp(&program, "gx", 4);
+        ChxVM chxvm(program);
+
+        InOuts outputs = chxvm.Run(inputs, ChxVMOptions());
+        EXPECT_ARRAY_ALL_CLOSE(expected_y, outputs["y"]->GetArray());
+        EXPECT_ARRAY_ALL_CLOSE(expected_gx, outputs["gx"]->GetArray());
+
+        // Float16 is interpolated in float32.
+        inputs["x"] = std::make_shared<ChxVMVar>(x.AsType(chainerx::Dtype::kFloat16));
+        inputs["gy"] = std::make_shared<ChxVMVar>(gy.AsType(chainerx::Dtype::kFloat16));
+        outputs = chxvm.Run(inputs, ChxVMOptions());
+        EXPECT_TRUE(chainerx::AllClose(
+                expected_y, outputs["y"]->GetArray().AsType(chainerx::Dtype::kFloat64), 1e-2, 1e-2));
+        EXPECT_TRUE(chainerx::AllClose(
+                expected_gx, outputs["gx"]->GetArray().AsType(chainerx::Dtype::kFloat64), 1e-2, 1e-2));
+    }
+}
+
+TEST(ChxVMTest, ROIPoolAndAlign) {
+    chainerx::testing::ContextSession sess;
+
+    const int64_t batch_size = 2;
+    const int64_t channels = 19;
+    const int64_t height = 6;
+    const int64_t width = 7;
+    chainerx::Array x = SlowRandom({batch_size, channels, height, width}).AsType(chainerx::Dtype::kFloat64) - 0.5;
+
+    for (int kind = 0; kind < 4; ++kind) {
+        SCOPED_TRACE(kind);
+        auto run = [&x, kind](
+                           const chainerx::Array& rois,
+                           const chainerx::Array& roi_indices,
+                           const chainerx::Array& gy,
+                           const std::vector<int64_t>& output_shape,
+                           float spatial_scale,
+                           const std::vector<int64_t>& sampling_ratio,
+                           int num_threads) {
+            InOuts inputs;
+            inputs.emplace("x", std::make_shared<ChxVMVar>(x));
+            inputs.emplace("rois", std::make_shared<ChxVMVar>(rois));
+            inputs.emplace("roi_indices", std::make_shared<ChxVMVar>(roi_indices));
+            inputs.emplace("gy", std::make_shared<ChxVMVar>(gy));
+
+            XCProgramProto program;
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(0), "x");
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(1), "rois");
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(2), "roi_indices");
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(3), "gy");
+            const chxvm::ChxVMValue y(4), ctx(5), gx(6);
+            switch (kind) {
+                case 0:
+                    chxvm::AddROIMaxPool2DOp(&program, y, ctx, 0, 1, 2, output_shape, spatial_scale);
+                    chxvm::AddROIMaxPool2DGradOp(&program, gx, 3, 5, output_shape, spatial_scale);
+                    break;
+                case 1:
+                    chxvm::AddROIAveragePool2DOp(&program, y, ctx, 0, 1, 2, output_shape, spatial_scale);
+                    chxvm::AddROIAveragePool2DGradOp(&program, gx, 3, 5, output_shape, spatial_scale);
+                    break;
+                case 2:
+                    chxvm::AddROIMaxAlign2DOp(&program, y, ctx, 0, 1, 2, output_shape, spatial_scale, sampling_ratio);
+                    chxvm::AddROIMaxAlign2DGradOp(&program, gx, 3, 5, output_shape, spatial_scale, sampling_ratio);
+                    break;
+                case 3:
+                    chxvm::AddROIAverageAlign2DOp(&program, y, ctx, 0, 1, 2, output_shape, spatial_scale, sampling_ratio);
+                    chxvm::AddROIAverageAlign2DGradOp(&program, gx, 3, 5, output_shape, spatial_scale, sampling_ratio);
+                    break;
+            }
+            chxvm::AddOutOp(&program, "y", 4);
+            chxvm::AddOutOp(&program, "gx", 6);
+            ChxVM chxvm(program);
+            ChxVMOptions options;
+            options.num_intra_op_threads = num_threads;
+            InOuts outputs = chxvm.Run(inputs, options);
+            return std::make_pair(outputs["y"]->GetArray(), outputs["gx"]->GetArray());
+        };
+
+        {
+            // ROIs whose bins are the pixels of images, swapped. Both
+            // ROIPool and ROIAlign copy the input.
+            const float o = kind >= 2 ? -0.5 : 0;
+            chainerx::Array rois = chainerx::testing::BuildArray({2, 4}).WithData<float>(
+                    {o, o, height + o, width + o, o, o, height + o, width + o});
+            chainerx::Array roi_indices = chainerx::testing::BuildArray({2}).WithData<int32_t>({1, 0});
+            chainerx::Array gy = SlowRandom({2, channels, height, width}).AsType(chainerx::Dtype::kFloat64);
+            chainerx::Array y, gx;
+            std::tie(y, gx) = run(rois, roi_indices, gy, {height, width}, 1, {1, 1}, 1);
+            EXPECT_ARRAY_ALL_CLOSE(chainerx::Stack({x.At({1}), x.At({0})}, 0), y);
+            EXPECT_ARRAY_ALL_CLOSE(chainerx::Stack({gy.At({1}), gy.At({0})}, 0), gx);
+        }
+
+        // Some ROIs overlap and some go out of images.
+        chainerx::Array rois = chainerx::testing::BuildArray({5, 4}).WithData<float>(
+                {0, 0, 12, 14, 2, 3, 9, 8, -4, -3, 14, 16, 7.5, 2.5, 8, 3, 1.5, 2.5, 10.5, 11.5});
+        chainerx::Array roi_indices = chainerx::testing::BuildArray({5}).WithData<int32_t>({0, 1, 0, 1, 0});
+        chainerx::Array gy = SlowRandom({5, channels, 3, 4}).AsType(chainerx::Dtype::kFloat64);
+        chainerx::Array y, gx;
+        std::tie(y, gx) = run(rois, roi_indices, gy, {3, 4}, 0.5, {2, 3}, 1);
+        EXPECT_EQ(gy.shape(), y.shape());
+        EXPECT_EQ(x.shape(), gx.shape());
+        // Each output is a linear combination of inputs, whose
+        // coefficients are distributed by the gradient.
+        EXPECT_NEAR(
+                static_cast<double>(chainerx::AsScalar(chainerx::Sum(y * gy))),
+                static_cast<double>(chainerx::AsScalar(chainerx::Sum(x * gx))),
+                1e-9);
+
+        // Results do not depend on the number of threads.
+        chainerx::Array y4, gx4;
+        std::tie(y4, gx4) = run(rois, roi_indices, gy, {3, 4}, 0.5, {2, 3}, 4);
+        EXPECT_ARRAY_EQ(y, y4);
+        EXPECT_ARRAY_EQ(gx, gx4);
+    }
+}
+
+// Fuses `graph`, which must become a single fusion group of the
+// native JIT, and emits the group as the emitter does. `ids` has
+// ChxVM variables for the inputs and the outputs of `graph`.
+void AddNativeFusionOp(Graph* graph, const std::map<std::string, int>& ids, XCProgramProto* program) {
+    g_fuse_operations = true;
+    g_use_native_jit = true;
+    FuseOperations(graph);
+    g_use_native_jit = false;
+    g_fuse_operations = false;
+
+    std::vector<Node*> nodes = graph->GetLiveNodes();
+    ASSERT_EQ(1, nodes.size());
+    const Node& node = *nodes[0];
+    ASSERT_EQ(Node::kChainerFusionGroup, node.op_type());
+    ASSERT_EQ("native", node.fusion_type());
+    const Graph& body = *node.subgraph();
+    const bool has_reduction =
+            std::any_of(body.nodes().begin(), body.nodes().end(), [](const Node* n) { return IsNativeRowReduction(*n); });
+
+    std::string code;
+    std::vector<int64_t> row_outputs;
+    if (has_reduction) {
+        ASSERT_TRUE(BuildNativeRowReductionProgram(
+                body.nodes(), node.chainer_fusion_group(), body.input_values(), body.output_values(), &code, &row_outputs));
+    } else {
+        ASSERT_TRUE(BuildNativeProgram(body.nodes(), node.chainer_fusion_group(), body.input_values(), body.output_values(), &code));
+    }
+    ASSERT_TRUE(PrepareNativeFusion(node.chainer_fusion_group(), code));
+
+    std::vector<int> inputs;
+    std::vector<chxvm::ChxVMValue> outputs;
+    for (Value* value : node.inputs()) {
+        inputs.push_back(ids.at(value->name()));
+    }
+    for (Value* value : node.outputs()) {
+        outputs.emplace_back(ids.at(value->name()));
+    }
+    if (has_reduction) {
+        chxvm::AddRowReductionNativeOp(program, outputs, inputs, outputs.size(), row_outputs, code, node.chainer_fusion_group());
+    } else {
+        chxvm::AddElementWiseNativeOp(program, outputs, inputs, outputs.size(), code, node.chainer_fusion_group());
+    }
+}
+
+TEST(ChxVMTest, ElementWiseNative) {
+    chainerx::testing::ContextSession sess;
+
+    // Sigmoid(a) * Tanh(b) + c. In the first case, `b` is read with an
+    // inner stride of zero. In the second case, `b` is broadcast in a
+    // way which is materialized before the kernel runs.
+    const std::vector<std::vector<chainerx::Shape>> cases = {
+            {{4, 3, 5}, {4, 3, 1}, {5}},
+            {{4, 3, 5}, {3, 1}, {5}},
+    };
+    for (Dtype dtype : {Dtype::kFloat32, Dtype::kFloat64}) {
+        for (const std::vector<chainerx::Shape>& shapes : cases) {
+            SCOPED_TRACE(dtype.ToString());
+            SCOPED_TRACE(shapes[1].ToString());
+            const chainerx::Shape& shape = shapes[0];
+
+            Graph graph("test");
+            Value* a = graph.AddInputValue("a", Type(dtype, std::vector<int64_t>(shapes[0].begin(), shapes[0].end())));
+            Value* b = graph.AddInputValue("b", Type(dtype, std::vector<int64_t>(shapes[1].begin(), shapes[1].end())));
+            Value* c = graph.AddInputValue("c", Type(dtype, std::vector<int64_t>(shapes[2].begin(), shapes[2].end())));
+            Value* output = graph.AddOutputValue("output", Type(dtype, std::vector<int64_t>(shape.begin(), shape.end())));
+            {
+                GraphBuilder gb(&graph, "test", output);
+                Value* t0 = gb.Op(Node::kSigmoid, {a});
+                Value* t1 = gb.Op(Node::kTanh, {b});
+                Value* t2 = gb.Op(Node::kMul, {t0, t1});
+                gb.Op(Node::kAdd, {t2, c}, output);
+            }
+
+            XCProgramProto program;
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(0), "a");
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(1), "b");
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(2), "c");
+            AddNativeFusionOp(&graph, {{"a", 0}, {"b", 1}, {"c", 2}, {"output", 3}}, &program);
+            chxvm::AddSigmoidOp(&program, chxvm::ChxVMValue(4), 0);
+            chxvm::AddTanhOp(&program, chxvm::ChxVMValue(5), 1);
+            chxvm::AddMulOp(&program, chxvm::ChxVMValue(6), 4, 5);
+            chxvm::AddAddOp(&program, chxvm::ChxVMValue(7), 6, 2);
+            chxvm::AddOutOp(&program, "fused", 3);
+            chxvm::AddOutOp(&program, "unfused", 7);
+
+            // `a` is a view with a nonzero offset.
+            chainerx::Shape base_shape(shape);
+            ++base_shape[0];
+            chainerx::Array base = (SlowRandom(base_shape) * 4 - 2).AsType(dtype.chx());
+            chainerx::Array a_array = base.At({chainerx::Slice(1, base_shape[0])});
+            ASSERT_NE(0, a_array.offset());
+            InOuts inputs;
+            inputs.emplace("a", std::make_shared<ChxVMVar>(a_array));
+            inputs.emplace("b", std::make_shared<ChxVMVar>((SlowRandom(shapes[1]) * 4 - 2).AsType(dtype.chx())));
+            inputs.emplace("c", std::make_shared<ChxVMVar>(SlowRandom(shapes[2]).AsType(dtype.chx())));
+
+            ChxVM chxvm(program);
+            InOuts outputs = chxvm.Run(inputs, ChxVMOptions());
+            const chainerx::Array& fused = outputs["fused"]->GetArray();
+            EXPECT_EQ(dtype.chx(), fused.dtype());
+            EXPECT_ARRAY_ALL_CLOSE(outputs["unfused"]->GetArray(), fused);
+        }
+    }
+}
+
+TEST(ChxVMTest, RowReductionNative) {
+    chainerx::testing::ContextSession sess;
+    const int64_t batch = 6;
+    const int64_t width = 37;
+    const std::vector<int64_t> dims = {batch, width};
+    const std::vector<int64_t> row_dims = {batch, 1};
+
+    for (Dtype dtype : {Dtype::kFloat32, Dtype::kFloat64}) {
+        SCOPED_TRACE(dtype.ToString());
+        chainerx::Array x = (SlowRandom({batch, width}) * 10 - 5).AsType(dtype.chx());
+
+        {
+            SCOPED_TRACE("LayerNorm");
+            Graph graph("test");
+            Value* xv = graph.AddInputValue("x", Type(dtype, dims));
+            Value* gamma = graph.AddInputValue("gamma", Type(dtype, {width}));
+            Value* output = graph.AddOutputValue("output", Type(dtype, dims));
+            Value* mean_output = graph.AddOutputValue("mean_output", Type(dtype, row_dims));
+            {
+                GraphBuilder gb(&graph, "test", output);
+                Value* mean = gb.Op(Node::kReduceMean, {xv}, mean_output);
+                mean->producer()->set_axes({-1});
+                Value* d = gb.Op(Node::kSub, {xv, mean}, gb.Temp(Type(dtype, dims)));
+                Value* d2 = gb.Op(Node::kMul, {d, d}, gb.Temp(Type(dtype, dims)));
+                Value* var = gb.Op(Node::kReduceMean, {d2}, gb.Temp(Type(dtype, row_dims)));
+                var->producer()->set_axes({-1});
+                Value* eps = gb.Const(Type(dtype, {}), {1e-5});
+                Value* var_eps = gb.Op(Node::kAdd, {var, eps}, gb.Temp(Type(dtype, row_dims)));
+                Value* std = gb.Op(Node::kSqrt, {var_eps}, gb.Temp(Type(dtype, row_dims)));
+                Value* normalized = gb.Op(Node::kDiv, {d, std}, gb.Temp(Type(dtype, dims)));
+                gb.Op(Node::kMul, {normalized, gamma}, output);
+            }
+
+            XCProgramProto program;
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(0), "x");
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(1), "gamma");
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(2), "eps");
+            AddNativeFusionOp(&graph, {{"x", 0}, {"gamma", 1}, {"output", 3}, {"mean_output", 4}}, &program);
+            chxvm::AddReduceMeanOp(&program, chxvm::ChxVMValue(5), 0, {1}, 1);
+            chxvm::AddSubOp(&program, chxvm::ChxVMValue(6), 0, 5);
+            chxvm::AddMulOp(&program, chxvm::ChxVMValue(7), 6, 6);
+            chxvm::AddReduceMeanOp(&program, chxvm::ChxVMValue(8), 7, {1}, 1);
+            chxvm::AddAddOp(&program, chxvm::ChxVMValue(9), 8, 2);
+            chxvm::AddSqrtOp(&program, chxvm::ChxVMValue(10), 9);
+            chxvm::AddDivOp(&program, chxvm::ChxVMValue(11), 6, 10);
+            chxvm::AddMulOp(&program, chxvm::ChxVMValue(12), 11, 1);
+            chxvm::AddOutOp(&program, "fused", 3);
+            chxvm::AddOutOp(&program, "fused_mean", 4);
+            chxvm::AddOutOp(&program, "unfused", 12);
+            chxvm::AddOutOp(&program, "unfused_mean", 5);
+
+            InOuts inputs;
+            inputs.emplace("x", std::make_shared<ChxVMVar>(x));
+            inputs.emplace("gamma", std::make_shared<ChxVMVar>(SlowRandom({width}).AsType(dtype.chx())));
+            inputs.emplace("eps", std::make_shared<ChxVMVar>(chainerx::Full({}, 1e-5, dtype.chx())));
+            ChxVM chxvm(program);
+            InOuts outputs = chxvm.Run(inputs, ChxVMOptions());
+            EXPECT_ARRAY_ALL_CLOSE(outputs["unfused"]->GetArray(), outputs["fused"]->GetArray());
+            EXPECT_ARRAY_ALL_CLOSE(outputs["unfused_mean"]->GetArray(), outputs["fused_mean"]->GetArray());
+        }
+
+        {
+            SCOPED_TRACE("Softmax");
+            Graph graph("test");
+            Value* xv = graph.AddInputValue("x", Type(dtype, dims));
+            Value* output = graph.AddOutputValue("output", Type(dtype, dims));
+            {
+                GraphBuilder gb(&graph, "test", output);
+                gb.Op(Node::kSoftmax, {xv}, output)->producer()->set_axis(1);
+            }
+
+            XCProgramProto program;
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(0), "x");
+            AddNativeFusionOp(&graph, {{"x", 0}, {"output", 1}}, &program);
+            chxvm::AddSoftmaxOp(&program, chxvm::ChxVMValue(2), 0, 1, 1);
+            chxvm::AddOutOp(&program, "fused", 1);
+            chxvm::AddOutOp(&program, "unfused", 2);
+
+            InOuts inputs;
+            inputs.emplace("x", std::make_shared<ChxVMVar>(x));
+            ChxVM chxvm(program);
+            InOuts outputs = chxvm.Run(inputs, ChxVMOptions());
+            EXPECT_ARRAY_ALL_CLOSE(outputs["unfused"]->GetArray(), outputs["fused"]->GetArray());
+        }
+
+        {
+            SCOPED_TRACE("ReduceMax");
+            Graph graph("test");
+            Value* xv = graph.AddInputValue("x", Type(dtype, dims));
+            Value* output = graph.AddOutputValue("output", Type(dtype, dims));
+            Value* max_output = graph.AddOutputValue("max_output", Type(dtype, row_dims));
+            {
+                GraphBuilder gb(&graph, "test", output);
+                Value* max = gb.Op(Node::kReduceMax, {xv}, max_output);
+                max->producer()->set_axes({-1});
+                gb.Op(Node::kSub, {xv, max}, output);
+            }
+
+            XCProgramProto program;
+            chxvm::AddInOp(&program, chxvm::ChxVMValue(0), "x");
+            AddNativeFusionOp(&graph, {{"x", 0}, {"output", 1}, {"max_output", 2}}, &program);
+            chxvm::AddReduceMaxOp(&program, chxvm::ChxVMValue(3), 0, {1}, 1);
+            chxvm::AddSubOp(&program, chxvm::ChxVMValue(4), 0, 3);
+            chxvm::AddOutOp(&program, "fused", 1);
+            chxvm::AddOutOp(&program, "fused_max", 2);
+            chxvm::AddOutOp(&program, "unfused", 4);
+            chxvm::AddOutOp(&program, "unfused_max", 3);
+
+            // NaN propagates to the maximum of its row.
+            std::vector<float> nans(batch * width);
+            nans[2 * width] = NAN;
+            nans[4 * width + width - 1] = NAN;
+            chainerx::Array x_nan = x + MakeArray(chainerx::Dtype::kFloat32, {batch, width}, nans.data()).AsType(dtype.chx());
+            InOuts inputs;
+            inputs.emplace("x", std::make_shared<ChxVMVar>(x_nan));
+            ChxVM chxvm(program);
+            InOuts outputs = chxvm.Run(inputs, ChxVMOptions());
+            const chainerx::Array& fused_max = outputs["fused_max"]->GetArray();
+            for (int64_t i = 0; i < batch; ++i) {
+                EXPECT_EQ(i == 2 || i == 4, std::isnan(static_cast<double>(chainerx::AsScalar(fused_max.At({i, 0}))))) << i;
+            }
+            EXPECT_TRUE(chainerx::AllClose(outputs["unfused_max"]->GetArray(), fused_max, 1e-5, 1e-8, true));
+            EXPECT_TRUE(chainerx::AllClose(outputs["unfused"]->GetArray(), outputs["fused"]->GetArray(), 1e-5, 1e-8, true));
+        }
+    }
+}
+
 }  // namespace
 }  // namespace runtime
 }  // namespace chainer_compiler
@@ -0,0 +1,361 @@
+#include "runtime/dataflow_executor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <mutex>
+
+#include <chainerx/backprop_mode.h>
+#include <chainerx/context.h>
+#include <chainerx/device.h>
+
+#include <common/log.h>
+#include <runtime/chainerx_util.h>
+#include <runtime/chxvm.h>
+#include <runtime/chxvm_op.h>
+#include <runtime/chxvm_state.h>
+#include <runtime/parallel_for.h>
+#include <runtime/thread_pool.h>
+
+namespace chainer_compiler {
+namespace runtime {
+namespace {
+
+// Ops which must not run concurrently with others: they change the
+// control flow, depend on `ChxVMState::pc`, touch the state shared by
+// the whole program, or call into code which may not be thread-safe.
+bool IsBarrier(XCInstructionProto::Op op) {
+    switch (op) {
+        case XCInstructionProto::Jmp:
+        case XCInstructionProto::JmpTrue:
+        case XCInstructionProto::JmpFalse:
+        case XCInstructionProto::In:
+        case XCInstructionProto::Out:
+        case XCInstructionProto::Print:
+        case XCInstructionProto::DoSomething:
+        case XCInstructionProto::ElementWiseNvrtc:
+        case XCInstructionProto::TVM:
+        case XCInstructionProto::NGraph:
+        case XCInstructionProto::Dldt:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Collects variables read and written by `inst`. `Free`, ops on
+// sequences, and consumed inputs update their inputs, so they are
+// treated as writers.
+void CollectAccesses(const XCInstructionProto& inst, std::vector<int>* reads, std::vector<int>* writes) {
+    auto add = [](std::vector<int>* ids, int id) {
+        if (id >= 0) ids->push_back(id);
+    };
+    std::vector<bool> modifies_inputs(inst.inputs_size(), inst.op() == XCInstructionProto::Free);
+    for (int index : inst.consumed_inputs()) modifies_inputs[index] = true;
+    for (int i = 0; i < inst.inputs_size(); ++i) {
+        const XCValueProto& value = inst.inputs(i);
+        std::vector<int>* ids = modifies_inputs[i] ? writes : reads;
+        switch (value.type()) {
+            case XCValueProto::ARRAY:
+                add(ids, value.array());
+                break;
+            case XCValueProto::ARRAY_LIST:
+                for (int id : value.array_list()) add(ids, id);
+                break;
+            case XCValueProto::SEQUENCE:
+                add(writes, value.sequence());
+                break;
+            case XCValueProto::OPAQUE:
+                add(ids, value.opaque());
+                break;
+            case XCValueProto::SHAPE:
+                add(ids, value.shape());
+                break;
+            case XCValueProto::SCALAR:
+                add(ids, value.scalar());
+                break;
+            default:
+                break;
+        }
+    }
+    for (int id : inst.outputs()) add(writes, id);
+}
+
+void RunOp(ChxVMOp* op, ChxVMState* state) {
+    if (state->options().catch_exception) {
+        try {
+            op->Run(state);
+        } catch (...) {
+            std::cerr << "Exception in " << op->debug_info() << std::endl;
+            throw;
+        }
+    } else {
+        op->Run(state);
+    }
+}
+
+struct WorkQueue {
+    std::mutex mu;
+    std::deque<int> tasks;
+};
+
+}  // namespace
+
+struct DataflowExecutor::Segment {
+    int begin;
+    int end;
+    // False if the instructions form a chain.
+    bool parallel{false};
+    // The number of predecessors of each instruction.
+    std::vector<int> num_deps;
+    std::vector<std::vector<int>> succs;
+    std::vector<int> roots;
+};
+
+DataflowExecutor::DataflowExecutor(const std::vector<std::unique_ptr<ChxVMOp>>& program) : program_(program) {
+    const int num_insts = program.size();
+    std::vector<bool> is_boundary(num_insts + 1);
+    for (int pc = 0; pc < num_insts; ++pc) {
+        const XCInstructionProto& inst = program[pc]->instruction();
+        if (IsBarrier(inst.op())) {
+            is_boundary[pc] = true;
+            is_boundary[pc + 1] = true;
+        }
+        int target = -1;
+        if (inst.op() == XCInstructionProto::Jmp) {
+            target = inst.inputs(0).i();
+        } else if (inst.op() == XCInstructionProto::JmpTrue || inst.op() == XCInstructionProto::JmpFalse) {
+            target = inst.inputs(1).i();
+        }
+        if (target >= 0) {
+            CHECK_LE(target, num_insts) << inst.DebugString();
+            is_boundary[target] = true;
+        }
+    }
+
+    segment_at_pc_.resize(num_insts);
+    for (int begin = 0; begin < num_insts;) {
+        if (IsBarrier(program[begin]->op())) {
+            ++begin;
+            continue;
+        }
+        int end = begin + 1;
+        while (end < num_insts && !is_boundary[end]) ++end;
+
+        std::unique_ptr<Segment> segment(new Segment());
+        segment->begin = begin;
+        segment->end = end;
+        const int size = end - begin;
+        segment->num_deps.resize(size);
+        segment->succs.resize(size);
+
+        // Dependencies through variables: read-after-write,
+        // write-after-write, and write-after-read.
+        std::map<int, int> last_writer;
+        std::map<int, std::vector<int>> readers;
+        std::vector<int> depth(size);
+        int max_depth = 0;
+        for (int i = 0; i < size; ++i) {
+            std::vector<int> reads, writes;
+            CollectAccesses(program[begin + i]->instruction(), &reads, &writes);
+            std::vector<int> deps;
+            for (int id : reads) {
+                auto found = last_writer.find(id);
+                if (found != last_writer.end()) deps.push_back(found->second);
+            }
+            for (int id : writes) {
+                auto found = last_writer.find(id);
+                if (found != last_writer.end()) deps.push_back(found->second);
+                std::vector<int>& rs = readers[id];
+                deps.insert(deps.end(), rs.begin(), rs.end());
+            }
+            for (int id : reads) readers[id].push_back(i);
+            for (int id : writes) {
+                last_writer[id] = i;
+                readers[id].clear();
+            }
+
+            std::sort(deps.begin(), deps.end());
+            deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+            deps.erase(std::remove(deps.begin(), deps.end(), i), deps.end());
+            segment->num_deps[i] = deps.size();
+            if (deps.empty()) segment->roots.push_back(i);
+            for (int dep : deps) {
+                segment->succs[dep].push_back(i);
+                depth[i] = std::max(depth[i], depth[dep] + 1);
+            }
+            max_depth = std::max(max_depth, depth[i]);
+        }
+        segment->parallel = max_depth + 1 < size;
+
+        segment_at_pc_[begin] = segment.get();
+        segments_.push_back(std::move(segment));
+        begin = end;
+    }
+}
+
+DataflowExecutor::~DataflowExecutor() {
+}
+
+bool DataflowExecutor::IsApplicable(const ChxVMOptions& options) {
+    if (options.num_inter_op_threads <= 1) return false;
+    if (options.trace_level || options.check_types || options.dump_memory_usage || options.chrome_tracing) return false;
+    if (!options.dump_outputs_dir.empty()) return false;
+    // Kernels on other devices are already asynchronous.
+    return IsNativeDevice(&chainerx::GetDefaultDevice());
+}
+
+int DataflowExecutor::num_parallel_segments() const {
+    return std::count_if(segments_.begin(), segments_.end(), [](const std::unique_ptr<Segment>& s) { return s->parallel; });
+}
+
+void DataflowExecutor::Run(ChxVMState* state, ThreadPool* pool) const {
+    while (state->pc() < program_.size()) {
+        const int pc = state->pc();
+        const Segment* segment = segment_at_pc_[pc];
+        if (segment) {
+            RunSegment(*segment, state, pool);
+            state->set_pc(segment->end);
+        } else {
+            RunOp(program_[pc].get(), state);
+            state->set_pc(state->pc() + 1);
+        }
+    }
+}
+
+void DataflowExecutor::RunSegment(const Segment& segment, ChxVMState* state, ThreadPool* pool) const {
+    if (!segment.parallel || pool->num_threads() == 1) {
+        for (int pc = segment.begin; pc < segment.end; ++pc) {
+            state->set_pc(pc);
+            RunOp(program_[pc].get(), state);
+        }
+        return;
+    }
+
+    const int size = segment.end - segment.begin;
+    const int num_threads = pool->num_threads();
+    std::unique_ptr<std::atomic<int>[]> pending(new std::atomic<int>[size]);
+    for (int i = 0; i < size; ++i) {
+        pending[i] = segment.num_deps[i];
+    }
+    std::unique_ptr<WorkQueue[]> queues(new WorkQueue[num_threads]);
+    for (size_t i = 0; i < segment.roots.size(); ++i) {
+        queues[i % num_threads].tasks.push_back(segment.roots[i]);
+    }
+    std::atomic<int> num_remaining{size};
+    std::atomic<bool> failed{false};
+    // The number of tasks in `queues`. Idle threads sleep on `idle_cv`
+    // until a task is pushed, all tasks finish, or a task fails.
+    std::atomic<int> num_queued{static_cast<int>(segment.roots.size())};
+    std::mutex idle_mu;
+    std::condition_variable idle_cv;
+    std::mutex error_mu;
+    std::exception_ptr error;
+    const ChxVMOp* error_op = nullptr;
+
+    auto pop_task = [&queues, &num_queued, num_threads](int thread_index, int* task) {
+        for (int k = 0; k < num_threads; ++k) {
+            WorkQueue& queue = queues[(thread_index + k) % num_threads];
+            std::lock_guard<std::mutex> lock(queue.mu);
+            if (queue.tasks.empty()) continue;
+            // Take the newest task from the own queue for locality and
+            // steal the oldest one from others.
+            if (k == 0) {
+                *task = queue.tasks.back();
+                queue.tasks.pop_back();
+            } else {
+                *task = queue.tasks.front();
+                queue.tasks.pop_front();
+            }
+            --num_queued;
+            return true;
+        }
+        return false;
+    };
+
+    chainerx::Context& context = chainerx::GetDefaultContext();
+    chainerx::Device& device = chainerx::GetDefaultDevice();
+    // Updates of the conditions must be visible to a thread which is
+    // about to wait, so `idle_mu` is taken before notifying.
+    auto wake = [&idle_mu, &idle_cv](bool all) {
+        {
+            std::lock_guard<std::mutex> lock(idle_mu);
+        }
+        if (all) {
+            idle_cv.notify_all();
+        } else {
+            idle_cv.notify_one();
+        }
+    };
+
+    auto work = [&](int thread_index) {
+        // Default context, device, backprop mode, and the number of
+        // intra-op threads are thread local. ChxVM is always run
+        // without backprop mode.
+        std::unique_ptr<chainerx::ContextScope> context_scope;
+        std::unique_ptr<chainerx::DeviceScope> device_scope;
+        std::unique_ptr<chainerx::NoBackpropModeScope> no_backprop;
+        std::unique_ptr<IntraOpThreadsScope> intra_op_threads;
+        if (thread_index) {
+            context_scope.reset(new chainerx::ContextScope(context));
+            device_scope.reset(new chainerx::DeviceScope(device));
+            no_backprop.reset(new chainerx::NoBackpropModeScope());
+            intra_op_threads.reset(new IntraOpThreadsScope(state->options().num_intra_op_threads));
+        }
+
+        while (num_remaining > 0 && !failed) {
+            int task;
+            if (!pop_task(thread_index, &task)) {
+                std::unique_lock<std::mutex> lock(idle_mu);
+                idle_cv.wait(lock, [&]() { return num_queued > 0 || num_remaining == 0 || failed; });
+                continue;
+            }
+
+            ChxVMOp* op = program_[segment.begin + task].get();
+            try {
+                op->Run(state);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mu);
+                if (!error) {
+                    error = std::current_exception();
+                    error_op = op;
+                }
+                failed = true;
+                wake(true);
+                break;
+            }
+
+            int num_pushed = 0;
+            for (int succ : segment.succs[task]) {
+                if (--pending[succ] == 0) {
+                    WorkQueue& queue = queues[thread_index];
+                    std::lock_guard<std::mutex> lock(queue.mu);
+                    queue.tasks.push_back(succ);
+                    ++num_queued;
+                    ++num_pushed;
+                }
+            }
+            if (--num_remaining == 0) {
+                wake(true);
+            } else if (num_pushed > 1) {
+                // This thread takes one of them.
+                wake(num_pushed > 2);
+            }
+        }
+    };
+    pool->RunOnAllThreads(work);
+
+    if (error) {
+        if (state->options().catch_exception) {
+            std::cerr << "Exception in " << error_op->debug_info() << std::endl;
+        }
+        std::rethrow_exception(error);
+    }
+}
+
+}  // namespace runtime
+}  // namespace chainer_compiler
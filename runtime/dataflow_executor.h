@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+namespace chainer_compiler {
+namespace runtime {
+
+class ChxVMOp;
+class ChxVMState;
+class ThreadPool;
+struct ChxVMOptions;
+
+// Runs a ChxVM program with inter-op parallelism. The program is split
+// into segments by barrier instructions (jumps, jump targets, and ops
+// with side effects). Instructions in a segment form a DAG by their
+// accesses to variables, and ready instructions are dispatched to the
+// threads of a pool, which steal work from each other.
+class DataflowExecutor {
+public:
+    explicit DataflowExecutor(const std::vector<std::unique_ptr<ChxVMOp>>& program);
+    ~DataflowExecutor();
+
+    // Returns true if `options` allows running instructions
+    // concurrently. Debugging features which observe each step of the
+    // interpreter require the sequential execution.
+    static bool IsApplicable(const ChxVMOptions& options);
+
+    // Runs the program from `state->pc()` to the end. Runs of
+    // different states may share the executor concurrently.
+    void Run(ChxVMState* state, ThreadPool* pool) const;
+
+    int num_parallel_segments() const;
+
+private:
+    struct Segment;
+
+    void RunSegment(const Segment& segment, ChxVMState* state, ThreadPool* pool) const;
+
+    const std::vector<std::unique_ptr<ChxVMOp>>& program_;
+    std::vector<std::unique_ptr<Segment>> segments_;
+    // The segment which starts at each pc, or null for barriers.
+    std::vector<const Segment*> segment_at_pc_;
+};
+
+}  // namespace runtime
+}  // namespace chainer_compiler
@@ -107,6 +107,7 @@ def gen_gen_chxvm_ops_h():
             rettype = 'void'
         lines.append('%s RunImpl(%s);' % (rettype, ', '.join(args)))
         lines.append('virtual void Run(ChxVMState* st) override;')
+        lines.append('virtual void RunRelease(ChxVMState* st) override;')
 
         lines.append('private:')
         for inp in op.inputs:
@@ -191,6 +192,7 @@ def gen_gen_chxvm_ops_cc():
 
         # Emit Run.
         lines.append('void %sOp::Run(ChxVMState* st) {' % op.name)
+        release_lines = []
 
         lines.append('if (st->trace_level() && !debug_info().empty()) '
                      'std::cerr << "# " << debug_info() << std::endl;')
@@ -254,9 +256,9 @@ def gen_gen_chxvm_ops_cc():
                 lines.append('return;')
                 lines.append('}')
 
-            for typ, name in op.inputs:
+            for i, (typ, name) in enumerate(op.inputs):
                 if typ == ARRAY:
-                    args.append('st->GetArray(%s)' % name)
+                    args.append('(consumes_input(%d) ? st->TakeArray(%s) : st->GetArray(%s))' % (i, name, name))
                 elif typ == OPTIONAL_ARRAY:
                     args.append('st->GetOptionalArray(%s)' % name)
                 elif typ == ARRAY_LIST:
@@ -284,29 +286,38 @@ def gen_gen_chxvm_ops_cc():
             if len(outputs) == 1:
                 typ, name = outputs[0]
                 if typ == ARRAY_LIST:
-                    lines.append('st->SetArrayList(%s, %s);' % (name, call))
+                    set_line = 'st->SetArrayList(%s, %s);' % (name, call)
                 elif typ == OPAQUE:
-                    lines.append('st->SetOpaque(%s, %s);' % (name, call))
+                    set_line = 'st->SetOpaque(%s, %s);' % (name, call)
                 elif typ == SHAPE:
-                    lines.append('st->SetShape(%s, %s);' % (name, call))
+                    set_line = 'st->SetShape(%s, %s);' % (name, call)
                 elif typ == SCALAR:
-                    lines.append('st->SetScalar(%s, %s);' % (name, call))
+                    set_line = 'st->SetScalar(%s, %s);' % (name, call)
                 else:
-                    lines.append('st->SetArray(%s, %s);' % (name, call))
+                    set_line = 'st->SetArray(%s, %s);' % (name, call)
+                lines.append(set_line)
+                release_lines.append(set_line)
             elif outputs:
                 lines.append('auto r_ = ' + call + ';')
+                release_lines.append('auto r_ = ' + call + ';')
                 for i, (typ, output) in enumerate(outputs):
                     # TODO(hamaji): Revisit optional outputs.
                     if typ == OPAQUE:
-                        lines.append('if (%s >= 0) st->SetOpaque(%s, std::get<%d>(r_));' % (output, output, i))
-                        lines.append('else delete std::get<%d>(r_);' % i)
+                        set_lines = [
+                            'if (%s >= 0) st->SetOpaque(%s, std::get<%d>(r_));' % (output, output, i),
+                            'else delete std::get<%d>(r_);' % i]
                     else:
-                        lines.append('if (%s >= 0) st->SetArray(%s, std::get<%d>(r_));' % (output, output, i))
+                        set_lines = [
+                            'if (%s >= 0) st->SetArray(%s, std::get<%d>(r_));' % (output, output, i)]
+                    lines.extend(set_lines)
+                    release_lines.extend(set_lines)
                     lines.append(line)
             else:
                 lines.append(call + ';')
+                release_lines.append(call + ';')
         else:
             lines.append('RunImpl(st);')
+            release_lines.append('RunImpl(st);')
 
         line = 'if (st->trace_level()) std::cerr'
         for typ, name in op.outputs:
@@ -331,6 +342,12 @@ def gen_gen_chxvm_ops_cc():
 
         lines.append('}')
 
+        # Emit RunRelease, which omits traces, checks, and the
+        # handling of null inputs.
+        lines.append('void %sOp::RunRelease(ChxVMState* st) {' % op.name)
+        lines.extend(release_lines)
+        lines.append('}')
+
     lines.append('ChxVMOp* MakeChxVMOp(const XCInstructionProto& inst) {')
     lines.append('switch (inst.op()) {')
     for op in XC_ALL_OPS:
@@ -1,5 +1,7 @@
 #include <limits>
 
+#include <chainerx/kernels/arithmetic.h>
+#include <chainerx/kernels/hyperbolic.h>
 #include <chainerx/kernels/misc.h>
 #include <chainerx/routines/creation.h>
 #include <chainerx/routines/explog.h>
@@ -16,11 +18,23 @@ namespace chainer_compiler {
 namespace runtime {
 
 chainerx::Array ReluOp::RunImpl(ChxVMState* st, const chainerx::Array& x) {
-    return chainerx::Relu(x);
+    nonstd::optional<chainerx::Array> out;
+    if (IsFloat(x.dtype())) out = st->GetReusableOutput(*this, 0, 0, x);
+    if (!out.has_value()) {
+        return chainerx::Relu(x);
+    }
+    // Write the result into the buffer placed by the compiler or `x`.
+    x.device().backend().CallKernel<chainerx::IfLessElseASSAKernel>(x, chainerx::Scalar(0.0), chainerx::Scalar(0.0), x, *out);
+    return *out;
 }
 
 chainerx::Array ReluGradOp::RunImpl(ChxVMState* st, const chainerx::Array& x, const chainerx::Array& gy) {
-    chainerx::Array out = chainerx::EmptyLike(x, x.device());
+    nonstd::optional<chainerx::Array> reused;
+    if (x.shape() == gy.shape() && x.dtype() == gy.dtype()) {
+        reused = st->GetReusableOutput(*this, 0, 1, gy);
+        if (!reused.has_value()) reused = st->GetReusableOutput(*this, 0, 0, x);
+    }
+    chainerx::Array out = reused.has_value() ? *reused : st->AllocateOutput(*this, 0, x.shape(), x.dtype(), x.device());
     double eps;
     // TODO(hamaji): Use IsLessElseSAAS once it is added.
     if (x.dtype() == chainerx::Dtype::kFloat16) {
@@ -55,11 +69,32 @@ chainerx::Array EluOp::RunImpl(ChxVMState* st, const chainerx::Array& x) {
 }
 
 chainerx::Array TanhOp::RunImpl(ChxVMState* st, const chainerx::Array& a) {
-    return chainerx::Tanh(a);
+    nonstd::optional<chainerx::Array> out;
+    if (IsFloat(a.dtype())) out = st->GetReusableOutput(*this, 0, 0, a);
+    if (!out.has_value()) {
+        return chainerx::Tanh(a);
+    }
+    a.device().backend().CallKernel<chainerx::TanhKernel>(a, *out);
+    return *out;
 }
 
 chainerx::Array SigmoidOp::RunImpl(ChxVMState* st, const chainerx::Array& a) {
-    return Sigmoid(a);
+    if (!IsFloat(a.dtype())) {
+        return Sigmoid(a);
+    }
+    nonstd::optional<chainerx::Array> out = st->GetReusableOutput(*this, 0, 0, a);
+    if (!out.has_value()) {
+        out = chainerx::EmptyLike(a, a.device());
+    }
+    // sigmoid(a) = tanh(a / 2) / 2 + 1 / 2, computed in `out`. A new
+    // output uses the same kernels so results do not depend on whether
+    // `a` could be reused.
+    chainerx::Backend& backend = a.device().backend();
+    backend.CallKernel<chainerx::MultiplyASKernel>(a, chainerx::Scalar(0.5), *out);
+    backend.CallKernel<chainerx::TanhKernel>(*out, *out);
+    backend.CallKernel<chainerx::MultiplyASKernel>(*out, chainerx::Scalar(0.5), *out);
+    backend.CallKernel<chainerx::AddASKernel>(*out, chainerx::Scalar(0.5), *out);
+    return *out;
 }
 
 namespace {
@@ -1,11 +1,20 @@
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
 #include <chainerx/kernels/connection.h>
 #include <chainerx/routines/connection.h>
+#include <chainerx/routines/creation.h>
 #include <chainerx/routines/linalg.h>
 #include <chainerx/routines/manipulation.h>
+#include <chainerx/routines/math.h>
+#include <chainerx/routines/misc.h>
 
 #include <common/log.h>
 #include <runtime/chainerx_util.h>
 #include <runtime/gen_chxvm_ops.h>
+#include <runtime/parallel_for.h>
 
 namespace chainer_compiler {
 namespace runtime {
@@ -22,8 +31,292 @@ chainerx::Array LinearGradWeightOp::RunImpl(ChxVMState* st, const chainerx::Arra
     return chainerx::Dot(chainerx::Transpose(gym), xm);
 }
 
-chainerx::Array ConvOp::RunImpl(
-        ChxVMState* st, const chainerx::Array& x, const chainerx::Array& w, const nonstd::optional<chainerx::Array>& b) {
+namespace {
+
+// A 2D convolution with groups on contiguous NCHW arrays. X is (N, C,
+// H, W), W is (M, C / group, KH, KW), and Y is (N, M, OH, OW).
+struct GroupedConv2D {
+    int64_t n, c, h, w;
+    int64_t m, oh, ow;
+    int64_t kh, kw;
+    int64_t sy, sx;
+    int64_t py, px;
+    int64_t group;
+
+    int64_t in_channels() const {
+        return c / group;
+    }
+    int64_t out_channels() const {
+        return m / group;
+    }
+};
+
+// Returns [begin, end) of output positions `o` whose input position
+// `o * stride + k - pad` is in [0, size).
+void GetValidRange(int64_t out_size, int64_t size, int64_t k, int64_t stride, int64_t pad, int64_t* begin, int64_t* end) {
+    const int64_t lo = pad - k;
+    const int64_t hi = size - 1 + pad - k;
+    *end = hi < 0 ? 0 : std::min(out_size, hi / stride + 1);
+    *begin = std::min(*end, lo <= 0 ? int64_t{0} : (lo + stride - 1) / stride);
+}
+
+// Adds taps of a filter in `wp` to a plane of `yp` for the output
+// positions in rows [oy_lo, oy_hi) and columns [ox_lo, ox_hi), one
+// tap at a time. The innermost loop runs along a row of the output.
+template <typename T>
+void AccumulateTaps(
+        const GroupedConv2D& p, const T* xp, const T* wp, int64_t oy_lo, int64_t oy_hi, int64_t ox_lo, int64_t ox_hi, T* yp) {
+    for (int64_t ky = 0; ky < p.kh; ++ky) {
+        int64_t oy_begin, oy_end;
+        GetValidRange(p.oh, p.h, ky, p.sy, p.py, &oy_begin, &oy_end);
+        oy_begin = std::max(oy_begin, oy_lo);
+        oy_end = std::min(oy_end, oy_hi);
+        for (int64_t kx = 0; kx < p.kw; ++kx) {
+            int64_t ox_begin, ox_end;
+            GetValidRange(p.ow, p.w, kx, p.sx, p.px, &ox_begin, &ox_end);
+            ox_begin = std::max(ox_begin, ox_lo);
+            ox_end = std::min(ox_end, ox_hi);
+            const T wv = wp[ky * p.kw + kx];
+            for (int64_t oy = oy_begin; oy < oy_end; ++oy) {
+                const T* xr = xp + (oy * p.sy + ky - p.py) * p.w + kx - p.px;
+                T* yr = yp + oy * p.ow;
+                for (int64_t ox = ox_begin; ox < ox_end; ++ox) {
+                    yr[ox] += wv * xr[ox * p.sx];
+                }
+            }
+        }
+    }
+}
+
+// Adds all taps of a filter to an output position, skipping ones out
+// of the input.
+template <typename T>
+void AccumulateTapsAt(const GroupedConv2D& p, const T* xp, const T* wp, int64_t oy, int64_t ox, T* yp) {
+    T sum = 0;
+    for (int64_t ky = 0; ky < p.kh; ++ky) {
+        const int64_t iy = oy * p.sy + ky - p.py;
+        if (iy < 0 || iy >= p.h) continue;
+        for (int64_t kx = 0; kx < p.kw; ++kx) {
+            const int64_t ix = ox * p.sx + kx - p.px;
+            if (ix < 0 || ix >= p.w) continue;
+            sum += wp[ky * p.kw + kx] * xp[iy * p.w + ix];
+        }
+    }
+    yp[oy * p.ow + ox] += sum;
+}
+
+// Same as AccumulateTaps for a KxK filter with the horizontal stride
+// S, which is common in depthwise convs. All taps of an output are
+// summed before it is stored.
+template <typename T, int K, int S>
+void AccumulateTapsKxK(const GroupedConv2D& p, const T* xp, const T* wp, T* yp) {
+    int64_t oy_lo, oy_hi, ox_lo, ox_hi, unused;
+    GetValidRange(p.oh, p.h, 0, p.sy, p.py, &oy_lo, &unused);
+    GetValidRange(p.oh, p.h, K - 1, p.sy, p.py, &unused, &oy_hi);
+    GetValidRange(p.ow, p.w, 0, S, p.px, &ox_lo, &unused);
+    GetValidRange(p.ow, p.w, K - 1, S, p.px, &unused, &ox_hi);
+    if (oy_lo >= oy_hi || ox_lo >= ox_hi) {
+        AccumulateTaps(p, xp, wp, 0, p.oh, 0, p.ow, yp);
+        return;
+    }
+
+    T w[K * K];
+    std::copy(wp, wp + K * K, w);
+    for (int64_t oy = oy_lo; oy < oy_hi; ++oy) {
+        const T* xr[K];
+        for (int ky = 0; ky < K; ++ky) {
+            xr[ky] = xp + (oy * p.sy + ky - p.py) * p.w - p.px;
+        }
+        T* yr = yp + oy * p.ow;
+        for (int64_t ox = ox_lo; ox < ox_hi; ++ox) {
+            T sum = 0;
+            for (int ky = 0; ky < K; ++ky) {
+                for (int kx = 0; kx < K; ++kx) {
+                    sum += w[ky * K + kx] * xr[ky][ox * S + kx];
+                }
+            }
+            yr[ox] += sum;
+        }
+    }
+    AccumulateTaps(p, xp, wp, 0, oy_lo, 0, p.ow, yp);
+    AccumulateTaps(p, xp, wp, oy_hi, p.oh, 0, p.ow, yp);
+    // Columns on the border are narrow.
+    for (int64_t oy = oy_lo; oy < oy_hi; ++oy) {
+        for (int64_t ox = 0; ox < ox_lo; ++ox) AccumulateTapsAt(p, xp, wp, oy, ox, yp);
+        for (int64_t ox = ox_hi; ox < p.ow; ++ox) AccumulateTapsAt(p, xp, wp, oy, ox, yp);
+    }
+}
+
+// Computes each output plane from the input planes of its group.
+template <typename T>
+void GroupedConvForward(const GroupedConv2D& p, const T* x, const T* w, const T* b, T* y) {
+    const int64_t cin = p.in_channels();
+    const int64_t cout = p.out_channels();
+    auto accumulate = [&p](const T* xp, const T* wp, T* yp) {
+        if (p.kh == 3 && p.kw == 3 && p.sx == 1) {
+            AccumulateTapsKxK<T, 3, 1>(p, xp, wp, yp);
+        } else if (p.kh == 3 && p.kw == 3 && p.sx == 2) {
+            AccumulateTapsKxK<T, 3, 2>(p, xp, wp, yp);
+        } else if (p.kh == 5 && p.kw == 5 && p.sx == 1) {
+            AccumulateTapsKxK<T, 5, 1>(p, xp, wp, yp);
+        } else if (p.kh == 5 && p.kw == 5 && p.sx == 2) {
+            AccumulateTapsKxK<T, 5, 2>(p, xp, wp, yp);
+        } else {
+            AccumulateTaps(p, xp, wp, 0, p.oh, 0, p.ow, yp);
+        }
+    };
+    ParallelFor(0, p.n * p.m, 1, [&p, x, w, b, y, cin, cout, &accumulate](int64_t begin, int64_t end) {
+        for (int64_t plane = begin; plane < end; ++plane) {
+            const int64_t ni = plane / p.m;
+            const int64_t oc = plane % p.m;
+            const int64_t g = oc / cout;
+            T* yp = y + plane * p.oh * p.ow;
+            std::fill(yp, yp + p.oh * p.ow, b ? b[oc] : T(0));
+            for (int64_t ic = 0; ic < cin; ++ic) {
+                accumulate(x + (ni * p.c + g * cin + ic) * p.h * p.w, w + (oc * cin + ic) * p.kh * p.kw, yp);
+            }
+        }
+    });
+}
+
+// Computes the gradient of X. Each task owns the input planes of a
+// group in an example, so no two tasks write the same element.
+template <typename T>
+void GroupedConvGradInput(const GroupedConv2D& p, const T* gy, const T* w, T* gx) {
+    const int64_t cin = p.in_channels();
+    const int64_t cout = p.out_channels();
+    ParallelFor(0, p.n * p.group, 1, [&p, gy, w, gx, cin, cout](int64_t begin, int64_t end) {
+        for (int64_t task = begin; task < end; ++task) {
+            const int64_t ni = task / p.group;
+            const int64_t g = task % p.group;
+            T* gxg = gx + (ni * p.c + g * cin) * p.h * p.w;
+            std::fill(gxg, gxg + cin * p.h * p.w, T(0));
+            for (int64_t oc = g * cout; oc < (g + 1) * cout; ++oc) {
+                const T* gyp = gy + (ni * p.m + oc) * p.oh * p.ow;
+                for (int64_t ic = 0; ic < cin; ++ic) {
+                    T* gxp = gxg + ic * p.h * p.w;
+                    const T* wp = w + (oc * cin + ic) * p.kh * p.kw;
+                    for (int64_t ky = 0; ky < p.kh; ++ky) {
+                        int64_t oy_begin, oy_end;
+                        GetValidRange(p.oh, p.h, ky, p.sy, p.py, &oy_begin, &oy_end);
+                        for (int64_t kx = 0; kx < p.kw; ++kx) {
+                            int64_t ox_begin, ox_end;
+                            GetValidRange(p.ow, p.w, kx, p.sx, p.px, &ox_begin, &ox_end);
+                            const T wv = wp[ky * p.kw + kx];
+                            for (int64_t oy = oy_begin; oy < oy_end; ++oy) {
+                                T* gxr = gxp + (oy * p.sy + ky - p.py) * p.w + kx - p.px;
+                                const T* gyr = gyp + oy * p.ow;
+                                for (int64_t ox = ox_begin; ox < ox_end; ++ox) {
+                                    gxr[ox * p.sx] += wv * gyr[ox];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+// Computes the gradient of W. Each task owns the filters of an output
+// channel and reduces over examples and output positions.
+template <typename T>
+void GroupedConvGradWeight(const GroupedConv2D& p, const T* x, const T* gy, T* gw) {
+    const int64_t cin = p.in_channels();
+    const int64_t cout = p.out_channels();
+    ParallelFor(0, p.m, 1, [&p, x, gy, gw, cin, cout](int64_t begin, int64_t end) {
+        for (int64_t oc = begin; oc < end; ++oc) {
+            const int64_t g = oc / cout;
+            T* gwp = gw + oc * cin * p.kh * p.kw;
+            std::fill(gwp, gwp + cin * p.kh * p.kw, T(0));
+            for (int64_t ni = 0; ni < p.n; ++ni) {
+                const T* gyp = gy + (ni * p.m + oc) * p.oh * p.ow;
+                for (int64_t ic = 0; ic < cin; ++ic) {
+                    const T* xp = x + (ni * p.c + g * cin + ic) * p.h * p.w;
+                    for (int64_t ky = 0; ky < p.kh; ++ky) {
+                        int64_t oy_begin, oy_end;
+                        GetValidRange(p.oh, p.h, ky, p.sy, p.py, &oy_begin, &oy_end);
+                        for (int64_t kx = 0; kx < p.kw; ++kx) {
+                            int64_t ox_begin, ox_end;
+                            GetValidRange(p.ow, p.w, kx, p.sx, p.px, &ox_begin, &ox_end);
+                            T sum = 0;
+                            for (int64_t oy = oy_begin; oy < oy_end; ++oy) {
+                                const T* xr = xp + (oy * p.sy + ky - p.py) * p.w + kx - p.px;
+                                const T* gyr = gyp + oy * p.ow;
+                                for (int64_t ox = ox_begin; ox < ox_end; ++ox) {
+                                    sum += gyr[ox] * xr[ox * p.sx];
+                                }
+                            }
+                            gwp[(ic * p.kh + ky) * p.kw + kx] += sum;
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+// Returns true if the native grouped conv kernels can handle 4D `x`
+// and `w` with an optional bias. Convs without groups are left to
+// ChainerX, which uses GEMM.
+bool UseNativeGroupedConv(int group, const chainerx::Array& x, const chainerx::Array& w, const nonstd::optional<chainerx::Array>& b) {
+    if (group <= 1) return false;
+    const chainerx::Dtype dtype = x.dtype();
+    if (dtype != chainerx::Dtype::kFloat32 && dtype != chainerx::Dtype::kFloat64) return false;
+    if (!IsNativeDevice(&x.device()) || x.ndim() != 4) return false;
+    if (!IsNativeDevice(&w.device()) || w.dtype() != dtype || w.ndim() != 4) return false;
+    if (b.has_value() && (!IsNativeDevice(&b->device()) || b->dtype() != dtype)) return false;
+    return true;
+}
+
+GroupedConv2D MakeGroupedConv2D(
+        const chainerx::Shape& x,
+        const chainerx::Shape& w,
+        const chainerx::Shape& y,
+        const Int64StackVector& strides,
+        const Int64StackVector& pads,
+        int group) {
+    CHECK_EQ(2UL, strides.size());
+    CHECK_EQ(2UL, pads.size());
+    CHECK_EQ(0, x[1] % group) << x;
+    CHECK_EQ(0, w[0] % group) << w;
+    CHECK_EQ(x[1] / group, w[1]) << x << " " << w;
+    CHECK_EQ(w[0], y[1]) << w << " " << y;
+    return GroupedConv2D{x[0], x[1], x[2], x[3], y[1], y[2], y[3], w[2], w[3], strides[0], strides[1], pads[0], pads[1], group};
+}
+
+chainerx::Array NativeGroupedConv(
+        const chainerx::Array& x,
+        const chainerx::Array& w,
+        const nonstd::optional<chainerx::Array>& b,
+        const Int64StackVector& strides,
+        const Int64StackVector& pads,
+        int group) {
+    const int64_t oh = (x.shape()[2] + pads[0] * 2 - w.shape()[2]) / strides[0] + 1;
+    const int64_t ow = (x.shape()[3] + pads[1] * 2 - w.shape()[3]) / strides[1] + 1;
+    chainerx::Array y = chainerx::Empty({x.shape()[0], w.shape()[0], oh, ow}, x.dtype(), x.device());
+    const GroupedConv2D p = MakeGroupedConv2D(x.shape(), w.shape(), y.shape(), strides, pads, group);
+    chainerx::Array xc = chainerx::AsContiguous(x);
+    chainerx::Array wc = chainerx::AsContiguous(w);
+    nonstd::optional<chainerx::Array> bc;
+    if (b.has_value()) bc = chainerx::AsContiguous(*b);
+    if (x.dtype() == chainerx::Dtype::kFloat32) {
+        GroupedConvForward<float>(p, GetData<float>(xc), GetData<float>(wc), bc ? GetData<float>(*bc) : nullptr, GetMutableData<float>(y));
+    } else {
+        GroupedConvForward<double>(
+                p, GetData<double>(xc), GetData<double>(wc), bc ? GetData<double>(*bc) : nullptr, GetMutableData<double>(y));
+    }
+    return y;
+}
+
+chainerx::Array RunConv(
+        const chainerx::Array& x,
+        const chainerx::Array& w,
+        const nonstd::optional<chainerx::Array>& b,
+        const Int64StackVector& strides,
+        const Int64StackVector& pads,
+        int group,
+        const std::string& auto_pad) {
     Int64StackVector comp_strides = ComplementStride(strides, x);
     Int64StackVector comp_pads = ComplementPad(pads, x);
 
@@ -43,6 +336,10 @@ chainerx::Array ConvOp::RunImpl(
         CHECK_EQ("NOTSET", auto_pad);
     }
 
+    if (UseNativeGroupedConv(group, x, w, b)) {
+        return NativeGroupedConv(x, w, b, comp_strides, comp_pads, group);
+    }
+
     if (group > 1) {
         std::vector<chainerx::Array> inputs = SplitByLengths(x, 1, std::vector<int64_t>(group, x.shape()[1] / group));
         std::vector<chainerx::Array> weights = SplitByLengths(w, 0, std::vector<int64_t>(group, w.shape()[0] / group));
@@ -60,24 +357,284 @@ chainerx::Array ConvOp::RunImpl(
     return chainerx::Conv(x, w, b, comp_strides, comp_pads);
 }
 
+// Gets strides in elements of `a` viewed as (N, C, S), where S is the
+// product of spatial dimensions. Returns false if the spatial
+// dimensions cannot be collapsed into one.
+bool GetNCSStrides(const chainerx::Array& a, int64_t* ncs) {
+    const int64_t item_size = a.GetItemSize();
+    int64_t s_stride = 1;
+    int64_t s_size = 1;
+    for (int i = a.ndim() - 1; i >= 2; --i) {
+        const int64_t dim = a.shape()[i];
+        if (dim == 1) continue;
+        const int64_t stride = a.strides()[i] / item_size;
+        if (s_size == 1) {
+            s_stride = stride;
+        } else if (stride != s_stride * s_size) {
+            return false;
+        }
+        s_size *= dim;
+    }
+    ncs[0] = a.strides()[0] / item_size;
+    ncs[1] = a.strides()[1] / item_size;
+    ncs[2] = s_stride;
+    return true;
+}
+
+// Computes `clamp(v < 0 ? v * alpha : v, lo, hi)` after adding the
+// bias and the residual `z` to a row of `y`, which is contiguous.
+// The row is along channels if `kChannelsInner` and along spatial
+// positions otherwise.
+template <typename T, bool kChannelsInner, bool kHasResidual>
+void ConvEpilogueRow(T* y, const T* bias, const T* z, int64_t z_stride, int64_t size, T alpha, T lo, T hi) {
+    for (int64_t k = 0; k < size; ++k) {
+        T v = y[k] + bias[kChannelsInner ? k : 0];
+        if (kHasResidual) v += z[k * z_stride];
+        v = v < 0 ? v * alpha : v;
+        v = v < lo ? lo : v;
+        y[k] = v > hi ? hi : v;
+    }
+}
+
+// Applies the bias, the residual, and the activation to the output
+// of Conv in place, in a single pass while each row is in cache.
+template <typename T, bool kChannelsInner, bool kHasResidual>
+void ApplyConvEpilogueImpl(
+        const chainerx::Array& y,
+        const int64_t* y_ncs,
+        const std::vector<T>& bias,
+        const nonstd::optional<chainerx::Array>& z,
+        const int64_t* z_ncs,
+        T alpha,
+        T lo,
+        T hi) {
+    const int64_t n = y.shape()[0];
+    const int64_t c = y.shape()[1];
+    const int64_t s = n * c ? y.GetTotalSize() / (n * c) : 0;
+    const int64_t outer = kChannelsInner ? s : c;
+    const int64_t inner = kChannelsInner ? c : s;
+    const int64_t y_outer_stride = kChannelsInner ? y_ncs[2] : y_ncs[1];
+    const int64_t z_outer_stride = kChannelsInner ? z_ncs[2] : z_ncs[1];
+    const int64_t z_inner_stride = kChannelsInner ? z_ncs[1] : z_ncs[2];
+    T* yp = GetMutableData<T>(y);
+    const T* zp = kHasResidual ? GetData<T>(*z) : nullptr;
+    const T* bp = bias.data();
+
+    const int64_t grain_size = std::max<int64_t>(1, 16384 / std::max<int64_t>(1, inner));
+    ParallelFor(0, n * outer, grain_size, [=](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+            const int64_t i = row / outer;
+            const int64_t j = row % outer;
+            T* yr = yp + i * y_ncs[0] + j * y_outer_stride;
+            const T* zr = kHasResidual ? zp + i * z_ncs[0] + j * z_outer_stride : nullptr;
+            const T* br = kChannelsInner ? bp : bp + j;
+            ConvEpilogueRow<T, kChannelsInner, kHasResidual>(yr, br, zr, z_inner_stride, inner, alpha, lo, hi);
+        }
+    });
+}
+
+template <typename T>
+void ApplyConvEpilogue(
+        const chainerx::Array& y,
+        const int64_t* y_ncs,
+        const nonstd::optional<chainerx::Array>& b,
+        const nonstd::optional<chainerx::Array>& z,
+        const int64_t* z_ncs,
+        const std::string& activation,
+        double alpha,
+        double min,
+        double max) {
+    // Relu and LeakyRelu are Clip(-inf, inf) after the multiplication of
+    // negative values.
+    T act_alpha = 0;
+    T lo = -std::numeric_limits<T>::infinity();
+    T hi = std::numeric_limits<T>::infinity();
+    if (activation == "LeakyRelu") {
+        act_alpha = alpha;
+    } else if (activation == "Clip") {
+        act_alpha = 1;
+        lo = min;
+        hi = max;
+    } else {
+        CHECK_EQ("Relu", activation);
+    }
+
+    const int64_t c = y.shape()[1];
+    std::vector<T> bias(c);
+    if (b.has_value()) {
+        chainerx::Array bc = chainerx::AsContiguous(*b);
+        const T* bp = GetData<T>(bc);
+        std::copy(bp, bp + c, bias.begin());
+    }
+
+    const bool channels_inner = y_ncs[2] != 1;
+    if (channels_inner) {
+        if (z.has_value()) {
+            ApplyConvEpilogueImpl<T, true, true>(y, y_ncs, bias, z, z_ncs, act_alpha, lo, hi);
+        } else {
+            ApplyConvEpilogueImpl<T, true, false>(y, y_ncs, bias, z, z_ncs, act_alpha, lo, hi);
+        }
+    } else {
+        if (z.has_value()) {
+            ApplyConvEpilogueImpl<T, false, true>(y, y_ncs, bias, z, z_ncs, act_alpha, lo, hi);
+        } else {
+            ApplyConvEpilogueImpl<T, false, false>(y, y_ncs, bias, z, z_ncs, act_alpha, lo, hi);
+        }
+    }
+}
+
+}  // namespace
+
+chainerx::Array ConvOp::RunImpl(
+        ChxVMState* st, const chainerx::Array& x, const chainerx::Array& w, const nonstd::optional<chainerx::Array>& b) {
+    return RunConv(x, w, b, strides, pads, group, auto_pad);
+}
+
+chainerx::Array ConvBiasActivationOp::RunImpl(
+        ChxVMState* st,
+        const chainerx::Array& x,
+        const chainerx::Array& w,
+        const nonstd::optional<chainerx::Array>& b,
+        const nonstd::optional<chainerx::Array>& z) {
+    const chainerx::Dtype dtype = x.dtype();
+    bool use_native = IsNativeDevice(&x.device()) && (dtype == chainerx::Dtype::kFloat32 || dtype == chainerx::Dtype::kFloat64);
+    if (b.has_value()) use_native &= b->dtype() == dtype && IsNativeDevice(&b->device());
+    if (z.has_value()) use_native &= z->dtype() == dtype && IsNativeDevice(&z->device());
+
+    chainerx::Array y = RunConv(x, w, use_native ? nonstd::nullopt : b, strides, pads, group, auto_pad);
+    if (use_native) {
+        // The output of Conv on the native device is not always
+        // contiguous (e.g., channels can be innermost), so the epilogue
+        // runs along the axis with the unit stride.
+        int64_t y_ncs[3];
+        int64_t z_ncs[3] = {0, 0, 0};
+        bool ok = y.ndim() >= 2 && GetNCSStrides(y, y_ncs) && (y_ncs[1] == 1 || y_ncs[2] == 1);
+        if (z.has_value()) ok &= z->shape() == y.shape() && GetNCSStrides(*z, z_ncs);
+        if (ok) {
+            if (dtype == chainerx::Dtype::kFloat32) {
+                ApplyConvEpilogue<float>(y, y_ncs, b, z, z_ncs, activation, alpha, min, max);
+            } else {
+                ApplyConvEpilogue<double>(y, y_ncs, b, z, z_ncs, activation, alpha, min, max);
+            }
+            return y;
+        }
+        if (b.has_value()) {
+            std::vector<int64_t> bias_shape(y.ndim(), 1);
+            bias_shape[1] = b->GetTotalSize();
+            y = y + b->Reshape(chainerx::Shape(bias_shape.begin(), bias_shape.end()));
+        }
+    }
+
+    if (z.has_value()) y = y + *z;
+    if (activation == "Relu") {
+        return chainerx::Relu(y);
+    } else if (activation == "LeakyRelu") {
+        chainerx::Array negs = (y < chainerx::Zeros({}, y.dtype(), y.device())).AsType(y.dtype());
+        return y * (1 - negs) + alpha * y * negs;
+    } else {
+        CHECK_EQ("Clip", activation);
+        return chainerx::Minimum(chainerx::Maximum(y, min), max);
+    }
+}
+
+namespace {
+
+chainerx::Array RunConvTranspose(
+        const chainerx::Array& x,
+        const chainerx::Array& w,
+        const nonstd::optional<chainerx::Array>& b,
+        const Int64StackVector& strides,
+        const Int64StackVector& pads,
+        const nonstd::optional<Int64StackVector>& out_size,
+        int group) {
+    if (group <= 1) {
+        return chainerx::ConvTranspose(x, w, b, strides, pads, out_size);
+    }
+
+    if (UseNativeGroupedConv(group, x, w, nonstd::nullopt)) {
+        // ConvTranspose is the gradient of Conv with respect to its
+        // input, whose weight has the same layout.
+        chainerx::Shape y_shape = {x.shape()[0], w.shape()[1] * group};
+        for (int i = 0; i < 2; ++i) {
+            y_shape.push_back(out_size.has_value() ? (*out_size)[i] : (x.shape()[2 + i] - 1) * strides[i] + w.shape()[2 + i] - pads[i] * 2);
+        }
+        chainerx::Array y = chainerx::Empty(y_shape, x.dtype(), x.device());
+        const GroupedConv2D p = MakeGroupedConv2D(y.shape(), w.shape(), x.shape(), strides, pads, group);
+        chainerx::Array xc = chainerx::AsContiguous(x);
+        chainerx::Array wc = chainerx::AsContiguous(w);
+        if (x.dtype() == chainerx::Dtype::kFloat32) {
+            GroupedConvGradInput<float>(p, GetData<float>(xc), GetData<float>(wc), GetMutableData<float>(y));
+        } else {
+            GroupedConvGradInput<double>(p, GetData<double>(xc), GetData<double>(wc), GetMutableData<double>(y));
+        }
+        if (b.has_value()) {
+            y += b->Reshape({1, b->GetTotalSize(), 1, 1});
+        }
+        return y;
+    }
+
+    std::vector<chainerx::Array> inputs = SplitByLengths(x, 1, std::vector<int64_t>(group, x.shape()[1] / group));
+    std::vector<chainerx::Array> weights = SplitByLengths(w, 0, std::vector<int64_t>(group, w.shape()[0] / group));
+    std::vector<chainerx::Array> biases;
+    if (b.has_value()) {
+        biases = SplitByLengths(*b, 0, std::vector<int64_t>(group, b->shape()[0] / group));
+    }
+    std::vector<chainerx::Array> outputs(group);
+    for (int i = 0; i < group; ++i) {
+        auto sub_bias = b.has_value() ? nonstd::optional<chainerx::Array>(biases[i]) : nonstd::nullopt;
+        outputs[i] = chainerx::ConvTranspose(inputs[i], weights[i], sub_bias, strides, pads, out_size);
+    }
+    return chainerx::Concatenate(outputs, 1);
+}
+
+}  // namespace
+
 chainerx::Array ConvTransposeOp::RunImpl(
         ChxVMState* st, const chainerx::Array& x, const chainerx::Array& w, const nonstd::optional<chainerx::Array>& b) {
-    nonstd::optional<chainerx::StackVector<int64_t, chainerx::kMaxNdim>> out_size = nonstd::nullopt;
+    nonstd::optional<Int64StackVector> out_size = nonstd::nullopt;
     if (!output_shape.empty()) {
         out_size = output_shape;
     }
-    return chainerx::ConvTranspose(x, w, b, ComplementStride(strides, x), ComplementPad(pads, x), out_size);
+    return RunConvTranspose(x, w, b, ComplementStride(strides, x), ComplementPad(pads, x), out_size, group);
 }
 
 chainerx::Array ConvTransposeWithDynamicShapeOp::RunImpl(
         ChxVMState* st, const chainerx::Array& x, const chainerx::Array& w, const chainerx::Shape& shape) {
-    chainerx::StackVector<int64_t, chainerx::kMaxNdim> out_size(shape.begin() + 2, shape.end());
-    return chainerx::ConvTranspose(x, w, nonstd::nullopt, ComplementStride(strides, x), ComplementPad(pads, x), out_size);
+    Int64StackVector out_size(shape.begin() + 2, shape.end());
+    return RunConvTranspose(x, w, nonstd::nullopt, ComplementStride(strides, x), ComplementPad(pads, x), out_size, group);
 }
 
 chainerx::Array ConvGradWeightOp::RunImpl(ChxVMState* st, const chainerx::Array& w, const chainerx::Array& x, const chainerx::Array& gy) {
-    return x.device().backend().CallKernel<chainerx::ConvGradWeightKernel>(
-            w.dtype(), w.shape(), x, gy, ComplementStride(strides, x), ComplementPad(pads, x), false /* cover_all */, nonstd::nullopt);
+    const Int64StackVector comp_strides = ComplementStride(strides, x);
+    const Int64StackVector comp_pads = ComplementPad(pads, x);
+    if (group <= 1) {
+        return x.device().backend().CallKernel<chainerx::ConvGradWeightKernel>(
+                w.dtype(), w.shape(), x, gy, comp_strides, comp_pads, false /* cover_all */, nonstd::nullopt);
+    }
+
+    if (UseNativeGroupedConv(group, x, gy, nonstd::nullopt) && w.dtype() == x.dtype()) {
+        chainerx::Array gw = chainerx::Empty(w.shape(), w.dtype(), x.device());
+        const GroupedConv2D p = MakeGroupedConv2D(x.shape(), w.shape(), gy.shape(), comp_strides, comp_pads, group);
+        chainerx::Array xc = chainerx::AsContiguous(x);
+        chainerx::Array gyc = chainerx::AsContiguous(gy);
+        if (x.dtype() == chainerx::Dtype::kFloat32) {
+            GroupedConvGradWeight<float>(p, GetData<float>(xc), GetData<float>(gyc), GetMutableData<float>(gw));
+        } else {
+            GroupedConvGradWeight<double>(p, GetData<double>(xc), GetData<double>(gyc), GetMutableData<double>(gw));
+        }
+        return gw;
+    }
+
+    std::vector<chainerx::Array> inputs = SplitByLengths(x, 1, std::vector<int64_t>(group, x.shape()[1] / group));
+    std::vector<chainerx::Array> grads = SplitByLengths(gy, 1, std::vector<int64_t>(group, gy.shape()[1] / group));
+    chainerx::Shape w_shape = w.shape();
+    w_shape[0] /= group;
+    std::vector<chainerx::Array> outputs(group);
+    for (int i = 0; i < group; ++i) {
+        outputs[i] = x.device().backend().CallKernel<chainerx::ConvGradWeightKernel>(
+                w.dtype(), w_shape, inputs[i], grads[i], comp_strides, comp_pads, false /* cover_all */, nonstd::nullopt);
+    }
+    return chainerx::Concatenate(outputs, 0);
 }
 
 }  // namespace runtime
@@ -1,3 +1,5 @@
+#include <chainerx/kernels/creation.h>
+#include <chainerx/kernels/misc.h>
 #include <chainerx/routines/creation.h>
 #include <chainerx/routines/manipulation.h>
 
@@ -108,7 +110,16 @@ chainerx::Array PadOp::RunImpl(ChxVMState* st, const chainerx::Array& data) {
 }
 
 chainerx::Array CastOp::RunImpl(ChxVMState* st, const chainerx::Array& input) {
-    return CastTo(input, static_cast<chainerx::Dtype>(to));
+    const chainerx::Dtype dtype = static_cast<chainerx::Dtype>(to);
+    // `CastTo` moves int64 arrays between devices.
+    if (consumes_input(0) && input.dtype() != dtype && input.dtype() != chainerx::Dtype::kInt64 && dtype != chainerx::Dtype::kInt64 &&
+        chainerx::GetItemSize(input.dtype()) == chainerx::GetItemSize(dtype) && IsExclusivelyOwned(input)) {
+        // Convert elements in place over the buffer of `input`.
+        chainerx::Array out = chainerx::FromData(input.shape(), dtype, input.data(), input.strides(), input.offset(), input.device());
+        input.device().backend().CallKernel<chainerx::AsTypeKernel>(input, out);
+        return out;
+    }
+    return CastTo(input, dtype);
 }
 
 chainerx::Array PadBatchSizeOp::RunImpl(ChxVMState* st, const chainerx::Array& data) {
@@ -1,3 +1,10 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <chainerx/kernels/arithmetic.h>
+#include <chainerx/kernels/linalg.h>
 #include <chainerx/routines/arithmetic.h>
 #include <chainerx/routines/connection.h>
 #include <chainerx/routines/creation.h>
@@ -13,6 +20,7 @@
 #include <common/log.h>
 #include <runtime/chainerx_util.h>
 #include <runtime/gen_chxvm_ops.h>
+#include <runtime/parallel_for.h>
 
 namespace chainer_compiler {
 namespace runtime {
@@ -45,19 +53,37 @@ std::tuple<chainerx::Array, chainerx::Array> CoerceBinary(const chainerx::Array&
     return std::tie(ax, bx);
 }
 
+// Runs `Kernel` directly into the output buffer placed by the
+// compiler or into a consumed input. Broadcasting and type coercion
+// are left to the routines.
+template <typename Kernel>
+nonstd::optional<chainerx::Array> RunPlacedBinary(ChxVMState* st, const ChxVMOp& op, const chainerx::Array& a, const chainerx::Array& b) {
+    if (a.shape() != b.shape() || a.dtype() != b.dtype() || a.dtype() == chainerx::Dtype::kBool || &a.device() != &b.device()) {
+        return nonstd::nullopt;
+    }
+    nonstd::optional<chainerx::Array> out = st->GetReusableOutput(op, 0, 0, a);
+    if (!out.has_value()) out = st->GetReusableOutput(op, 0, 1, b);
+    if (!out.has_value()) return nonstd::nullopt;
+    a.device().backend().CallKernel<Kernel>(a, b, *out);
+    return out;
+}
+
 }  // namespace
 
 chainerx::Array AddOp::RunImpl(ChxVMState* st, const chainerx::Array& a, const chainerx::Array& b) {
+    if (auto placed = RunPlacedBinary<chainerx::AddKernel>(st, *this, a, b)) return *placed;
     auto t = CoerceBinary(a, b);
     return std::get<0>(t) + std::get<1>(t);
 }
 
 chainerx::Array SubOp::RunImpl(ChxVMState* st, const chainerx::Array& a, const chainerx::Array& b) {
+    if (auto placed = RunPlacedBinary<chainerx::SubtractKernel>(st, *this, a, b)) return *placed;
     auto t = CoerceBinary(a, b);
     return std::get<0>(t) - std::get<1>(t);
 }
 
 chainerx::Array MulOp::RunImpl(ChxVMState* st, const chainerx::Array& a, const chainerx::Array& b) {
+    if (auto placed = RunPlacedBinary<chainerx::MultiplyKernel>(st, *this, a, b)) return *placed;
     auto t = CoerceBinary(a, b);
     return std::get<0>(t) * std::get<1>(t);
 }
@@ -151,6 +177,137 @@ chainerx::Array MatMulOp::RunImpl(ChxVMState* st, const chainerx::Array& a, cons
     return chainerx::Dot(a, b);
 }
 
+namespace {
+
+struct IdentityActivation {
+    template <typename T>
+    T operator()(T v) const {
+        return v;
+    }
+};
+
+struct ReluActivation {
+    template <typename T>
+    T operator()(T v) const {
+        return v < 0 ? 0 : v;
+    }
+};
+
+struct SigmoidActivation {
+    template <typename T>
+    T operator()(T v) const {
+        return 1 / (1 + std::exp(-v));
+    }
+};
+
+struct TanhActivation {
+    template <typename T>
+    T operator()(T v) const {
+        return std::tanh(v);
+    }
+};
+
+// The output is computed by at most `kGemmMaxPanels` panels of rows
+// and the epilogue is applied to each panel while it is in cache. A
+// panel has at least `kGemmMinPanelRows` rows so each dot call stays a
+// matrix product rather than a series of matrix-vector products.
+constexpr int64_t kGemmMaxPanels = 8;
+constexpr int64_t kGemmMinPanelRows = 64;
+
+// Computes `activation(alpha * a . b + beta * c)` into `y`. `c` is
+// broadcast to `y` by its strides in elements.
+template <typename T, class Activation>
+void RunGemmPanels(
+        const chainerx::Array& a, const chainerx::Array& b, const T* c, const int64_t* c_strides, T alpha, T beta, const chainerx::Array& y) {
+    const int64_t m = y.shape()[0];
+    const int64_t n = y.shape()[1];
+    T* yp = GetMutableData<T>(y);
+    const int64_t c_row_stride = c_strides[0];
+    const int64_t c_col_stride = c_strides[1];
+    const int64_t panel_rows = std::max(kGemmMinPanelRows, (m + kGemmMaxPanels - 1) / kGemmMaxPanels);
+    for (int64_t begin = 0; begin < m; begin += panel_rows) {
+        const int64_t end = std::min(m, begin + panel_rows);
+        const std::vector<chainerx::ArrayIndex> rows = {chainerx::Slice(begin, end)};
+        y.device().backend().CallKernel<chainerx::DotKernel>(a.At(rows), b, y.At(rows));
+        ParallelFor(begin, end, std::max<int64_t>(1, 16384 / n), [=](int64_t row_begin, int64_t row_end) {
+            for (int64_t i = row_begin; i < row_end; ++i) {
+                T* yr = yp + i * n;
+                const T* cr = c + i * c_row_stride;
+                for (int64_t j = 0; j < n; ++j) {
+                    yr[j] = Activation()(alpha * yr[j] + beta * cr[j * c_col_stride]);
+                }
+            }
+        });
+    }
+}
+
+template <typename T>
+void RunGemmPanels(
+        const chainerx::Array& a,
+        const chainerx::Array& b,
+        const T* c,
+        const int64_t* c_strides,
+        T alpha,
+        T beta,
+        const std::string& activation,
+        const chainerx::Array& y) {
+    if (activation.empty()) {
+        RunGemmPanels<T, IdentityActivation>(a, b, c, c_strides, alpha, beta, y);
+    } else if (activation == "Relu") {
+        RunGemmPanels<T, ReluActivation>(a, b, c, c_strides, alpha, beta, y);
+    } else if (activation == "Sigmoid") {
+        RunGemmPanels<T, SigmoidActivation>(a, b, c, c_strides, alpha, beta, y);
+    } else {
+        CHECK_EQ("Tanh", activation);
+        RunGemmPanels<T, TanhActivation>(a, b, c, c_strides, alpha, beta, y);
+    }
+}
+
+// Computes `activation(alpha * a . b + beta * c)` for 2D `a` and `b`
+// on the native device. Returns nullopt for unsupported inputs.
+nonstd::optional<chainerx::Array> NativeGemmBiasActivation(
+        const chainerx::Array& a,
+        const chainerx::Array& b,
+        nonstd::optional<chainerx::Array> c,
+        double alpha,
+        double beta,
+        const std::string& activation) {
+    const chainerx::Dtype dtype = a.dtype();
+    if (dtype != chainerx::Dtype::kFloat32 && dtype != chainerx::Dtype::kFloat64) return nonstd::nullopt;
+    if (!IsNativeDevice(&a.device()) || !IsNativeDevice(&b.device()) || b.dtype() != dtype) return nonstd::nullopt;
+    if (a.ndim() != 2 || b.ndim() != 2 || a.shape()[1] != b.shape()[0]) return nonstd::nullopt;
+    const int64_t m = a.shape()[0];
+    const int64_t n = b.shape()[1];
+    if (m == 0 || n == 0 || a.shape()[1] == 0) return nonstd::nullopt;
+
+    // As Gemm, `c` is ignored when `beta` is zero even if it has NaNs.
+    if (beta == 0.0) c = nonstd::nullopt;
+    int64_t c_strides[2] = {0, 0};
+    if (c.has_value()) {
+        if (!IsNativeDevice(&c->device()) || c->dtype() != dtype || c->ndim() > 2) return nonstd::nullopt;
+        for (int i = 0; i < c->ndim(); ++i) {
+            const int axis = 2 - c->ndim() + i;
+            const int64_t dim = c->shape()[i];
+            if (dim == 1) continue;
+            if (dim != (axis == 0 ? m : n)) return nonstd::nullopt;
+            c_strides[axis] = c->strides()[i] / c->GetItemSize();
+        }
+    } else {
+        c = chainerx::Zeros({}, dtype, a.device());
+        beta = 0.0;
+    }
+
+    chainerx::Array y = chainerx::Empty({m, n}, dtype, a.device());
+    if (dtype == chainerx::Dtype::kFloat32) {
+        RunGemmPanels<float>(a, b, GetData<float>(*c), c_strides, alpha, beta, activation, y);
+    } else {
+        RunGemmPanels<double>(a, b, GetData<double>(*c), c_strides, alpha, beta, activation, y);
+    }
+    return y;
+}
+
+}  // namespace
+
 chainerx::Array GemmOp::RunImpl(ChxVMState* st, const chainerx::Array& a, const chainerx::Array& b, const chainerx::Array& c) {
     if (alpha == 1.0 && beta == 1.0 && !trans_a && trans_b && c.ndim() == 1) {
         return Linear(a, b, c);
@@ -168,6 +325,29 @@ chainerx::Array GemmOp::RunImpl(ChxVMState* st, const chainerx::Array& a, const
     return r + xc;
 }
 
+chainerx::Array GemmBiasActivationOp::RunImpl(
+        ChxVMState* st, const chainerx::Array& a, const chainerx::Array& b, const nonstd::optional<chainerx::Array>& c) {
+    chainerx::Array xa = a;
+    chainerx::Array xb = b;
+    if (trans_a) xa = chainerx::Transpose(xa);
+    if (trans_b) xb = chainerx::Transpose(xb);
+    if (nonstd::optional<chainerx::Array> y = NativeGemmBiasActivation(xa, xb, c, alpha, beta, activation)) {
+        return *y;
+    }
+
+    chainerx::Array r = chainerx::Dot(xa, xb);
+    if (alpha != 1.0) r *= alpha;
+    if (c.has_value() && beta != 0.0) r = r + (beta == 1.0 ? *c : *c * beta);
+    if (activation == "Relu") {
+        return chainerx::Relu(r);
+    } else if (activation == "Sigmoid") {
+        return Sigmoid(r);
+    } else {
+        CHECK_EQ("Tanh", activation);
+        return chainerx::Tanh(r);
+    }
+}
+
 chainerx::Array MaxOp::RunImpl(ChxVMState* st, const std::vector<chainerx::Array>& inputs) {
     CHECK_LT(0, inputs.size());
     chainerx::Array result = inputs[0];
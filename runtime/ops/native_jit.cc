@@ -0,0 +1,475 @@
+#include <dlfcn.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+
+#include <chainerx/array.h>
+#include <chainerx/routines/creation.h>
+#include <chainerx/shape.h>
+
+#include <common/log.h>
+#include <common/strutil.h>
+#include <runtime/chainerx_util.h>
+#include <runtime/gen_chxvm_ops.h>
+#include <runtime/ops/native_jit.h>
+#include <runtime/parallel_for.h>
+
+namespace chainer_compiler {
+namespace runtime {
+
+namespace {
+
+// The signature of functions generated by `BuildNativeProgram`.
+typedef void (*FusionFunc)(
+        int64_t outer_begin,
+        int64_t outer_end,
+        int64_t inner_begin,
+        int64_t inner_end,
+        int64_t inner,
+        const void* const* ins,
+        const int64_t* outer_strides,
+        void* const* outs);
+
+const char kCompileFlags[] = "-std=c++14 -O3 -march=native -fno-math-errno -fopenmp-simd -shared -fPIC";
+
+// FNV-1a, which is stable across processes unlike `std::hash`.
+uint64_t HashString(const std::string& s) {
+    uint64_t h = 14695981039346656037ULL;
+    for (char c : s) {
+        h ^= static_cast<uint8_t>(c);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Shared objects in the cache directory are loaded without further
+// verification, so the default directory is private to the user.
+std::string GetCacheDir() {
+    const char* dir = getenv("CHAINER_COMPILER_JIT_CACHE_DIR");
+    if (dir && *dir) return dir;
+    const char* cache_home = getenv("XDG_CACHE_HOME");
+    if (cache_home && *cache_home) return StrCat(cache_home, "/chainer_compiler/jit");
+    const char* home = getenv("HOME");
+    if (home && *home) return StrCat(home, "/.cache/chainer_compiler/jit");
+    return "";
+}
+
+std::string GetCompiler() {
+    const char* cxx = getenv("CXX");
+    return cxx ? cxx : "c++";
+}
+
+// Returns true if `path` is owned by the effective user and nobody
+// else can write to it.
+bool IsPrivate(const std::string& path, bool is_dir) {
+    struct stat st;
+    // The shared object must not be a symlink to a file of others.
+    if ((is_dir ? stat(path.c_str(), &st) : lstat(path.c_str(), &st)) != 0) return false;
+    if (is_dir ? !S_ISDIR(st.st_mode) : !S_ISREG(st.st_mode)) return false;
+    return st.st_uid == geteuid() && (st.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+// Creates `dir` and its parents with mode 0700 and checks the
+// ownership and the mode of `dir`.
+bool MakePrivateDir(const std::string& dir) {
+    for (size_t pos = dir.find('/', 1); pos != std::string::npos; pos = dir.find('/', pos + 1)) {
+        mkdir(dir.substr(0, pos).c_str(), 0700);
+    }
+    if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+        std::cerr << "WARNING: Failed to create " << dir << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (!IsPrivate(dir, true)) {
+        std::cerr << "WARNING: " << dir << " must be a directory owned by the user and not writable by others" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Runs `args` without a shell so the compiler and file names are not
+// interpreted. Returns true if the command succeeds.
+bool RunCommand(const std::vector<std::string>& args) {
+    std::vector<char*> argv;
+    for (const std::string& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    const pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return false;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Compiles `code` to a shared object unless a shared object of the
+// same code is already in the cache directory. Files are renamed
+// atomically so processes can share the directory. Returns false on
+// failure.
+bool CompileToSharedObject(const std::string& code, std::string* so_filename) {
+    const std::string compiler = GetCompiler();
+    const std::string dir = GetCacheDir();
+    if (dir.empty()) {
+        std::cerr << "WARNING: No directory for the native JIT. Set CHAINER_COMPILER_JIT_CACHE_DIR" << std::endl;
+        return false;
+    }
+    if (!MakePrivateDir(dir)) return false;
+    char hash[17];
+    snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(HashString(StrCat(compiler, " ", kCompileFlags, "\n", code))));
+    *so_filename = StrCat(dir, "/", hash, ".so");
+    if (access(so_filename->c_str(), R_OK) != 0) {
+        const std::string tmp_prefix = StrCat(dir, "/", hash, ".", getpid());
+        const std::string src_filename = tmp_prefix + ".cc";
+        const std::string tmp_filename = tmp_prefix + ".so";
+        {
+            std::ofstream ofs(src_filename);
+            ofs << code;
+            if (!ofs) {
+                std::cerr << "WARNING: Failed to write " << src_filename << std::endl;
+                return false;
+            }
+        }
+
+        // `CXX` may have a launcher or flags (e.g., "ccache g++").
+        std::vector<std::string> args;
+        for (const std::string& arg : SplitString(StrCat(compiler, " ", kCompileFlags), " ")) {
+            if (!arg.empty()) args.push_back(arg);
+        }
+        args.insert(args.end(), {"-o", tmp_filename, src_filename});
+        if (!RunCommand(args)) {
+            // The source is left for debugging.
+            std::cerr << "WARNING: Command failed: " << JoinString(args, " ") << std::endl;
+            unlink(tmp_filename.c_str());
+            return false;
+        }
+        unlink(src_filename.c_str());
+        if (rename(tmp_filename.c_str(), so_filename->c_str()) != 0) {
+            std::cerr << "WARNING: Failed to rename " << tmp_filename << ": " << strerror(errno) << std::endl;
+            unlink(tmp_filename.c_str());
+            return false;
+        }
+    }
+
+    if (!IsPrivate(*so_filename, false)) {
+        std::cerr << "WARNING: " << *so_filename << " must be a file owned by the user and not writable by others" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Returns nullptr if `code` cannot be compiled or loaded. Failures
+// are cached as well so they are not retried for each run.
+FusionFunc CompileAndLoad(const std::string& name, const std::string& code) {
+    static std::mutex mu;
+    static std::map<std::string, FusionFunc> cache;
+    std::lock_guard<std::mutex> lock(mu);
+    auto found = cache.find(code);
+    if (found != cache.end()) return found->second;
+
+    FusionFunc func = nullptr;
+    std::string so_filename;
+    if (CompileToSharedObject(code, &so_filename)) {
+        // The shared object is never closed as the function is cached.
+        void* handle = dlopen(so_filename.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (handle) {
+            func = reinterpret_cast<FusionFunc>(dlsym(handle, name.c_str()));
+        }
+        if (!func) {
+            const char* error = dlerror();
+            std::cerr << "WARNING: Failed to load " << name << " from " << so_filename << ": " << (error ? error : "") << std::endl;
+        }
+    }
+
+    CHECK(cache.emplace(code, func).second);
+    return func;
+}
+
+// How an input is read in the (outer, inner) iteration space.
+struct InputLayout {
+    int64_t outer_stride;
+    int64_t inner_stride;
+};
+
+// Returns whether `input` has all dims of `shape` or none of them
+// (i.e., is broadcast) in [begin, end).
+bool IsFullOrBroadcast(const chainerx::Shape& shape, const chainerx::Shape& input, int begin, int end, bool* is_full) {
+    const int offset = shape.size() - input.size();
+    bool full = true;
+    bool broadcast = true;
+    for (int i = begin; i < end; ++i) {
+        const int64_t dim = i < offset ? 1 : input[i - offset];
+        if (dim != shape[i]) full = false;
+        if (dim != 1) broadcast = false;
+    }
+    *is_full = full;
+    return full || broadcast;
+}
+
+// Splits `shape` into (outer, inner) at `split` so that every input
+// is read by strides of `layouts`. Returns false if it is impossible.
+bool CollapseShapeAt(
+        const chainerx::Shape& shape,
+        const std::vector<chainerx::Array>& inputs,
+        int split,
+        int64_t* inner,
+        std::vector<InputLayout>* layouts) {
+    const int ndim = shape.size();
+    *inner = 1;
+    for (int i = split; i < ndim; ++i) *inner *= shape[i];
+
+    layouts->clear();
+    for (const chainerx::Array& input : inputs) {
+        bool outer_full, inner_full;
+        if (!IsFullOrBroadcast(shape, input.shape(), 0, split, &outer_full)) return false;
+        if (!IsFullOrBroadcast(shape, input.shape(), split, ndim, &inner_full)) return false;
+        InputLayout layout;
+        layout.inner_stride = inner_full ? 1 : 0;
+        layout.outer_stride = !outer_full ? 0 : inner_full ? *inner : 1;
+        layouts->push_back(layout);
+    }
+    return true;
+}
+
+// Same as above, but chooses the split. A larger inner size is
+// preferred as the inner loop is vectorized.
+bool CollapseShape(
+        const chainerx::Shape& shape, const std::vector<chainerx::Array>& inputs, int64_t* inner, std::vector<InputLayout>* layouts) {
+    for (int split = 0; split <= static_cast<int>(shape.size()); ++split) {
+        if (CollapseShapeAt(shape, inputs, split, inner, layouts)) return true;
+    }
+    return false;
+}
+
+const char* GetTypeName(chainerx::Dtype dtype) {
+    switch (dtype) {
+        case chainerx::Dtype::kFloat32:
+            return "float";
+        case chainerx::Dtype::kFloat64:
+            return "double";
+        default:
+            CHECK(false) << "Unsupported dtype for native JIT: " << dtype;
+    }
+    return nullptr;
+}
+
+// Moves inputs to the native device and makes them contiguous.
+// Returns the shape they are broadcast to.
+chainerx::Shape PrepareInputs(const std::vector<chainerx::Array>& orig_inputs, const std::string& code, std::vector<chainerx::Array>* inputs) {
+    CHECK(!orig_inputs.empty());
+    const chainerx::Dtype dtype = orig_inputs[0].dtype();
+    CHECK_NE(std::string::npos, code.find(StrCat("typedef ", GetTypeName(dtype), " T;"))) << dtype << "\ncode:\n" << code;
+    chainerx::Shape shape = orig_inputs[0].shape();
+    for (chainerx::Array input : orig_inputs) {
+        CHECK_EQ(dtype, input.dtype());
+        shape = chainerx::internal::BroadcastShapes(shape, input.shape());
+        if (!IsNativeDevice(&input.device())) {
+            input = input.ToNative();
+        }
+        inputs->push_back(chainerx::AsContiguous(input));
+    }
+    return shape;
+}
+
+// Functions of a fusion group compiled for each layout of inputs.
+// Strides of broadcast inputs are compile-time constants so the inner
+// loop is vectorized.
+class NativeFusionCache {
+public:
+    // Returns nullptr on failure.
+    FusionFunc Load(int fusion_id, const std::string& code, const std::vector<InputLayout>& layouts) {
+        std::vector<int64_t> inner_strides;
+        for (const InputLayout& layout : layouts) {
+            inner_strides.push_back(layout.inner_stride);
+        }
+        std::lock_guard<std::mutex> lock(mu_);
+        auto found = funcs_.find(inner_strides);
+        if (found != funcs_.end()) return found->second;
+
+        std::string prologue;
+        for (size_t i = 0; i < inner_strides.size(); ++i) {
+            if (inner_strides[i] != 1) {
+                prologue += StrCat("#define CHX_INNER_STRIDE_", i, " ", inner_strides[i], "\n");
+            }
+        }
+        FusionFunc func = CompileAndLoad(StrCat("fusion", fusion_id), prologue + code);
+        CHECK(funcs_.emplace(inner_strides, func).second);
+        return func;
+    }
+
+    // Broadcasts all inputs to `shape` so they are read with unit
+    // strides by `code` itself, which is checked by
+    // `PrepareNativeFusion`. This is used when inputs are broadcast in
+    // a way which cannot be expressed by (outer, inner) strides or when
+    // the code specialized for broadcast inputs fails to compile.
+    // `split` is the axis of the inner loop, or -1 to choose it.
+    FusionFunc LoadForFullInputs(
+            int fusion_id,
+            const std::string& code,
+            const chainerx::Shape& shape,
+            int split,
+            std::vector<chainerx::Array>* inputs,
+            int64_t* inner,
+            std::vector<InputLayout>* layouts) {
+        for (chainerx::Array& input : *inputs) {
+            input = chainerx::AsContiguous(input.BroadcastTo(shape));
+        }
+        CHECK(split < 0 ? CollapseShape(shape, *inputs, inner, layouts) : CollapseShapeAt(shape, *inputs, split, inner, layouts));
+        FusionFunc func = Load(fusion_id, code, *layouts);
+        CHECK(func) << "Failed to load native code of fusion" << fusion_id;
+        return func;
+    }
+
+private:
+    std::mutex mu_;
+    // Keyed by the inner strides of inputs.
+    std::map<std::vector<int64_t>, FusionFunc> funcs_;
+};
+
+std::vector<const void*> GetInputPointers(const std::vector<chainerx::Array>& inputs) {
+    std::vector<const void*> ptrs;
+    for (const chainerx::Array& input : inputs) {
+        // Contiguous arrays may still have offsets (e.g., in the arena
+        // of the static memory plan).
+        ptrs.push_back(static_cast<const char*>(input.raw_data()) + input.offset());
+    }
+    return ptrs;
+}
+
+std::vector<int64_t> GetOuterStrides(const std::vector<InputLayout>& layouts) {
+    std::vector<int64_t> strides;
+    for (const InputLayout& layout : layouts) {
+        strides.push_back(layout.outer_stride);
+    }
+    return strides;
+}
+
+std::vector<chainerx::Array> ToDevice(std::vector<chainerx::Array> outputs, chainerx::Device& device) {
+    if (!IsNativeDevice(&device)) {
+        for (chainerx::Array& output : outputs) {
+            output = output.ToDevice(device);
+        }
+    }
+    return outputs;
+}
+
+// Enough elements to amortize the dispatch of a chunk.
+const int64_t kGrainSize = 16384;
+
+}  // namespace
+
+bool PrepareNativeFusion(int fusion_id, const std::string& code) {
+    return CompileAndLoad(StrCat("fusion", fusion_id), code) != nullptr;
+}
+
+class ElementWiseNativeOp::ElementWiseNativeImpl : public NativeFusionCache {};
+
+void ElementWiseNativeOp::InitImpl() {
+    impl_ = new ElementWiseNativeImpl();
+}
+
+ElementWiseNativeOp::~ElementWiseNativeOp() {
+    delete impl_;
+}
+
+std::vector<chainerx::Array> ElementWiseNativeOp::RunImpl(
+        chainer_compiler::runtime::ChxVMState* st, const std::vector<chainerx::Array>& orig_inputs) {
+    std::vector<chainerx::Array> inputs;
+    const chainerx::Shape shape = PrepareInputs(orig_inputs, code, &inputs);
+
+    int64_t inner;
+    std::vector<InputLayout> layouts;
+    FusionFunc func = nullptr;
+    if (CollapseShape(shape, inputs, &inner, &layouts)) {
+        func = impl_->Load(fusion_id, code, layouts);
+    }
+    if (!func) {
+        func = impl_->LoadForFullInputs(fusion_id, code, shape, -1, &inputs, &inner, &layouts);
+    }
+    const int64_t outer = inner ? shape.GetTotalSize() / inner : 0;
+
+    const std::vector<const void*> in_ptrs = GetInputPointers(inputs);
+    const std::vector<int64_t> outer_strides = GetOuterStrides(layouts);
+    std::vector<chainerx::Array> outputs;
+    std::vector<void*> out_ptrs;
+    for (int i = 0; i < num_outputs; ++i) {
+        outputs.push_back(chainerx::Empty(shape, inputs[0].dtype(), inputs[0].device()));
+        out_ptrs.push_back(outputs.back().raw_data());
+    }
+
+    if (outer == 1) {
+        ParallelFor(0, inner, kGrainSize, [&](int64_t begin, int64_t end) {
+            func(0, 1, begin, end, inner, in_ptrs.data(), outer_strides.data(), out_ptrs.data());
+        });
+    } else {
+        ParallelFor(0, outer, std::max<int64_t>(1, kGrainSize / std::max<int64_t>(1, inner)), [&](int64_t begin, int64_t end) {
+            func(begin, end, 0, inner, inner, in_ptrs.data(), outer_strides.data(), out_ptrs.data());
+        });
+    }
+    return ToDevice(outputs, orig_inputs[0].device());
+}
+
+class RowReductionNativeOp::RowReductionNativeImpl : public NativeFusionCache {};
+
+void RowReductionNativeOp::InitImpl() {
+    impl_ = new RowReductionNativeImpl();
+}
+
+RowReductionNativeOp::~RowReductionNativeOp() {
+    delete impl_;
+}
+
+std::vector<chainerx::Array> RowReductionNativeOp::RunImpl(
+        chainer_compiler::runtime::ChxVMState* st, const std::vector<chainerx::Array>& orig_inputs) {
+    std::vector<chainerx::Array> inputs;
+    const chainerx::Shape shape = PrepareInputs(orig_inputs, code, &inputs);
+    CHECK_LT(0, shape.size());
+    const int split = shape.size() - 1;
+
+    // Rows are along the last axis.
+    int64_t inner;
+    std::vector<InputLayout> layouts;
+    FusionFunc func = nullptr;
+    if (CollapseShapeAt(shape, inputs, split, &inner, &layouts)) {
+        func = impl_->Load(fusion_id, code, layouts);
+    }
+    if (!func) {
+        func = impl_->LoadForFullInputs(fusion_id, code, shape, split, &inputs, &inner, &layouts);
+    }
+    const int64_t outer = inner ? shape.GetTotalSize() / inner : 0;
+
+    chainerx::Shape row_shape(shape);
+    row_shape.back() = 1;
+    const std::vector<const void*> in_ptrs = GetInputPointers(inputs);
+    const std::vector<int64_t> outer_strides = GetOuterStrides(layouts);
+    std::vector<chainerx::Array> outputs;
+    std::vector<void*> out_ptrs;
+    for (int i = 0; i < num_outputs; ++i) {
+        const bool is_row = std::count(row_outputs.begin(), row_outputs.end(), i);
+        outputs.push_back(chainerx::Empty(is_row ? row_shape : shape, inputs[0].dtype(), inputs[0].device()));
+        out_ptrs.push_back(outputs.back().raw_data());
+    }
+
+    ParallelFor(0, outer, std::max<int64_t>(1, kGrainSize / std::max<int64_t>(1, inner)), [&](int64_t begin, int64_t end) {
+        func(begin, end, 0, inner, inner, in_ptrs.data(), outer_strides.data(), out_ptrs.data());
+    });
+    return ToDevice(outputs, orig_inputs[0].device());
+}
+
+}  // namespace runtime
+}  // namespace chainer_compiler
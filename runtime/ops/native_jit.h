@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+namespace chainer_compiler {
+namespace runtime {
+
+// Compiles `code` built by `BuildNativeProgram` or
+// `BuildNativeRowReductionProgram` with the system C++ compiler and
+// loads the function `fusion<fusion_id>` in it. Returns false on
+// failure, in which case the fusion group should be run without the
+// native JIT.
+bool PrepareNativeFusion(int fusion_id, const std::string& code);
+
+}  // namespace runtime
+}  // namespace chainer_compiler
@@ -0,0 +1,577 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <chainerx/kernels/linalg.h>
+#include <chainerx/routines/creation.h>
+#include <chainerx/routines/linalg.h>
+#include <chainerx/routines/manipulation.h>
+#include <chainerx/routines/reduction.h>
+
+#include <common/log.h>
+#include <runtime/chainerx_util.h>
+#include <runtime/chxvm_state.h>
+#include <runtime/gen_chxvm_ops.h>
+#include <runtime/ops/native_rnn.h>
+#include <runtime/parallel_for.h>
+
+namespace chainer_compiler {
+namespace runtime {
+
+namespace {
+
+template <typename T>
+T Sigmoid(T v) {
+    return 1 / (1 + std::exp(-v));
+}
+
+bool IsSupported(const std::vector<const chainerx::Array*>& arrays) {
+    const chainerx::Dtype dtype = arrays[0]->dtype();
+    if (dtype != chainerx::Dtype::kFloat32 && dtype != chainerx::Dtype::kFloat64) return false;
+    for (const chainerx::Array* a : arrays) {
+        if (a->dtype() != dtype || !IsNativeDevice(&a->device())) return false;
+    }
+    return true;
+}
+
+// Returns 0 or 1 for each time step and example as [seq_length,
+// batch_size], or an empty vector if all steps are valid.
+std::vector<uint8_t> GetSequenceMask(const nonstd::optional<chainerx::Array>& sequence_lens, int64_t seq_length, int64_t batch_size) {
+    std::vector<uint8_t> mask;
+    if (!sequence_lens.has_value()) return mask;
+    CHECK_EQ(1, sequence_lens->ndim());
+    CHECK_EQ(batch_size, sequence_lens->shape()[0]);
+    chainerx::Array lens = chainerx::AsContiguous(sequence_lens->AsType(chainerx::Dtype::kInt64).ToNative());
+    const int64_t* lp = GetData<int64_t>(lens);
+    mask.resize(seq_length * batch_size);
+    for (int64_t t = 0; t < seq_length; ++t) {
+        for (int64_t i = 0; i < batch_size; ++i) {
+            mask[t * batch_size + i] = t < lp[i];
+        }
+    }
+    return mask;
+}
+
+// Computes `x . w^T` for all time steps at once. `x` is
+// [seq_length, batch_size, input_size].
+chainerx::Array ProjectInputs(const chainerx::Array& x, const chainerx::Array& w) {
+    chainerx::Array x2d = chainerx::Reshape(x, {x.shape()[0] * x.shape()[1], x.shape()[2]});
+    return chainerx::AsContiguous(chainerx::Dot(x2d, chainerx::Transpose(w)));
+}
+
+// Computes `a . b` into `out` without allocating an output.
+void DotInto(const chainerx::Array& a, const chainerx::Array& b, const chainerx::Array& out) {
+    out.device().backend().CallKernel<chainerx::DotKernel>(a, b, out);
+}
+
+// Returns the sum of the bias of W and R of a direction, which are
+// concatenated in `b` of [num_directions, 2 * size].
+chainerx::Array GetBias(const nonstd::optional<chainerx::Array>& b, int d, int64_t size, const chainerx::Array& x) {
+    if (!b.has_value()) return chainerx::Zeros({size}, x.dtype(), x.device());
+    chainerx::Array bs = b->At({d});
+    return chainerx::AsContiguous(bs.At({chainerx::Slice(0, size)}) + bs.At({chainerx::Slice(size, 2 * size)}));
+}
+
+// Returns a copy of the initial state of a direction, which is
+// updated in place.
+chainerx::Array GetInitialState(const nonstd::optional<chainerx::Array>& initial, int d, int64_t batch_size, int64_t hidden_size, const chainerx::Array& x) {
+    if (!initial.has_value()) return chainerx::Zeros({batch_size, hidden_size}, x.dtype(), x.device());
+    return chainerx::Copy(initial->At({d}));
+}
+
+bool IsReversed(int direction, int d) {
+    return direction == 1 || d == 1;
+}
+
+// Values of the forward computation of LSTM kept for LSTMGrad. Arrays
+// except inputs are indexed by [direction, time].
+class NativeLSTMContext : public ChxVMOpaque {
+public:
+    NativeLSTMContext(
+            const chainerx::Array& x,
+            const chainerx::Array& w,
+            const chainerx::Array& r,
+            const chainerx::Array& gates,
+            const chainerx::Array& tanh_c,
+            const chainerx::Array& prev_h,
+            const chainerx::Array& prev_c,
+            std::vector<uint8_t> mask,
+            int direction,
+            bool dump_memory_usage)
+        : x_(x), w_(w), r_(r), gates_(gates), tanh_c_(tanh_c), prev_h_(prev_h), prev_c_(prev_c), mask_(std::move(mask)), direction_(direction) {
+        if (dump_memory_usage) {
+            SetRetainedArrays({x_, w_, r_, gates_, tanh_c_, prev_h_, prev_c_});
+        }
+    }
+
+    virtual ~NativeLSTMContext() = default;
+
+    virtual std::string ToString() const {
+        return "lstm";
+    }
+    virtual std::string DebugString() const {
+        return "lstm";
+    }
+
+    // [seq_length, batch_size, input_size]
+    const chainerx::Array& x() const {
+        return x_;
+    }
+    // [num_directions, 4 * hidden_size, input_size]
+    const chainerx::Array& w() const {
+        return w_;
+    }
+    // [num_directions, 4 * hidden_size, hidden_size]
+    const chainerx::Array& r() const {
+        return r_;
+    }
+    // Activated i, o, f, and c gates as [num_directions, seq_length,
+    // batch_size, 4 * hidden_size].
+    const chainerx::Array& gates() const {
+        return gates_;
+    }
+    // tanh of the new cell as [num_directions, seq_length, batch_size,
+    // hidden_size].
+    const chainerx::Array& tanh_c() const {
+        return tanh_c_;
+    }
+    // The hidden state and the cell before each time step.
+    const chainerx::Array& prev_h() const {
+        return prev_h_;
+    }
+    const chainerx::Array& prev_c() const {
+        return prev_c_;
+    }
+    const std::vector<uint8_t>& mask() const {
+        return mask_;
+    }
+    int direction() const {
+        return direction_;
+    }
+
+private:
+    chainerx::Array x_;
+    chainerx::Array w_;
+    chainerx::Array r_;
+    chainerx::Array gates_;
+    chainerx::Array tanh_c_;
+    chainerx::Array prev_h_;
+    chainerx::Array prev_c_;
+    std::vector<uint8_t> mask_;
+    int direction_;
+};
+
+// Runs LSTM for a direction and stores outputs and values for LSTMGrad.
+template <typename T>
+void RunLSTMDirection(
+        const chainerx::Array& x,
+        const chainerx::Array& w,
+        const chainerx::Array& r,
+        const nonstd::optional<chainerx::Array>& b,
+        const nonstd::optional<chainerx::Array>& initial_h,
+        const nonstd::optional<chainerx::Array>& initial_c,
+        const std::vector<uint8_t>& mask,
+        int direction,
+        int d,
+        const chainerx::Array& y,
+        const chainerx::Array& y_h,
+        const chainerx::Array& y_c,
+        const chainerx::Array& gates,
+        const chainerx::Array& tanh_c,
+        const chainerx::Array& prev_h,
+        const chainerx::Array& prev_c) {
+    const int64_t seq_length = x.shape()[0];
+    const int64_t batch_size = x.shape()[1];
+    const int64_t num_directions = w.shape()[0];
+    const int64_t hidden_size = r.shape()[2];
+    const int64_t gate_size = 4 * hidden_size;
+
+    const chainerx::Array xw = ProjectInputs(x, w.At({d}));
+    const chainerx::Array rt = chainerx::AsContiguous(chainerx::Transpose(r.At({d})));
+    const chainerx::Array bias = GetBias(b, d, gate_size, x);
+    const chainerx::Array h = GetInitialState(initial_h, d, batch_size, hidden_size, x);
+    const chainerx::Array c = GetInitialState(initial_c, d, batch_size, hidden_size, x);
+    const chainerx::Array hr = chainerx::Empty({batch_size, gate_size}, x.dtype(), x.device());
+
+    const T* xwp = GetData<T>(xw);
+    const T* bp = GetData<T>(bias);
+    const T* hrp = GetData<T>(hr);
+    T* hp = GetMutableData<T>(h);
+    T* cp = GetMutableData<T>(c);
+    T* yp = GetMutableData<T>(y);
+    T* gp = GetMutableData<T>(gates) + d * seq_length * batch_size * gate_size;
+    T* tcp = GetMutableData<T>(tanh_c) + d * seq_length * batch_size * hidden_size;
+    T* php = GetMutableData<T>(prev_h) + d * seq_length * batch_size * hidden_size;
+    T* pcp = GetMutableData<T>(prev_c) + d * seq_length * batch_size * hidden_size;
+
+    for (int64_t t = 0; t < seq_length; ++t) {
+        const int64_t time = IsReversed(direction, d) ? seq_length - t - 1 : t;
+        const int64_t state_offset = time * batch_size * hidden_size;
+        std::copy(hp, hp + batch_size * hidden_size, php + state_offset);
+        std::copy(cp, cp + batch_size * hidden_size, pcp + state_offset);
+        DotInto(h, rt, hr);
+
+        for (int64_t i = 0; i < batch_size; ++i) {
+            const bool valid = mask.empty() || mask[time * batch_size + i];
+            const T* xwr = xwp + (time * batch_size + i) * gate_size;
+            const T* hrr = hrp + i * gate_size;
+            T* gr = gp + (time * batch_size + i) * gate_size;
+            T* tcr = tcp + state_offset + i * hidden_size;
+            T* hr_i = hp + i * hidden_size;
+            T* cr = cp + i * hidden_size;
+            T* yr = yp + ((time * num_directions + d) * batch_size + i) * hidden_size;
+            for (int64_t j = 0; j < hidden_size; ++j) {
+                const T ig = Sigmoid(xwr[j] + hrr[j] + bp[j]);
+                const T og = Sigmoid(xwr[hidden_size + j] + hrr[hidden_size + j] + bp[hidden_size + j]);
+                const T fg = Sigmoid(xwr[2 * hidden_size + j] + hrr[2 * hidden_size + j] + bp[2 * hidden_size + j]);
+                const T cg = std::tanh(xwr[3 * hidden_size + j] + hrr[3 * hidden_size + j] + bp[3 * hidden_size + j]);
+                const T nc = fg * cr[j] + ig * cg;
+                const T tc = std::tanh(nc);
+                gr[j] = ig;
+                gr[hidden_size + j] = og;
+                gr[2 * hidden_size + j] = fg;
+                gr[3 * hidden_size + j] = cg;
+                tcr[j] = tc;
+                if (valid) {
+                    cr[j] = nc;
+                    hr_i[j] = og * tc;
+                    yr[j] = og * tc;
+                } else {
+                    yr[j] = 0;
+                }
+            }
+        }
+    }
+
+    std::copy(hp, hp + batch_size * hidden_size, GetMutableData<T>(y_h) + d * batch_size * hidden_size);
+    std::copy(cp, cp + batch_size * hidden_size, GetMutableData<T>(y_c) + d * batch_size * hidden_size);
+}
+
+// Runs the recurrence of LSTM backward and stores gradients of gates
+// before activations to `ggates` as [seq_length * batch_size, 4 *
+// hidden_size].
+template <typename T>
+void RunLSTMGradDirection(const NativeLSTMContext& context, const chainerx::Array& gy, int d, const chainerx::Array& ggates) {
+    const chainerx::Array& r = context.r();
+    const int64_t seq_length = gy.shape()[0];
+    const int64_t num_directions = gy.shape()[1];
+    const int64_t batch_size = gy.shape()[2];
+    const int64_t hidden_size = gy.shape()[3];
+    const int64_t gate_size = 4 * hidden_size;
+    const std::vector<uint8_t>& mask = context.mask();
+
+    const chainerx::Array rd = chainerx::AsContiguous(r.At({d}));
+    const chainerx::Array gh = chainerx::Zeros({batch_size, hidden_size}, gy.dtype(), gy.device());
+    const chainerx::Array gc = chainerx::Zeros({batch_size, hidden_size}, gy.dtype(), gy.device());
+    const chainerx::Array ghr = chainerx::Empty({batch_size, hidden_size}, gy.dtype(), gy.device());
+
+    const T* gyp = GetData<T>(gy);
+    const T* gp = GetData<T>(context.gates()) + d * seq_length * batch_size * gate_size;
+    const T* tcp = GetData<T>(context.tanh_c()) + d * seq_length * batch_size * hidden_size;
+    const T* pcp = GetData<T>(context.prev_c()) + d * seq_length * batch_size * hidden_size;
+    T* ghp = GetMutableData<T>(gh);
+    T* gcp = GetMutableData<T>(gc);
+    const T* ghrp = GetData<T>(ghr);
+    T* ggp = GetMutableData<T>(ggates);
+
+    for (int64_t t = seq_length - 1; t >= 0; --t) {
+        const int64_t time = IsReversed(context.direction(), d) ? seq_length - t - 1 : t;
+        const int64_t state_offset = time * batch_size * hidden_size;
+        for (int64_t i = 0; i < batch_size; ++i) {
+            const bool valid = mask.empty() || mask[time * batch_size + i];
+            const T* gyr = gyp + ((time * num_directions + d) * batch_size + i) * hidden_size;
+            const T* gr = gp + (time * batch_size + i) * gate_size;
+            const T* tcr = tcp + state_offset + i * hidden_size;
+            const T* pcr = pcp + state_offset + i * hidden_size;
+            T* ghr_i = ghp + i * hidden_size;
+            T* gcr = gcp + i * hidden_size;
+            T* ggr = ggp + (time * batch_size + i) * gate_size;
+            if (!valid) {
+                // The state is passed through and the output is zero.
+                std::fill(ggr, ggr + gate_size, T(0));
+                continue;
+            }
+            for (int64_t j = 0; j < hidden_size; ++j) {
+                const T ig = gr[j];
+                const T og = gr[hidden_size + j];
+                const T fg = gr[2 * hidden_size + j];
+                const T cg = gr[3 * hidden_size + j];
+                const T tc = tcr[j];
+                const T gnh = gyr[j] + ghr_i[j];
+                const T gnc = gcr[j] + gnh * og * (1 - tc * tc);
+                ggr[j] = gnc * cg * ig * (1 - ig);
+                ggr[hidden_size + j] = gnh * tc * og * (1 - og);
+                ggr[2 * hidden_size + j] = gnc * pcr[j] * fg * (1 - fg);
+                ggr[3 * hidden_size + j] = gnc * ig * (1 - cg * cg);
+                gcr[j] = gnc * fg;
+                ghr_i[j] = 0;
+            }
+        }
+
+        // The gradient of the previous hidden state through R.
+        const chainerx::Array gg = ggates.At({chainerx::Slice(time * batch_size, (time + 1) * batch_size)});
+        DotInto(gg, rd, ghr);
+        for (int64_t k = 0; k < batch_size * hidden_size; ++k) {
+            ghp[k] += ghrp[k];
+        }
+    }
+}
+
+// Runs GRU for a direction and stores outputs to `y` and `y_h`.
+template <typename T>
+void RunGRUDirection(
+        const chainerx::Array& x,
+        const chainerx::Array& w,
+        const chainerx::Array& r,
+        const nonstd::optional<chainerx::Array>& b,
+        const nonstd::optional<chainerx::Array>& initial_h,
+        const std::vector<uint8_t>& mask,
+        bool linear_before_reset,
+        int direction,
+        int d,
+        const chainerx::Array& y,
+        const chainerx::Array& y_h) {
+    const int64_t seq_length = x.shape()[0];
+    const int64_t batch_size = x.shape()[1];
+    const int64_t num_directions = w.shape()[0];
+    const int64_t hidden_size = r.shape()[2];
+    const int64_t gate_size = 3 * hidden_size;
+
+    const chainerx::Array xw = ProjectInputs(x, w.At({d}));
+    const chainerx::Array rs = r.At({d});
+    // With `linear_before_reset`, all gates are multiplied by R at
+    // once. Otherwise, the hidden gate is multiplied after the reset.
+    const int64_t hr_size = linear_before_reset ? gate_size : 2 * hidden_size;
+    const chainerx::Array rt = chainerx::AsContiguous(chainerx::Transpose(rs.At({chainerx::Slice(0, hr_size)})));
+    const chainerx::Array rt_h = chainerx::AsContiguous(chainerx::Transpose(rs.At({chainerx::Slice(2 * hidden_size, gate_size)})));
+    chainerx::Array wb = chainerx::Zeros({gate_size}, x.dtype(), x.device());
+    chainerx::Array rb = chainerx::Zeros({gate_size}, x.dtype(), x.device());
+    if (b.has_value()) {
+        chainerx::Array bs = b->At({d});
+        wb = chainerx::AsContiguous(bs.At({chainerx::Slice(0, gate_size)}));
+        rb = chainerx::AsContiguous(bs.At({chainerx::Slice(gate_size, 2 * gate_size)}));
+    }
+    const chainerx::Array h = GetInitialState(initial_h, d, batch_size, hidden_size, x);
+    const chainerx::Array hr = chainerx::Empty({batch_size, hr_size}, x.dtype(), x.device());
+    const chainerx::Array z = chainerx::Empty({batch_size, hidden_size}, x.dtype(), x.device());
+    const chainerx::Array rh = chainerx::Empty({batch_size, hidden_size}, x.dtype(), x.device());
+    const chainerx::Array rhr = chainerx::Empty({batch_size, hidden_size}, x.dtype(), x.device());
+
+    const T* xwp = GetData<T>(xw);
+    const T* wbp = GetData<T>(wb);
+    const T* rbp = GetData<T>(rb);
+    const T* hrp = GetData<T>(hr);
+    const T* rhrp = GetData<T>(rhr);
+    T* hp = GetMutableData<T>(h);
+    T* zp = GetMutableData<T>(z);
+    T* rhp = GetMutableData<T>(rh);
+    T* yp = GetMutableData<T>(y);
+
+    for (int64_t t = 0; t < seq_length; ++t) {
+        const int64_t time = IsReversed(direction, d) ? seq_length - t - 1 : t;
+        DotInto(h, rt, hr);
+
+        // The update gate, and the reset gate applied to the hidden
+        // state or its projection.
+        for (int64_t i = 0; i < batch_size; ++i) {
+            const T* xwr = xwp + (time * batch_size + i) * gate_size;
+            const T* hrr = hrp + i * hr_size;
+            const T* hr_i = hp + i * hidden_size;
+            T* zr = zp + i * hidden_size;
+            T* rhr_i = rhp + i * hidden_size;
+            for (int64_t j = 0; j < hidden_size; ++j) {
+                zr[j] = Sigmoid(xwr[j] + hrr[j] + wbp[j] + rbp[j]);
+                const T rg = Sigmoid(xwr[hidden_size + j] + hrr[hidden_size + j] + wbp[hidden_size + j] + rbp[hidden_size + j]);
+                const int64_t k = 2 * hidden_size + j;
+                rhr_i[j] = linear_before_reset ? rg * (hrr[k] + rbp[k]) : rg * hr_i[j];
+            }
+        }
+        if (!linear_before_reset) DotInto(rh, rt_h, rhr);
+
+        for (int64_t i = 0; i < batch_size; ++i) {
+            const bool valid = mask.empty() || mask[time * batch_size + i];
+            const T* xwr = xwp + (time * batch_size + i) * gate_size;
+            const T* zr = zp + i * hidden_size;
+            const T* rhr_i = (linear_before_reset ? rhp : rhrp) + i * hidden_size;
+            T* hr_i = hp + i * hidden_size;
+            T* yr = yp + ((time * num_directions + d) * batch_size + i) * hidden_size;
+            for (int64_t j = 0; j < hidden_size; ++j) {
+                const int64_t k = 2 * hidden_size + j;
+                const T nh = std::tanh(xwr[k] + wbp[k] + rhr_i[j] + (linear_before_reset ? 0 : rbp[k]));
+                if (valid) {
+                    hr_i[j] = (1 - zr[j]) * nh + zr[j] * hr_i[j];
+                    yr[j] = hr_i[j];
+                } else {
+                    yr[j] = 0;
+                }
+            }
+        }
+    }
+
+    std::copy(hp, hp + batch_size * hidden_size, GetMutableData<T>(y_h) + d * batch_size * hidden_size);
+}
+
+}  // namespace
+
+bool NativeLSTM(
+        ChxVMState* st,
+        const chainerx::Array& x,
+        const chainerx::Array& w,
+        const chainerx::Array& r,
+        const nonstd::optional<chainerx::Array>& b,
+        const nonstd::optional<chainerx::Array>& sequence_lens,
+        const nonstd::optional<chainerx::Array>& initial_h,
+        const nonstd::optional<chainerx::Array>& initial_c,
+        const nonstd::optional<chainerx::Array>& p,
+        int direction,
+        std::tuple<chainerx::Array, chainerx::Array, chainerx::Array, ChxVMOpaque*>* result) {
+    // Peepholes are left to the ChainerX implementation.
+    if (p.has_value()) return false;
+    std::vector<const chainerx::Array*> arrays = {&x, &w, &r};
+    for (const nonstd::optional<chainerx::Array>* a : {&b, &initial_h, &initial_c}) {
+        if (a->has_value()) arrays.push_back(&**a);
+    }
+    if (!IsSupported(arrays)) return false;
+
+    const int64_t seq_length = x.shape()[0];
+    const int64_t batch_size = x.shape()[1];
+    const int num_directions = w.shape()[0];
+    CHECK_EQ(0, w.shape()[1] % 4);
+    const int64_t hidden_size = w.shape()[1] / 4;
+    CHECK_EQ(4 * hidden_size, r.shape()[1]);
+    CHECK_EQ(hidden_size, r.shape()[2]);
+    if (b.has_value()) CHECK_EQ(8 * hidden_size, b->shape()[1]);
+    CHECK_EQ(direction == 2 ? 2 : 1, num_directions);
+
+    const std::vector<uint8_t> mask = GetSequenceMask(sequence_lens, seq_length, batch_size);
+    const chainerx::Dtype dtype = x.dtype();
+    chainerx::Device& device = x.device();
+    chainerx::Array xc = chainerx::AsContiguous(x);
+    chainerx::Array y = chainerx::Empty({seq_length, num_directions, batch_size, hidden_size}, dtype, device);
+    chainerx::Array y_h = chainerx::Empty({num_directions, batch_size, hidden_size}, dtype, device);
+    chainerx::Array y_c = chainerx::Empty({num_directions, batch_size, hidden_size}, dtype, device);
+    chainerx::Array gates = chainerx::Empty({num_directions, seq_length, batch_size, 4 * hidden_size}, dtype, device);
+    chainerx::Array tanh_c = chainerx::Empty({num_directions, seq_length, batch_size, hidden_size}, dtype, device);
+    chainerx::Array prev_h = chainerx::Empty({num_directions, seq_length, batch_size, hidden_size}, dtype, device);
+    chainerx::Array prev_c = chainerx::Empty({num_directions, seq_length, batch_size, hidden_size}, dtype, device);
+
+    // The two directions of a bidirectional LSTM are independent.
+    ParallelFor(0, num_directions, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t d = begin; d < end; ++d) {
+            if (dtype == chainerx::Dtype::kFloat32) {
+                RunLSTMDirection<float>(
+                        xc, w, r, b, initial_h, initial_c, mask, direction, d, y, y_h, y_c, gates, tanh_c, prev_h, prev_c);
+            } else {
+                RunLSTMDirection<double>(
+                        xc, w, r, b, initial_h, initial_c, mask, direction, d, y, y_h, y_c, gates, tanh_c, prev_h, prev_c);
+            }
+        }
+    });
+
+    ChxVMOpaque* context = new NativeLSTMContext(
+            xc, w, r, gates, tanh_c, prev_h, prev_c, mask, direction, st->options().dump_memory_usage);
+    *result = std::make_tuple(y, y_h, y_c, context);
+    return true;
+}
+
+bool NativeLSTMGrad(
+        const chainerx::Array& gy,
+        const ChxVMOpaque& ctx,
+        std::tuple<chainerx::Array, chainerx::Array, chainerx::Array, chainerx::Array>* result) {
+    if (!dynamic_cast<const NativeLSTMContext*>(&ctx)) return false;
+    auto& context = dynamic_cast<const NativeLSTMContext&>(ctx);
+    const chainerx::Array& x = context.x();
+    const chainerx::Array& w = context.w();
+    CHECK(IsSupported({&gy, &x}));
+
+    const int64_t seq_length = gy.shape()[0];
+    const int num_directions = gy.shape()[1];
+    const int64_t batch_size = gy.shape()[2];
+    const int64_t hidden_size = gy.shape()[3];
+    const chainerx::Array gyc = chainerx::AsContiguous(gy);
+    const chainerx::Array x2d = chainerx::Reshape(x, {seq_length * batch_size, x.shape()[2]});
+
+    std::vector<chainerx::Array> gxs(num_directions);
+    std::vector<chainerx::Array> gws(num_directions);
+    std::vector<chainerx::Array> grs(num_directions);
+    std::vector<chainerx::Array> gbs(num_directions);
+    ParallelFor(0, num_directions, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t d = begin; d < end; ++d) {
+            chainerx::Array ggates = chainerx::Empty({seq_length * batch_size, 4 * hidden_size}, gy.dtype(), gy.device());
+            if (gy.dtype() == chainerx::Dtype::kFloat32) {
+                RunLSTMGradDirection<float>(context, gyc, d, ggates);
+            } else {
+                RunLSTMGradDirection<double>(context, gyc, d, ggates);
+            }
+
+            // Gradients of parameters are reduced over all time steps
+            // by matrix multiplications.
+            const chainerx::Array prev_h = chainerx::Reshape(context.prev_h().At({d}), {seq_length * batch_size, hidden_size});
+            const chainerx::Array ggates_t = chainerx::Transpose(ggates);
+            gxs[d] = chainerx::Dot(ggates, w.At({d}));
+            gws[d] = chainerx::Dot(ggates_t, x2d);
+            grs[d] = chainerx::Dot(ggates_t, prev_h);
+            const chainerx::Array gb = chainerx::Sum(ggates, chainerx::Axes{0});
+            // The bias of W and R get the same gradient.
+            gbs[d] = chainerx::Concatenate({gb, gb}, 0);
+        }
+    });
+
+    chainerx::Array gx = gxs[0];
+    for (int d = 1; d < num_directions; ++d) gx = gx + gxs[d];
+    gx = chainerx::Reshape(gx, x.shape());
+    *result = std::make_tuple(gx, chainerx::Stack(gws, 0), chainerx::Stack(grs, 0), chainerx::Stack(gbs, 0));
+    return true;
+}
+
+bool NativeGRU(
+        const chainerx::Array& x,
+        const chainerx::Array& w,
+        const chainerx::Array& r,
+        const nonstd::optional<chainerx::Array>& b,
+        const nonstd::optional<chainerx::Array>& sequence_lens,
+        const nonstd::optional<chainerx::Array>& initial_h,
+        bool linear_before_reset,
+        int direction,
+        std::tuple<chainerx::Array, chainerx::Array>* result) {
+    std::vector<const chainerx::Array*> arrays = {&x, &w, &r};
+    for (const nonstd::optional<chainerx::Array>* a : {&b, &initial_h}) {
+        if (a->has_value()) arrays.push_back(&**a);
+    }
+    if (!IsSupported(arrays)) return false;
+
+    const int64_t seq_length = x.shape()[0];
+    const int64_t batch_size = x.shape()[1];
+    const int num_directions = w.shape()[0];
+    CHECK_EQ(0, w.shape()[1] % 3);
+    const int64_t hidden_size = w.shape()[1] / 3;
+    CHECK_EQ(3 * hidden_size, r.shape()[1]);
+    CHECK_EQ(hidden_size, r.shape()[2]);
+    if (b.has_value()) CHECK_EQ(6 * hidden_size, b->shape()[1]);
+    CHECK_EQ(direction == 2 ? 2 : 1, num_directions);
+
+    const std::vector<uint8_t> mask = GetSequenceMask(sequence_lens, seq_length, batch_size);
+    const chainerx::Dtype dtype = x.dtype();
+    chainerx::Array xc = chainerx::AsContiguous(x);
+    chainerx::Array y = chainerx::Empty({seq_length, num_directions, batch_size, hidden_size}, dtype, x.device());
+    chainerx::Array y_h = chainerx::Empty({num_directions, batch_size, hidden_size}, dtype, x.device());
+
+    // The two directions of a bidirectional GRU are independent.
+    ParallelFor(0, num_directions, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t d = begin; d < end; ++d) {
+            if (dtype == chainerx::Dtype::kFloat32) {
+                RunGRUDirection<float>(xc, w, r, b, initial_h, mask, linear_before_reset, direction, d, y, y_h);
+            } else {
+                RunGRUDirection<double>(xc, w, r, b, initial_h, mask, linear_before_reset, direction, d, y, y_h);
+            }
+        }
+    });
+
+    *result = std::make_tuple(y, y_h);
+    return true;
+}
+
+}  // namespace runtime
+}  // namespace chainer_compiler
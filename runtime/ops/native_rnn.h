@@ -0,0 +1,42 @@
+#include <chainerx/array.h>
+
+namespace chainer_compiler {
+namespace runtime {
+
+// LSTM and GRU on the native device. The projection of inputs is
+// computed for all time steps by a single matrix multiplication, and
+// gates of each time step are computed in a single pass after the
+// multiplication of the hidden state. They return false for
+// unsupported inputs.
+
+bool NativeLSTM(
+        ChxVMState* st,
+        const chainerx::Array& x,
+        const chainerx::Array& w,
+        const chainerx::Array& r,
+        const nonstd::optional<chainerx::Array>& b,
+        const nonstd::optional<chainerx::Array>& sequence_lens,
+        const nonstd::optional<chainerx::Array>& initial_h,
+        const nonstd::optional<chainerx::Array>& initial_c,
+        const nonstd::optional<chainerx::Array>& p,
+        int direction,
+        std::tuple<chainerx::Array, chainerx::Array, chainerx::Array, ChxVMOpaque*>* result);
+
+bool NativeLSTMGrad(
+        const chainerx::Array& gy,
+        const ChxVMOpaque& ctx,
+        std::tuple<chainerx::Array, chainerx::Array, chainerx::Array, chainerx::Array>* result);
+
+bool NativeGRU(
+        const chainerx::Array& x,
+        const chainerx::Array& w,
+        const chainerx::Array& r,
+        const nonstd::optional<chainerx::Array>& b,
+        const nonstd::optional<chainerx::Array>& sequence_lens,
+        const nonstd::optional<chainerx::Array>& initial_h,
+        bool linear_before_reset,
+        int direction,
+        std::tuple<chainerx::Array, chainerx::Array>* result);
+
+}  // namespace runtime
+}  // namespace chainer_compiler
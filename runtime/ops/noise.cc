@@ -1,17 +1,72 @@
+#include <algorithm>
+#include <cmath>
+
+#include <chainerx/native/native_backend.h>
 #include <chainerx/routines/creation.h>
+#include <chainerx/routines/manipulation.h>
 
 #include <common/log.h>
 #include <runtime/chainerx_util.h>
+#include <runtime/chxvm_state.h>
 #include <runtime/gen_chxvm_ops.h>
+#include <runtime/parallel_for.h>
+#include <runtime/random.h>
 
 namespace chainer_compiler {
 namespace runtime {
 
+namespace {
+
+// Keeps elements whose random numbers are not less than `threshold`,
+// writing the output and the mask in a single pass. Only the mask is
+// written when `x` is null.
+template <typename T>
+void DropoutNative(const PhiloxRandom& random, uint64_t threshold, int64_t size, const T* x, T* y, T* m) {
+    constexpr int64_t kGrainSize = 16384;
+    ParallelFor(0, size, kGrainSize, [&random, threshold, x, y, m](int64_t begin, int64_t end) {
+        constexpr int64_t kBlockSize = 256;
+        uint32_t bits[kBlockSize];
+        for (int64_t i = begin; i < end; i += kBlockSize) {
+            const int64_t n = std::min(kBlockSize, end - i);
+            random.Fill(i, n, bits);
+            for (int64_t j = 0; j < n; ++j) {
+                const T keep = bits[j] >= threshold;
+                if (x) y[i + j] = x[i + j] * keep;
+                m[i + j] = keep;
+            }
+        }
+    });
+}
+
+}  // namespace
+
 std::tuple<chainerx::Array, chainerx::Array> DropoutOp::RunImpl(ChxVMState* st, const chainerx::Array& data) {
     if (st->is_training()) {
-        WARN_ONCE("Dropout for training is slow.");
-        chainerx::Array rnd = SlowRandom(data.shape());
-        chainerx::Array mask = CastTo(rnd > MakeScalarArray(ratio), data.dtype());
+        const PhiloxRandom random(st->random_seed(), st->NextRandomStream(*this));
+        const chainerx::Dtype dtype = data.dtype();
+        // An element is kept when a uniform random number in [0, 1) is
+        // not less than `ratio`.
+        const uint64_t threshold = static_cast<uint64_t>(std::ceil(std::max(0.0f, std::min(1.0f, ratio)) * 4294967296.0));
+        if (IsNativeDevice(&data.device()) && (dtype == chainerx::Dtype::kFloat32 || dtype == chainerx::Dtype::kFloat64)) {
+            chainerx::Array x = chainerx::AsContiguous(data);
+            nonstd::optional<chainerx::Array> out = st->GetReusableOutput(*this, 0, 0, x);
+            if (!out.has_value()) out = st->AllocateOutput(*this, 0, x.shape(), dtype, x.device());
+            chainerx::Array mask = st->AllocateOutput(*this, 1, x.shape(), dtype, x.device());
+            const int64_t size = x.GetTotalSize();
+            if (dtype == chainerx::Dtype::kFloat32) {
+                DropoutNative<float>(random, threshold, size, GetData<float>(x), GetMutableData<float>(*out), GetMutableData<float>(mask));
+            } else {
+                DropoutNative<double>(
+                        random, threshold, size, GetData<double>(x), GetMutableData<double>(*out), GetMutableData<double>(mask));
+            }
+            return std::tuple<chainerx::Array, chainerx::Array>{*out, mask};
+        }
+
+        // Other dtypes and devices use the same mask, which is made on
+        // the host and copied.
+        chainerx::Array host_mask = chainerx::Empty(data.shape(), chainerx::Dtype::kFloat32, chainerx::GetNativeBackend().GetDevice(0));
+        DropoutNative<float>(random, threshold, host_mask.GetTotalSize(), nullptr, nullptr, GetMutableData<float>(host_mask));
+        chainerx::Array mask = CastTo(host_mask, dtype).ToDevice(data.device());
         chainerx::Array out = data * mask;
         return std::tuple<chainerx::Array, chainerx::Array>{out, mask};
     } else {
@@ -1,19 +1,26 @@
 #include <math.h>
 
 #include <algorithm>
+#include <limits>
+#include <memory>
 #include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include <chainerx/float16.h>
 #include <chainerx/kernels/pooling.h>
 #include <chainerx/routines/creation.h>
 #include <chainerx/routines/manipulation.h>
 #include <chainerx/routines/math.h>
 #include <chainerx/routines/pooling.h>
-#include <chainerx/routines/statistics.h>
+#include <chainerx/routines/reduction.h>
 
 #include <common/log.h>
 #include <runtime/chainerx_util.h>
 #include <runtime/chxvm_state.h>
 #include <runtime/gen_chxvm_ops.h>
+#include <runtime/parallel_for.h>
 
 namespace chainer_compiler {
 namespace runtime {
@@ -90,409 +97,499 @@ chainerx::Array AveragePoolGradOp::RunImpl(ChxVMState* st, const chainerx::Array
             gy, kernel_shape, context.strides(), context.pads(), pad_mode, context.state(), nonstd::nullopt);
 }
 
-// A faithful re-implementation of Chainer's ROI ops.
+// ROI ops compatible with Chainer's `roi_*_pooling_2d` and
+// `roi_*_align_2d`. Kernels read the feature map in NHWC so the
+// innermost loops run over contiguous channels. Forward kernels are
+// split by ROIs. Gradients of overlapping ROIs are accumulated to the
+// same pixels, so backward kernels are split by channels instead.
 // TODO(hamaji): Move this to ChainerX.
 namespace {
 
-chainerx::Slice ROIPoolingSlice(double size, double stride, double max_size, double roi_offset) {
-    int64_t start = int64_t(floor(size * stride));
-    int64_t end = int64_t(ceil((size + 1) * stride));
-    start = std::min<double>(std::max<double>(start + roi_offset, 0), max_size);
-    end = std::min<double>(std::max<double>(end + roi_offset, 0), max_size);
-    return chainerx::Slice(start, end);
-}
-
-template <class ReduceFn>
-chainerx::Array ROIPool2D(
-        const chainerx::Array& bottom_data,
-        const chainerx::Array& bottom_rois,
-        const chainerx::Array& bottom_roi_indices,
-        const Int64StackVector& output_shape,
-        const float spatial_scale,
-        ReduceFn fn) {
-    CHECK_EQ(4, bottom_data.ndim());
-    CHECK_EQ(2, output_shape.size());
-    const int64_t channels = bottom_data.shape()[1];
-    const int64_t height = bottom_data.shape()[2];
-    const int64_t width = bottom_data.shape()[3];
-    const int64_t n_rois = bottom_rois.shape()[0];
-    const int64_t outh = output_shape[0];
-    const int64_t outw = output_shape[1];
-    chainerx::Array top_data = chainerx::Zeros(chainerx::Shape{n_rois, channels, outh, outw}, bottom_rois.dtype());
-
-    for (int64_t i_roi = 0; i_roi < n_rois; ++i_roi) {
-        int64_t idx = int64_t(chainerx::AsScalar(bottom_roi_indices.At({i_roi})));
-        int64_t ymin = round(double(chainerx::AsScalar(bottom_rois.At({i_roi, 0})) * spatial_scale));
-        int64_t xmin = round(double(chainerx::AsScalar(bottom_rois.At({i_roi, 1})) * spatial_scale));
-        int64_t ymax = round(double(chainerx::AsScalar(bottom_rois.At({i_roi, 2})) * spatial_scale));
-        int64_t xmax = round(double(chainerx::AsScalar(bottom_rois.At({i_roi, 3})) * spatial_scale));
-        int64_t roi_height = std::max<int64_t>(ymax - ymin, 1);
-        int64_t roi_width = std::max<int64_t>(xmax - xmin, 1);
-        double strideh = 1. * roi_height / outh;
-        double stridew = 1. * roi_width / outw;
-
-        for (int64_t outy = 0; outy < outh; ++outy) {
-            const chainerx::Slice& sliceh = ROIPoolingSlice(outy, strideh, height, ymin);
-            if (sliceh.stop() <= sliceh.start()) {
-                continue;
-            }
-
-            for (int64_t outx = 0; outx < outw; ++outx) {
-                const chainerx::Slice& slicew = ROIPoolingSlice(outx, stridew, width, xmin);
-                if (slicew.stop() <= slicew.start()) {
-                    continue;
-                }
-
-                chainerx::Array roi_data = bottom_data.At({idx, chainerx::Slice(), sliceh, slicew}).Reshape({channels, -1});
-                top_data.At({i_roi, chainerx::Slice(), outy, outx}) += fn(roi_data, 1, false);
+// Transposes [outer, a, b] to [outer, b, a].
+template <typename T>
+void TransposeLastTwoAxes(const T* src, T* dst, int64_t outer, int64_t a, int64_t b) {
+    const int64_t grain_size = std::max<int64_t>(1, 16384 / a);
+    ParallelFor(0, outer * b, grain_size, [=](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+            const T* sp = src + i / b * a * b + i % b;
+            T* dp = dst + i * a;
+            for (int64_t k = 0; k < a; ++k) {
+                dp[k] = sp[k * b];
             }
         }
-    }
-
-    return top_data;
-}
-
-nonstd::optional<std::tuple<double, int64_t, int64_t>> get_bounds(double p, int64_t limit) {
-    if (p < -1 || limit < p) {
-        return nonstd::nullopt;
-    }
-    if (p < 0.0) {
-        p = 0.0;
-    }
-    int64_t low = static_cast<int64_t>(p);
-    int64_t high;
-    if (limit - 1 <= low) {
-        p = high = low = limit - 1;
-    } else {
-        high = low + 1;
-    }
-    return nonstd::make_optional(std::make_tuple(p, low, high));
+    });
 }
 
-using ArrayIndices = chainerx::StackVector<int64_t, chainerx::kMaxNdim>;
-template <typename T>
-T& ContiguousArrayAt(chainerx::Array& a, const ArrayIndices& indices) {
-    assert(a.IsContiguous());
-    assert(a.shape().size() == indices.size());
-    assert(a.dtype() == chainerx::PrimitiveType<T>::kDtype);
-    int64_t index = indices.back();
-    int64_t stride = 1;
-    for (int64_t i = indices.size() - 2; i >= 0; --i) {
-        stride *= a.shape()[i + 1];
-        index += indices[i] * stride;
+// ROIs in (ymin, xmin, ymax, xmax) and their batch indices.
+struct ROIs {
+    ROIs(const chainerx::Array& rois, const chainerx::Array& roi_indices, int64_t batch_size) : size(rois.shape()[0]) {
+        CHECK_EQ(2, rois.ndim());
+        CHECK_EQ(4, rois.shape()[1]);
+        CHECK_EQ(1, roi_indices.ndim());
+        CHECK_EQ(size, roi_indices.shape()[0]);
+        chainerx::Array b = chainerx::AsContiguous(rois.ToNative().AsType(chainerx::Dtype::kFloat64));
+        chainerx::Array i = chainerx::AsContiguous(roi_indices.ToNative().AsType(chainerx::Dtype::kInt64));
+        boxes.assign(GetData<double>(b), GetData<double>(b) + size * 4);
+        indices.assign(GetData<int64_t>(i), GetData<int64_t>(i) + size);
+        for (int64_t index : indices) {
+            CHECK_LE(0, index);
+            CHECK_LT(index, batch_size);
+        }
     }
-    assert(index < a.GetTotalSize());
-    return *(static_cast<T*>(a.raw_data()) + index);
-}
-
-template <typename T>
-T ContiguousArrayAt(const chainerx::Array& a, const ArrayIndices& indices) {
-    return ContiguousArrayAt<T>(const_cast<chainerx::Array&>(a), indices);
-}
 
-bool is_roi_covered_by_bottom_data(
-        double roi_start_h, double roi_start_w, double roi_end_h, double roi_end_w, int64_t height, int64_t width) {
-    auto is_p_covered = [](double start_p, double end_p, int64_t limit) {
-        return 0.0 < start_p && static_cast<int64_t>(end_p) < (limit - 1);
-    };
-    return is_p_covered(roi_start_h, roi_end_h, height) && is_p_covered(roi_start_w, roi_end_w, width);
-}
+    int64_t size;
+    std::vector<double> boxes;
+    std::vector<int64_t> indices;
+};
 
-template <class ReduceMode>
-class ROIAlign2DImpl {
-public:
-    ROIAlign2DImpl(
-            const chainerx::Array& bottom_data,
-            const chainerx::Array& bottom_rois,
-            const chainerx::Array& bottom_roi_indices,
+struct ROIParams {
+    ROIParams(
+            const chainerx::Shape& x_shape,
             const Int64StackVector& output_shape,
-            const float spatial_scale0,
-            const chainerx::StackVector<int64_t, chainerx::kMaxNdim>& sampling_ratio)
-        : spatial_scale(spatial_scale0),
-          channels(bottom_data.shape()[1]),
-          height(bottom_data.shape()[2]),
-          width(bottom_data.shape()[3]),
-          n_rois(bottom_rois.shape()[0]),
+            float spatial_scale,
+            const Int64StackVector& sampling_ratio = Int64StackVector{1, 1})
+        : batch_size(x_shape[0]),
+          channels(x_shape[1]),
+          height(x_shape[2]),
+          width(x_shape[3]),
           pooled_height(output_shape[0]),
           pooled_width(output_shape[1]),
-          roi_bin_grid_h(sampling_ratio[0]),
-          roi_bin_grid_w(sampling_ratio[1]) {
-        contiguous_bottom_data = chainerx::AsContiguous(bottom_data);
-        contiguous_bottom_roi_indices = chainerx::AsContiguous(bottom_roi_indices);
-        contiguous_bottom_rois = chainerx::AsContiguous(bottom_rois);
-        top_data = chainerx::Empty(chainerx::Shape{n_rois, channels, pooled_height, pooled_width}, bottom_data.dtype());
-        bottom_ptr = static_cast<float*>(contiguous_bottom_data.raw_data());
-        top_ptr = static_cast<float*>(top_data.raw_data());
-    }
-
-    chainerx::Array Run() {
-        if (n_rois < 20) {
-            for (int64_t n = 0; n < n_rois; ++n) {
-                RunROI(n);
-            }
-        } else {
-#if CHAINER_COMPILER_ENABLE_OPENMP
-#pragma omp parallel for
-#endif
-            for (int64_t n = 0; n < n_rois; ++n) {
-                RunROI(n);
-            }
-        }
-        return top_data;
+          spatial_scale(spatial_scale),
+          grid_h(sampling_ratio[0]),
+          grid_w(sampling_ratio[1]) {
+        CHECK_EQ(4, x_shape.size());
+        CHECK_EQ(2, output_shape.size());
+        CHECK_EQ(2, sampling_ratio.size());
+        CHECK_LT(0, grid_h);
+        CHECK_LT(0, grid_w);
     }
 
-private:
-    struct PixelPos {
-        double p;
-        int64_t p_low, p_high;
-        double lp() const {
-            return p - p_low;
-        }
-        double hp() const {
-            return 1.0 - lp();
-        }
-        bool IsInvalid() const {
-            return p_low < 0;
-        }
-    };
+    int64_t num_bins() const {
+        return pooled_height * pooled_width;
+    }
 
-    struct PixelWeight {
-        double w1, w2, w3, w4;
-    };
+    const int64_t batch_size;
+    const int64_t channels;
+    const int64_t height;
+    const int64_t width;
+    const int64_t pooled_height;
+    const int64_t pooled_width;
+    const float spatial_scale;
+    const int64_t grid_h;
+    const int64_t grid_w;
+};
 
-    void RunROI(int n) {
-        std::vector<PixelWeight> pixel_weights(pooled_height * pooled_width * roi_bin_grid_h * roi_bin_grid_w);
-        std::vector<PixelPos> pixel_x(pooled_width * roi_bin_grid_w);
-        std::vector<PixelPos> pixel_y(pooled_height * roi_bin_grid_h);
-
-        int64_t roi_batch_ind = ContiguousArrayAt<int32_t>(contiguous_bottom_roi_indices, {n});
-        double roi_start_h = ContiguousArrayAt<float>(contiguous_bottom_rois, {n, 0}) * spatial_scale;
-        double roi_start_w = ContiguousArrayAt<float>(contiguous_bottom_rois, {n, 1}) * spatial_scale;
-        double roi_end_h = ContiguousArrayAt<float>(contiguous_bottom_rois, {n, 2}) * spatial_scale;
-        double roi_end_w = ContiguousArrayAt<float>(contiguous_bottom_rois, {n, 3}) * spatial_scale;
-
-        double roi_height = std::max<double>(roi_end_h - roi_start_h, 1.);
-        double roi_width = std::max<double>(roi_end_w - roi_start_w, 1.);
-        double bin_size_h = roi_height / pooled_height;
-        double bin_size_w = roi_width / pooled_width;
-
-        const float* bottom_base = &bottom_ptr[roi_batch_ind * channels * height * width];
-        float* top_base = &top_ptr[n * channels * pooled_height * pooled_width];
-        if (is_roi_covered_by_bottom_data(roi_start_h, roi_start_w, roi_end_h, roi_end_w, height, width)) {
-            FillPixelPositions(roi_start_h, bin_size_h, pooled_height, roi_bin_grid_h, &pixel_y);
-            FillPixelPositions(roi_start_w, bin_size_w, pooled_width, roi_bin_grid_w, &pixel_x);
-            FillPixelWeights(pixel_x, pixel_y, &pixel_weights);
-            if (roi_bin_grid_h == 2 && roi_bin_grid_w == 2) {
-                CalculateOutput<false, 2>(pixel_weights, pixel_x, pixel_y, bottom_base, top_base);
-            } else {
-                CalculateOutput<false, 0>(pixel_weights, pixel_x, pixel_y, bottom_base, top_base);
+// The pixels [begin, end) of each bin of ROIPool along an axis.
+std::vector<std::pair<int64_t, int64_t>> ROIPoolRanges(
+        double roi_min, double roi_max, double spatial_scale, int64_t pooled, int64_t limit) {
+    const int64_t roi_start = std::round(roi_min * spatial_scale);
+    const int64_t roi_end = std::round(roi_max * spatial_scale);
+    const double stride = 1. * std::max<int64_t>(roi_end - roi_start, 1) / pooled;
+    std::vector<std::pair<int64_t, int64_t>> ranges(pooled);
+    for (int64_t i = 0; i < pooled; ++i) {
+        const int64_t begin = std::floor(i * stride) + roi_start;
+        const int64_t end = std::ceil((i + 1) * stride) + roi_start;
+        ranges[i].first = std::min(std::max<int64_t>(begin, 0), limit);
+        ranges[i].second = std::min(std::max<int64_t>(end, 0), limit);
+    }
+    return ranges;
+}
+
+// A sampling point of ROIAlign along an axis, which is interpolated
+// from pixels `low` and `high` by `1 - weight` and `weight`. `low` is
+// negative if the point is out of the feature map.
+struct ROIAlignPoint {
+    int64_t low;
+    int64_t high;
+    double weight;
+};
+
+std::vector<ROIAlignPoint> ROIAlignPoints(
+        double roi_min, double roi_max, double spatial_scale, int64_t pooled, int64_t grid, int64_t limit) {
+    const double roi_start = roi_min * spatial_scale;
+    const double bin_size = std::max(roi_max * spatial_scale - roi_start, 1.) / pooled;
+    std::vector<ROIAlignPoint> points(pooled * grid);
+    for (int64_t i = 0; i < pooled; ++i) {
+        for (int64_t j = 0; j < grid; ++j) {
+            ROIAlignPoint* pt = &points[i * grid + j];
+            double p = roi_start + i * bin_size + (j + 0.5) * bin_size / grid;
+            if (p < -1 || limit < p) {
+                *pt = ROIAlignPoint{-1, -1, 0};
+                continue;
             }
-        } else {
-            FillPixelPositionsBounded(roi_start_h, bin_size_h, pooled_height, roi_bin_grid_h, height, &pixel_y);
-            FillPixelPositionsBounded(roi_start_w, bin_size_w, pooled_width, roi_bin_grid_w, width, &pixel_x);
-            FillPixelWeights(pixel_x, pixel_y, &pixel_weights);
-            if (roi_bin_grid_h == 2 && roi_bin_grid_w == 2) {
-                CalculateOutput<true, 2>(pixel_weights, pixel_x, pixel_y, bottom_base, top_base);
+            p = std::max(p, 0.);
+            pt->low = static_cast<int64_t>(p);
+            if (limit - 1 <= pt->low) {
+                pt->low = pt->high = limit - 1;
+                pt->weight = 0;
             } else {
-                CalculateOutput<true, 0>(pixel_weights, pixel_x, pixel_y, bottom_base, top_base);
+                pt->high = pt->low + 1;
+                pt->weight = p - pt->low;
             }
         }
     }
+    return points;
+}
 
-    void FillPixelPositions(
-            double roi_start, double bin_size_w, int64_t pooled_width, int64_t roi_bin_grid_w, std::vector<PixelPos>* positions) {
-        for (int64_t px = 0; px < pooled_width; ++px) {
-            for (int64_t ix = 0; ix < roi_bin_grid_w; ++ix) {
-                PixelPos* pp = &(*positions)[px * roi_bin_grid_w + ix];
-                pp->p = roi_start + px * bin_size_w + (ix + 0.5) * bin_size_w / roi_bin_grid_w;
-                pp->p_low = static_cast<int64_t>(pp->p);
-                pp->p_high = pp->p_low + 1;
-            }
+// Writes `out` of an ROI in [bins, channels] to `y` in [channels, bins].
+template <typename T>
+void StoreROIOutput(const std::vector<T>& out, int64_t num_bins, int64_t channels, T* y) {
+    for (int64_t c = 0; c < channels; ++c) {
+        for (int64_t bin = 0; bin < num_bins; ++bin) {
+            y[c * num_bins + bin] = out[bin * channels + c];
         }
     }
+}
 
-    void FillPixelPositionsBounded(
-            double roi_start,
-            double bin_size_w,
-            int64_t pooled_width,
-            int64_t roi_bin_grid_w,
-            int64_t width,
-            std::vector<PixelPos>* positions) {
-        for (int64_t px = 0; px < pooled_width; ++px) {
-            for (int64_t ix = 0; ix < roi_bin_grid_w; ++ix) {
-                PixelPos* pp = &(*positions)[px * roi_bin_grid_w + ix];
-                double x = roi_start + px * bin_size_w + (ix + 0.5) * bin_size_w / roi_bin_grid_w;
-                auto bounds = get_bounds(x, width);
-                if (bounds) {
-                    std::tie(pp->p, pp->p_low, pp->p_high) = *bounds;
-                } else {
-                    pp->p_low = -1;
+// `x` is NHWC. `y` is [rois, channels, bins]. `argmax` is [rois, bins,
+// channels] and has the pixel of the maximum in an image.
+template <typename T, bool is_max>
+void ROIPool2DKernel(const ROIParams& p, const ROIs& rois, const T* x, T* y, int32_t* argmax) {
+    const int64_t channels = p.channels;
+    const int64_t num_bins = p.num_bins();
+    ParallelFor(0, rois.size, 1, [&p, &rois, x, y, argmax, channels, num_bins](int64_t begin, int64_t end) {
+        std::vector<T> out(num_bins * channels);
+        for (int64_t r = begin; r < end; ++r) {
+            const double* box = &rois.boxes[r * 4];
+            const auto ys = ROIPoolRanges(box[0], box[2], p.spatial_scale, p.pooled_height, p.height);
+            const auto xs = ROIPoolRanges(box[1], box[3], p.spatial_scale, p.pooled_width, p.width);
+            const T* image = x + rois.indices[r] * p.height * p.width * channels;
+            for (int64_t ph = 0; ph < p.pooled_height; ++ph) {
+                for (int64_t pw = 0; pw < p.pooled_width; ++pw) {
+                    const int64_t bin = ph * p.pooled_width + pw;
+                    T* o = &out[bin * channels];
+                    int32_t* a = is_max ? argmax + (r * num_bins + bin) * channels : nullptr;
+                    const int64_t count = (ys[ph].second - ys[ph].first) * (xs[pw].second - xs[pw].first);
+                    if (count <= 0) {
+                        std::fill(o, o + channels, T(0));
+                        if (is_max) std::fill(a, a + channels, -1);
+                        continue;
+                    }
+                    std::fill(o, o + channels, is_max ? -std::numeric_limits<T>::infinity() : T(0));
+                    if (is_max) std::fill(a, a + channels, -1);
+                    for (int64_t iy = ys[ph].first; iy < ys[ph].second; ++iy) {
+                        for (int64_t ix = xs[pw].first; ix < xs[pw].second; ++ix) {
+                            const int32_t pixel = iy * p.width + ix;
+                            const T* v = image + pixel * channels;
+                            for (int64_t c = 0; c < channels; ++c) {
+                                if (is_max) {
+                                    if (o[c] < v[c]) {
+                                        o[c] = v[c];
+                                        a[c] = pixel;
+                                    }
+                                } else {
+                                    o[c] += v[c];
+                                }
+                            }
+                        }
+                    }
+                    if (!is_max) {
+                        const T inv_count = T(1) / count;
+                        for (int64_t c = 0; c < channels; ++c) {
+                            o[c] *= inv_count;
+                        }
+                    }
                 }
             }
+            StoreROIOutput(out, num_bins, channels, y + r * channels * num_bins);
         }
-    }
+    });
+}
 
-    void FillPixelWeights(
-            const std::vector<PixelPos>& pixel_x, const std::vector<PixelPos>& pixel_y, std::vector<PixelWeight>* pixel_weights) {
-        for (int64_t ph = 0; ph < pooled_height; ++ph) {
-            for (int64_t iy = 0; iy < roi_bin_grid_h; ++iy) {
-                const PixelPos& py = pixel_y[ph * roi_bin_grid_h + iy];
-                double ly = py.lp();
-                double hy = py.hp();
-                for (int64_t pw = 0; pw < pooled_width; ++pw) {
-                    for (int64_t ix = 0; ix < roi_bin_grid_w; ++ix) {
-                        const PixelPos& px = pixel_x[pw * roi_bin_grid_w + ix];
-                        double lx = px.lp();
-                        double hx = px.hp();
-                        double w1 = hy * hx;
-                        double w2 = hy * lx;
-                        double w3 = ly * hx;
-                        double w4 = ly * lx;
-
-                        PixelWeight* weights = &(*pixel_weights)[((ph * pooled_width + pw) * roi_bin_grid_h + iy) * roi_bin_grid_w + ix];
-                        weights->w1 = w1;
-                        weights->w2 = w2;
-                        weights->w3 = w3;
-                        weights->w4 = w4;
+// `gy` is [rois, bins, channels]. `gx` is NHWC filled with zeros.
+template <typename T, bool is_max>
+void ROIPool2DGradKernel(const ROIParams& p, const ROIs& rois, const T* gy, const int32_t* argmax, T* gx) {
+    std::vector<std::vector<std::pair<int64_t, int64_t>>> all_ys, all_xs;
+    for (int64_t r = 0; r < rois.size; ++r) {
+        const double* box = &rois.boxes[r * 4];
+        all_ys.push_back(ROIPoolRanges(box[0], box[2], p.spatial_scale, p.pooled_height, p.height));
+        all_xs.push_back(ROIPoolRanges(box[1], box[3], p.spatial_scale, p.pooled_width, p.width));
+    }
+    const int64_t channels = p.channels;
+    const int64_t num_bins = p.num_bins();
+    constexpr int64_t kChannelGrainSize = 16;
+    ParallelFor(0, channels, kChannelGrainSize, [&](int64_t begin, int64_t end) {
+        for (int64_t r = 0; r < rois.size; ++r) {
+            const auto& ys = all_ys[r];
+            const auto& xs = all_xs[r];
+            T* image = gx + rois.indices[r] * p.height * p.width * channels;
+            for (int64_t ph = 0; ph < p.pooled_height; ++ph) {
+                for (int64_t pw = 0; pw < p.pooled_width; ++pw) {
+                    const int64_t bin = ph * p.pooled_width + pw;
+                    const T* g = gy + (r * num_bins + bin) * channels;
+                    if (is_max) {
+                        const int32_t* a = argmax + (r * num_bins + bin) * channels;
+                        for (int64_t c = begin; c < end; ++c) {
+                            if (a[c] >= 0) image[a[c] * channels + c] += g[c];
+                        }
+                        continue;
+                    }
+                    const int64_t count = (ys[ph].second - ys[ph].first) * (xs[pw].second - xs[pw].first);
+                    if (count <= 0) continue;
+                    const T inv_count = T(1) / count;
+                    for (int64_t iy = ys[ph].first; iy < ys[ph].second; ++iy) {
+                        for (int64_t ix = xs[pw].first; ix < xs[pw].second; ++ix) {
+                            T* v = image + (iy * p.width + ix) * channels;
+                            for (int64_t c = begin; c < end; ++c) {
+                                v[c] += g[c] * inv_count;
+                            }
+                        }
                     }
                 }
             }
         }
-    }
+    });
+}
 
-    template <bool needs_bounds_check, int static_roi_bin_grid>
-    void CalculateOutput(
-            const std::vector<PixelWeight>& pixel_weights,
-            const std::vector<PixelPos>& pixel_x,
-            const std::vector<PixelPos>& pixel_y,
-            const float* bottom_base,
-            float* top_base) {
-        int64_t rbgh, rbgw;
-        if (static_roi_bin_grid) {
-            rbgh = rbgw = static_roi_bin_grid;
-        } else {
-            rbgh = roi_bin_grid_h;
-            rbgw = roi_bin_grid_w;
-        }
+// Bilinear weights and pixels of a sampling point of ROIAlign.
+template <typename T>
+struct ROIAlignSample {
+    ROIAlignSample(const ROIAlignPoint& py, const ROIAlignPoint& px, int64_t width, int64_t channels)
+        : w1((1 - py.weight) * (1 - px.weight)),
+          w2((1 - py.weight) * px.weight),
+          w3(py.weight * (1 - px.weight)),
+          w4(py.weight * px.weight),
+          o1((py.low * width + px.low) * channels),
+          o2((py.low * width + px.high) * channels),
+          o3((py.high * width + px.low) * channels),
+          o4((py.high * width + px.high) * channels) {
+    }
+
+    const T w1, w2, w3, w4;
+    const int64_t o1, o2, o3, o4;
+};
 
-        ReduceMode reduce(rbgh, rbgw);
-        for (int64_t c = 0; c < channels; ++c) {
-            auto pixel_weights_iterator = pixel_weights.begin();
-            for (int64_t ph = 0; ph < pooled_height; ++ph) {
-                for (int64_t pw = 0; pw < pooled_width; ++pw) {
-                    reduce.Reset();
-                    for (int64_t iy = 0; iy < rbgh; ++iy) {
-                        const PixelPos& py = pixel_y[ph * rbgh + iy];
-                        if (needs_bounds_check && py.IsInvalid()) continue;
-                        const int64_t y_low = py.p_low;
-                        const int64_t y_high = py.p_high;
-                        const float* bottom_low = &bottom_base[y_low * width];
-                        const float* bottom_high = &bottom_base[y_high * width];
-                        for (int64_t ix = 0; ix < rbgw; ++ix, ++pixel_weights_iterator) {
-                            const PixelPos& px = pixel_x[pw * rbgw + ix];
-                            if (needs_bounds_check && px.IsInvalid()) continue;
-                            const int64_t x_low = px.p_low;
-                            const int64_t x_high = px.p_high;
-                            const PixelWeight& weights = *pixel_weights_iterator;
-                            const double w1 = weights.w1;
-                            const double w2 = weights.w2;
-                            const double w3 = weights.w3;
-                            const double w4 = weights.w4;
-
-                            float v1 = bottom_low[x_low];
-                            float v2 = bottom_low[x_high];
-                            float v3 = bottom_high[x_low];
-                            float v4 = bottom_high[x_high];
-
-                            double weighted_average = w1 * v1 + w2 * v2 + w3 * v3 + w4 * v4;
-                            reduce.Reduce(weighted_average);
+// Same as `ROIPool2DKernel`, but `argmax` has the index of the
+// sampling point in a bin.
+template <typename T, bool is_max>
+void ROIAlign2DKernel(const ROIParams& p, const ROIs& rois, const T* x, T* y, int32_t* argmax) {
+    const int64_t channels = p.channels;
+    const int64_t num_bins = p.num_bins();
+    ParallelFor(0, rois.size, 1, [&p, &rois, x, y, argmax, channels, num_bins](int64_t begin, int64_t end) {
+        const T inv_count = T(1) / (p.grid_h * p.grid_w);
+        std::vector<T> out(num_bins * channels);
+        for (int64_t r = begin; r < end; ++r) {
+            const double* box = &rois.boxes[r * 4];
+            const auto ys = ROIAlignPoints(box[0], box[2], p.spatial_scale, p.pooled_height, p.grid_h, p.height);
+            const auto xs = ROIAlignPoints(box[1], box[3], p.spatial_scale, p.pooled_width, p.grid_w, p.width);
+            const T* image = x + rois.indices[r] * p.height * p.width * channels;
+            for (int64_t ph = 0; ph < p.pooled_height; ++ph) {
+                for (int64_t pw = 0; pw < p.pooled_width; ++pw) {
+                    const int64_t bin = ph * p.pooled_width + pw;
+                    T* o = &out[bin * channels];
+                    int32_t* a = is_max ? argmax + (r * num_bins + bin) * channels : nullptr;
+                    std::fill(o, o + channels, is_max ? -std::numeric_limits<T>::infinity() : T(0));
+                    if (is_max) std::fill(a, a + channels, -1);
+                    for (int64_t iy = 0; iy < p.grid_h; ++iy) {
+                        const ROIAlignPoint& py = ys[ph * p.grid_h + iy];
+                        if (py.low < 0) continue;
+                        for (int64_t ix = 0; ix < p.grid_w; ++ix) {
+                            const ROIAlignPoint& px = xs[pw * p.grid_w + ix];
+                            if (px.low < 0) continue;
+                            const ROIAlignSample<T> s(py, px, p.width, channels);
+                            const T* v1 = image + s.o1;
+                            const T* v2 = image + s.o2;
+                            const T* v3 = image + s.o3;
+                            const T* v4 = image + s.o4;
+                            const int32_t index = iy * p.grid_w + ix;
+                            for (int64_t c = 0; c < channels; ++c) {
+                                const T v = s.w1 * v1[c] + s.w2 * v2[c] + s.w3 * v3[c] + s.w4 * v4[c];
+                                if (is_max) {
+                                    if (o[c] < v) {
+                                        o[c] = v;
+                                        a[c] = index;
+                                    }
+                                } else {
+                                    o[c] += v;
+                                }
+                            }
+                        }
+                    }
+                    if (!is_max) {
+                        for (int64_t c = 0; c < channels; ++c) {
+                            o[c] *= inv_count;
                         }
                     }
-                    top_base[ph * pooled_width + pw] = reduce.Finish();
                 }
             }
-            bottom_base += height * width;
-            top_base += pooled_height * pooled_width;
+            StoreROIOutput(out, num_bins, channels, y + r * channels * num_bins);
         }
-    }
-
-    const float spatial_scale;
-    const int64_t channels;
-    const int64_t height;
-    const int64_t width;
-    const int64_t n_rois;
-    const int64_t pooled_height;
-    const int64_t pooled_width;
-    const int64_t roi_bin_grid_h;
-    const int64_t roi_bin_grid_w;
-
-    chainerx::Array contiguous_bottom_data;
-    chainerx::Array contiguous_bottom_roi_indices;
-    chainerx::Array contiguous_bottom_rois;
-    chainerx::Array top_data;
-    const float* bottom_ptr;
-    float* top_ptr;
-};
+    });
+}
 
-template <class ReduceMode>
-chainerx::Array ROIAlign2D(
-        const chainerx::Array& bottom_data,
-        const chainerx::Array& bottom_rois,
-        const chainerx::Array& bottom_roi_indices,
-        const Int64StackVector& output_shape,
-        const float spatial_scale,
-        const chainerx::StackVector<int64_t, chainerx::kMaxNdim>& sampling_ratio) {
-    CHECK_EQ(4, bottom_data.ndim());
-    CHECK_EQ(2, output_shape.size());
-    CHECK_EQ(2, sampling_ratio.size());
-    ROIAlign2DImpl<ReduceMode> impl(bottom_data, bottom_rois, bottom_roi_indices, output_shape, spatial_scale, sampling_ratio);
-    return impl.Run();
+template <typename T, bool is_max>
+void ROIAlign2DGradKernel(const ROIParams& p, const ROIs& rois, const T* gy, const int32_t* argmax, T* gx) {
+    std::vector<std::vector<ROIAlignPoint>> all_ys, all_xs;
+    for (int64_t r = 0; r < rois.size; ++r) {
+        const double* box = &rois.boxes[r * 4];
+        all_ys.push_back(ROIAlignPoints(box[0], box[2], p.spatial_scale, p.pooled_height, p.grid_h, p.height));
+        all_xs.push_back(ROIAlignPoints(box[1], box[3], p.spatial_scale, p.pooled_width, p.grid_w, p.width));
+    }
+    const int64_t channels = p.channels;
+    const int64_t num_bins = p.num_bins();
+    constexpr int64_t kChannelGrainSize = 16;
+    ParallelFor(0, channels, kChannelGrainSize, [&](int64_t begin, int64_t end) {
+        const T inv_count = T(1) / (p.grid_h * p.grid_w);
+        for (int64_t r = 0; r < rois.size; ++r) {
+            const auto& ys = all_ys[r];
+            const auto& xs = all_xs[r];
+            T* image = gx + rois.indices[r] * p.height * p.width * channels;
+            for (int64_t ph = 0; ph < p.pooled_height; ++ph) {
+                for (int64_t pw = 0; pw < p.pooled_width; ++pw) {
+                    const int64_t bin = ph * p.pooled_width + pw;
+                    const T* g = gy + (r * num_bins + bin) * channels;
+                    if (is_max) {
+                        const int32_t* a = argmax + (r * num_bins + bin) * channels;
+                        for (int64_t c = begin; c < end; ++c) {
+                            if (a[c] < 0) continue;
+                            const ROIAlignPoint& py = ys[ph * p.grid_h + a[c] / p.grid_w];
+                            const ROIAlignPoint& px = xs[pw * p.grid_w + a[c] % p.grid_w];
+                            const ROIAlignSample<T> s(py, px, p.width, channels);
+                            image[s.o1 + c] += s.w1 * g[c];
+                            image[s.o2 + c] += s.w2 * g[c];
+                            image[s.o3 + c] += s.w3 * g[c];
+                            image[s.o4 + c] += s.w4 * g[c];
+                        }
+                        continue;
+                    }
+                    for (int64_t iy = 0; iy < p.grid_h; ++iy) {
+                        const ROIAlignPoint& py = ys[ph * p.grid_h + iy];
+                        if (py.low < 0) continue;
+                        for (int64_t ix = 0; ix < p.grid_w; ++ix) {
+                            const ROIAlignPoint& px = xs[pw * p.grid_w + ix];
+                            if (px.low < 0) continue;
+                            const ROIAlignSample<T> s(py, px, p.width, channels);
+                            T* v1 = image + s.o1;
+                            T* v2 = image + s.o2;
+                            T* v3 = image + s.o3;
+                            T* v4 = image + s.o4;
+                            for (int64_t c = begin; c < end; ++c) {
+                                const T gc = g[c] * inv_count;
+                                v1[c] += s.w1 * gc;
+                                v2[c] += s.w2 * gc;
+                                v3[c] += s.w3 * gc;
+                                v4[c] += s.w4 * gc;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    });
 }
 
-class ReduceByMax {
+// Keeps the ROIs and the argmax of a forward ROI op for its gradient.
+class ROIBackwardContext : public ChxVMOpaque {
 public:
-    ReduceByMax(int64_t /*roi_bin_grid_h*/, int64_t /*roi_bin_grid_w*/) {
-        Reset();
+    ROIBackwardContext(const chainerx::Array& x, std::shared_ptr<ROIs> rois, nonstd::optional<chainerx::Array> argmax)
+        : x_shape_(x.shape()), x_dtype_(x.dtype()), x_device_(&x.device()), rois_(rois), argmax_(argmax) {
     }
+    virtual ~ROIBackwardContext() = default;
 
-    void Reset() {
-        max_val_ = std::numeric_limits<double>::lowest();
+    const chainerx::Shape& x_shape() const {
+        return x_shape_;
     }
-
-    void Reduce(double weighted_average) {
-        max_val_ = std::max(max_val_, weighted_average);
+    chainerx::Dtype x_dtype() const {
+        return x_dtype_;
     }
-
-    double Finish() const {
-        return max_val_;
+    chainerx::Device& x_device() const {
+        return *x_device_;
+    }
+    const ROIs& rois() const {
+        return *rois_;
+    }
+    const nonstd::optional<chainerx::Array>& argmax() const {
+        return argmax_;
     }
 
 private:
-    double max_val_;
+    const chainerx::Shape x_shape_;
+    const chainerx::Dtype x_dtype_;
+    chainerx::Device* x_device_;
+    std::shared_ptr<ROIs> rois_;
+    nonstd::optional<chainerx::Array> argmax_;
 };
 
-class ReduceByAverage {
-public:
-    ReduceByAverage(int64_t roi_bin_grid_h, int64_t roi_bin_grid_w) : inv_elems_(1.0 / (roi_bin_grid_h * roi_bin_grid_w)) {
-        Reset();
-    }
+// Kernels compute float16 and other dtypes in float32.
+chainerx::Dtype GetROIComputeDtype(chainerx::Dtype dtype) {
+    return dtype == chainerx::Dtype::kFloat64 ? chainerx::Dtype::kFloat64 : chainerx::Dtype::kFloat32;
+}
 
-    void Reset() {
-        sum_ = 0.0;
+template <typename T, bool is_align, bool is_max>
+void RunROIKernel(const ROIParams& p, const ROIs& rois, const chainerx::Array& x, const chainerx::Array& y, const chainerx::Array& argmax) {
+    chainerx::Array xt = chainerx::Empty({p.batch_size, p.height, p.width, p.channels}, x.dtype(), x.device());
+    TransposeLastTwoAxes(GetData<T>(x), GetMutableData<T>(xt), p.batch_size, p.channels, p.height * p.width);
+    int32_t* a = is_max ? GetMutableData<int32_t>(argmax) : nullptr;
+    if (is_align) {
+        ROIAlign2DKernel<T, is_max>(p, rois, GetData<T>(xt), GetMutableData<T>(y), a);
+    } else {
+        ROIPool2DKernel<T, is_max>(p, rois, GetData<T>(xt), GetMutableData<T>(y), a);
     }
+}
 
-    void Reduce(double weighted_average) {
-        sum_ += weighted_average;
+template <bool is_align, bool is_max>
+std::tuple<chainerx::Array, ChxVMOpaque*> RunROI(
+        ChxVMState* st,
+        const chainerx::Array& x,
+        const chainerx::Array& rois,
+        const chainerx::Array& roi_indices,
+        const ROIParams& p) {
+    auto rs = std::make_shared<ROIs>(rois, roi_indices, p.batch_size);
+    const chainerx::Dtype dtype = GetROIComputeDtype(x.dtype());
+    chainerx::Array xc = chainerx::AsContiguous(x.ToNative().AsType(dtype, false));
+    chainerx::Array y = chainerx::Empty({rs->size, p.channels, p.pooled_height, p.pooled_width}, dtype, xc.device());
+    nonstd::optional<chainerx::Array> argmax;
+    if (is_max) {
+        argmax = chainerx::Empty({rs->size, p.num_bins(), p.channels}, chainerx::Dtype::kInt32, xc.device());
+    }
+    if (dtype == chainerx::Dtype::kFloat32) {
+        RunROIKernel<float, is_align, is_max>(p, *rs, xc, y, is_max ? *argmax : y);
+    } else {
+        RunROIKernel<double, is_align, is_max>(p, *rs, xc, y, is_max ? *argmax : y);
     }
+    ChxVMOpaque* ctx = new ROIBackwardContext(x, rs, argmax);
+    if (st->options().dump_memory_usage && argmax.has_value()) {
+        ctx->SetRetainedArrays({*argmax});
+    }
+    y = y.AsType(x.dtype(), false).ToDevice(x.device());
+    return std::tie(y, ctx);
+}
 
-    double Finish() const {
-        return sum_ * inv_elems_;
+template <typename T, bool is_align, bool is_max>
+void RunROIGradKernel(const ROIParams& p, const ROIBackwardContext& context, const chainerx::Array& gy, const chainerx::Array& gx) {
+    const ROIs& rois = context.rois();
+    chainerx::Array gyt = chainerx::Empty({rois.size, p.num_bins(), p.channels}, gy.dtype(), gy.device());
+    TransposeLastTwoAxes(GetData<T>(gy), GetMutableData<T>(gyt), rois.size, p.channels, p.num_bins());
+    chainerx::Array gxt = chainerx::Zeros({p.batch_size, p.height, p.width, p.channels}, gy.dtype(), gy.device());
+    const int32_t* a = is_max ? GetData<int32_t>(*context.argmax()) : nullptr;
+    if (is_align) {
+        ROIAlign2DGradKernel<T, is_max>(p, rois, GetData<T>(gyt), a, GetMutableData<T>(gxt));
+    } else {
+        ROIPool2DGradKernel<T, is_max>(p, rois, GetData<T>(gyt), a, GetMutableData<T>(gxt));
     }
+    TransposeLastTwoAxes(GetData<T>(gxt), GetMutableData<T>(gx), p.batch_size, p.height * p.width, p.channels);
+}
 
-private:
-    double sum_;
-    double inv_elems_;
-};
+template <bool is_align, bool is_max>
+chainerx::Array RunROIGrad(
+        const chainerx::Array& gy,
+        const ChxVMOpaque& ctx,
+        const Int64StackVector& output_shape,
+        float spatial_scale,
+        const Int64StackVector& sampling_ratio = Int64StackVector{1, 1}) {
+    auto& context = dynamic_cast<const ROIBackwardContext&>(ctx);
+    const ROIParams p(context.x_shape(), output_shape, spatial_scale, sampling_ratio);
+    CHECK_EQ(gy.shape(), (chainerx::Shape{context.rois().size, p.channels, p.pooled_height, p.pooled_width}));
+    const chainerx::Dtype dtype = GetROIComputeDtype(context.x_dtype());
+    chainerx::Array gyc = chainerx::AsContiguous(gy.ToNative().AsType(dtype, false));
+    chainerx::Array gx = chainerx::Empty(context.x_shape(), dtype, gyc.device());
+    if (dtype == chainerx::Dtype::kFloat32) {
+        RunROIGradKernel<float, is_align, is_max>(p, context, gyc, gx);
+    } else {
+        RunROIGradKernel<double, is_align, is_max>(p, context, gyc, gx);
+    }
+    return gx.AsType(context.x_dtype(), false).ToDevice(context.x_device());
+}
 
 void NaiveUpsampleImpl(
         const chainerx::Array& x, const chainerx::Array& y, const std::vector<int64_t>& int_scales, const std::vector<int64_t>& indices) {
@@ -517,96 +614,202 @@ void NaiveUpsample(const chainerx::Array& x, const chainerx::Array& y, const std
     NaiveUpsampleImpl(x, y, int_scales, {});
 }
 
-template <int static_xy_scale>
-void Upsample2D32bitForRawPtr(
-        float* dst,
-        const float* src,
-        int64_t batch_size,
-        int64_t num_channels,
-        int64_t height,
-        int64_t width,
-        int64_t y_scale,
-        int64_t x_scale) {
-    if (static_xy_scale) {
-        y_scale = x_scale = static_xy_scale;
-    }
-    const int64_t dst_height = height * y_scale;
+// Nearest neighbor upsampling of [num_planes, height, width] by
+// integer scales. Each input row is expanded once and copied to
+// `y_scale` output rows. Values are copied by `T` of the same size as
+// the element type.
+template <typename T, int static_x_scale>
+void UpsampleNearest2D(const T* src, T* dst, int64_t num_planes, int64_t height, int64_t width, int64_t y_scale, int64_t x_scale) {
+    if (static_x_scale) x_scale = static_x_scale;
     const int64_t dst_width = width * x_scale;
-    const int64_t pitch = dst_height * dst_width;
-    for (int64_t b = 0; b < batch_size; ++b) {
-        for (int64_t c = 0; c < num_channels; ++c) {
-            const int64_t dst_base = (b * num_channels + c) * pitch;
-            for (int64_t y = 0; y < height; ++y) {
+    const int64_t grain_size = std::max<int64_t>(1, 16384 / (dst_width * y_scale));
+    ParallelFor(0, num_planes * height, grain_size, [=](int64_t begin, int64_t end) {
+        for (int64_t row = begin; row < end; ++row) {
+            const T* sp = src + row * width;
+            T* dp = dst + row * y_scale * dst_width;
+            for (int64_t x = 0; x < width; ++x) {
+                for (int64_t xi = 0; xi < x_scale; ++xi) {
+                    dp[x * x_scale + xi] = sp[x];
+                }
+            }
+            for (int64_t yi = 1; yi < y_scale; ++yi) {
+                std::copy(dp, dp + dst_width, dp + yi * dst_width);
+            }
+        }
+    });
+}
+
+// The gradient of `UpsampleNearest2D`, which sums each `y_scale` x
+// `x_scale` block of `gy`.
+template <typename T, typename Acc, int static_x_scale>
+void UpsampleNearest2DGrad(const T* gy, T* gx, int64_t num_planes, int64_t height, int64_t width, int64_t y_scale, int64_t x_scale) {
+    if (static_x_scale) x_scale = static_x_scale;
+    const int64_t dst_width = width * x_scale;
+    const int64_t grain_size = std::max<int64_t>(1, 16384 / (dst_width * y_scale));
+    ParallelFor(0, num_planes * height, grain_size, [=](int64_t begin, int64_t end) {
+        std::vector<Acc> sum(width);
+        for (int64_t row = begin; row < end; ++row) {
+            std::fill(sum.begin(), sum.end(), Acc(0));
+            for (int64_t yi = 0; yi < y_scale; ++yi) {
+                const T* gp = gy + (row * y_scale + yi) * dst_width;
                 for (int64_t x = 0; x < width; ++x) {
-                    float v = *src++;
-                    for (int64_t yi = 0; yi < y_scale; ++yi) {
-                        const int64_t dst_y = y * y_scale + yi;
-                        for (int64_t xi = 0; xi < x_scale; ++xi) {
-                            const int64_t dst_x = x * x_scale + xi;
-                            const int64_t dst_index = dst_base + dst_y * dst_width + dst_x;
-                            dst[dst_index] = v;
-                        }
+                    for (int64_t xi = 0; xi < x_scale; ++xi) {
+                        sum[x] += static_cast<Acc>(gp[x * x_scale + xi]);
                     }
                 }
             }
+            T* gp = gx + row * width;
+            for (int64_t x = 0; x < width; ++x) {
+                gp[x] = static_cast<T>(sum[x]);
+            }
         }
+    });
+}
+
+// Dispatches `UpsampleNearest2D` by the element size. `x_scale` of 2
+// is the most common and specialized.
+void RunUpsampleNearest2D(const chainerx::Array& x, const chainerx::Array& y, int64_t y_scale, int64_t x_scale) {
+    const int64_t num_planes = x.shape()[0] * x.shape()[1];
+    const int64_t height = x.shape()[2];
+    const int64_t width = x.shape()[3];
+    auto run = [&](auto* src, auto* dst) {
+        using T = typename std::remove_pointer<decltype(dst)>::type;
+        if (x_scale == 2) {
+            UpsampleNearest2D<T, 2>(src, dst, num_planes, height, width, y_scale, x_scale);
+        } else {
+            UpsampleNearest2D<T, 0>(src, dst, num_planes, height, width, y_scale, x_scale);
+        }
+    };
+    switch (x.GetItemSize()) {
+        case 1:
+            run(GetData<uint8_t>(x), GetMutableData<uint8_t>(y));
+            break;
+        case 2:
+            run(GetData<uint16_t>(x), GetMutableData<uint16_t>(y));
+            break;
+        case 4:
+            run(GetData<uint32_t>(x), GetMutableData<uint32_t>(y));
+            break;
+        case 8:
+            run(GetData<uint64_t>(x), GetMutableData<uint64_t>(y));
+            break;
+        default:
+            CHECK(false) << x.dtype();
     }
 }
 
-chainerx::Array Upsample2D32bitForCPU(chainerx::Array x, const chainerx::Shape& to_shape, const std::vector<int64_t>& int_scales) {
-    x = chainerx::AsContiguous(x);
-    chainerx::Array y = chainerx::Empty(to_shape, x.dtype(), x.device());
-    if (int_scales[2] == 2 && int_scales[3] == 2) {
-        Upsample2D32bitForRawPtr<2>(
-                reinterpret_cast<float*>(y.raw_data()),
-                reinterpret_cast<float*>(x.raw_data()),
-                x.shape()[0],
-                x.shape()[1],
-                x.shape()[2],
-                x.shape()[3],
-                -1,
-                -1);
+template <typename T, typename Acc>
+void RunUpsampleNearest2DGrad(const chainerx::Array& gy, const chainerx::Array& gx, int64_t y_scale, int64_t x_scale) {
+    const int64_t num_planes = gx.shape()[0] * gx.shape()[1];
+    const int64_t height = gx.shape()[2];
+    const int64_t width = gx.shape()[3];
+    if (x_scale == 2) {
+        UpsampleNearest2DGrad<T, Acc, 2>(GetData<T>(gy), GetMutableData<T>(gx), num_planes, height, width, y_scale, x_scale);
     } else {
-        Upsample2D32bitForRawPtr<0>(
-                reinterpret_cast<float*>(y.raw_data()),
-                reinterpret_cast<float*>(x.raw_data()),
-                x.shape()[0],
-                x.shape()[1],
-                x.shape()[2],
-                x.shape()[3],
-                int_scales[2],
-                int_scales[3]);
+        UpsampleNearest2DGrad<T, Acc, 0>(GetData<T>(gy), GetMutableData<T>(gx), num_planes, height, width, y_scale, x_scale);
     }
-    return y;
 }
 
-}  // namespace
-
-chainerx::Array ROIMaxPool2DOp::RunImpl(
-        ChxVMState* st, const chainerx::Array& x, const chainerx::Array& rois, const chainerx::Array& roi_indices) {
-    CHECK(!IsCudaDevice(&x.device())) << "Not implemented";
-    return ROIPool2D(x, rois, roi_indices, output_shape, spatial_scale, chainerx::AMax);
-}
+// Coefficients of the linear interpolation along an axis with aligned
+// corners: the `i`-th output is `(1 - weight[i]) * src[index0[i]] +
+// weight[i] * src[index1[i]]`.
+template <typename Acc>
+struct LinearTable {
+    LinearTable(int64_t src_size, int64_t dst_size) : index0(dst_size), index1(dst_size), weight(dst_size) {
+        for (int64_t i = 0; i < dst_size; ++i) {
+            const double v = dst_size > 1 ? static_cast<double>(i) * (src_size - 1) / (dst_size - 1) : 0;
+            index0[i] = std::min<int64_t>(v, std::max<int64_t>(src_size - 2, 0));
+            index1[i] = std::min<int64_t>(index0[i] + 1, src_size - 1);
+            weight[i] = v - index0[i];
+        }
+    }
 
-chainerx::Array ROIAveragePool2DOp::RunImpl(
-        ChxVMState* st, const chainerx::Array& x, const chainerx::Array& rois, const chainerx::Array& roi_indices) {
-    CHECK(!IsCudaDevice(&x.device())) << "Not implemented";
-    return ROIPool2D(x, rois, roi_indices, output_shape, spatial_scale, chainerx::Mean);
-}
+    std::vector<int64_t> index0;
+    std::vector<int64_t> index1;
+    std::vector<Acc> weight;
+};
 
-chainerx::Array ROIMaxAlign2DOp::RunImpl(
-        ChxVMState* st, const chainerx::Array& x, const chainerx::Array& rois, const chainerx::Array& roi_indices) {
-    CHECK(!IsCudaDevice(&x.device())) << "Not implemented";
-    return ROIAlign2D<ReduceByMax>(x, rois, roi_indices, output_shape, spatial_scale, sampling_ratio);
+// Bilinear resizing of [num_planes, sh, sw] to [num_planes, dh, dw].
+// Each source row used by the output is interpolated horizontally
+// once, and output rows are blended from two of them, which is a
+// contiguous loop.
+template <typename T, typename Acc>
+void ResizeImagesBilinear(const T* src, T* dst, int64_t num_planes, int64_t sh, int64_t sw, int64_t dh, int64_t dw) {
+    const LinearTable<Acc> ys(sh, dh);
+    const LinearTable<Acc> xs(sw, dw);
+    std::vector<uint8_t> used(sh);
+    for (int64_t y = 0; y < dh; ++y) {
+        used[ys.index0[y]] = used[ys.index1[y]] = true;
+    }
+    ParallelFor(0, num_planes, 1, [=, &ys, &xs, &used](int64_t begin, int64_t end) {
+        std::vector<Acc> rows(sh * dw);
+        for (int64_t plane = begin; plane < end; ++plane) {
+            const T* sp = src + plane * sh * sw;
+            T* dp = dst + plane * dh * dw;
+            for (int64_t y = 0; y < sh; ++y) {
+                if (!used[y]) continue;
+                const T* srow = sp + y * sw;
+                Acc* row = &rows[y * dw];
+                for (int64_t x = 0; x < dw; ++x) {
+                    const Acc w = xs.weight[x];
+                    row[x] = (1 - w) * static_cast<Acc>(srow[xs.index0[x]]) + w * static_cast<Acc>(srow[xs.index1[x]]);
+                }
+            }
+            for (int64_t y = 0; y < dh; ++y) {
+                const Acc* r0 = &rows[ys.index0[y] * dw];
+                const Acc* r1 = &rows[ys.index1[y] * dw];
+                const Acc w = ys.weight[y];
+                T* drow = dp + y * dw;
+                for (int64_t x = 0; x < dw; ++x) {
+                    drow[x] = static_cast<T>((1 - w) * r0[x] + w * r1[x]);
+                }
+            }
+        }
+    });
 }
 
-chainerx::Array ROIAverageAlign2DOp::RunImpl(
-        ChxVMState* st, const chainerx::Array& x, const chainerx::Array& rois, const chainerx::Array& roi_indices) {
-    CHECK(!IsCudaDevice(&x.device())) << "Not implemented";
-    return ROIAlign2D<ReduceByAverage>(x, rois, roi_indices, output_shape, spatial_scale, sampling_ratio);
+// The gradient of `ResizeImagesBilinear`, which distributes `gy` in
+// the reverse order: vertically to source rows, and then horizontally.
+template <typename T, typename Acc>
+void ResizeImagesBilinearGrad(const T* gy, T* gx, int64_t num_planes, int64_t sh, int64_t sw, int64_t dh, int64_t dw) {
+    const LinearTable<Acc> ys(sh, dh);
+    const LinearTable<Acc> xs(sw, dw);
+    ParallelFor(0, num_planes, 1, [=, &ys, &xs](int64_t begin, int64_t end) {
+        std::vector<Acc> rows(sh * dw);
+        std::vector<Acc> sum(sw);
+        for (int64_t plane = begin; plane < end; ++plane) {
+            const T* gp = gy + plane * dh * dw;
+            T* gxp = gx + plane * sh * sw;
+            std::fill(rows.begin(), rows.end(), Acc(0));
+            for (int64_t y = 0; y < dh; ++y) {
+                Acc* r0 = &rows[ys.index0[y] * dw];
+                Acc* r1 = &rows[ys.index1[y] * dw];
+                const Acc w = ys.weight[y];
+                const T* grow = gp + y * dw;
+                for (int64_t x = 0; x < dw; ++x) {
+                    const Acc g = static_cast<Acc>(grow[x]);
+                    r0[x] += (1 - w) * g;
+                    r1[x] += w * g;
+                }
+            }
+            for (int64_t y = 0; y < sh; ++y) {
+                const Acc* row = &rows[y * dw];
+                std::fill(sum.begin(), sum.end(), Acc(0));
+                for (int64_t x = 0; x < dw; ++x) {
+                    const Acc w = xs.weight[x];
+                    sum[xs.index0[x]] += (1 - w) * row[x];
+                    sum[xs.index1[x]] += w * row[x];
+                }
+                for (int64_t x = 0; x < sw; ++x) {
+                    gxp[y * sw + x] = static_cast<T>(sum[x]);
+                }
+            }
+        }
+    });
 }
 
-chainerx::Array UpsampleOp::RunImpl(ChxVMState* st, const chainerx::Array& x, const chainerx::Array& scales) {
+// Returns integer scales of Upsample.
+std::vector<int64_t> GetUpsampleScales(const chainerx::Array& scales) {
     CHECK_EQ(1, scales.ndim());
     std::vector<int64_t> int_scales;
     for (int64_t i = 0; i < scales.shape()[0]; ++i) {
@@ -622,20 +825,65 @@ chainerx::Array UpsampleOp::RunImpl(ChxVMState* st, const chainerx::Array& x, co
         CHECK_LE(1, int_scale) << "scales must be greater than or equal to 1: " << scales;
         int_scales.push_back(int_scale);
     }
+    return int_scales;
+}
+
+// True if only the last two axes of NCHW are upsampled.
+bool IsUpsample2D(const std::vector<int64_t>& int_scales) {
+    return int_scales.size() == 4 && int_scales[0] == 1 && int_scales[1] == 1;
+}
+
+}  // namespace
+
+std::tuple<chainerx::Array, ChxVMOpaque*> ROIMaxPool2DOp::RunImpl(
+        ChxVMState* st, const chainerx::Array& x, const chainerx::Array& rois, const chainerx::Array& roi_indices) {
+    return RunROI<false, true>(st, x, rois, roi_indices, ROIParams(x.shape(), output_shape, spatial_scale));
+}
+
+std::tuple<chainerx::Array, ChxVMOpaque*> ROIAveragePool2DOp::RunImpl(
+        ChxVMState* st, const chainerx::Array& x, const chainerx::Array& rois, const chainerx::Array& roi_indices) {
+    return RunROI<false, false>(st, x, rois, roi_indices, ROIParams(x.shape(), output_shape, spatial_scale));
+}
+
+std::tuple<chainerx::Array, ChxVMOpaque*> ROIMaxAlign2DOp::RunImpl(
+        ChxVMState* st, const chainerx::Array& x, const chainerx::Array& rois, const chainerx::Array& roi_indices) {
+    return RunROI<true, true>(st, x, rois, roi_indices, ROIParams(x.shape(), output_shape, spatial_scale, sampling_ratio));
+}
+
+std::tuple<chainerx::Array, ChxVMOpaque*> ROIAverageAlign2DOp::RunImpl(
+        ChxVMState* st, const chainerx::Array& x, const chainerx::Array& rois, const chainerx::Array& roi_indices) {
+    return RunROI<true, false>(st, x, rois, roi_indices, ROIParams(x.shape(), output_shape, spatial_scale, sampling_ratio));
+}
+
+chainerx::Array ROIMaxPool2DGradOp::RunImpl(ChxVMState* st, const chainerx::Array& gy, const ChxVMOpaque& ctx) {
+    return RunROIGrad<false, true>(gy, ctx, output_shape, spatial_scale);
+}
+
+chainerx::Array ROIAveragePool2DGradOp::RunImpl(ChxVMState* st, const chainerx::Array& gy, const ChxVMOpaque& ctx) {
+    return RunROIGrad<false, false>(gy, ctx, output_shape, spatial_scale);
+}
+
+chainerx::Array ROIMaxAlign2DGradOp::RunImpl(ChxVMState* st, const chainerx::Array& gy, const ChxVMOpaque& ctx) {
+    return RunROIGrad<true, true>(gy, ctx, output_shape, spatial_scale, sampling_ratio);
+}
+
+chainerx::Array ROIAverageAlign2DGradOp::RunImpl(ChxVMState* st, const chainerx::Array& gy, const ChxVMOpaque& ctx) {
+    return RunROIGrad<true, false>(gy, ctx, output_shape, spatial_scale, sampling_ratio);
+}
 
+chainerx::Array UpsampleOp::RunImpl(ChxVMState* st, const chainerx::Array& x, const chainerx::Array& scales) {
+    const std::vector<int64_t> int_scales = GetUpsampleScales(scales);
     chainerx::Shape to_shape(x.shape());
+    CHECK_EQ(to_shape.size(), int_scales.size());
     for (size_t i = 0; i < int_scales.size(); ++i) {
         to_shape[i] *= int_scales[i];
     }
 
-    if (int_scales.size() == 4 && int_scales[0] == 1 && int_scales[1] == 1 && x.GetItemSize() == 4) {
-        if (IsNativeDevice(&x.device())) {
-            return Upsample2D32bitForCPU(x, to_shape, int_scales);
-        } else {
-            chainerx::Array x_cpu = x.ToNative();
-            chainerx::Array y = Upsample2D32bitForCPU(x_cpu, to_shape, int_scales);
-            return y.ToDevice(x.device());
-        }
+    if (IsUpsample2D(int_scales)) {
+        chainerx::Array xc = chainerx::AsContiguous(x.ToNative());
+        chainerx::Array y = chainerx::Empty(to_shape, x.dtype(), xc.device());
+        RunUpsampleNearest2D(xc, y, int_scales[2], int_scales[3]);
+        return y.ToDevice(x.device());
     }
 
     chainerx::Array y = chainerx::Zeros(to_shape, x.dtype());
@@ -643,41 +891,44 @@ chainerx::Array UpsampleOp::RunImpl(ChxVMState* st, const chainerx::Array& x, co
     return y;
 }
 
-namespace {
-
-void ResizeImagesFloat32ForCPU(const chainerx::Array& x, const chainerx::Array& y) {
-    const float* src = static_cast<float*>(x.raw_data());
-    float* dst = static_cast<float*>(y.raw_data());
-
-    const int64_t sh = x.shape()[2];
-    const int64_t sw = x.shape()[3];
-    const int64_t dh = y.shape()[2];
-    const int64_t dw = y.shape()[3];
-
-    for (int64_t b = 0; b < x.shape()[0]; ++b) {
-        for (int64_t c = 0; c < x.shape()[1]; ++c) {
-            const float* sp = src + ((b * x.shape()[1]) + c) * sh * sw;
-            for (int64_t yi = 0; yi < dh; ++yi) {
-                const double v = static_cast<double>(yi) * (sh - 1) / (dh - 1);
-                const int v0 = std::min<int>(v, sh - 2);
-                const int v1 = v0 + 1;
-                for (int64_t xi = 0; xi < dw; ++xi) {
-                    const double u = static_cast<double>(xi) * (sw - 1) / (dw - 1);
-                    const int u0 = std::min<int>(u, sw - 2);
-                    const int u1 = u0 + 1;
-                    const double w1 = (u1 - u) * (v1 - v);
-                    const double w2 = (u - u0) * (v1 - v);
-                    const double w3 = (u1 - u) * (v - v0);
-                    const double w4 = (u - u0) * (v - v0);
-                    const float val = (w1 * sp[v0 * sw + u0] + w2 * sp[v0 * sw + u1] + w3 * sp[v1 * sw + u0] + w4 * sp[v1 * sw + u1]);
-                    *dst++ = val;
-                }
-            }
+chainerx::Array UpsampleGradOp::RunImpl(ChxVMState* st, const chainerx::Array& gy, const chainerx::Array& scales) {
+    const std::vector<int64_t> int_scales = GetUpsampleScales(scales);
+    chainerx::Shape shape(gy.shape());
+    CHECK_EQ(shape.size(), int_scales.size());
+    for (size_t i = 0; i < int_scales.size(); ++i) {
+        CHECK_EQ(0, shape[i] % int_scales[i]) << gy.shape() << " " << scales;
+        shape[i] /= int_scales[i];
+    }
+
+    if (IsUpsample2D(int_scales) && IsFloat(gy.dtype())) {
+        chainerx::Array gyc = chainerx::AsContiguous(gy.ToNative());
+        chainerx::Array gx = chainerx::Empty(shape, gy.dtype(), gyc.device());
+        switch (gy.dtype()) {
+            case chainerx::Dtype::kFloat16:
+                RunUpsampleNearest2DGrad<chainerx::Float16, float>(gyc, gx, int_scales[2], int_scales[3]);
+                break;
+            case chainerx::Dtype::kFloat32:
+                RunUpsampleNearest2DGrad<float, float>(gyc, gx, int_scales[2], int_scales[3]);
+                break;
+            case chainerx::Dtype::kFloat64:
+                RunUpsampleNearest2DGrad<double, double>(gyc, gx, int_scales[2], int_scales[3]);
+                break;
+            default:
+                CHECK(false) << gy.dtype();
         }
+        return gx.ToDevice(gy.device());
     }
-}
 
-}  // namespace
+    // Sum each block of `gy` by reducing axes split by scales.
+    chainerx::Shape split_shape;
+    chainerx::Axes axes;
+    for (size_t i = 0; i < int_scales.size(); ++i) {
+        split_shape.push_back(shape[i]);
+        split_shape.push_back(int_scales[i]);
+        axes.push_back(2 * i + 1);
+    }
+    return chainerx::Sum(chainerx::Reshape(gy, split_shape), axes);
+}
 
 chainerx::Array ResizeImagesOp::RunImpl(ChxVMState* st, const chainerx::Array& x) {
     CHECK_EQ(4, x.ndim());
@@ -686,46 +937,57 @@ chainerx::Array ResizeImagesOp::RunImpl(ChxVMState* st, const chainerx::Array& x
     y_shape[2] = output_shape[0];
     y_shape[3] = output_shape[1];
 
-    if (IsNativeDevice(&x.device()) && x.dtype() == chainerx::Dtype::kFloat32) {
-        chainerx::Array xc = chainerx::AsContiguous(x);
-        chainerx::Array y = chainerx::Empty(y_shape, x.dtype());
-        ResizeImagesFloat32ForCPU(xc, y);
-        return y;
-    }
-
-    chainerx::Array y = chainerx::Zeros(y_shape, x.dtype());
-
+    chainerx::Array xc = chainerx::AsContiguous(x.ToNative());
+    // Other dtypes are interpolated in float64.
+    if (!IsFloat(xc.dtype())) xc = xc.AsType(chainerx::Dtype::kFloat64);
+    chainerx::Array y = chainerx::Empty(y_shape, xc.dtype(), xc.device());
+    const int64_t num_planes = x.shape()[0] * x.shape()[1];
     const int64_t sh = x.shape()[2];
     const int64_t sw = x.shape()[3];
-    const int64_t dh = y.shape()[2];
-    const int64_t dw = y.shape()[3];
-
-    for (int64_t b = 0; b < x.shape()[0]; ++b) {
-        for (int64_t c = 0; c < x.shape()[1]; ++c) {
-            for (int64_t yi = 0; yi < y_shape[2]; ++yi) {
-                for (int64_t xi = 0; xi < y_shape[3]; ++xi) {
-                    const double u = static_cast<double>(xi) * (sw - 1) / (dw - 1);
-                    const double v = static_cast<double>(yi) * (sh - 1) / (dh - 1);
-                    const int u0 = std::min<int>(u, sw - 2);
-                    const int v0 = std::min<int>(v, sh - 2);
-                    const int u1 = u0 + 1;
-                    const int v1 = v0 + 1;
-                    const double w1 = (u1 - u) * (v1 - v);
-                    const double w2 = (u - u0) * (v1 - v);
-                    const double w3 = (u1 - u) * (v - v0);
-                    const double w4 = (u - u0) * (v - v0);
-                    const double val =
-                            (w1 * static_cast<double>(chainerx::AsScalar(x.At({b, c, v0, u0}))) +
-                             w2 * static_cast<double>(chainerx::AsScalar(x.At({b, c, v0, u1}))) +
-                             w3 * static_cast<double>(chainerx::AsScalar(x.At({b, c, v1, u0}))) +
-                             w4 * static_cast<double>(chainerx::AsScalar(x.At({b, c, v1, u1}))));
-                    y.At({b, c, yi, xi}) += val;
-                }
-            }
-        }
-    }
+    const int64_t dh = y_shape[2];
+    const int64_t dw = y_shape[3];
+    switch (xc.dtype()) {
+        case chainerx::Dtype::kFloat16:
+            ResizeImagesBilinear<chainerx::Float16, float>(
+                    GetData<chainerx::Float16>(xc), GetMutableData<chainerx::Float16>(y), num_planes, sh, sw, dh, dw);
+            break;
+        case chainerx::Dtype::kFloat32:
+            ResizeImagesBilinear<float, float>(GetData<float>(xc), GetMutableData<float>(y), num_planes, sh, sw, dh, dw);
+            break;
+        case chainerx::Dtype::kFloat64:
+            ResizeImagesBilinear<double, double>(GetData<double>(xc), GetMutableData<double>(y), num_planes, sh, sw, dh, dw);
+            break;
+        default:
+            CHECK(false) << xc.dtype();
+    }
+    return y.AsType(x.dtype()).ToDevice(x.device());
+}
 
-    return y;
+chainerx::Array ResizeImagesGradOp::RunImpl(ChxVMState* st, const chainerx::Array& gy, const chainerx::Shape& shape) {
+    CHECK_EQ(4, gy.ndim());
+    CHECK_EQ(4, shape.size());
+    chainerx::Array gyc = chainerx::AsContiguous(gy.ToNative());
+    chainerx::Array gx = chainerx::Empty(shape, gy.dtype(), gyc.device());
+    const int64_t num_planes = shape[0] * shape[1];
+    const int64_t sh = shape[2];
+    const int64_t sw = shape[3];
+    const int64_t dh = gy.shape()[2];
+    const int64_t dw = gy.shape()[3];
+    switch (gy.dtype()) {
+        case chainerx::Dtype::kFloat16:
+            ResizeImagesBilinearGrad<chainerx::Float16, float>(
+                    GetData<chainerx::Float16>(gyc), GetMutableData<chainerx::Float16>(gx), num_planes, sh, sw, dh, dw);
+            break;
+        case chainerx::Dtype::kFloat32:
+            ResizeImagesBilinearGrad<float, float>(GetData<float>(gyc), GetMutableData<float>(gx), num_planes, sh, sw, dh, dw);
+            break;
+        case chainerx::Dtype::kFloat64:
+            ResizeImagesBilinearGrad<double, double>(GetData<double>(gyc), GetMutableData<double>(gx), num_planes, sh, sw, dh, dw);
+            break;
+        default:
+            CHECK(false) << "ResizeImagesGrad is not supported for " << gy.dtype();
+    }
+    return gx.ToDevice(gy.device());
 }
 
 }  // namespace runtime
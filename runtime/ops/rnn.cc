@@ -11,6 +11,8 @@
 #include <runtime/chainerx_util.h>
 #include <runtime/gen_chxvm_ops.h>
 #include <runtime/ops/cudnn_rnn.h>
+#include <runtime/ops/native_rnn.h>
+#include <runtime/parallel_for.h>
 
 namespace chainer_compiler {
 namespace runtime {
@@ -131,6 +133,11 @@ std::tuple<chainerx::Array, chainerx::Array> GRUOp::RunImpl(
     // W: [num_directions, 3 * hidden_size, input_size]
     // R: [num_directions, 3 * hidden_size, hidden_size]
     // B: [num_directions, 6 * hidden_size]
+    {
+        std::tuple<chainerx::Array, chainerx::Array> result;
+        if (NativeGRU(x, w, r, b, sequence_lens, initial_h, linear_before_reset, direction, &result)) return result;
+    }
+
     int64_t seq_length = x.shape()[0];
     int64_t batch_size = x.shape()[1];
     CHECK_EQ(0, w.shape()[1] % 3);
@@ -150,11 +157,14 @@ std::tuple<chainerx::Array, chainerx::Array> GRUOp::RunImpl(
         WARN_ONCE("Bidirectional GRU has huge error");
     }
 
-    SequenceLengthMask mask(sequence_lens, x.dtype(), seq_length, batch_size);
+    const SequenceLengthMask mask(sequence_lens, x.dtype(), seq_length, batch_size);
     chainerx::Array outputs[2];
     chainerx::Array hs[2];
 
-    for (int d = 0; d < num_direction; ++d) {
+    // The two directions of a bidirectional GRU are independent.
+    auto run_direction = [&](int d) {
+        // `UpdateState` caches the mask of the current time step.
+        SequenceLengthMask dmask(mask);
         chainerx::Array ws = w.At({d});
         chainerx::Array rs = r.At({d});
         chainerx::Array gates_w = chainerx::Transpose(ws.At({chainerx::Slice(0, 2 * hidden_size)}));
@@ -198,13 +208,18 @@ std::tuple<chainerx::Array, chainerx::Array> GRUOp::RunImpl(
             }
             if (b.has_value()) nh += w_bh;
             nh = chainerx::Tanh(nh);
-            mask.UpdateState(time, (1 - z) * nh + z * h, &h);
+            dmask.UpdateState(time, (1 - z) * nh + z * h, &h);
             output.At({time}) += h;
         }
-        mask.MaskOutput(&output);
+        dmask.MaskOutput(&output);
         outputs[d] = output;
         hs[d] = h;
-    }
+    };
+    ParallelFor(0, num_direction, 1, [&run_direction](int64_t begin, int64_t end) {
+        for (int64_t d = begin; d < end; ++d) {
+            run_direction(d);
+        }
+    });
 
     if (num_direction == 1) {
         chainerx::Array output = chainerx::Reshape(outputs[0], {seq_length, 1, batch_size, hidden_size});
@@ -237,6 +252,11 @@ std::tuple<chainerx::Array, chainerx::Array, chainerx::Array, ChxVMOpaque*> LSTM
     }
 #endif  // CHAINER_COMPILER_ENABLE_CUDNN
 
+    {
+        std::tuple<chainerx::Array, chainerx::Array, chainerx::Array, ChxVMOpaque*> result;
+        if (NativeLSTM(st, x, w, r, b, sequence_lens, initial_h, initial_c, p, direction, &result)) return result;
+    }
+
     std::vector<chainerx::Array> xs = {x, w, r};
     if (b.has_value()) xs.push_back(*b);
     std::unique_ptr<BackwardContext> bwd(new BackwardContext("LSTM", xs));
@@ -363,6 +383,11 @@ std::tuple<chainerx::Array, chainerx::Array, chainerx::Array, chainerx::Array> L
     }
 #endif
 
+    {
+        std::tuple<chainerx::Array, chainerx::Array, chainerx::Array, chainerx::Array> result;
+        if (NativeLSTMGrad(gy, ctx, &result)) return result;
+    }
+
     auto& context = dynamic_cast<const BackwardContext&>(ctx);
     chainerx::ForceBackpropModeScope bp_scope{context.backprop_id()};
     std::vector<chainerx::Array> gxs{context.Backward({gy})};
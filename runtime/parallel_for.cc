@@ -0,0 +1,207 @@
+#include "runtime/parallel_for.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <chainerx/backprop_mode.h>
+#include <chainerx/context.h>
+#include <chainerx/device.h>
+
+#include <common/log.h>
+
+namespace chainer_compiler {
+namespace runtime {
+namespace {
+
+std::atomic<int> g_num_threads{1};
+
+// Set by `IntraOpThreadsScope`. 0 means `g_num_threads` is used.
+thread_local int g_scoped_num_threads = 0;
+thread_local bool g_in_parallel_for = false;
+
+// A loop dispatched by `ParallelFor`. Chunks are taken by the calling
+// thread and by up to `max_helpers` workers.
+struct Loop {
+    const std::function<void(int64_t, int64_t)>* fn;
+    std::atomic<int64_t> next;
+    int64_t end;
+    int64_t chunk_size;
+    chainerx::Context* context;
+    chainerx::Device* device;
+    int max_helpers;
+
+    // Guarded by `LoopQueue::mu_`.
+    int num_joined{0};
+    int num_running{0};
+
+    std::atomic<bool> failed{false};
+    std::mutex error_mu;
+    std::exception_ptr error;
+
+    void RunChunks() {
+        while (!failed) {
+            const int64_t chunk_begin = next.fetch_add(chunk_size);
+            if (chunk_begin >= end) break;
+            try {
+                (*fn)(chunk_begin, std::min(end, chunk_begin + chunk_size));
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mu);
+                if (!error) error = std::current_exception();
+                failed = true;
+            }
+        }
+    }
+};
+
+// Worker threads shared by the whole process. Unlike `ThreadPool`,
+// loops of different callers are accepted at the same time: each idle
+// worker joins the oldest loop which still wants helpers.
+class LoopQueue {
+public:
+    int num_threads() const {
+        return num_threads_;
+    }
+
+    // Grows the workers to `num_threads` - 1. Workers are never
+    // removed as other threads may expect them.
+    void Reserve(int num_threads) {
+        if (num_threads_ >= num_threads) return;
+        std::lock_guard<std::mutex> lock(mu_);
+        while (static_cast<int>(workers_.size()) + 1 < num_threads) {
+            workers_.emplace_back([this]() { WorkerLoop(); });
+        }
+        num_threads_ = std::max<int>(num_threads_, workers_.size() + 1);
+    }
+
+    // Runs `loop` on the calling thread and idle workers, and returns
+    // after all of them leave it.
+    void Run(Loop* loop) {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            loops_.push_back(loop);
+        }
+        start_cv_.notify_all();
+
+        loop->RunChunks();
+
+        std::unique_lock<std::mutex> lock(mu_);
+        auto found = std::find(loops_.begin(), loops_.end(), loop);
+        if (found != loops_.end()) loops_.erase(found);
+        done_cv_.wait(lock, [loop]() { return loop->num_running == 0; });
+    }
+
+private:
+    void WorkerLoop() {
+        while (true) {
+            Loop* loop;
+            {
+                std::unique_lock<std::mutex> lock(mu_);
+                start_cv_.wait(lock, [this]() { return !loops_.empty(); });
+                loop = loops_.front();
+                ++loop->num_running;
+                if (++loop->num_joined == loop->max_helpers) loops_.pop_front();
+            }
+
+            {
+                // Default context, device, and backprop mode are thread
+                // local.
+                chainerx::ContextScope context_scope(*loop->context);
+                chainerx::DeviceScope device_scope(*loop->device);
+                chainerx::NoBackpropModeScope no_backprop;
+                g_in_parallel_for = true;
+                loop->RunChunks();
+                g_in_parallel_for = false;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mu_);
+                --loop->num_running;
+            }
+            done_cv_.notify_all();
+        }
+    }
+
+    std::mutex mu_;
+    std::atomic<int> num_threads_{1};
+    std::vector<std::thread> workers_;
+    std::deque<Loop*> loops_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+};
+
+// Never destroyed, as workers may still wait for loops at exit.
+LoopQueue* GetLoopQueue() {
+    static LoopQueue* queue = new LoopQueue();
+    return queue;
+}
+
+}  // namespace
+
+void SetNumIntraOpThreads(int num_threads) {
+    CHECK_LT(0, num_threads);
+    GetLoopQueue()->Reserve(num_threads);
+    g_num_threads = num_threads;
+}
+
+int GetNumIntraOpThreads() {
+    return g_scoped_num_threads ? g_scoped_num_threads : g_num_threads.load();
+}
+
+IntraOpThreadsScope::IntraOpThreadsScope(int num_threads) : saved_num_threads_(g_scoped_num_threads) {
+    CHECK_LT(0, num_threads);
+    GetLoopQueue()->Reserve(num_threads);
+    g_scoped_num_threads = num_threads;
+}
+
+IntraOpThreadsScope::~IntraOpThreadsScope() {
+    g_scoped_num_threads = saved_num_threads_;
+}
+
+void ParallelFor(int64_t begin, int64_t end, int64_t grain_size, const std::function<void(int64_t, int64_t)>& fn) {
+    if (begin >= end) return;
+    grain_size = std::max<int64_t>(grain_size, 1);
+    const int64_t size = end - begin;
+    const int max_threads = GetNumIntraOpThreads();
+    if (size <= grain_size || g_in_parallel_for || max_threads == 1) {
+        fn(begin, end);
+        return;
+    }
+
+    // The workers may be more than the number requested by this
+    // thread. A few chunks per thread balance the load without making
+    // chunks too small.
+    LoopQueue* queue = GetLoopQueue();
+    const int num_threads = std::min(max_threads, queue->num_threads());
+    const int64_t chunk_size = std::max(grain_size, (size + num_threads * 4 - 1) / (num_threads * 4));
+    const int64_t num_chunks = (size + chunk_size - 1) / chunk_size;
+    if (num_threads == 1 || num_chunks == 1) {
+        fn(begin, end);
+        return;
+    }
+
+    Loop loop;
+    loop.fn = &fn;
+    loop.next = begin;
+    loop.end = end;
+    loop.chunk_size = chunk_size;
+    loop.context = &chainerx::GetDefaultContext();
+    loop.device = &chainerx::GetDefaultDevice();
+    loop.max_helpers = std::min<int64_t>(num_threads - 1, num_chunks - 1);
+    g_in_parallel_for = true;
+    queue->Run(&loop);
+    g_in_parallel_for = false;
+
+    if (loop.error) {
+        std::rethrow_exception(loop.error);
+    }
+}
+
+}  // namespace runtime
+}  // namespace chainer_compiler
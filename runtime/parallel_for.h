@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+
+namespace chainer_compiler {
+namespace runtime {
+
+// Sets the number of threads used by `ParallelFor` on threads without
+// an `IntraOpThreadsScope`. The worker threads are shared by the whole
+// process and are added on demand but never removed. 1 disables
+// intra-op parallelism.
+void SetNumIntraOpThreads(int num_threads);
+
+// Returns the number of threads `ParallelFor` uses on this thread.
+int GetNumIntraOpThreads();
+
+// Overrides the number of threads used by `ParallelFor` on the current
+// thread while alive, so runs with different `ChxVMOptions` do not
+// change each other's setting.
+class IntraOpThreadsScope {
+public:
+    explicit IntraOpThreadsScope(int num_threads);
+    ~IntraOpThreadsScope();
+
+private:
+    IntraOpThreadsScope(const IntraOpThreadsScope&) = delete;
+    IntraOpThreadsScope& operator=(const IntraOpThreadsScope&) = delete;
+
+    int saved_num_threads_;
+};
+
+// Splits [begin, end) into chunks of at least `grain_size` iterations
+// and calls `fn(chunk_begin, chunk_end)` for them concurrently. `fn`
+// must not depend on the order of chunks. The calling thread takes
+// chunks too, so the loop also proceeds when all workers are busy.
+// Loops of different threads (e.g., concurrently running ops of the
+// inter-op executor or of other sessions) share the workers: each idle
+// worker helps the oldest loop which has fewer helpers than it asked
+// for. The loop runs inline when the range is small or when it is
+// nested in another `ParallelFor`.
+void ParallelFor(int64_t begin, int64_t end, int64_t grain_size, const std::function<void(int64_t, int64_t)>& fn);
+
+}  // namespace runtime
+}  // namespace chainer_compiler
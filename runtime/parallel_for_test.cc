@@ -0,0 +1,151 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <chainerx/context.h>
+#include <chainerx/testing/context_session.h>
+
+#include <runtime/parallel_for.h>
+
+namespace chainer_compiler {
+namespace runtime {
+namespace {
+
+TEST(ParallelForTest, VisitAll) {
+    chainerx::testing::ContextSession sess;
+    SetNumIntraOpThreads(4);
+
+    for (int64_t grain_size : {1, 7, 1000, 2000}) {
+        std::vector<int> visited(1000);
+        ParallelFor(0, visited.size(), grain_size, [&visited](int64_t begin, int64_t end) {
+            EXPECT_LT(begin, end);
+            for (int64_t i = begin; i < end; ++i) {
+                ++visited[i];
+            }
+        });
+        for (int v : visited) {
+            EXPECT_EQ(1, v);
+        }
+    }
+
+    // Empty range.
+    ParallelFor(3, 3, 1, [](int64_t begin, int64_t end) { FAIL(); });
+
+    SetNumIntraOpThreads(1);
+}
+
+TEST(ParallelForTest, Nested) {
+    chainerx::testing::ContextSession sess;
+    SetNumIntraOpThreads(4);
+
+    std::atomic<int64_t> sum{0};
+    ParallelFor(0, 10, 1, [&sum](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+            ParallelFor(0, 10, 1, [&sum, i](int64_t b, int64_t e) {
+                for (int64_t j = b; j < e; ++j) sum += i * 10 + j;
+            });
+        }
+    });
+    EXPECT_EQ(99 * 100 / 2, sum);
+
+    SetNumIntraOpThreads(1);
+}
+
+TEST(ParallelForTest, Exception) {
+    chainerx::testing::ContextSession sess;
+    SetNumIntraOpThreads(4);
+
+    EXPECT_THROW(ParallelFor(0, 100, 1, [](int64_t begin, int64_t end) {
+                     if (begin <= 50 && 50 < end) throw std::runtime_error("error");
+                 }),
+                 std::runtime_error);
+
+    SetNumIntraOpThreads(1);
+}
+
+TEST(ParallelForTest, Scope) {
+    chainerx::testing::ContextSession sess;
+    EXPECT_EQ(1, GetNumIntraOpThreads());
+
+    {
+        IntraOpThreadsScope scope(3);
+        EXPECT_EQ(3, GetNumIntraOpThreads());
+
+        std::mutex mu;
+        std::set<std::thread::id> thread_ids;
+        std::vector<int> visited(1000);
+        ParallelFor(0, visited.size(), 1, [&](int64_t begin, int64_t end) {
+            for (int64_t i = begin; i < end; ++i) {
+                ++visited[i];
+            }
+            std::lock_guard<std::mutex> lock(mu);
+            thread_ids.insert(std::this_thread::get_id());
+        });
+        for (int v : visited) {
+            EXPECT_EQ(1, v);
+        }
+        EXPECT_GE(3, thread_ids.size());
+
+        {
+            IntraOpThreadsScope inner(1);
+            EXPECT_EQ(1, GetNumIntraOpThreads());
+        }
+        EXPECT_EQ(3, GetNumIntraOpThreads());
+
+        // Other threads are not affected.
+        std::thread th([]() { EXPECT_EQ(1, GetNumIntraOpThreads()); });
+        th.join();
+    }
+    EXPECT_EQ(1, GetNumIntraOpThreads());
+}
+
+TEST(ParallelForTest, Concurrent) {
+    chainerx::testing::ContextSession sess;
+    chainerx::Context& context = chainerx::GetDefaultContext();
+    SetNumIntraOpThreads(4);
+
+    // While a loop of two threads is running, a loop of another thread
+    // gets a helper from the two remaining workers instead of running
+    // inline.
+    std::atomic<bool> second_done{false};
+    std::mutex mu;
+    std::condition_variable cv;
+    std::set<std::thread::id> second_thread_ids;
+    std::thread first([&]() {
+        chainerx::ContextScope context_scope(context);
+        IntraOpThreadsScope scope(2);
+        ParallelFor(0, 2, 1, [&](int64_t begin, int64_t end) {
+            std::unique_lock<std::mutex> lock(mu);
+            cv.wait_for(lock, std::chrono::seconds(10), [&]() { return second_done.load(); });
+        });
+    });
+    std::thread second([&]() {
+        chainerx::ContextScope context_scope(context);
+        IntraOpThreadsScope scope(2);
+        ParallelFor(0, 2, 1, [&](int64_t begin, int64_t end) {
+            std::unique_lock<std::mutex> lock(mu);
+            second_thread_ids.insert(std::this_thread::get_id());
+            cv.notify_all();
+            cv.wait_for(lock, std::chrono::seconds(10), [&]() { return second_thread_ids.size() == 2; });
+        });
+        second_done = true;
+        std::lock_guard<std::mutex> lock(mu);
+        cv.notify_all();
+    });
+    first.join();
+    second.join();
+    EXPECT_EQ(2, second_thread_ids.size());
+
+    SetNumIntraOpThreads(1);
+}
+
+}  // namespace
+}  // namespace runtime
+}  // namespace chainer_compiler
@@ -0,0 +1,97 @@
+#include "runtime/random.h"
+
+#include <algorithm>
+
+#include <common/log.h>
+#include <runtime/parallel_for.h>
+
+namespace chainer_compiler {
+namespace runtime {
+namespace {
+
+constexpr uint32_t kPhiloxM0 = 0xD2511F53;
+constexpr uint32_t kPhiloxM1 = 0xCD9E8D57;
+constexpr uint32_t kPhiloxW0 = 0x9E3779B9;
+constexpr uint32_t kPhiloxW1 = 0xBB67AE85;
+
+// The number of counters processed together. Lanes of a batch are
+// independent so the compiler can vectorize the rounds. A smaller
+// batch is fully unrolled by GCC and not vectorized.
+constexpr int kBatch = 32;
+constexpr int kBatchSize = 4 * kBatch;
+
+// Generates 4 * kBatch numbers for counters from `counter`.
+void GenerateBatch(const uint32_t* key, const uint32_t* stream, uint64_t counter, uint32_t* out) {
+    uint32_t c0[kBatch], c1[kBatch], c2[kBatch], c3[kBatch];
+    for (int i = 0; i < kBatch; ++i) {
+        const uint64_t c = counter + i;
+        c0[i] = static_cast<uint32_t>(c);
+        c1[i] = static_cast<uint32_t>(c >> 32);
+        c2[i] = stream[0];
+        c3[i] = stream[1];
+    }
+    uint32_t k0 = key[0];
+    uint32_t k1 = key[1];
+    for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < kBatch; ++i) {
+            const uint64_t p0 = static_cast<uint64_t>(kPhiloxM0) * c0[i];
+            const uint64_t p1 = static_cast<uint64_t>(kPhiloxM1) * c2[i];
+            c0[i] = static_cast<uint32_t>(p1 >> 32) ^ c1[i] ^ k0;
+            c1[i] = static_cast<uint32_t>(p1);
+            c2[i] = static_cast<uint32_t>(p0 >> 32) ^ c3[i] ^ k1;
+            c3[i] = static_cast<uint32_t>(p0);
+        }
+        k0 += kPhiloxW0;
+        k1 += kPhiloxW1;
+    }
+    for (int i = 0; i < kBatch; ++i) {
+        out[4 * i] = c0[i];
+        out[4 * i + 1] = c1[i];
+        out[4 * i + 2] = c2[i];
+        out[4 * i + 3] = c3[i];
+    }
+}
+
+}  // namespace
+
+PhiloxRandom::PhiloxRandom(uint64_t seed, uint64_t stream) {
+    key_[0] = static_cast<uint32_t>(seed);
+    key_[1] = static_cast<uint32_t>(seed >> 32);
+    stream_[0] = static_cast<uint32_t>(stream);
+    stream_[1] = static_cast<uint32_t>(stream >> 32);
+}
+
+void PhiloxRandom::Fill(int64_t offset, int64_t size, uint32_t* out) const {
+    CHECK_LE(0, offset);
+    uint32_t buf[kBatchSize];
+    for (int64_t i = 0; i < size;) {
+        const int64_t index = offset + i;
+        const int64_t skip = index % 4;
+        const int64_t n = std::min(kBatchSize - skip, size - i);
+        if (skip == 0 && n == kBatchSize) {
+            GenerateBatch(key_, stream_, index / 4, out + i);
+        } else {
+            GenerateBatch(key_, stream_, index / 4, buf);
+            std::copy(buf + skip, buf + skip + n, out + i);
+        }
+        i += n;
+    }
+}
+
+void PhiloxRandom::FillUniform(int64_t offset, int64_t size, float* out) const {
+    constexpr int64_t kGrainSize = 16384;
+    ParallelFor(0, size, kGrainSize, [this, offset, out](int64_t begin, int64_t end) {
+        uint32_t buf[kBatchSize];
+        for (int64_t i = begin; i < end; i += kBatchSize) {
+            const int64_t n = std::min<int64_t>(kBatchSize, end - i);
+            Fill(offset + i, n, buf);
+            for (int64_t j = 0; j < n; ++j) {
+                // The upper 24 bits, which are exactly representable.
+                out[i + j] = (buf[j] >> 8) * (1.0f / (1 << 24));
+            }
+        }
+    });
+}
+
+}  // namespace runtime
+}  // namespace chainer_compiler
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace chainer_compiler {
+namespace runtime {
+
+// A counter-based random number generator by Philox4x32-10 (Salmon et
+// al., "Parallel random numbers: as easy as 1, 2, 3", SC'11). The
+// `i`-th number of a stream is a function of `(seed, stream, i)`, so
+// any range of the stream can be generated independently, and the
+// numbers do not depend on the number of threads.
+class PhiloxRandom {
+public:
+    PhiloxRandom(uint64_t seed, uint64_t stream);
+
+    // Fills `out` with the `offset`-th to `offset + size - 1`-th 32bit
+    // random numbers of the stream.
+    void Fill(int64_t offset, int64_t size, uint32_t* out) const;
+
+    // Same as above, but numbers are converted to uniform floats in
+    // [0, 1) and the loop is split among intra-op threads.
+    void FillUniform(int64_t offset, int64_t size, float* out) const;
+
+private:
+    uint32_t key_[2];
+    uint32_t stream_[2];
+};
+
+}  // namespace runtime
+}  // namespace chainer_compiler
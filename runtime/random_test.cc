@@ -0,0 +1,71 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <chainerx/testing/context_session.h>
+
+#include <runtime/parallel_for.h>
+#include <runtime/random.h>
+
+namespace chainer_compiler {
+namespace runtime {
+namespace {
+
+TEST(RandomTest, KnownAnswer) {
+    // From the known answer tests of Random123.
+    PhiloxRandom random(0, 0);
+    std::vector<uint32_t> bits(4);
+    random.Fill(0, bits.size(), bits.data());
+    EXPECT_EQ(0x6627e8d5U, bits[0]);
+    EXPECT_EQ(0xe169c58dU, bits[1]);
+    EXPECT_EQ(0xbc57ac4cU, bits[2]);
+    EXPECT_EQ(0x9b00dbd8U, bits[3]);
+}
+
+TEST(RandomTest, Offset) {
+    PhiloxRandom random(42, 3);
+    std::vector<uint32_t> expected(1000);
+    random.Fill(0, expected.size(), expected.data());
+    for (int64_t offset : {1, 3, 64, 127, 500}) {
+        for (int64_t size : {1, 5, 128, 300}) {
+            std::vector<uint32_t> bits(size);
+            random.Fill(offset, size, bits.data());
+            for (int64_t i = 0; i < size; ++i) {
+                EXPECT_EQ(expected[offset + i], bits[i]) << offset << " " << size << " " << i;
+            }
+        }
+    }
+
+    // Different seeds and streams.
+    std::vector<uint32_t> bits(expected.size());
+    PhiloxRandom(43, 3).Fill(0, bits.size(), bits.data());
+    EXPECT_NE(expected, bits);
+    PhiloxRandom(42, 4).Fill(0, bits.size(), bits.data());
+    EXPECT_NE(expected, bits);
+}
+
+TEST(RandomTest, Uniform) {
+    chainerx::testing::ContextSession sess;
+
+    PhiloxRandom random(1, 2);
+    std::vector<float> expected(100000);
+    random.FillUniform(0, expected.size(), expected.data());
+    double sum = 0;
+    for (float v : expected) {
+        EXPECT_LE(0, v);
+        EXPECT_GT(1, v);
+        sum += v;
+    }
+    EXPECT_NEAR(0.5, sum / expected.size(), 0.01);
+
+    // Numbers do not depend on the number of threads.
+    SetNumIntraOpThreads(4);
+    std::vector<float> values(expected.size());
+    random.FillUniform(0, values.size(), values.data());
+    EXPECT_EQ(expected, values);
+    SetNumIntraOpThreads(1);
+}
+
+}  // namespace
+}  // namespace runtime
+}  // namespace chainer_compiler
@@ -0,0 +1,66 @@
+#include "runtime/thread_pool.h"
+
+#include <common/log.h>
+
+namespace chainer_compiler {
+namespace runtime {
+
+ThreadPool::ThreadPool(int num_threads) {
+    CHECK_LT(0, num_threads);
+    for (int i = 1; i < num_threads; ++i) {
+        workers_.emplace_back([this, i]() { WorkerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::RunOnAllThreads(const std::function<void(int)>& fn) {
+    std::lock_guard<std::mutex> run_lock(run_mu_);
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        fn_ = &fn;
+        num_running_ = workers_.size();
+        ++generation_;
+    }
+    start_cv_.notify_all();
+
+    fn(0);
+
+    std::unique_lock<std::mutex> lock(mu_);
+    done_cv_.wait(lock, [this]() { return num_running_ == 0; });
+    fn_ = nullptr;
+}
+
+void ThreadPool::WorkerLoop(int thread_index) {
+    int64_t seen_generation = 0;
+    while (true) {
+        const std::function<void(int)>* fn;
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            start_cv_.wait(lock, [this, seen_generation]() { return stop_ || generation_ != seen_generation; });
+            if (stop_) return;
+            seen_generation = generation_;
+            fn = fn_;
+        }
+
+        (*fn)(thread_index);
+
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            --num_running_;
+        }
+        done_cv_.notify_one();
+    }
+}
+
+}  // namespace runtime
+}  // namespace chainer_compiler
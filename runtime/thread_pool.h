@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace chainer_compiler {
+namespace runtime {
+
+// A fixed set of threads which run the same function together. The
+// calling thread of `RunOnAllThreads` takes part as the thread #0, so
+// `num_threads - 1` threads are spawned.
+class ThreadPool {
+public:
+    explicit ThreadPool(int num_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int num_threads() const {
+        return workers_.size() + 1;
+    }
+
+    // Calls `fn(thread_index)` on every thread and waits for all of
+    // them to finish.
+    void RunOnAllThreads(const std::function<void(int)>& fn);
+
+private:
+    void WorkerLoop(int thread_index);
+
+    std::vector<std::thread> workers_;
+    // Serializes concurrent callers of `RunOnAllThreads`.
+    std::mutex run_mu_;
+
+    std::mutex mu_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    const std::function<void(int)>* fn_{nullptr};
+    int64_t generation_{0};
+    int num_running_{0};
+    bool stop_{false};
+};
+
+}  // namespace runtime
+}  // namespace chainer_compiler
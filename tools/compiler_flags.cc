@@ -9,8 +9,10 @@ void AddCompilerFlags(cmdline::parser* args) {
     args->add("compiler_log", '\0', "Show logs from compiler");
     args->add("permissive", '\0', "Relax checks to accept more kinds of ONNX");
     args->add("skip_inference", '\0', "Skip dtype/shape inference");
+    args->add("onnx_shape_inference", '\0', "Infer shapes by ONNX's shape inference on the whole graph");
     args->add("fuse_operations", '\0', "Fuse consecutive operations");
     args->add("use_nvrtc", '\0', "Use NVRTC");
+    args->add("use_native_jit", '\0', "Compile fused operations for CPU with the system C++ compiler");
     args->add("use_tvm", '\0', "Use TVM");
     args->add("reuse_tvm_code", '\0', "Reuse TVM code (unsafe)");
     args->add("use_ngraph", '\0', "Use nGraph");
@@ -28,16 +30,25 @@ void AddCompilerFlags(cmdline::parser* args) {
     args->add("dump_after_fusion", '\0', "Dump the ONNX graph after operator fusion");
     args->add("dump_after_scheduling", '\0', "Dump the ONNX graph after scheduling");
     args->add("dump_subgraphs", '\0', "Dump the subgraph tree of the ONNX graph");
+    args->add("static_memory_plan", '\0', "Place statically shaped outputs in a preallocated arena");
+    args->add("skip_chxvm_peephole", '\0', "Do not run peephole optimizations on ChxVM programs");
+    args->add<std::string>("scheduler", '\0', "The scheduler of nodes (greedy, min_peak, or critical_path)", false);
+    args->add<int>("scheduler_beam_width", '\0', "Beam width of the min_peak scheduler", 0);
+    args->add<int>("scheduler_time_budget", '\0', "Time budget of the min_peak scheduler (in msec)", 0);
+    args->add<int>("scheduler_num_workers", '\0', "The number of parallel nodes in a stage of the critical_path scheduler", 0);
     args->add<std::string>("computation_order", '\0', "Run the specified policy of computation order (backprop only)", false);
     args->add<int>("chen_budget", '\0', "Memory budget of Chen's policy (in MB)", 0);
+    args->add<int>("remat_budget", '\0', "Peak memory budget of the remat policy (in MB)", 0);
 }
 
 void ApplyCompilerFlags(const cmdline::parser& args) {
     g_compiler_log = args.exist("compiler_log");
     g_permissive = args.exist("permissive");
     g_skip_inference = args.exist("skip_inference");
+    g_onnx_shape_inference = args.exist("onnx_shape_inference");
     g_fuse_operations = args.exist("fuse_operations");
     g_use_nvrtc = args.exist("use_nvrtc");
+    g_use_native_jit = args.exist("use_native_jit");
     g_use_tvm = args.exist("use_tvm");
     g_reuse_tvm_code = args.exist("reuse_tvm_code");
     g_use_ngraph = args.exist("use_ngraph");
@@ -55,8 +66,15 @@ void ApplyCompilerFlags(const cmdline::parser& args) {
     g_dump_after_fusion = args.exist("dump_after_fusion");
     g_dump_after_scheduling = args.exist("dump_after_scheduling");
     g_dump_subgraphs = args.exist("dump_subgraphs");
+    g_static_memory_plan = args.exist("static_memory_plan");
+    g_skip_chxvm_peephole = args.exist("skip_chxvm_peephole");
+    g_scheduler = args.get<std::string>("scheduler");
+    g_scheduler_beam_width = args.get<int>("scheduler_beam_width");
+    g_scheduler_time_budget = args.get<int>("scheduler_time_budget");
+    g_scheduler_num_workers = args.get<int>("scheduler_num_workers");
     g_computation_order = args.get<std::string>("computation_order");
     g_chen_budget = args.get<int>("chen_budget");
+    g_remat_budget = args.get<int>("remat_budget");
     if (args.exist("trace")) g_trace_level = 1;
     if (args.exist("verbose")) g_trace_level = 2;
 }
@@ -1,12 +1,14 @@
-// Dump an ONNX proto
+// Dump an ONNX proto or a ChxVM program
 
 #include <glob.h>
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <limits>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -15,8 +17,17 @@
 #include <common/log.h>
 #include <common/protoutil.h>
 #include <common/strutil.h>
+#include <compiler/chxvm/peephole.h>
+#include <compiler/dtype_inference.h>
+#include <compiler/graph.h>
+#include <compiler/memory_simulator.h>
+#include <compiler/model.h>
+#include <compiler/passes.h>
+#include <compiler/scheduler.h>
+#include <compiler/shape_inference.h>
 #include <compiler/tensor.h>
 #include <compiler/util.h>
+#include <runtime/chxvm.pb.h>
 #include <tools/cmdline.h>
 #include <tools/util.h>
 
@@ -45,9 +56,102 @@ void DumpTensor(const std::string& filename) {
     std::cout << xtensor_normalized.DebugString();
 }
 
+// Dumps a program written by `run_onnx --out_chxvm`.
+void DumpChxVM(const std::string& filename, const cmdline::parser& args) {
+    XCProgramProto program(LoadLargeProto<XCProgramProto>(filename));
+    if (args.exist("peephole")) {
+        chxvm::PeepholeStats stats = chxvm::OptimizeProgram(&program);
+        std::cout << "Peephole: " << stats.num_instructions_before << " => " << stats.num_instructions_after << " instructions\n"
+                  << " Early frees: " << stats.num_early_frees << "\n"
+                  << " Forwarded copies: " << stats.num_forwarded_copies << "\n"
+                  << " Coalesced moves: " << stats.num_coalesced_moves << "\n"
+                  << " Dead copies: " << stats.num_dead_copies << "\n"
+                  << " Hoisted constants: " << stats.num_hoisted_constants << "\n"
+                  << " Removed jumps: " << stats.num_removed_jumps << "\n";
+        if (!args.exist("full")) return;
+    }
+    std::cout << program.DebugString();
+}
+
+// Compares the native shape inference with ONNX's one on the whole
+// graph. Types of temporary values in the model are reset.
+void BenchShapeInference(const std::string& filename) {
+    onnx::ModelProto xmodel(LoadLargeProto<onnx::ModelProto>(filename));
+
+    auto infer = [&xmodel](bool use_onnx, std::map<std::string, std::string>* types) {
+        Model model(xmodel);
+        Graph* graph = model.mutable_graph();
+        for (const std::unique_ptr<Value>& value : graph->all_values()) {
+            if (value->IsTemp()) value->set_type(new Type());
+        }
+
+        std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+        if (use_onnx) {
+            graph->InferShapes();
+            InferAllDtype(graph);
+        } else {
+            InferAllShapes(graph);
+        }
+        std::chrono::system_clock::time_point end = std::chrono::system_clock::now();
+
+        for (const std::unique_ptr<Value>& value : graph->all_values()) {
+            (*types)[value->name()] = value->type().ToString();
+        }
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() * 0.001;
+    };
+
+    std::map<std::string, std::string> onnx_types, native_types;
+    const double onnx_elapsed = infer(true, &onnx_types);
+    const double native_elapsed = infer(false, &native_types);
+    std::cout << "ONNX: " << onnx_elapsed << " msec\n"
+              << "Native: " << native_elapsed << " msec\n";
+
+    int num_diffs = 0;
+    for (const auto& p : onnx_types) {
+        const std::string& native_type = native_types[p.first];
+        if (p.second == native_type) continue;
+        std::cout << " " << p.first << ": " << p.second << " (ONNX) vs " << native_type << " (native)\n";
+        ++num_diffs;
+    }
+    std::cout << "Values with different types: " << num_diffs << "/" << onnx_types.size() << "\n";
+}
+
+// Compares peak memory usage simulated for orders by the greedy
+// scheduler and the min_peak scheduler.
+void CompareSchedulers(const std::string& filename, bool gen_backprop) {
+    Model model(LoadLargeProto<onnx::ModelProto>(filename));
+    RunDefaultPasses(&model, gen_backprop);
+    Graph* graph = model.mutable_graph();
+
+    int64_t greedy_peak = -1;
+    for (const auto& p : {std::make_pair("greedy", SchedulerType::kGreedy), std::make_pair("min_peak", SchedulerType::kMinPeakMemory)}) {
+        for (Node* node : graph->nodes()) {
+            node->set_chainer_order(-1);
+        }
+        std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+        ScheduleComputation(*graph, 0, p.second);
+        std::chrono::system_clock::time_point end = std::chrono::system_clock::now();
+        const double elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() * 0.001;
+
+        SimulatedMemoryUsage usage = SimulateMemoryUsage(*graph);
+        std::cout << p.first << ": peak=" << usage.peak / 1000 / 1000 << "MB (" << elapsed << " msec)";
+        if (greedy_peak < 0) {
+            greedy_peak = usage.peak;
+        } else if (greedy_peak > 0) {
+            std::cout << " " << (greedy_peak - usage.peak) * 100.0 / greedy_peak << "% reduction";
+        }
+        if (usage.num_unknowns) std::cout << " unknown shapes=" << usage.num_unknowns << "/" << usage.num_values;
+        std::cout << "\n";
+    }
+}
+
 void RunMain(int argc, char** argv) {
     cmdline::parser args;
     args.add("full", '\0', "Dump all tensor values.");
+    args.add("peephole", '\0', "Report instructions removed by peephole optimizations of ChxVM programs.");
+    args.add("shape_inference", '\0', "Compare the native shape inference with ONNX's one on ONNX models.");
+    args.add("scheduler", '\0', "Compare peak memory usage by the greedy and min_peak schedulers on ONNX models.");
+    args.add("backprop", '\0', "Generate gradients before scheduling (with --scheduler).");
     args.parse_check(argc, argv);
 
     if (args.rest().empty()) {
@@ -60,10 +164,16 @@ void RunMain(int argc, char** argv) {
     for (const std::string& filename : args.rest()) {
         std::cout << "=== " << filename << " ===\n";
 
-        if (HasSuffix(filename, ".onnx")) {
+        if (args.exist("shape_inference")) {
+            BenchShapeInference(HasSuffix(filename, ".onnx") ? filename : filename + "/model.onnx");
+        } else if (args.exist("scheduler")) {
+            CompareSchedulers(HasSuffix(filename, ".onnx") ? filename : filename + "/model.onnx", args.exist("backprop"));
+        } else if (HasSuffix(filename, ".onnx")) {
             DumpONNX(filename, args);
         } else if (HasSuffix(filename, ".pb")) {
             DumpTensor(filename);
+        } else if (HasSuffix(filename, ".chxvm")) {
+            DumpChxVM(filename, args);
         } else {
             // TODO(hamaji): Check if this directory is a standard
             // ONNX test directory.
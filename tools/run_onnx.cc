@@ -278,6 +278,7 @@ public:
         }
         chxvm_opts_.trace_level = trace_level();
         chxvm_opts_.is_training = args_.exist("backprop") || args_.exist("backprop_two_phase");
+        chxvm_opts_.seed = args_.get<int>("seed");
         chxvm_opts_.check_types = true;
         chxvm_opts_.check_nans = args_.exist("check_nans");
         chxvm_opts_.check_infs = args_.exist("check_infs");
@@ -285,6 +286,8 @@ public:
         chxvm_opts_.dump_memory_usage = args_.exist("trace");
         chxvm_opts_.base_memory_usage = initial_free_bytes_;
         chxvm_opts_.dump_outputs_dir = args_.get<std::string>("dump_outputs_dir");
+        chxvm_opts_.num_inter_op_threads = args_.get<int>("num_inter_op_threads");
+        chxvm_opts_.num_intra_op_threads = args_.get<int>("num_intra_op_threads");
         if (!args_.get<std::string>("chrome_tracing").empty()) {
             chxvm_opts_.chrome_tracing = new ChromeTracingEmitter();
         }
@@ -523,6 +526,9 @@ void RunMain(const std::vector<std::string>& argv) {
     args.add<std::string>("dump_outputs_dir", '\0', "Dump each output of ChxVM ops to this directory", false);
     args.add<std::string>("report_json", '\0', "Dump report in a JSON", false);
     args.add<int>("iterations", 'I', "The number of iteartions", false, 1);
+    args.add<int>("num_inter_op_threads", '\0', "The number of threads which run independent ops concurrently", false, 1);
+    args.add<int>("num_intra_op_threads", '\0', "The number of threads which run loops in ops concurrently", false, 1);
+    args.add<int>("seed", '\0', "The seed of random ops (a different seed for each run if negative)", false, -1);
     args.add<double>("rtol", '\0', "rtol of AllClose", false, 1e-4);
     args.add<double>("atol", '\0', "atol of AllClose", false, 1e-6);
     args.add("no_catch", '\0', "Do not catch the exception in ChxVM for better GDB experience");
@@ -1,6 +1,7 @@
 #include "tools/util.h"
 
 #include <algorithm>
+#include <atomic>
 
 #include <chainerx/array.h>
 #include <chainerx/dtype.h>
@@ -14,6 +15,7 @@
 #include <compiler/model.h>
 #include <runtime/chainerx_util.h>
 #include <runtime/chxvm_var.h>
+#include <runtime/parallel_for.h>
 
 namespace chainer_compiler {
 namespace runtime {
@@ -88,19 +90,23 @@ int MismatchInAllClose(const chainerx::Array& a, const chainerx::Array& b, doubl
         chainerx::IndexableArray<const T> b_iarray{b_native};
         chainerx::Indexer<> indexer{a_native.shape()};
 
-        int64_t error_count = 0;
-        for (auto it = indexer.It(0); it; ++it) {
-            T ai = chainerx::native::StorageToDataType<const T>(a_iarray[it]);
-            T bi = chainerx::native::StorageToDataType<const T>(b_iarray[it]);
-            if (equal_nan && chainerx::IsNan(ai) && chainerx::IsNan(bi)) {
-                // nop
-            } else if (
-                    chainerx::IsNan(ai) || chainerx::IsNan(bi) ||
-                    std::abs(static_cast<double>(ai) - static_cast<double>(bi)) > atol + rtol * std::abs(static_cast<double>(bi))) {
-                error_count++;
+        std::atomic<int64_t> error_count{0};
+        ParallelFor(0, indexer.total_size(), 1 << 16, [&](int64_t begin, int64_t end) {
+            int64_t local_error_count = 0;
+            for (auto it = indexer.It(begin); it && it.raw_index() < end; ++it) {
+                T ai = chainerx::native::StorageToDataType<const T>(a_iarray[it]);
+                T bi = chainerx::native::StorageToDataType<const T>(b_iarray[it]);
+                if (equal_nan && chainerx::IsNan(ai) && chainerx::IsNan(bi)) {
+                    // nop
+                } else if (
+                        chainerx::IsNan(ai) || chainerx::IsNan(bi) ||
+                        std::abs(static_cast<double>(ai) - static_cast<double>(bi)) > atol + rtol * std::abs(static_cast<double>(bi))) {
+                    local_error_count++;
+                }
             }
-        }
-        return error_count;
+            error_count += local_error_count;
+        });
+        return error_count.load();
     });
 }
 